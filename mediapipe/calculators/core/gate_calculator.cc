@@ -132,6 +132,7 @@ class GateCalculator : public CalculatorBase {
     if (cc->Outputs().HasTag(kStateChangeTag)) {
       cc->Outputs().Tag(kStateChangeTag).Set<bool>();
     }
+    cc->SetInlineExecution(true);
 
     return absl::OkStatus();
   }
@@ -66,6 +66,7 @@ class PacketPresenceCalculator : public CalculatorBase {
     // Process() function is invoked in response to input stream timestamp
     // bound updates.
     cc->SetProcessTimestampBounds(true);
+    cc->SetInlineExecution(true);
     return absl::OkStatus();
   }
 
@@ -104,6 +104,7 @@ class SplitVectorCalculator : public CalculatorBase {
         }
       }
     }
+    cc->SetInlineExecution(true);
 
     return absl::OkStatus();
   }
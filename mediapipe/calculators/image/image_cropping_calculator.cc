@@ -17,6 +17,7 @@
 #include <cmath>
 
 #include "absl/log/absl_log.h"
+#include "mediapipe/framework/formats/cpu_frame_pool.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/rect.pb.h"
@@ -267,16 +268,17 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   const cv::Mat shift_dst = cv::Mat(3, 3, CV_64F, shift_dst_vec);
   const cv::Mat adjusted_projection_matrix =
       shift_dst * projection_matrix * shift_src;
-  cv::Mat cropped_image;
-  cv::warpPerspective(input_mat, cropped_image, adjusted_projection_matrix,
-                      cv::Size(output_width, output_height),
+  // Warps straight into the output frame, which has the size and type that
+  // warpPerspective expects, so no intermediate image is allocated.
+  const cv::Size output_size(output_width, output_height);
+  std::unique_ptr<ImageFrame> output_frame =
+      CpuFramePool::GetDefault().GetFrame(
+          input_img.Format(), output_size.width, output_size.height);
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  cv::warpPerspective(input_mat, output_mat, adjusted_projection_matrix,
+                      output_size,
                       /* flags = */ 0,
                       /* borderMode = */ border_mode);
-
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
-      input_img.Format(), cropped_image.cols, cropped_image.rows));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  cropped_image.copyTo(output_mat);
   cc->Outputs().Tag(kImageTag).Add(output_frame.release(),
                                    cc->InputTimestamp());
   return absl::OkStatus();
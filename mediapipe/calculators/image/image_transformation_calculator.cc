@@ -16,6 +16,7 @@
 #include "mediapipe/calculators/image/image_transformation_calculator.pb.h"
 #include "mediapipe/calculators/image/rotation_mode.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/cpu_frame_pool.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
@@ -570,8 +571,8 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
     flipped_mat = rotated_mat;
   }
 
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(format, output_width, output_height));
+  std::unique_ptr<ImageFrame> output_frame =
+      CpuFramePool::GetDefault().GetFrame(format, output_width, output_height);
   cv::Mat output_mat = formats::MatView(output_frame.get());
   flipped_mat.copyTo(output_mat);
   cc->Outputs()
@@ -20,6 +20,7 @@
 #include "absl/log/absl_log.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_calculator.pb.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_fused.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/api2/packet.h"
@@ -42,7 +43,8 @@
 
 #if !MEDIAPIPE_DISABLE_OPENCV
 #include "mediapipe/calculators/tensor/image_to_tensor_converter_opencv.h"
-#elif MEDIAPIPE_ENABLE_HALIDE
+#endif
+#if MEDIAPIPE_ENABLE_HALIDE
 #include "mediapipe/calculators/tensor/image_to_tensor_converter_frame_buffer.h"
 #endif
 
@@ -87,14 +89,25 @@ namespace api2 {
 //     GPU (i.e., Image::UsesGpu() returns true), or otherwise processed on CPU.
 //   - IMAGE input of type ImageFrame is always processed on CPU.
 //   - IMAGE_GPU input (of type GpuBuffer) is always processed on GPU.
+//   - YUV images (e.g. decoder output in NV12 or I420) are processed on CPU
+//     when cpu_converter is CPU_CONVERTER_FRAME_BUFFER, which samples the
+//     regions straight from the YUV planes.
 //
 //   NORM_RECT - NormalizedRect @Optional
 //     Describes region of image to extract.
 //     @Optional: rect covering the whole image is used if not specified.
 //
+//   NORM_RECTS - std::vector<NormalizedRect> @Optional
+//     Describes regions of image to extract into a single batched tensor, with
+//     one [H, W, C] image per rect. Cannot be used together with NORM_RECT.
+//     Sentinel rects (zero width and height) are skipped like with NORM_RECT,
+//     and no tensor is output if all rects are sentinels. Supported by the CPU
+//     converters and the OpenGL buffer converter.
+//
 // Outputs:
 //   TENSORS - std::vector<Tensor>
-//     Vector containing a single Tensor populated with an extracted RGB image.
+//     Vector containing a single Tensor populated with an extracted RGB image,
+//     or with the images extracted from NORM_RECTS along the batch dimension.
 //   MATRIX - std::array<float, 16> @Optional
 //     An std::array<float, 16> representing a 4x4 row-major-order matrix that
 //     maps a point on the input image to a point on the output tensor, and
@@ -111,6 +124,9 @@ namespace api2 {
 //     20x20 and places it in the middle of the output image with an equal
 //     padding of 10 pixels at the top and the bottom. The resulting array is
 //     therefore [0.f, 0.25f, 0.f, 0.25f] (10/40 = 0.25f).
+//   MATRICES - std::vector<std::array<float, 16>> @Optional
+//   LETTERBOX_PADDINGS - std::vector<std::array<float, 4>> @Optional
+//     MATRIX and LETTERBOX_PADDING of each rect when NORM_RECTS is used.
 //
 // Example:
 // node {
@@ -139,24 +155,50 @@ class ImageToTensorCalculator : public Node {
   static constexpr Input<GpuBuffer>::Optional kInGpu{"IMAGE_GPU"};
   static constexpr Input<mediapipe::NormalizedRect>::Optional kInNormRect{
       "NORM_RECT"};
+  static constexpr Input<std::vector<mediapipe::NormalizedRect>>::Optional
+      kInNormRects{"NORM_RECTS"};
   static constexpr Output<std::vector<Tensor>>::Optional kOutTensors{"TENSORS"};
   static constexpr Output<Tensor>::Optional kOutTensor{"TENSOR"};
   static constexpr Output<std::array<float, 4>>::Optional kOutLetterboxPadding{
       "LETTERBOX_PADDING"};
   static constexpr Output<std::array<float, 16>>::Optional kOutMatrix{"MATRIX"};
+  static constexpr Output<std::vector<std::array<float, 4>>>::Optional
+      kOutLetterboxPaddings{"LETTERBOX_PADDINGS"};
+  static constexpr Output<std::vector<std::array<float, 16>>>::Optional
+      kOutMatrices{"MATRICES"};
 
-  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInNormRect, kOutTensors, kOutTensor,
-                          kOutLetterboxPadding, kOutMatrix);
+  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInNormRect, kInNormRects, kOutTensors,
+                          kOutTensor, kOutLetterboxPadding, kOutMatrix,
+                          kOutLetterboxPaddings, kOutMatrices);
 
   static absl::Status UpdateContract(CalculatorContract* cc) {
     const auto& options =
         cc->Options<mediapipe::ImageToTensorCalculatorOptions>();
 
     RET_CHECK_OK(ValidateOptionOutputDims(options));
+    if (options.output_tensor_float16()) {
+      RET_CHECK_EQ(options.cpu_converter(),
+                   mediapipe::ImageToTensorCalculatorOptions::
+                       CPU_CONVERTER_FUSED)
+          << "Float16 output requires the fused CPU converter.";
+      RET_CHECK(options.has_output_tensor_float_range())
+          << "Float16 output requires a float output range.";
+    }
     RET_CHECK(kIn(cc).IsConnected() ^ kInGpu(cc).IsConnected())
         << "One and only one of IMAGE and IMAGE_GPU input is expected.";
     RET_CHECK(kOutTensors(cc).IsConnected() ^ kOutTensor(cc).IsConnected())
         << "One and only one of TENSORS and TENSOR output is supported.";
+    if (kInNormRects(cc).IsConnected()) {
+      RET_CHECK(!kInNormRect(cc).IsConnected())
+          << "NORM_RECT and NORM_RECTS cannot be used together.";
+      RET_CHECK(!kOutLetterboxPadding(cc).IsConnected() &&
+                !kOutMatrix(cc).IsConnected())
+          << "Use LETTERBOX_PADDINGS and MATRICES with NORM_RECTS.";
+    } else {
+      RET_CHECK(!kOutLetterboxPaddings(cc).IsConnected() &&
+                !kOutMatrices(cc).IsConnected())
+          << "LETTERBOX_PADDINGS and MATRICES require NORM_RECTS.";
+    }
 
 #if MEDIAPIPE_DISABLE_GPU
     if (kInGpu(cc).IsConnected()) {
@@ -194,14 +236,30 @@ class ImageToTensorCalculator : public Node {
       return absl::OkStatus();
     }
 
-    absl::optional<mediapipe::NormalizedRect> norm_rect;
-    if (kInNormRect(cc).IsConnected()) {
+    // The rects to extract, or a single unset rect for the whole image.
+    std::vector<absl::optional<mediapipe::NormalizedRect>> norm_rects;
+    if (kInNormRects(cc).IsConnected()) {
+      if (kInNormRects(cc).IsEmpty() || kInNormRects(cc)->empty()) {
+        // Timestamp bound update happens automatically. (See Open().)
+        return absl::OkStatus();
+      }
+      for (const auto& norm_rect : *kInNormRects(cc)) {
+        // Sentinel rects are skipped, as with NORM_RECT.
+        if (norm_rect.width() == 0 && norm_rect.height() == 0) continue;
+        norm_rects.push_back(norm_rect);
+      }
+      if (norm_rects.empty()) {
+        ABSL_DLOG(WARNING)
+            << "Updating timestamp bound in response to sentinel rects";
+        return absl::OkStatus();
+      }
+    } else if (kInNormRect(cc).IsConnected()) {
       if (kInNormRect(cc).IsEmpty()) {
         // Timestamp bound update happens automatically. (See Open().)
         return absl::OkStatus();
       }
-      norm_rect = *kInNormRect(cc);
-      if (norm_rect->width() == 0 && norm_rect->height() == 0) {
+      const mediapipe::NormalizedRect& norm_rect = *kInNormRect(cc);
+      if (norm_rect.width() == 0 && norm_rect.height() == 0) {
         // WORKAROUND: some existing graphs may use sentinel rects {width=0,
         // height=0, ...} quite often and calculator has to handle them
         // gracefully by updating timestamp bound instead of returning failure.
@@ -211,6 +269,9 @@ class ImageToTensorCalculator : public Node {
             << "Updating timestamp bound in response to a sentinel rect";
         return absl::OkStatus();
       }
+      norm_rects.push_back(norm_rect);
+    } else {
+      norm_rects.push_back(absl::nullopt);
     }
 
 #if MEDIAPIPE_DISABLE_GPU
@@ -221,36 +282,63 @@ class ImageToTensorCalculator : public Node {
                                                  : GetInputImage(kIn(cc)));
 #endif  // MEDIAPIPE_DISABLE_GPU
 
-    RotatedRect roi = GetRoi(image->width(), image->height(), norm_rect);
     const int tensor_width = params_.output_width.value_or(image->width());
     const int tensor_height = params_.output_height.value_or(image->height());
-    MP_ASSIGN_OR_RETURN(auto padding,
-                        PadRoi(tensor_width, tensor_height,
-                               options_.keep_aspect_ratio(), &roi));
+    std::vector<RotatedRect> rois;
+    std::vector<std::array<float, 4>> paddings;
+    std::vector<std::array<float, 16>> matrices;
+    const bool send_matrices =
+        kOutMatrix(cc).IsConnected() || kOutMatrices(cc).IsConnected();
+    for (const auto& norm_rect : norm_rects) {
+      RotatedRect roi = GetRoi(image->width(), image->height(), norm_rect);
+      MP_ASSIGN_OR_RETURN(auto padding,
+                          PadRoi(tensor_width, tensor_height,
+                                 options_.keep_aspect_ratio(), &roi));
+      rois.push_back(roi);
+      paddings.push_back(padding);
+      if (send_matrices) {
+        std::array<float, 16> matrix;
+        GetRotatedSubRectToRectTransformMatrix(
+            roi, image->width(), image->height(),
+            /*flip_horizontally=*/false, &matrix);
+        matrices.push_back(matrix);
+      }
+    }
     if (kOutLetterboxPadding(cc).IsConnected()) {
-      kOutLetterboxPadding(cc).Send(padding);
+      kOutLetterboxPadding(cc).Send(paddings[0]);
     }
     if (kOutMatrix(cc).IsConnected()) {
-      std::array<float, 16> matrix;
-      GetRotatedSubRectToRectTransformMatrix(
-          roi, image->width(), image->height(),
-          /*flip_horizontally=*/false, &matrix);
-      kOutMatrix(cc).Send(std::move(matrix));
+      kOutMatrix(cc).Send(matrices[0]);
+    }
+    if (kOutLetterboxPaddings(cc).IsConnected()) {
+      kOutLetterboxPaddings(cc).Send(std::move(paddings));
+    }
+    if (kOutMatrices(cc).IsConnected()) {
+      kOutMatrices(cc).Send(std::move(matrices));
     }
 
     // Lazy initialization of the GPU or CPU converter.
     MP_RETURN_IF_ERROR(InitConverterIfNecessary(cc, *image.get()));
 
+    const bool use_gpu = UsesGpuConverter(*image);
     Tensor::ElementType output_tensor_type =
-        GetOutputTensorType(image->UsesGpu(), params_);
-    Tensor tensor(
-        output_tensor_type,
-        {1, tensor_height, tensor_width, GetNumOutputChannels(*image)},
-        memory_manager_);
-    MP_RETURN_IF_ERROR((image->UsesGpu() ? gpu_converter_ : cpu_converter_)
-                           ->Convert(*image, roi, params_.range_min,
-                                     params_.range_max,
-                                     /*tensor_buffer_offset=*/0, tensor));
+        use_gpu ? GetOutputTensorType(/*uses_gpu=*/true, params_)
+                : GetCpuOutputTensorType();
+    const int batch_size = rois.size();
+    Tensor tensor(output_tensor_type,
+                  {batch_size, tensor_height, tensor_width,
+                   GetNumOutputChannels(*image)},
+                  memory_manager_);
+    // All rects are extracted from the same image, which is fetched, and
+    // downloaded or color converted if needed, only once.
+    const int image_bytes = tensor.bytes() / batch_size;
+    ImageToTensorConverter& converter =
+        use_gpu ? *gpu_converter_ : *cpu_converter_;
+    for (int i = 0; i < batch_size; ++i) {
+      MP_RETURN_IF_ERROR(converter.Convert(
+          *image, rois[i], params_.range_min, params_.range_max,
+          /*tensor_buffer_offset=*/i * image_bytes, tensor));
+    }
 
     if (kOutTensors(cc).IsConnected()) {
       auto result = std::make_unique<std::vector<Tensor>>();
@@ -266,7 +354,7 @@ class ImageToTensorCalculator : public Node {
   absl::Status InitConverterIfNecessary(CalculatorContext* cc,
                                         const Image& image) {
     // Lazy initialization of the GPU or CPU converter.
-    if (image.UsesGpu()) {
+    if (UsesGpuConverter(image)) {
       if (!params_.is_float_output) {
         return absl::UnimplementedError(
             "ImageToTensorConverter for the input GPU image currently doesn't "
@@ -310,6 +398,29 @@ class ImageToTensorCalculator : public Node {
 #endif  // !MEDIAPIPE_DISABLE_GPU
       }
     } else {
+      if (!cpu_converter_ &&
+          options_.cpu_converter() ==
+              mediapipe::ImageToTensorCalculatorOptions::CPU_CONVERTER_FUSED) {
+        MP_ASSIGN_OR_RETURN(
+            cpu_converter_,
+            CreateFusedConverter(cc, GetBorderMode(options_.border_mode()),
+                                 GetCpuOutputTensorType()));
+      }
+      if (!cpu_converter_ &&
+          options_.cpu_converter() ==
+              mediapipe::ImageToTensorCalculatorOptions::
+                  CPU_CONVERTER_FRAME_BUFFER) {
+#if MEDIAPIPE_ENABLE_HALIDE
+        MP_ASSIGN_OR_RETURN(
+            cpu_converter_,
+            CreateFrameBufferConverter(cc,
+                                       GetBorderMode(options_.border_mode()),
+                                       GetCpuOutputTensorType()));
+#else
+        return absl::UnimplementedError(
+            "CPU_CONVERTER_FRAME_BUFFER requires MEDIAPIPE_ENABLE_HALIDE.");
+#endif  // MEDIAPIPE_ENABLE_HALIDE
+      }
       if (!cpu_converter_) {
 #if !MEDIAPIPE_DISABLE_OPENCV
         MP_ASSIGN_OR_RETURN(
@@ -336,6 +447,24 @@ class ImageToTensorCalculator : public Node {
     return absl::OkStatus();
   }
 
+  // Returns true if the image is converted on GPU. YUV images keep their
+  // planes in CPU memory behind a GpuBuffer, and are converted on CPU if the
+  // FrameBuffer converter can sample them directly.
+  bool UsesGpuConverter(const Image& image) const {
+    return image.UsesGpu() &&
+           !(IsYuvImage(image) &&
+             options_.cpu_converter() ==
+                 mediapipe::ImageToTensorCalculatorOptions::
+                     CPU_CONVERTER_FRAME_BUFFER);
+  }
+
+  Tensor::ElementType GetCpuOutputTensorType() const {
+    if (options_.output_tensor_float16()) {
+      return Tensor::ElementType::kFloat16;
+    }
+    return GetOutputTensorType(/*uses_gpu=*/false, params_);
+  }
+
   std::unique_ptr<ImageToTensorConverter> gpu_converter_;
   std::unique_ptr<ImageToTensorConverter> cpu_converter_;
   mediapipe::ImageToTensorCalculatorOptions options_;
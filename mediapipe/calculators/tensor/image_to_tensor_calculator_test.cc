@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -557,6 +558,143 @@ TEST(ImageToTensorCalculatorTest, CanBeUsedWithoutGpuServiceSet) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+TEST(ImageToTensorCalculatorTest, ExtractsNormRectsIntoOneBatch) {
+  for (const char* cpu_converter :
+       {"CPU_CONVERTER_DEFAULT", "CPU_CONVERTER_FUSED"}) {
+    auto graph_config = mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+        absl::Substitute(R"pb(
+                           input_stream: "input_image"
+                           input_stream: "rois"
+                           node {
+                             calculator: "ImageToTensorCalculator"
+                             input_stream: "IMAGE:input_image"
+                             input_stream: "NORM_RECTS:rois"
+                             output_stream: "TENSORS:tensors"
+                             output_stream: "MATRICES:matrices"
+                             options {
+                               [mediapipe.ImageToTensorCalculatorOptions.ext] {
+                                 output_tensor_width: 4
+                                 output_tensor_height: 4
+                                 output_tensor_uint_range { min: 0 max: 255 }
+                                 cpu_converter: $0
+                               }
+                             }
+                           }
+                         )pb",
+                         cpu_converter));
+    std::vector<Packet> tensor_packets;
+    std::vector<Packet> matrix_packets;
+    tool::AddVectorSink("tensors", &graph_config, &tensor_packets);
+    tool::AddVectorSink("matrices", &graph_config, &matrix_packets);
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(graph_config));
+    MP_ASSERT_OK(graph.StartRun({}));
+
+    // An 8x4 image whose left and right halves are extracted.
+    auto image_frame = std::make_shared<ImageFrame>(ImageFormat::SRGB, 8, 4);
+    for (int y = 0; y < 4; ++y) {
+      uint8_t* row =
+          image_frame->MutablePixelData() + y * image_frame->WidthStep();
+      for (int i = 0; i < 8 * 3; ++i) {
+        row[i] = y * 24 + i;
+      }
+    }
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input_image",
+        MakePacket<Image>(Image(image_frame)).At(Timestamp(0))));
+    std::vector<mediapipe::NormalizedRect> rois(2);
+    for (int i = 0; i < 2; ++i) {
+      rois[i].set_x_center(0.25f + 0.5f * i);
+      rois[i].set_y_center(0.5f);
+      rois[i].set_width(0.5f);
+      rois[i].set_height(1.0f);
+    }
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "rois", MakePacket<std::vector<mediapipe::NormalizedRect>>(rois).At(
+                    Timestamp(0))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+
+    ASSERT_THAT(tensor_packets, testing::SizeIs(1));
+    const auto& tensors = tensor_packets[0].Get<std::vector<Tensor>>();
+    ASSERT_THAT(tensors, testing::SizeIs(1));
+    EXPECT_EQ(tensors[0].shape().dims, (std::vector<int>{2, 4, 4, 3}));
+    auto view = tensors[0].GetCpuReadView();
+    const uint8_t* values = view.buffer<uint8_t>();
+    for (int b = 0; b < 2; ++b) {
+      for (int y = 0; y < 4; ++y) {
+        for (int i = 0; i < 4 * 3; ++i) {
+          EXPECT_EQ(values[(b * 4 + y) * 4 * 3 + i],
+                    image_frame->PixelData()[y * image_frame->WidthStep() +
+                                             b * 4 * 3 + i])
+              << cpu_converter;
+        }
+      }
+    }
+    ASSERT_THAT(matrix_packets, testing::SizeIs(1));
+    EXPECT_THAT(matrix_packets[0].Get<std::vector<std::array<float, 16>>>(),
+                testing::SizeIs(2));
+
+    MP_ASSERT_OK(graph.CloseAllPacketSources());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+  }
+}
+
+TEST(ImageToTensorCalculatorTest, SkipsSentinelRectsInNormRects) {
+  auto graph_config = mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+      R"pb(
+        input_stream: "input_image"
+        input_stream: "rois"
+        node {
+          calculator: "ImageToTensorCalculator"
+          input_stream: "IMAGE:input_image"
+          input_stream: "NORM_RECTS:rois"
+          output_stream: "TENSORS:tensors"
+          options {
+            [mediapipe.ImageToTensorCalculatorOptions.ext] {
+              output_tensor_width: 4
+              output_tensor_height: 4
+              output_tensor_uint_range { min: 0 max: 255 }
+            }
+          }
+        }
+      )pb");
+  std::vector<Packet> tensor_packets;
+  tool::AddVectorSink("tensors", &graph_config, &tensor_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(graph_config));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  auto image_frame = std::make_shared<ImageFrame>(ImageFormat::SRGB, 8, 4);
+  image_frame->SetToZero();
+  mediapipe::NormalizedRect roi;
+  roi.set_x_center(0.75f);
+  roi.set_y_center(0.5f);
+  roi.set_width(0.5f);
+  roi.set_height(1.0f);
+  const mediapipe::NormalizedRect sentinel;
+  // One sentinel among other rects, then only sentinels.
+  const std::vector<mediapipe::NormalizedRect> rois[] = {{sentinel, roi},
+                                                         {sentinel}};
+  for (int i = 0; i < 2; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input_image",
+        MakePacket<Image>(Image(image_frame)).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "rois", MakePacket<std::vector<mediapipe::NormalizedRect>>(rois[i]).At(
+                    Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  ASSERT_THAT(tensor_packets, testing::SizeIs(1));
+  EXPECT_EQ(tensor_packets[0].Timestamp(), Timestamp(0));
+  const auto& tensors = tensor_packets[0].Get<std::vector<Tensor>>();
+  ASSERT_THAT(tensors, testing::SizeIs(1));
+  EXPECT_EQ(tensors[0].shape().dims, (std::vector<int>{1, 4, 4, 3}));
+
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
 #if !MEDIAPIPE_DISABLE_GPU && !MEDIAPIPE_METAL_ENABLED
 
 TEST(ImageToTensorCalculatorTest,
@@ -14,10 +14,12 @@
 
 #include "mediapipe/calculators/tensor/image_to_tensor_converter_frame_buffer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -45,6 +47,85 @@ int RadiansToDegrees(float radians) {
   return degrees;
 }
 
+bool IsYuvFormat(FrameBuffer::Format format) {
+  return format == FrameBuffer::Format::kNV12 ||
+         format == FrameBuffer::Format::kNV21 ||
+         format == FrameBuffer::Format::kYV12 ||
+         format == FrameBuffer::Format::kYV21;
+}
+
+// Samples an 8-bit plane at (x, y) with bilinear interpolation, replicating
+// the border pixels.
+float SamplePlane(const uint8_t* plane, int row_stride, int pixel_stride,
+                  int width, int height, float x, float y) {
+  const float left = std::floor(x);
+  const float top = std::floor(y);
+  const float right_weight = x - left;
+  const float bottom_weight = y - top;
+  // Clamped before the conversion, as out of range floats can't be cast to
+  // int.
+  const int x0 = static_cast<int>(std::clamp(left, 0.0f, width - 1.0f));
+  const int x1 = static_cast<int>(std::clamp(left + 1.0f, 0.0f, width - 1.0f));
+  const int y0 = static_cast<int>(std::clamp(top, 0.0f, height - 1.0f));
+  const int y1 = static_cast<int>(std::clamp(top + 1.0f, 0.0f, height - 1.0f));
+  const uint8_t* row0 = plane + y0 * row_stride;
+  const uint8_t* row1 = plane + y1 * row_stride;
+  const float top_value =
+      row0[x0 * pixel_stride] +
+      right_weight * (row0[x1 * pixel_stride] - row0[x0 * pixel_stride]);
+  const float bottom_value =
+      row1[x0 * pixel_stride] +
+      right_weight * (row1[x1 * pixel_stride] - row1[x0 * pixel_stride]);
+  return top_value + bottom_weight * (bottom_value - top_value);
+}
+
+// Samples the region-of-interest mapped by "roi_transform" from the planes of
+// a YUV 4:2:0 image of width x height pixels, and writes its RGB values to
+// "output" in HWC order. Float outputs are normalized with "value_transform",
+// uint8 outputs are rounded.
+template <typename T>
+void SampleYuvToRgb(const FrameBuffer::YuvData& yuv, int width, int height,
+                    const RoiTransform& roi_transform,
+                    const ValueTransformation& value_transform,
+                    int output_width, int output_height, T* output) {
+  const int uv_width = (width + 1) / 2;
+  const int uv_height = (height + 1) / 2;
+  for (int y = 0; y < output_height; ++y) {
+    for (int x = 0; x < output_width; ++x) {
+      const float src_x = roi_transform.origin_x + x * roi_transform.x_step_x +
+                          y * roi_transform.y_step_x;
+      const float src_y = roi_transform.origin_y + x * roi_transform.x_step_y +
+                          y * roi_transform.y_step_y;
+      // Chroma samples are co-sited with the even luma samples.
+      const float luma = SamplePlane(yuv.y_buffer, yuv.y_row_stride,
+                                     /*pixel_stride=*/1, width, height, src_x,
+                                     src_y);
+      const float u =
+          SamplePlane(yuv.u_buffer, yuv.uv_row_stride, yuv.uv_pixel_stride,
+                      uv_width, uv_height, src_x / 2, src_y / 2) -
+          128.0f;
+      const float v =
+          SamplePlane(yuv.v_buffer, yuv.uv_row_stride, yuv.uv_pixel_stride,
+                      uv_width, uv_height, src_x / 2, src_y / 2) -
+          128.0f;
+      // Full-range JFIF coefficients, like frame_buffer::Convert.
+      const float rgb[3] = {
+          std::clamp(luma + 1.402f * v, 0.0f, 255.0f),
+          std::clamp(luma - 0.34414f * u - 0.71414f * v, 0.0f, 255.0f),
+          std::clamp(luma + 1.772f * u, 0.0f, 255.0f),
+      };
+      T* pixel = output + (y * output_width + x) * 3;
+      for (int c = 0; c < 3; ++c) {
+        if constexpr (std::is_same_v<T, uint8_t>) {
+          pixel[c] = static_cast<uint8_t>(rgb[c] + 0.5f);
+        } else {
+          pixel[c] = rgb[c] * value_transform.scale + value_transform.offset;
+        }
+      }
+    }
+  }
+}
+
 // FrameBuffer-based implementation of ImageToTensorConverter.
 class ImageToTensorFrameBufferConverter : public ImageToTensorConverter {
  public:
@@ -57,17 +138,28 @@ class ImageToTensorFrameBufferConverter : public ImageToTensorConverter {
                        Tensor& output_tensor) override;
 
  private:
-  absl::Status ValidateTensorShape(const Tensor::Shape& output_shape);
+  // Checks that the output tensor holds an [H, W, 3] image at
+  // tensor_buffer_offset.
+  absl::Status ValidateOutputTensor(const Tensor& output_tensor,
+                                    int tensor_buffer_offset);
+  // Samples the region-of-interest directly from the planes of a YUV 4:2:0
+  // input and converts only the sampled pixels to RGB, without intermediate
+  // frames. Supports arbitrary rotations and tensor buffer offsets.
+  absl::Status ConvertYuvToTensor(const FrameBuffer& input,
+                                  const RotatedRect& roi, float range_min,
+                                  float range_max, int tensor_buffer_offset,
+                                  Tensor& output_tensor);
   // Crops, rotates and resizes the input based on the provided
   // region-of-interest.
   absl::Status CropRotateResize90Degrees(
       std::shared_ptr<const FrameBuffer> input, const RotatedRect& roi,
       std::shared_ptr<FrameBuffer> output);
-  // Converts the input FrameBuffer to a float Tensor. Output tensor must have
-  // type kFloat32.
-  absl::Status ConvertToFloatTensor(
-      std::shared_ptr<const FrameBuffer> input_frame, float range_min,
-      float range_max, Tensor& output_tensor);
+  // Converts the values of a packed RGB buffer to floats written at
+  // tensor_buffer_offset. Output tensor must have type kFloat32.
+  absl::Status ConvertToFloatTensor(const uint8_t* rgb, int num_values,
+                                    float range_min, float range_max,
+                                    int tensor_buffer_offset,
+                                    Tensor& output_tensor);
 
   Tensor::ElementType tensor_type_;
 
@@ -83,10 +175,6 @@ class ImageToTensorFrameBufferConverter : public ImageToTensorConverter {
 absl::Status ImageToTensorFrameBufferConverter::Convert(
     const mediapipe::Image& input, const RotatedRect& roi, float range_min,
     float range_max, int tensor_buffer_offset, Tensor& output_tensor) {
-  // TODO: add support for non-zero tensor buffer offset.
-  RET_CHECK_EQ(tensor_buffer_offset, 0)
-      << "Non-zero tensor_buffer_offset input is not supported yet.";
-
   // Range other than [0,255] is not supported for uint8 tensor outputs.
   if (tensor_type_ == Tensor::ElementType::kUInt8) {
     RET_CHECK(static_cast<int>(range_min) == 0 &&
@@ -95,8 +183,13 @@ absl::Status ImageToTensorFrameBufferConverter::Convert(
 
   auto input_frame =
       input.GetGpuBuffer(/*upload_to_gpu=*/false).GetReadView<FrameBuffer>();
+  if (IsYuvFormat(input_frame->format())) {
+    return ConvertYuvToTensor(*input_frame, roi, range_min, range_max,
+                              tensor_buffer_offset, output_tensor);
+  }
+
+  MP_RETURN_IF_ERROR(ValidateOutputTensor(output_tensor, tensor_buffer_offset));
   const auto& output_shape = output_tensor.shape();
-  MP_RETURN_IF_ERROR(ValidateTensorShape(output_shape));
   FrameBuffer::Dimension output_dimension{/*width=*/output_shape.dims[2],
                                           /*height=*/output_shape.dims[1]};
 
@@ -104,7 +197,7 @@ absl::Status ImageToTensorFrameBufferConverter::Convert(
   if (RadiansToDegrees(roi.rotation) % 90 == 0) {
     if (tensor_type_ == Tensor::ElementType::kUInt8) {
       auto view = output_tensor.GetCpuWriteView();
-      uint8_t* data = view.buffer<uint8_t>();
+      uint8_t* data = view.buffer<uint8_t>() + tensor_buffer_offset;
       auto output_frame =
           frame_buffer::CreateFromRgbRawBuffer(data, output_dimension);
       return CropRotateResize90Degrees(input_frame, roi, output_frame);
@@ -119,8 +212,9 @@ absl::Status ImageToTensorFrameBufferConverter::Convert(
           output_buffer_.get(), output_dimension);
       MP_RETURN_IF_ERROR(
           CropRotateResize90Degrees(input_frame, roi, output_frame));
-      return ConvertToFloatTensor(output_frame, range_min, range_max,
-                                  output_tensor);
+      return ConvertToFloatTensor(
+          output_buffer_.get(), output_dimension.Size() * 3, range_min,
+          range_max, tensor_buffer_offset, output_tensor);
     }
   } else {
     // TODO: add support for arbitrary rotations
@@ -131,14 +225,55 @@ absl::Status ImageToTensorFrameBufferConverter::Convert(
   return absl::OkStatus();
 }
 
-absl::Status ImageToTensorFrameBufferConverter::ValidateTensorShape(
-    const Tensor::Shape& shape) {
+absl::Status ImageToTensorFrameBufferConverter::ValidateOutputTensor(
+    const Tensor& output_tensor, int tensor_buffer_offset) {
+  const auto& shape = output_tensor.shape();
   RET_CHECK_EQ(shape.dims.size(), 4)
       << "Wrong output dims size: " << shape.dims.size();
-  RET_CHECK_EQ(shape.dims[0], 1)
-      << "Handling batch dimension not equal to 1 is not implemented in this "
-         "converter.";
   RET_CHECK_EQ(shape.dims[3], 3) << "Wrong output channel: " << shape.dims[3];
+  RET_CHECK_GE(tensor_buffer_offset, 0)
+      << "The input tensor_buffer_offset needs to be non-negative.";
+  const int element_size = output_tensor.element_size();
+  RET_CHECK_EQ(tensor_buffer_offset % element_size, 0)
+      << "The tensor_buffer_offset must be a multiple of the element size.";
+  RET_CHECK_GE(shape.num_elements(), tensor_buffer_offset / element_size +
+                                         shape.dims[1] * shape.dims[2] * 3)
+      << "The buffer offset + the input image size is larger than the "
+         "allocated tensor buffer.";
+  return absl::OkStatus();
+}
+
+absl::Status ImageToTensorFrameBufferConverter::ConvertYuvToTensor(
+    const FrameBuffer& input, const RotatedRect& roi, float range_min,
+    float range_max, int tensor_buffer_offset, Tensor& output_tensor) {
+  MP_ASSIGN_OR_RETURN(const FrameBuffer::YuvData yuv,
+                      FrameBuffer::GetYuvDataFromFrameBuffer(input));
+  MP_RETURN_IF_ERROR(ValidateOutputTensor(output_tensor, tensor_buffer_offset));
+  const auto& output_shape = output_tensor.shape();
+  const int output_height = output_shape.dims[1];
+  const int output_width = output_shape.dims[2];
+
+  constexpr float kInputImageRangeMin = 0.0f;
+  constexpr float kInputImageRangeMax = 255.0f;
+  MP_ASSIGN_OR_RETURN(
+      auto value_transform,
+      GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
+                                  range_min, range_max));
+
+  const RoiTransform roi_transform =
+      GetRoiTransform(roi, output_width, output_height);
+  const int width = input.dimension().width;
+  const int height = input.dimension().height;
+  auto view = output_tensor.GetCpuWriteView();
+  uint8_t* output = view.buffer<uint8_t>() + tensor_buffer_offset;
+  if (tensor_type_ == Tensor::ElementType::kUInt8) {
+    SampleYuvToRgb(yuv, width, height, roi_transform, value_transform,
+                   output_width, output_height, output);
+  } else {
+    SampleYuvToRgb(yuv, width, height, roi_transform, value_transform,
+                   output_width, output_height,
+                   reinterpret_cast<float*>(output));
+  }
   return absl::OkStatus();
 }
 
@@ -210,8 +345,8 @@ absl::Status ImageToTensorFrameBufferConverter::CropRotateResize90Degrees(
 }
 
 absl::Status ImageToTensorFrameBufferConverter::ConvertToFloatTensor(
-    std::shared_ptr<const FrameBuffer> input_frame, float range_min,
-    float range_max, Tensor& output_tensor) {
+    const uint8_t* rgb, int num_values, float range_min, float range_max,
+    int tensor_buffer_offset, Tensor& output_tensor) {
   RET_CHECK(output_tensor.element_type() == Tensor::ElementType::kFloat32);
   constexpr float kInputImageRangeMin = 0.0f;
   constexpr float kInputImageRangeMax = 255.0f;
@@ -219,8 +354,13 @@ absl::Status ImageToTensorFrameBufferConverter::ConvertToFloatTensor(
       auto transform,
       GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
                                   range_min, range_max));
-  return frame_buffer::ToFloatTensor(*input_frame, transform.scale,
-                                     transform.offset, output_tensor);
+  auto view = output_tensor.GetCpuWriteView();
+  float* output =
+      reinterpret_cast<float*>(view.buffer<uint8_t>() + tensor_buffer_offset);
+  for (int i = 0; i < num_values; ++i) {
+    output[i] = rgb[i] * transform.scale + transform.offset;
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace
@@ -0,0 +1,238 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_frame_buffer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_fused.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+#if !MEDIAPIPE_DISABLE_GPU
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/gpu/gpu_buffer.h"
+#include "mediapipe/gpu/gpu_buffer_storage_yuv_image.h"
+#include "mediapipe/gpu/image_frame_view.h"
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
+namespace mediapipe {
+namespace {
+
+#if !MEDIAPIPE_DISABLE_GPU
+
+constexpr int kWidth = 32;
+constexpr int kHeight = 24;
+
+// Returns the values of a uint8 or float32 tensor as floats.
+std::vector<float> GetValues(const Tensor& tensor) {
+  auto view = tensor.GetCpuReadView();
+  const int size = tensor.shape().num_elements();
+  if (tensor.element_type() == Tensor::ElementType::kUInt8) {
+    const uint8_t* values = view.buffer<uint8_t>();
+    return std::vector<float>(values, values + size);
+  }
+  const float* values = view.buffer<float>();
+  return std::vector<float>(values, values + size);
+}
+
+// The planes are smooth gradients that stay within the RGB gamut, so that the
+// bilinear sampling of the YUV planes can be compared with the RGB conversion,
+// which upsamples the chroma planes to the nearest pixel, with a small
+// tolerance.
+uint8_t LumaAt(int x, int y) { return 50 + 3 * x + 3 * y; }
+uint8_t UAt(int x, int y) { return 110 + x + y; }
+uint8_t VAt(int x, int y) { return 125 + x / 2 + y; }
+
+// Returns a kWidth x kHeight image of the given YUV format, wrapped in a
+// GpuBuffer like the output of a video decoder.
+Image MakeYuvImage(libyuv::FourCC fourcc) {
+  const int chroma_width = kWidth / 2;
+  const int chroma_height = kHeight / 2;
+  auto luma = std::make_unique<uint8_t[]>(kWidth * kHeight);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      luma[y * kWidth + x] = LumaAt(x, y);
+    }
+  }
+  std::unique_ptr<uint8_t[]> chroma[2];
+  int chroma_stride = 0;
+  int second_chroma_stride = 0;
+  if (fourcc == libyuv::FOURCC_YV12) {
+    // Separate V and U planes, in this order.
+    chroma_stride = chroma_width;
+    second_chroma_stride = chroma_width;
+    chroma[0] = std::make_unique<uint8_t[]>(chroma_width * chroma_height);
+    chroma[1] = std::make_unique<uint8_t[]>(chroma_width * chroma_height);
+    for (int y = 0; y < chroma_height; ++y) {
+      for (int x = 0; x < chroma_width; ++x) {
+        chroma[0][y * chroma_stride + x] = VAt(x, y);
+        chroma[1][y * chroma_stride + x] = UAt(x, y);
+      }
+    }
+  } else {
+    // One interleaved plane, UV for NV12 and VU for NV21.
+    chroma_stride = chroma_width * 2;
+    chroma[0] = std::make_unique<uint8_t[]>(chroma_stride * chroma_height);
+    const int u_index = fourcc == libyuv::FOURCC_NV12 ? 0 : 1;
+    for (int y = 0; y < chroma_height; ++y) {
+      for (int x = 0; x < chroma_width; ++x) {
+        chroma[0][y * chroma_stride + x * 2 + u_index] = UAt(x, y);
+        chroma[0][y * chroma_stride + x * 2 + 1 - u_index] = VAt(x, y);
+      }
+    }
+  }
+  auto yuv_image = std::make_shared<YUVImage>(
+      fourcc, std::move(luma), kWidth, std::move(chroma[0]), chroma_stride,
+      std::move(chroma[1]), second_chroma_stride, kWidth, kHeight);
+  return Image(GpuBuffer(
+      std::make_shared<GpuBufferStorageYuvImage>(std::move(yuv_image))));
+}
+
+// Returns the RGB conversion of a YUV image, as the FrameBuffer converter used
+// to do before it could sample the YUV planes.
+Image ToRgbImage(const Image& yuv_image) {
+  auto rgb_view = yuv_image.GetGpuBuffer(/*upload_to_gpu=*/false)
+                      .GetReadView<ImageFrame>();
+  auto frame = std::make_shared<ImageFrame>();
+  frame->CopyFrom(*rgb_view, ImageFrame::kDefaultAlignmentBoundary);
+  return Image(std::move(frame));
+}
+
+TEST(ImageToTensorConverterFrameBufferTest, DetectsYuvImages) {
+  for (const libyuv::FourCC fourcc :
+       {libyuv::FOURCC_NV12, libyuv::FOURCC_NV21, libyuv::FOURCC_YV12}) {
+    Image yuv_image = MakeYuvImage(fourcc);
+    EXPECT_TRUE(IsYuvImage(yuv_image));
+    EXPECT_EQ(GetNumOutputChannels(yuv_image), 3);
+    EXPECT_FALSE(IsYuvImage(ToRgbImage(yuv_image)));
+  }
+}
+
+TEST(ImageToTensorConverterFrameBufferTest, YuvConversionMatchesRgbPath) {
+  const RotatedRect rois[] = {
+      // The whole image.
+      {/*center_x=*/16, /*center_y=*/12, /*width=*/32, /*height=*/24,
+       /*rotation=*/0},
+      // Rotated.
+      {/*center_x=*/15, /*center_y=*/13, /*width=*/20, /*height=*/14,
+       /*rotation=*/0.7f},
+      {/*center_x=*/16, /*center_y=*/12, /*width=*/16, /*height=*/20,
+       /*rotation=*/static_cast<float>(M_PI / 2)},
+      // Partly out of bounds.
+      {/*center_x=*/28, /*center_y=*/4, /*width=*/24, /*height=*/16,
+       /*rotation=*/0},
+  };
+  for (const libyuv::FourCC fourcc :
+       {libyuv::FOURCC_NV12, libyuv::FOURCC_NV21, libyuv::FOURCC_YV12}) {
+    Image yuv_image = MakeYuvImage(fourcc);
+    Image rgb_image = ToRgbImage(yuv_image);
+    for (const Tensor::ElementType type :
+         {Tensor::ElementType::kUInt8, Tensor::ElementType::kFloat32}) {
+      const float range_max =
+          type == Tensor::ElementType::kUInt8 ? 255.0f : 1.0f;
+      MP_ASSERT_OK_AND_ASSIGN(
+          auto converter, CreateFrameBufferConverter(
+                              /*cc=*/nullptr, BorderMode::kReplicate, type));
+      MP_ASSERT_OK_AND_ASSIGN(
+          auto rgb_converter,
+          CreateFusedConverter(/*cc=*/nullptr, BorderMode::kReplicate, type));
+      for (const RotatedRect& roi : rois) {
+        Tensor tensor(type, {1, 12, 16, 3});
+        Tensor expected(type, {1, 12, 16, 3});
+        MP_ASSERT_OK(converter->Convert(yuv_image, roi, /*range_min=*/0.0f,
+                                        range_max, /*tensor_buffer_offset=*/0,
+                                        tensor));
+        MP_ASSERT_OK(rgb_converter->Convert(rgb_image, roi,
+                                            /*range_min=*/0.0f, range_max,
+                                            /*tensor_buffer_offset=*/0,
+                                            expected));
+        EXPECT_THAT(GetValues(tensor),
+                    testing::Pointwise(
+                        testing::FloatNear(4.0f * range_max / 255.0f),
+                        GetValues(expected)))
+            << "fourcc: " << fourcc << ", rotation: " << roi.rotation
+            << ", center: " << roi.center_x << "," << roi.center_y;
+      }
+    }
+  }
+}
+
+TEST(ImageToTensorConverterFrameBufferTest, WritesYuvConversionAtOffset) {
+  Image yuv_image = MakeYuvImage(libyuv::FOURCC_NV12);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto converter,
+      CreateFrameBufferConverter(/*cc=*/nullptr, BorderMode::kReplicate,
+                                 Tensor::ElementType::kFloat32));
+  const RotatedRect roi{/*center_x=*/15, /*center_y=*/13, /*width=*/20,
+                        /*height=*/14, /*rotation=*/0.7f};
+  Tensor single(Tensor::ElementType::kFloat32, {1, 12, 16, 3});
+  MP_ASSERT_OK(converter->Convert(yuv_image, roi, /*range_min=*/-1.0f,
+                                  /*range_max=*/1.0f,
+                                  /*tensor_buffer_offset=*/0, single));
+  Tensor batch(Tensor::ElementType::kFloat32, {2, 12, 16, 3});
+  MP_ASSERT_OK(converter->Convert(yuv_image, roi, /*range_min=*/-1.0f,
+                                  /*range_max=*/1.0f,
+                                  /*tensor_buffer_offset=*/single.bytes(),
+                                  batch));
+
+  const std::vector<float> expected = GetValues(single);
+  const std::vector<float> values = GetValues(batch);
+  EXPECT_EQ(std::vector<float>(values.begin() + expected.size(), values.end()),
+            expected);
+}
+
+TEST(ImageToTensorConverterFrameBufferTest, WritesRgbConversionAtOffset) {
+  Image rgb_image = ToRgbImage(MakeYuvImage(libyuv::FOURCC_NV12));
+  for (const Tensor::ElementType type :
+       {Tensor::ElementType::kUInt8, Tensor::ElementType::kFloat32}) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto converter, CreateFrameBufferConverter(
+                            /*cc=*/nullptr, BorderMode::kReplicate, type));
+    const RotatedRect roi{/*center_x=*/16, /*center_y=*/12, /*width=*/16,
+                          /*height=*/20,
+                          /*rotation=*/static_cast<float>(M_PI / 2)};
+    Tensor single(type, {1, 12, 16, 3});
+    MP_ASSERT_OK(converter->Convert(rgb_image, roi, /*range_min=*/0.0f,
+                                    /*range_max=*/255.0f,
+                                    /*tensor_buffer_offset=*/0, single));
+    Tensor batch(type, {2, 12, 16, 3});
+    MP_ASSERT_OK(converter->Convert(rgb_image, roi, /*range_min=*/0.0f,
+                                    /*range_max=*/255.0f,
+                                    /*tensor_buffer_offset=*/single.bytes(),
+                                    batch));
+
+    const std::vector<float> expected = GetValues(single);
+    const std::vector<float> values = GetValues(batch);
+    EXPECT_EQ(
+        std::vector<float>(values.begin() + expected.size(), values.end()),
+        expected);
+  }
+}
+
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
+}  // namespace
+}  // namespace mediapipe
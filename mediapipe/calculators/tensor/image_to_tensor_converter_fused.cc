@@ -0,0 +1,320 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_fused.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The width of the column blocks the output is converted in, see Convert.
+constexpr int kBlockWidth = 64;
+
+// The input pixels interpolated by each output pixel of a row: the byte offsets
+// of the top left, top right, bottom left and bottom right pixels and their
+// weights. The weights include the scale of the value range transformation.
+struct RowSamples {
+  std::vector<int32_t> offsets[4];
+  std::vector<float> weights[4];
+
+  void Resize(int width) {
+    for (int i = 0; i < 4; ++i) {
+      offsets[i].resize(width);
+      weights[i].resize(width);
+    }
+  }
+};
+
+// Computes the samples of the "width" output pixels of row "y" starting at
+// column "x_begin". Pixels outside of the image get
+// zero weights with kZero border mode, and are replaced by the nearest image
+// pixels with kReplicate border mode.
+//
+// The loop is branch-free so that it can be auto-vectorized.
+void ComputeRowSamples(const RoiTransform& transform, int x_begin, int y,
+                       int width, int image_width, int image_height,
+                       int row_step, int pixel_step, bool zero_border,
+                       float scale, RowSamples& samples) {
+  const float row_x = transform.origin_x + x_begin * transform.x_step_x +
+                      y * transform.y_step_x;
+  const float row_y = transform.origin_y + x_begin * transform.x_step_y +
+                      y * transform.y_step_y;
+  const float max_x = image_width - 1;
+  const float max_y = image_height - 1;
+  int32_t* offsets[4];
+  float* weights[4];
+  for (int i = 0; i < 4; ++i) {
+    offsets[i] = samples.offsets[i].data();
+    weights[i] = samples.weights[i].data();
+  }
+  for (int x = 0; x < width; ++x) {
+    const float src_x = row_x + x * transform.x_step_x;
+    const float src_y = row_y + x * transform.x_step_y;
+    const float left = std::floor(src_x);
+    const float top = std::floor(src_y);
+    float right_weight = src_x - left;
+    float bottom_weight = src_y - top;
+    float left_weight = 1.0f - right_weight;
+    float top_weight = 1.0f - bottom_weight;
+    if (zero_border) {
+      left_weight *= (left >= 0.0f && left <= max_x) ? 1.0f : 0.0f;
+      right_weight *= (left >= -1.0f && left < max_x) ? 1.0f : 0.0f;
+      top_weight *= (top >= 0.0f && top <= max_y) ? 1.0f : 0.0f;
+      bottom_weight *= (top >= -1.0f && top < max_y) ? 1.0f : 0.0f;
+    }
+    left_weight *= scale;
+    right_weight *= scale;
+    // Clamping in float keeps far out of bounds points from overflowing int.
+    const int32_t left_offset =
+        static_cast<int32_t>(std::clamp(left, 0.0f, max_x)) * pixel_step;
+    const int32_t right_offset =
+        static_cast<int32_t>(std::clamp(left + 1.0f, 0.0f, max_x)) *
+        pixel_step;
+    const int32_t top_offset =
+        static_cast<int32_t>(std::clamp(top, 0.0f, max_y)) * row_step;
+    const int32_t bottom_offset =
+        static_cast<int32_t>(std::clamp(top + 1.0f, 0.0f, max_y)) * row_step;
+    offsets[0][x] = top_offset + left_offset;
+    offsets[1][x] = top_offset + right_offset;
+    offsets[2][x] = bottom_offset + left_offset;
+    offsets[3][x] = bottom_offset + right_offset;
+    weights[0][x] = top_weight * left_weight;
+    weights[1][x] = top_weight * right_weight;
+    weights[2][x] = bottom_weight * left_weight;
+    weights[3][x] = bottom_weight * right_weight;
+  }
+}
+
+// Interpolates the first kChannels channels of the "width" samples of a row
+// and writes the normalized values to "output" in HWC order.
+template <int kChannels>
+void InterpolateRow(const uint8_t* pixels, const RowSamples& samples,
+                    int width, float offset, float* output) {
+  const int32_t* offsets0 = samples.offsets[0].data();
+  const int32_t* offsets1 = samples.offsets[1].data();
+  const int32_t* offsets2 = samples.offsets[2].data();
+  const int32_t* offsets3 = samples.offsets[3].data();
+  const float* weights0 = samples.weights[0].data();
+  const float* weights1 = samples.weights[1].data();
+  const float* weights2 = samples.weights[2].data();
+  const float* weights3 = samples.weights[3].data();
+  for (int x = 0; x < width; ++x) {
+    for (int c = 0; c < kChannels; ++c) {
+      output[x * kChannels + c] = weights0[x] * pixels[offsets0[x] + c] +
+                                  weights1[x] * pixels[offsets1[x] + c] +
+                                  weights2[x] * pixels[offsets2[x] + c] +
+                                  weights3[x] * pixels[offsets3[x] + c] +
+                                  offset;
+    }
+  }
+}
+
+// Converts a float to IEEE half precision, rounding to nearest even.
+inline uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000u;
+  bits &= 0x7fffffffu;
+  if (bits >= 0x47800000u) {
+    // Too large for half precision, infinity or NaN.
+    return sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u);
+  }
+  if (bits < 0x38800000u) {
+    // Subnormal in half precision: let the FPU round by adding 0.5f, which
+    // moves the mantissa bits into place.
+    float shifted;
+    std::memcpy(&shifted, &bits, sizeof(shifted));
+    shifted += 0.5f;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    return sign | (bits - 0x3f000000u);
+  }
+  // Rebias the exponent and round the mantissa to nearest even.
+  bits += 0xc8000fffu + ((bits >> 13) & 1u);
+  return sign | (bits >> 13);
+}
+
+template <typename T>
+void StoreRow(const float* values, int size, T* output);
+
+template <>
+void StoreRow<uint16_t>(const float* values, int size, uint16_t* output) {
+  for (int i = 0; i < size; ++i) {
+    output[i] = FloatToHalf(values[i]);
+  }
+}
+
+template <>
+void StoreRow<uint8_t>(const float* values, int size, uint8_t* output) {
+  for (int i = 0; i < size; ++i) {
+    output[i] = static_cast<uint8_t>(
+        std::floor(std::clamp(values[i], 0.0f, 255.0f) + 0.5f));
+  }
+}
+
+template <>
+void StoreRow<int8_t>(const float* values, int size, int8_t* output) {
+  for (int i = 0; i < size; ++i) {
+    output[i] = static_cast<int8_t>(
+        std::floor(std::clamp(values[i], -128.0f, 127.0f) + 0.5f));
+  }
+}
+
+class ImageToTensorFusedConverter : public ImageToTensorConverter {
+ public:
+  ImageToTensorFusedConverter(BorderMode border_mode,
+                              Tensor::ElementType tensor_type)
+      : border_mode_(border_mode), tensor_type_(tensor_type) {}
+
+  absl::Status Convert(const mediapipe::Image& input, const RotatedRect& roi,
+                       float range_min, float range_max,
+                       int tensor_buffer_offset,
+                       Tensor& output_tensor) override {
+    const ImageFormat::Format format = input.image_format();
+    if (format != ImageFormat::SRGB && format != ImageFormat::SRGBA &&
+        format != ImageFormat::GRAY8) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported format: ", static_cast<uint32_t>(format)));
+    }
+    RET_CHECK_GE(tensor_buffer_offset, 0)
+        << "The input tensor_buffer_offset needs to be non-negative.";
+    RET_CHECK(output_tensor.element_type() == tensor_type_)
+        << "Wrong output tensor type: "
+        << static_cast<int>(output_tensor.element_type());
+    const auto& output_shape = output_tensor.shape();
+    RET_CHECK_EQ(output_shape.dims.size(), 4)
+        << "Wrong output dims size: " << output_shape.dims.size();
+    RET_CHECK_GE(output_shape.dims[0], 1)
+        << "The batch dimension needs to be equal or larger than 1.";
+    const int output_height = output_shape.dims[1];
+    const int output_width = output_shape.dims[2];
+    const int output_channels = output_shape.dims[3];
+    RET_CHECK_EQ(output_channels, format == ImageFormat::GRAY8 ? 1 : 3)
+        << "Wrong output channel: " << output_channels;
+    const int element_size = output_tensor.element_size();
+    RET_CHECK_EQ(tensor_buffer_offset % element_size, 0)
+        << "The tensor_buffer_offset must be a multiple of the element size.";
+    const int row_size = output_width * output_channels;
+    RET_CHECK_GE(output_shape.num_elements(),
+                 tensor_buffer_offset / element_size + output_height * row_size)
+        << "The buffer offset + the input image size is larger than the "
+           "allocated tensor buffer.";
+
+    constexpr float kInputImageRangeMin = 0.0f;
+    constexpr float kInputImageRangeMax = 255.0f;
+    MP_ASSIGN_OR_RETURN(
+        auto value_transform,
+        GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
+                                    range_min, range_max));
+    const RoiTransform roi_transform =
+        GetRoiTransform(roi, output_width, output_height);
+
+    samples_.Resize(kBlockWidth);
+    if (tensor_type_ != Tensor::ElementType::kFloat32) {
+      block_values_.resize(kBlockWidth * output_channels);
+    }
+
+    PixelReadLock lock(input);
+    const uint8_t* pixels = lock.Pixels();
+    RET_CHECK(pixels) << "Failed to access the input image pixels.";
+    auto buffer_view = output_tensor.GetCpuWriteView();
+    uint8_t* output = buffer_view.buffer<uint8_t>() + tensor_buffer_offset;
+    // The output is converted in blocks of kBlockWidth columns, so that the
+    // input pixels sampled by consecutive rows of a block are still in the
+    // cache even if the ROI is large or rotated.
+    for (int x_begin = 0; x_begin < output_width; x_begin += kBlockWidth) {
+      const int width = std::min(kBlockWidth, output_width - x_begin);
+      const int size = width * output_channels;
+      for (int y = 0; y < output_height; ++y) {
+        ComputeRowSamples(roi_transform, x_begin, y, width, input.width(),
+                          input.height(), input.step(), input.channels(),
+                          border_mode_ == BorderMode::kZero,
+                          value_transform.scale, samples_);
+        uint8_t* block_output =
+            output + (y * row_size + x_begin * output_channels) * element_size;
+        // Float values are written in place, other types go through a block
+        // of floats which stays in the cache.
+        float* values = tensor_type_ == Tensor::ElementType::kFloat32
+                            ? reinterpret_cast<float*>(block_output)
+                            : block_values_.data();
+        if (output_channels == 1) {
+          InterpolateRow<1>(pixels, samples_, width, value_transform.offset,
+                            values);
+        } else {
+          InterpolateRow<3>(pixels, samples_, width, value_transform.offset,
+                            values);
+        }
+        switch (tensor_type_) {
+          case Tensor::ElementType::kFloat16:
+            StoreRow(values, size, reinterpret_cast<uint16_t*>(block_output));
+            break;
+          case Tensor::ElementType::kUInt8:
+            StoreRow(values, size, block_output);
+            break;
+          case Tensor::ElementType::kInt8:
+            StoreRow(values, size, reinterpret_cast<int8_t*>(block_output));
+            break;
+          default:
+            break;
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  BorderMode border_mode_;
+  Tensor::ElementType tensor_type_;
+  // Scratch buffers for one row of a block, reused across calls.
+  RowSamples samples_;
+  std::vector<float> block_values_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateFusedConverter(
+    CalculatorContext* cc, BorderMode border_mode,
+    Tensor::ElementType tensor_type) {
+  if (tensor_type != Tensor::ElementType::kFloat32 &&
+      tensor_type != Tensor::ElementType::kFloat16 &&
+      tensor_type != Tensor::ElementType::kUInt8 &&
+      tensor_type != Tensor::ElementType::kInt8) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Tensor type is currently not supported by "
+                     "ImageToTensorFusedConverter, type: ",
+                     tensor_type));
+  }
+  return std::make_unique<ImageToTensorFusedConverter>(border_mode,
+                                                       tensor_type);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,174 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_fused.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_opencv.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns an image with smooth gradients, so that the bilinear interpolation
+// of the fused and the OpenCV converters can be compared with a small
+// tolerance.
+Image MakeGradientImage(ImageFormat::Format format, int width, int height) {
+  auto frame = std::make_shared<ImageFrame>(format, width, height);
+  const int channels = frame->NumberOfChannels();
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        row[x * channels + c] = (x * 2 + y * 3 + c * 40) % 256;
+      }
+    }
+  }
+  return Image(std::move(frame));
+}
+
+// Converts half precision bits to float, for normal numbers and zero.
+float HalfToFloat(uint16_t half) {
+  const int exponent = (half >> 10) & 0x1f;
+  const float mantissa = (half & 0x3ff) / 1024.0f;
+  const float value =
+      exponent == 0 ? 0.0f : std::ldexp(1.0f + mantissa, exponent - 15);
+  return (half & 0x8000) ? -value : value;
+}
+
+TEST(ImageToTensorConverterFusedTest, CopiesPixelsWithIdentityRoi) {
+  Image image = MakeGradientImage(ImageFormat::SRGB, 8, 6);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto converter,
+      CreateFusedConverter(/*cc=*/nullptr, BorderMode::kReplicate,
+                           Tensor::ElementType::kFloat32));
+  Tensor tensor(Tensor::ElementType::kFloat32, {1, 6, 8, 3});
+  const RotatedRect roi{/*center_x=*/4, /*center_y=*/3, /*width=*/8,
+                        /*height=*/6, /*rotation=*/0};
+  MP_ASSERT_OK(converter->Convert(image, roi, /*range_min=*/0.0f,
+                                  /*range_max=*/1.0f,
+                                  /*tensor_buffer_offset=*/0, tensor));
+
+  auto view = tensor.GetCpuReadView();
+  const float* values = view.buffer<float>();
+  PixelReadLock lock(image);
+  for (int y = 0; y < 6; ++y) {
+    for (int x = 0; x < 8; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        const uint8_t pixel = lock.Pixels()[y * image.step() + x * 3 + c];
+        EXPECT_FLOAT_EQ(values[(y * 8 + x) * 3 + c], pixel / 255.0f);
+      }
+    }
+  }
+}
+
+TEST(ImageToTensorConverterFusedTest, MatchesOpenCvConverter) {
+  Image image = MakeGradientImage(ImageFormat::SRGBA, 64, 48);
+  const RotatedRect roi{/*center_x=*/30, /*center_y=*/20, /*width=*/50,
+                        /*height=*/40, /*rotation=*/0.5f};
+  for (BorderMode border_mode : {BorderMode::kZero, BorderMode::kReplicate}) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto fused_converter,
+        CreateFusedConverter(/*cc=*/nullptr, border_mode,
+                             Tensor::ElementType::kUInt8));
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto opencv_converter,
+        CreateOpenCvConverter(/*cc=*/nullptr, border_mode,
+                              Tensor::ElementType::kUInt8));
+    Tensor fused(Tensor::ElementType::kUInt8, {1, 20, 24, 3});
+    Tensor expected(Tensor::ElementType::kUInt8, {1, 20, 24, 3});
+    MP_ASSERT_OK(fused_converter->Convert(image, roi, /*range_min=*/0.0f,
+                                          /*range_max=*/255.0f,
+                                          /*tensor_buffer_offset=*/0, fused));
+    MP_ASSERT_OK(opencv_converter->Convert(
+        image, roi, /*range_min=*/0.0f, /*range_max=*/255.0f,
+        /*tensor_buffer_offset=*/0, expected));
+
+    auto fused_view = fused.GetCpuReadView();
+    auto expected_view = expected.GetCpuReadView();
+    for (int i = 0; i < fused.shape().num_elements(); ++i) {
+      EXPECT_NEAR(fused_view.buffer<uint8_t>()[i],
+                  expected_view.buffer<uint8_t>()[i], 2)
+          << "at element " << i;
+    }
+  }
+}
+
+TEST(ImageToTensorConverterFusedTest, WritesZeroBorderAsRangeMin) {
+  Image image = MakeGradientImage(ImageFormat::GRAY8, 4, 4);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto converter, CreateFusedConverter(/*cc=*/nullptr, BorderMode::kZero,
+                                           Tensor::ElementType::kInt8));
+  Tensor tensor(Tensor::ElementType::kInt8, {1, 4, 4, 1});
+  // The ROI is entirely right of the image.
+  const RotatedRect roi{/*center_x=*/12, /*center_y=*/2, /*width=*/4,
+                        /*height=*/4, /*rotation=*/0};
+  MP_ASSERT_OK(converter->Convert(image, roi, /*range_min=*/-128.0f,
+                                  /*range_max=*/127.0f,
+                                  /*tensor_buffer_offset=*/0, tensor));
+
+  auto view = tensor.GetCpuReadView();
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(view.buffer<int8_t>()[i], -128);
+  }
+}
+
+TEST(ImageToTensorConverterFusedTest, WritesFloat16AtOffset) {
+  Image image = MakeGradientImage(ImageFormat::SRGB, 4, 2);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto converter,
+      CreateFusedConverter(/*cc=*/nullptr, BorderMode::kReplicate,
+                           Tensor::ElementType::kFloat16));
+  // The second image of a batch of two.
+  Tensor tensor(Tensor::ElementType::kFloat16, {2, 2, 4, 3});
+  const int image_size = 2 * 4 * 3;
+  const RotatedRect roi{/*center_x=*/2, /*center_y=*/1, /*width=*/4,
+                        /*height=*/2, /*rotation=*/0};
+  MP_ASSERT_OK(converter->Convert(
+      image, roi, /*range_min=*/-1.0f, /*range_max=*/1.0f,
+      /*tensor_buffer_offset=*/image_size * sizeof(uint16_t), tensor));
+
+  auto view = tensor.GetCpuReadView();
+  const uint16_t* values = view.buffer<uint16_t>() + image_size;
+  PixelReadLock lock(image);
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        const uint8_t pixel = lock.Pixels()[y * image.step() + x * 3 + c];
+        EXPECT_NEAR(HalfToFloat(values[(y * 4 + x) * 3 + c]),
+                    pixel / 127.5f - 1.0f, 1e-3f);
+      }
+    }
+  }
+}
+
+TEST(ImageToTensorConverterFusedTest, RejectsUnsupportedTensorType) {
+  EXPECT_FALSE(CreateFusedConverter(/*cc=*/nullptr, BorderMode::kZero,
+                                    Tensor::ElementType::kInt32)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -28,6 +28,7 @@
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/gpu/gpu_buffer_format.h"
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gpu_buffer.h"
 #endif  // !MEDIAPIPE_DISABLE_GPU
@@ -100,6 +101,23 @@ absl::StatusOr<ValueTransformation> GetValueRangeTransformation(
   return ValueTransformation{scale, offset};
 }
 
+RoiTransform GetRoiTransform(const RotatedRect& roi, int output_width,
+                             int output_height) {
+  const float cos_r = std::cos(roi.rotation);
+  const float sin_r = std::sin(roi.rotation);
+  RoiTransform transform;
+  transform.x_step_x = roi.width * cos_r / output_width;
+  transform.x_step_y = roi.width * sin_r / output_width;
+  transform.y_step_x = -roi.height * sin_r / output_height;
+  transform.y_step_y = roi.height * cos_r / output_height;
+  // The top left corner of the ROI.
+  transform.origin_x =
+      roi.center_x - 0.5f * (roi.width * cos_r - roi.height * sin_r);
+  transform.origin_y =
+      roi.center_y - 0.5f * (roi.width * sin_r + roi.height * cos_r);
+  return transform;
+}
+
 void GetRotatedSubRectToRectTransformMatrix(const RotatedRect& sub_rect,
                                             int rect_width, int rect_height,
                                             bool flip_horizontally,
@@ -256,6 +274,10 @@ Tensor::ElementType GetOutputTensorType(bool uses_gpu,
 }
 
 int GetNumOutputChannels(const mediapipe::Image& image) {
+  // YUV images are converted to RGB.
+  if (IsYuvImage(image)) {
+    return 3;
+  }
 #if !MEDIAPIPE_DISABLE_GPU
 #if MEDIAPIPE_METAL_ENABLED
   if (image.UsesGpu()) {
@@ -274,6 +296,18 @@ int GetNumOutputChannels(const mediapipe::Image& image) {
   return 3;
 }
 
+bool IsYuvImage(const mediapipe::Image& image) {
+  switch (image.format()) {
+    case GpuBufferFormat::kNV12:
+    case GpuBufferFormat::kNV21:
+    case GpuBufferFormat::kI420:
+    case GpuBufferFormat::kYV12:
+      return true;
+    default:
+      return false;
+  }
+}
+
 absl::StatusOr<std::shared_ptr<const mediapipe::Image>> GetInputImage(
     const api2::Packet<api2::OneOf<Image, mediapipe::ImageFrame>>&
         image_packet) {
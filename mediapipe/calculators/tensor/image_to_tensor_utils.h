@@ -88,6 +88,24 @@ absl::StatusOr<ValueTransformation> GetValueRangeTransformation(
     float from_range_min, float from_range_max, float to_range_min,
     float to_range_max);
 
+// Maps the output pixel (x, y) of a CPU converter to the input image point
+//   (origin_x + x * x_step_x + y * y_step_x,
+//    origin_y + x * x_step_y + y * y_step_y).
+// The output corners map to the ROI corners like in the OpenCV converter.
+struct RoiTransform {
+  float origin_x;
+  float origin_y;
+  float x_step_x;
+  float x_step_y;
+  float y_step_x;
+  float y_step_y;
+};
+
+// Returns the transform that maps an output of output_width x output_height
+// pixels to the ROI.
+RoiTransform GetRoiTransform(const RotatedRect& roi, int output_width,
+                             int output_height);
+
 // Populates 4x4 "matrix" with row major order transformation matrix which
 // maps (x, y) in range [0, 1] (describing points of @sub_rect)
 // to (x', y') in range [0, 1]*** (describing points of a rect:
@@ -212,6 +230,11 @@ Tensor::ElementType GetOutputTensorType(bool uses_gpu,
 // Gets the number of output channels from the input Image format.
 int GetNumOutputChannels(const mediapipe::Image& image);
 
+// Returns true if the image holds YUV 4:2:0 planes in CPU memory, such as
+// decoder output wrapped in a GpuBufferStorageYuvImage. These images are
+// converted on CPU even though Image::UsesGpu() returns true for them.
+bool IsYuvImage(const mediapipe::Image& image);
+
 // Converts the packet that hosts different format (Image, ImageFrame,
 // GpuBuffer) into the mediapipe::Image format.
 absl::StatusOr<std::shared_ptr<const mediapipe::Image>> GetInputImage(
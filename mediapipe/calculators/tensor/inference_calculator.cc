@@ -14,6 +14,7 @@
 
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -142,5 +143,40 @@ void InferenceCalculator::WarnFeedbackTensorsUnsupported(
   }
 }
 
+std::string InferenceCalculator::GetSharedModelKey(CalculatorContext* cc) {
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  if (!options.input_output_config().feedback_tensor_links().empty() ||
+      options.delegate().xnnpack().enable_zero_copy_tensor_io()) {
+    return "";
+  }
+  // Models and op resolvers passed as side packets are identified by address,
+  // which cannot be reused while the shared interpreters hold them.
+  std::string key = absl::StrCat(cc->CalculatorType(), "|");
+  if (!options.model_path().empty()) {
+    absl::StrAppend(&key, "path:", options.model_path());
+  } else if (!kSideInModel(cc).IsEmpty()) {
+    absl::StrAppend(&key, "model:",
+                    absl::Hex(reinterpret_cast<uintptr_t>(
+                        kSideInModel(cc).Get().get())));
+  } else {
+    return "";
+  }
+  if (!kSideInOpResolver(cc).IsEmpty()) {
+    absl::StrAppend(&key, "|op_resolver:",
+                    absl::Hex(reinterpret_cast<uintptr_t>(
+                        &kSideInOpResolver(cc).Get())));
+  } else if (!kSideInCustomOpResolver(cc).IsEmpty()) {
+    absl::StrAppend(&key, "|op_resolver:",
+                    absl::Hex(reinterpret_cast<uintptr_t>(
+                        &kSideInCustomOpResolver(cc).Get())));
+  }
+  mediapipe::InferenceCalculatorOptions::Delegate delegate =
+      options.delegate();
+  if (!kDelegate(cc).IsEmpty()) delegate.MergeFrom(kDelegate(cc).Get());
+  absl::StrAppend(&key, "|threads:", options.cpu_num_thread(), "|",
+                  delegate.SerializeAsString());
+  return key;
+}
+
 }  // namespace api2
 }  // namespace mediapipe
@@ -24,6 +24,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/calculators/tensor/inference_io_mapper.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
@@ -160,6 +161,12 @@ class InferenceCalculator : public NodeIntf {
 
   // Checks if feedback tensor support is available and warns otherwise.
   static void WarnFeedbackTensorsUnsupported(CalculatorContract* cc);
+
+  // Returns the key under which the interpreters of this calculator can be
+  // shared with other graphs through kSharedInferenceService, or an empty
+  // string if they must not be shared, e.g. because they keep state between
+  // invocations.
+  static std::string GetSharedModelKey(CalculatorContext* cc);
 };
 
 struct InferenceCalculatorSelector : public InferenceCalculator {
@@ -195,6 +202,9 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
 
   // Override Process to handle common Tensor I/O functionality.
   absl::Status Process(CalculatorContext* cc) final {
+    if (cc->BatchSize() > 1) {
+      return ProcessInputBatch(cc);
+    }
     if (InferenceCalculator::kInTensors(cc).IsConnected()) {
       // Using old vector<Tensor> inputs; skip if empty input stream, but error
       // if the input vector is empty.
@@ -236,7 +246,93 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
   virtual absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) = 0;
 
+  // Process call providing the TensorSpan inputs of several timestamps, when
+  // the subclass sets a max batch size in its contract (see
+  // InferenceCalculatorOptions.max_batch_size). By default, Process is called
+  // for each TensorSpan.
+  virtual absl::StatusOr<std::vector<std::vector<Tensor>>> ProcessBatch(
+      CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(tensor_spans.size());
+    for (const TensorSpan& tensor_span : tensor_spans) {
+      MP_ASSIGN_OR_RETURN(std::vector<Tensor> output_tensors,
+                          Process(cc, tensor_span));
+      outputs.push_back(std::move(output_tensors));
+    }
+    return outputs;
+  }
+
+  // Applies InferenceCalculatorOptions.max_batch_size to the contract. To be
+  // called from the UpdateContract of subclasses that override ProcessBatch.
+  static absl::Status SetMaxBatchSizeFromOptions(CalculatorContract* cc) {
+    const int max_batch_size =
+        cc->Options<mediapipe::InferenceCalculatorOptions>().max_batch_size();
+    RET_CHECK_GE(max_batch_size, 1);
+    cc->SetMaxBatchSize(max_batch_size);
+    return absl::OkStatus();
+  }
+
  private:
+  // Runs inference on all the input sets of a batch at once, and sends the
+  // outputs of each input set at its own timestamp. Input sets with an empty
+  // input packet are skipped, as in Process.
+  absl::Status ProcessInputBatch(CalculatorContext* cc) {
+    RET_CHECK(io_mapper_ != nullptr)
+        << "IO mapper is not initialized. MaybeUpdateIoMapping must be called "
+           "prior to Process.";
+    const bool use_vector_input =
+        InferenceCalculator::kInTensors(cc).IsConnected();
+    const int num_streams = InferenceCalculator::kInTensor(cc).Count();
+    // Holds the input packets, which own the tensors referenced by the spans.
+    std::vector<Packet<std::vector<Tensor>>> vector_packets;
+    std::vector<Packet<Tensor>> tensor_packets;
+    std::vector<Timestamp> timestamps;
+    std::vector<TensorSpan> tensor_spans;
+    for (int b = 0; b < cc->BatchSize(); ++b) {
+      std::vector<const Tensor*> tensor_refs;
+      if (use_vector_input) {
+        auto packet = InferenceCalculator::kInTensors(cc).InBatch(b);
+        if (packet.IsEmpty()) continue;
+        RET_CHECK(!packet.Get().empty());
+        for (const Tensor& tensor : packet.Get()) {
+          tensor_refs.push_back(&tensor);
+        }
+        vector_packets.push_back(std::move(packet));
+      } else {
+        bool has_empty_input = false;
+        for (int i = 0; i < num_streams; ++i) {
+          auto packet = InferenceCalculator::kInTensor(cc)[i].InBatch(b);
+          if (packet.IsEmpty()) {
+            has_empty_input = true;
+            break;
+          }
+          tensor_refs.push_back(&packet.Get());
+          tensor_packets.push_back(std::move(packet));
+        }
+        if (has_empty_input) continue;
+      }
+      MP_ASSIGN_OR_RETURN(
+          TensorSpan remapped_tensors,
+          io_mapper_->RemapInputTensors(TensorSpan(std::move(tensor_refs))));
+      tensor_spans.push_back(std::move(remapped_tensors));
+      timestamps.push_back(cc->InputTimestampInBatch(b));
+    }
+    if (tensor_spans.empty()) {
+      return absl::OkStatus();
+    }
+    MP_ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                        ProcessBatch(cc, tensor_spans));
+    RET_CHECK_EQ(outputs.size(), timestamps.size());
+    for (int i = 0; i < outputs.size(); ++i) {
+      MP_ASSIGN_OR_RETURN(
+          std::vector<Tensor> output_tensors,
+          io_mapper_->RemapOutputTensors(std::move(outputs[i])));
+      MP_RETURN_IF_ERROR(
+          SendOutputTensors(cc, std::move(output_tensors), timestamps[i]));
+    }
+    return absl::OkStatus();
+  }
+
   // Remaps input tensors according to the IO map, runs inference, and remaps
   // output tensors.
   absl::StatusOr<std::vector<Tensor>> RemapAndProcessTensors(
@@ -256,15 +352,23 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
   // ensure we can destroy/move the tensors.
   static absl::Status SendOutputTensors(CalculatorContext* cc,
                                         std::vector<Tensor>&& output_tensors) {
+    return SendOutputTensors(cc, std::move(output_tensors),
+                             cc->InputTimestamp());
+  }
+
+  static absl::Status SendOutputTensors(CalculatorContext* cc,
+                                        std::vector<Tensor>&& output_tensors,
+                                        Timestamp timestamp) {
     if (InferenceCalculator::kOutTensors(cc).IsConnected()) {
-      InferenceCalculator::kOutTensors(cc).Send(std::move(output_tensors));
+      InferenceCalculator::kOutTensors(cc).Send(std::move(output_tensors),
+                                                timestamp);
     } else {
       const int output_count =
           std::min(InferenceCalculator::kOutTensor(cc).Count(),
                    static_cast<int>(output_tensors.size()));
       for (int i = 0; i < output_count; ++i) {
         InferenceCalculator::kOutTensor(cc)[i].Send(
-            std::move(output_tensors[i]));
+            std::move(output_tensors[i]), timestamp);
       }
     }
     return absl::OkStatus();
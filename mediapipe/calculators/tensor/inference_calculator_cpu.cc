@@ -21,13 +21,16 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/shared_inference_service.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #if defined(MEDIAPIPE_ANDROID)
@@ -50,9 +53,14 @@ class InferenceCalculatorCpuImpl
  private:
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
+  absl::StatusOr<std::unique_ptr<InferenceRunner>>
+  CreateInterpreterDelegateRunner(CalculatorContext* cc);
   absl::StatusOr<TfLiteDelegatePtr> MaybeCreateDelegate(CalculatorContext* cc);
   absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
+  absl::StatusOr<std::vector<std::vector<Tensor>>> ProcessBatch(
+      CalculatorContext* cc,
+      absl::Span<const TensorSpan> tensor_spans) override;
   std::unique_ptr<InferenceRunner> inference_runner_;
 };
 
@@ -64,6 +72,10 @@ absl::Status InferenceCalculatorCpuImpl::UpdateContract(
 
   MP_RETURN_IF_ERROR(TensorContractCheck(cc));
 
+  MP_RETURN_IF_ERROR(SetMaxBatchSizeFromOptions(cc));
+  cc->UseService(kSharedInferenceService).Optional();
+  cc->UseService(kMemoryManagerService).Optional();
+
   return absl::OkStatus();
 }
 
@@ -80,6 +92,12 @@ absl::StatusOr<std::vector<Tensor>> InferenceCalculatorCpuImpl::Process(
   return output_tensors;
 }
 
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceCalculatorCpuImpl::ProcessBatch(
+    CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+  return inference_runner_->RunBatch(cc, tensor_spans);
+}
+
 absl::Status InferenceCalculatorCpuImpl::Close(CalculatorContext* cc) {
   inference_runner_ = nullptr;
   return absl::OkStatus();
@@ -87,6 +105,21 @@ absl::Status InferenceCalculatorCpuImpl::Close(CalculatorContext* cc) {
 
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorCpuImpl::CreateInferenceRunner(CalculatorContext* cc) {
+  auto shared_inference = cc->Service(kSharedInferenceService);
+  if (shared_inference.IsAvailable()) {
+    const std::string model_key = GetSharedModelKey(cc);
+    if (!model_key.empty()) {
+      return shared_inference.GetObject().GetRunner(model_key, [this, cc]() {
+        return CreateInterpreterDelegateRunner(cc);
+      });
+    }
+  }
+  return CreateInterpreterDelegateRunner(cc);
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+InferenceCalculatorCpuImpl::CreateInterpreterDelegateRunner(
+    CalculatorContext* cc) {
   MP_ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
   MP_ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
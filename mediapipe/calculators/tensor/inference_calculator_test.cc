@@ -20,6 +20,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/calculators/tensor/inference_calculator_test_base.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -31,6 +32,8 @@
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"  // NOLINT
+#include "mediapipe/framework/profiler/graph_tracer.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
 #include "mediapipe/framework/tool/validate_type.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -259,6 +262,68 @@ TEST(InferenceCalculatorTest, SmokeTestTfliteWithTensorAlignment) {
       /*use_vectors=*/true, /*apply_default_tflite_tensor_alignment=*/true);
 }
 
+// Runs the add model on several queued timestamps at once.
+void DoBatchingTest(const std::string& delegate) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrCat(
+          // Runs nothing until WaitUntilIdle, so that all packets are queued.
+          R"(executor { type: "ApplicationThreadExecutor" })",
+          // Traces the interpreter invocations.
+          R"(profiler_config { trace_enabled: true trace_log_disabled: true })",
+          absl::StrReplaceAll(
+              kGraphWithModelPathInOption,
+              {{"$delegate", absl::StrCat(delegate, " max_batch_size: 4")},
+               {"$mmap", "false"}})));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  constexpr int kNumPackets = 10;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(
+            CreateInputs(/*apply_default_tflite_tensor_alignment=*/false))
+            .At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  // The queued timestamps are run in batches of 4, 4 and 2, each with one
+  // interpreter invocation.
+  int num_invocations = 0;
+  for (const TraceEvent& event : graph.profiler()->tracer()->GetTraceEvents(
+           absl::InfinitePast(), absl::InfiniteFuture())) {
+    if (event.event_type == GraphTrace::CPU_TASK_INVOKE && !event.is_finish) {
+      ++num_invocations;
+    }
+  }
+  EXPECT_EQ(num_invocations, 3);
+
+  ASSERT_EQ(output_packets.size(), kNumPackets);
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+    const auto& result_vec = output_packets[i].Get<std::vector<Tensor>>();
+    ASSERT_EQ(result_vec.size(), 1);
+    EXPECT_EQ(result_vec[0].shape().dims,
+              std::vector<int>({1, kTensorHeight, kTensorWidth,
+                                kTensorChannels}));
+    auto view = result_vec[0].GetCpuReadView();
+    auto result_buffer = view.buffer<float>();
+    for (int j = 0; j < result_vec[0].shape().num_elements(); ++j) {
+      ASSERT_EQ(3, result_buffer[j]);
+    }
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(InferenceCalculatorTest, BatchingTflite) {
+  DoBatchingTest("delegate { tflite {} }");
+}
+TEST(InferenceCalculatorTest, BatchingXnnpack) {
+  DoBatchingTest("delegate { xnnpack {} }");
+}
+
 void BM_InitializeCalculator(benchmark::State& state) {
   mediapipe::InferenceCalculatorOptions::Delegate delegate;
   delegate.mutable_tflite();
@@ -20,13 +20,16 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/shared_inference_service.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
@@ -46,8 +49,13 @@ class InferenceCalculatorXnnpackImpl
  private:
   absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
+  absl::StatusOr<std::vector<std::vector<Tensor>>> ProcessBatch(
+      CalculatorContext* cc,
+      absl::Span<const TensorSpan> tensor_spans) override;
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
+  absl::StatusOr<std::unique_ptr<InferenceRunner>>
+  CreateInterpreterDelegateRunner(CalculatorContext* cc);
   absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(CalculatorContext* cc);
 
   std::unique_ptr<InferenceRunner> inference_runner_;
@@ -61,6 +69,10 @@ absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
 
+  MP_RETURN_IF_ERROR(SetMaxBatchSizeFromOptions(cc));
+  cc->UseService(kSharedInferenceService).Optional();
+  cc->UseService(kMemoryManagerService).Optional();
+
   return absl::OkStatus();
 }
 
@@ -77,6 +89,12 @@ absl::StatusOr<std::vector<Tensor>> InferenceCalculatorXnnpackImpl::Process(
   return output_tensors;
 }
 
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceCalculatorXnnpackImpl::ProcessBatch(
+    CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+  return inference_runner_->RunBatch(cc, tensor_spans);
+}
+
 absl::Status InferenceCalculatorXnnpackImpl::Close(CalculatorContext* cc) {
   inference_runner_ = nullptr;
   return absl::OkStatus();
@@ -84,6 +102,21 @@ absl::Status InferenceCalculatorXnnpackImpl::Close(CalculatorContext* cc) {
 
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorXnnpackImpl::CreateInferenceRunner(CalculatorContext* cc) {
+  auto shared_inference = cc->Service(kSharedInferenceService);
+  if (shared_inference.IsAvailable()) {
+    const std::string model_key = GetSharedModelKey(cc);
+    if (!model_key.empty()) {
+      return shared_inference.GetObject().GetRunner(model_key, [this, cc]() {
+        return CreateInterpreterDelegateRunner(cc);
+      });
+    }
+  }
+  return CreateInterpreterDelegateRunner(cc);
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+InferenceCalculatorXnnpackImpl::CreateInterpreterDelegateRunner(
+    CalculatorContext* cc) {
   MP_ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
   MP_ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
   const auto& calculator_opts =
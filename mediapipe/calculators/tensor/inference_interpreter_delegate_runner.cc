@@ -21,9 +21,11 @@
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_feedback_manager.h"
 #include "mediapipe/calculators/tensor/inference_io_mapper.h"
@@ -33,6 +35,8 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/c/c_api_types.h"
@@ -107,46 +111,59 @@ absl::Status VerifyModelTensorsForCustomAllocation(
   return absl::OkStatus();
 }
 
+// Returns the graph's MemoryManager, if available to the calculator.
+MemoryManager* GetMemoryManager(CalculatorContext* cc) {
+  if (cc == nullptr) {
+    return nullptr;
+  }
+  auto memory_manager_service = cc->Service(kMemoryManagerService);
+  return memory_manager_service.IsAvailable()
+             ? &memory_manager_service.GetObject()
+             : nullptr;
+}
+
+// Allocates a tensor for the output at tensor_index. If batch_size is greater
+// than 1, the tensor holds a single entry of the batch.
 absl::StatusOr<Tensor> AllocateOutputTensor(const int tensor_index,
-                                            const Interpreter& interpreter) {
+                                            const Interpreter& interpreter,
+                                            MemoryManager* memory_manager,
+                                            int batch_size = 1) {
   const TfLiteTensor* tensor = interpreter.tensor(tensor_index);
   Tensor::Shape shape{std::vector<int>{
       tensor->dims->data, tensor->dims->data + tensor->dims->size}};
+  if (batch_size > 1) {
+    shape.dims[0] /= batch_size;
+  }
   switch (tensor->type) {
     case TfLiteType::kTfLiteFloat16:
     case TfLiteType::kTfLiteFloat32:
       return Tensor(Tensor::ElementType::kFloat32, shape,
                     Tensor::QuantizationParameters{tensor->params.scale,
                                                    tensor->params.zero_point},
-                    /*memory_manager=*/nullptr,
-                    tflite::kDefaultTensorAlignment);
+                    memory_manager, tflite::kDefaultTensorAlignment);
       break;
     case TfLiteType::kTfLiteUInt8:
       return Tensor(Tensor::ElementType::kUInt8, shape,
                     Tensor::QuantizationParameters{tensor->params.scale,
                                                    tensor->params.zero_point},
-                    /*memory_manager=*/nullptr,
-                    tflite::kDefaultTensorAlignment);
+                    memory_manager, tflite::kDefaultTensorAlignment);
       break;
     case TfLiteType::kTfLiteInt8:
       return Tensor(Tensor::ElementType::kInt8, shape,
                     Tensor::QuantizationParameters{tensor->params.scale,
                                                    tensor->params.zero_point},
-                    /*memory_manager=*/nullptr,
-                    tflite::kDefaultTensorAlignment);
+                    memory_manager, tflite::kDefaultTensorAlignment);
       break;
     case TfLiteType::kTfLiteInt32:
       return Tensor(Tensor::ElementType::kInt32, shape,
                     Tensor::QuantizationParameters{tensor->params.scale,
                                                    tensor->params.zero_point},
-                    /*memory_manager=*/nullptr,
-                    tflite::kDefaultTensorAlignment);
+                    memory_manager, tflite::kDefaultTensorAlignment);
       break;
     case TfLiteType::kTfLiteBool:
       return Tensor(Tensor::ElementType::kBool, shape,
                     Tensor::QuantizationParameters{1.0f, 0},
-                    /*memory_manager=*/nullptr,
-                    tflite::kDefaultTensorAlignment);
+                    memory_manager, tflite::kDefaultTensorAlignment);
       break;
     case TfLiteType::kTfLiteString:
       // No current use-case for copying TfLiteTensors with string type to
@@ -241,19 +258,43 @@ absl::Status CopyTensorFromInterpreter(Interpreter* interpreter,
 
 absl::StatusOr<std::vector<Tensor>> AllocateOutputTensors(
     const std::vector<int>& model_output_indexes,
-    const Interpreter& interpreter) {
+    const Interpreter& interpreter, MemoryManager* memory_manager) {
   std::vector<Tensor> output_tensors;
   output_tensors.reserve(model_output_indexes.size());
   for (int i = 0; i < model_output_indexes.size(); ++i) {
     MP_ASSIGN_OR_RETURN(
         Tensor output_tensor,
         AllocateOutputTensor(interpreter.outputs()[model_output_indexes[i]],
-                             interpreter));
+                             interpreter, memory_manager));
     output_tensors.push_back(std::move(output_tensor));
   }
   return output_tensors;
 }
 
+// Returns true if the first dimension of every tensor is 1 and every tensor
+// has the same byte size in the interpreter and in a MediaPipe Tensor, so
+// that several sets of inputs can be stacked along the first dimension.
+bool HasBatchDimension(const Interpreter& interpreter,
+                       const std::vector<int>& tensor_indices) {
+  for (const int tensor_index : tensor_indices) {
+    const TfLiteTensor* tensor = interpreter.tensor(tensor_index);
+    if (tensor->dims->size == 0 || tensor->dims->data[0] != 1) {
+      return false;
+    }
+    switch (tensor->type) {
+      case TfLiteType::kTfLiteFloat32:
+      case TfLiteType::kTfLiteUInt8:
+      case TfLiteType::kTfLiteInt8:
+      case TfLiteType::kTfLiteInt32:
+      case TfLiteType::kTfLiteBool:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 class InferenceInterpreterDelegateRunner : public InferenceRunner {
@@ -269,11 +310,28 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
         delegate_(std::move(delegate)),
         input_output_tensor_names_(std::move(input_output_tensor_names)),
         feedback_manager_(std::move(feedback_manager)),
-        enable_zero_copy_tensor_io_(enable_zero_copy_tensor_io) {}
+        enable_zero_copy_tensor_io_(enable_zero_copy_tensor_io) {
+    supports_batching_ =
+        !enable_zero_copy_tensor_io_ &&
+        (!feedback_manager_ ||
+         feedback_manager_->GetNumberOfFeedbackTensors() == 0) &&
+        HasBatchDimension(*interpreter_, interpreter_->inputs()) &&
+        HasBatchDimension(*interpreter_, interpreter_->outputs());
+    if (supports_batching_) {
+      for (const int tensor_index : interpreter_->inputs()) {
+        const TfLiteIntArray* dims = interpreter_->tensor(tensor_index)->dims;
+        unbatched_input_dims_.emplace_back(dims->data, dims->data + dims->size);
+      }
+    }
+  }
 
   absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
 
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      absl::Span<const TensorSpan> tensor_spans) override;
+
   const InputOutputTensorNames& GetInputOutputTensorNames() const override {
     return input_output_tensor_names_;
   }
@@ -285,8 +343,124 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
   InputOutputTensorNames input_output_tensor_names_;
   std::unique_ptr<InferenceFeedbackManager> feedback_manager_;
   bool enable_zero_copy_tensor_io_ = false;
+
+  // Invokes the interpreter, profiled as part of "cc" unless it is null.
+  absl::Status Invoke(CalculatorContext* cc);
+
+  // Resizes the first dimension of all model inputs to batch_size.
+  absl::Status ResizeBatch(int batch_size);
+
+  // Returns the batch dimension to run batch_size stacked input sets with, or
+  // 1 if they cannot be stacked. Batches are rounded up to a power of two and
+  // padded, and the current batch dimension is kept while it is at most twice
+  // batch_size, so that batches of varying sizes, and single input sets run
+  // after a small batch, do not reallocate the interpreter tensors.
+  int GetBatchBucket(int batch_size) const;
+
+  // Returns true if the input sets can be stacked along the batch dimension.
+  bool CanStack(absl::Span<const TensorSpan> tensor_spans) const;
+
+  // Resizes the batch dimension to bucket, and checks that the outputs follow.
+  // Returns false, and stops batching, if they don't.
+  absl::StatusOr<bool> ResizeBatchForStacking(int bucket);
+
+  // Runs the input sets stacked along the current batch dimension, which must
+  // be at least their number. The remaining entries are zeroed.
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunStacked(
+      CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans);
+
+  // True while the model may be run on stacked inputs. Cleared if resizing
+  // the batch dimension fails or does not resize the outputs.
+  bool supports_batching_ = false;
+  // Input shapes of the model as loaded, with a batch dimension of 1.
+  std::vector<std::vector<int>> unbatched_input_dims_;
+  // The current size of the batch dimension of the interpreter tensors.
+  int interpreter_batch_size_ = 1;
 };
 
+absl::Status InferenceInterpreterDelegateRunner::ResizeBatch(int batch_size) {
+  if (batch_size == interpreter_batch_size_) {
+    return absl::OkStatus();
+  }
+  for (int i = 0; i < interpreter_->inputs().size(); ++i) {
+    std::vector<int> dims = unbatched_input_dims_[i];
+    dims[0] = batch_size;
+    RET_CHECK_EQ(
+        interpreter_->ResizeInputTensor(interpreter_->inputs()[i], dims),
+        kTfLiteOk);
+  }
+  // Only counts as resized once the tensors are allocated, so that a failed
+  // resize is retried with the original shapes.
+  interpreter_batch_size_ = -1;
+  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk)
+      << "Cannot resize the batch dimension to " << batch_size;
+  interpreter_batch_size_ = batch_size;
+  return absl::OkStatus();
+}
+
+int InferenceInterpreterDelegateRunner::GetBatchBucket(int batch_size) const {
+  if (!supports_batching_) {
+    return 1;
+  }
+  if (interpreter_batch_size_ >= batch_size &&
+      interpreter_batch_size_ <= 2 * batch_size) {
+    return interpreter_batch_size_;
+  }
+  int bucket = 1;
+  while (bucket < batch_size) {
+    bucket *= 2;
+  }
+  return bucket;
+}
+
+bool InferenceInterpreterDelegateRunner::CanStack(
+    absl::Span<const TensorSpan> tensor_spans) const {
+  for (const TensorSpan& tensor_span : tensor_spans) {
+    if (tensor_span.size() != interpreter_->inputs().size()) {
+      return false;
+    }
+    for (int i = 0; i < tensor_span.size(); ++i) {
+      if (tensor_span[i].shape().is_dynamic) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<bool> InferenceInterpreterDelegateRunner::ResizeBatchForStacking(
+    int bucket) {
+  absl::Status status = ResizeBatch(bucket);
+  if (status.ok()) {
+    for (const int tensor_index : interpreter_->outputs()) {
+      const TfLiteTensor* tensor = interpreter_->tensor(tensor_index);
+      if (tensor->dims->data[0] != bucket) {
+        status = absl::FailedPreconditionError(absl::StrCat(
+            "Output tensor ", tensor_index, " has no batch dimension."));
+        break;
+      }
+    }
+  }
+  if (!status.ok()) {
+    ABSL_LOG(WARNING) << "Running inference on one input set at a time: "
+                      << status.message();
+    supports_batching_ = false;
+    MP_RETURN_IF_ERROR(ResizeBatch(1));
+    return false;
+  }
+  return true;
+}
+
+absl::Status InferenceInterpreterDelegateRunner::Invoke(CalculatorContext* cc) {
+  if (cc == nullptr) {
+    RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+    return absl::OkStatus();
+  }
+  MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
+  RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+  return absl::OkStatus();
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     CalculatorContext* cc, const TensorSpan& tensor_span) {
   const int num_feedback_tensors =
@@ -294,6 +468,15 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
 
   RET_CHECK_EQ(tensor_span.size() + num_feedback_tensors,
                interpreter_->inputs().size());
+  if (interpreter_batch_size_ != 1) {
+    if (GetBatchBucket(1) == interpreter_batch_size_ &&
+        CanStack(absl::MakeConstSpan(&tensor_span, 1))) {
+      MP_ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                          RunStacked(cc, absl::MakeConstSpan(&tensor_span, 1)));
+      return std::move(outputs[0]);
+    }
+    MP_RETURN_IF_ERROR(ResizeBatch(1));
+  }
 
   std::vector<int> input_indices_excluding_feedback_tensors;
   input_indices_excluding_feedback_tensors.reserve(tensor_span.size());
@@ -372,7 +555,7 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
   MP_ASSIGN_OR_RETURN(
       std::vector<Tensor> output_tensors,
       AllocateOutputTensors(output_indices_excluding_feedback_tensors,
-                            *interpreter_));
+                            *interpreter_, GetMemoryManager(cc)));
 
   std::vector<Tensor::CpuWriteView> output_tensor_views;
   if (enable_zero_copy_tensor_io_) {
@@ -395,10 +578,7 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
   }
 
   // Run inference.
-  {
-    MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
-    RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
-  }
+  MP_RETURN_IF_ERROR(Invoke(cc));
   input_tensor_views.clear();
   output_tensor_views.clear();
 
@@ -421,6 +601,69 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
   return output_tensors;
 }
 
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceInterpreterDelegateRunner::RunBatch(
+    CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+  const int bucket = GetBatchBucket(tensor_spans.size());
+  if (bucket > 1 && CanStack(tensor_spans)) {
+    MP_ASSIGN_OR_RETURN(const bool resized, ResizeBatchForStacking(bucket));
+    if (resized) {
+      return RunStacked(cc, tensor_spans);
+    }
+  }
+  return InferenceRunner::RunBatch(cc, tensor_spans);
+}
+
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceInterpreterDelegateRunner::RunStacked(
+    CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+  const int batch_size = tensor_spans.size();
+  RET_CHECK_LE(batch_size, interpreter_batch_size_);
+  // Stacks the input sets along the batch dimension, and zeroes the padding.
+  for (int i = 0; i < interpreter_->inputs().size(); ++i) {
+    TfLiteTensor* tensor = interpreter_->tensor(interpreter_->inputs()[i]);
+    const size_t entry_bytes = tensor->bytes / interpreter_batch_size_;
+    for (int b = 0; b < batch_size; ++b) {
+      const Tensor& input_tensor = tensor_spans[b][i];
+      RET_CHECK_EQ(input_tensor.bytes(), entry_bytes)
+          << "Input tensor " << i << " does not match the model input shape.";
+      auto input_tensor_view = input_tensor.GetCpuReadView();
+      std::memcpy(tensor->data.raw + b * entry_bytes,
+                  input_tensor_view.buffer<char>(), entry_bytes);
+    }
+    std::memset(tensor->data.raw + batch_size * entry_bytes, 0,
+                (interpreter_batch_size_ - batch_size) * entry_bytes);
+  }
+
+  // Run inference.
+  MP_RETURN_IF_ERROR(Invoke(cc));
+
+  // Splits each output along the batch dimension.
+  MemoryManager* memory_manager = GetMemoryManager(cc);
+  std::vector<std::vector<Tensor>> outputs(batch_size);
+  for (std::vector<Tensor>& output_tensors : outputs) {
+    output_tensors.reserve(interpreter_->outputs().size());
+  }
+  for (const int tensor_index : interpreter_->outputs()) {
+    const TfLiteTensor* tensor = interpreter_->tensor(tensor_index);
+    const size_t entry_bytes = tensor->bytes / interpreter_batch_size_;
+    for (int b = 0; b < batch_size; ++b) {
+      MP_ASSIGN_OR_RETURN(
+          Tensor output_tensor,
+          AllocateOutputTensor(tensor_index, *interpreter_, memory_manager,
+                               interpreter_batch_size_));
+      RET_CHECK_EQ(output_tensor.bytes(), entry_bytes);
+      {
+        auto output_tensor_view = output_tensor.GetCpuWriteView();
+        std::memcpy(output_tensor_view.buffer<char>(),
+                    tensor->data.raw + b * entry_bytes, entry_bytes);
+      }
+      outputs[b].push_back(std::move(output_tensor));
+    }
+  }
+  return outputs;
+}
+
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
@@ -1,5 +1,6 @@
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -335,6 +336,72 @@ TEST_F(InferenceCalculatorDelegateRunnnerTest,
                          "input->output passthrough tensors")));
 }
 
+Tensor MakeFloatTensor(const std::vector<float>& values) {
+  Tensor tensor(Tensor::ElementType::kFloat32,
+                Tensor::Shape{1, static_cast<int>(values.size())},
+                /*memory_manager=*/nullptr, tflite::kDefaultTensorAlignment);
+  auto view = tensor.GetCpuWriteView();
+  std::copy(values.begin(), values.end(), view.buffer<float>());
+  return tensor;
+}
+
+std::vector<float> GetFloatValues(const Tensor& tensor) {
+  auto view = tensor.GetCpuReadView();
+  const float* buffer = view.buffer<float>();
+  return std::vector<float>(buffer, buffer + tensor.shape().num_elements());
+}
+
+TEST_F(InferenceCalculatorDelegateRunnnerTest, RunBatchStacksInputSets) {
+  MP_ASSERT_OK_AND_ASSIGN(auto model,
+                          TfLiteModelLoader::LoadFromPath(kFloat32ModelFile));
+  auto op_resolver = PacketAdopting<tflite::OpResolver>(
+      std::make_unique<
+          tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>());
+  MP_EXPECT_OK(ExecuteAnyInvocableInGraphCalculator(
+      [&](CalculatorContext* cc) -> absl::Status {
+        MP_ASSIGN_OR_RETURN(auto inference_runner,
+                            CreateInferenceInterpreterDelegateRunner(
+                                std::move(model), std::move(op_resolver),
+                                /*delegate=*/nullptr,
+                                /*interpreter_num_threads=*/-1));
+        // The batch of 3 runs padded to 4, and the batch of 2 in the same
+        // allocation.
+        for (const int batch_size : {3, 2}) {
+          std::vector<std::vector<Tensor>> inputs;
+          std::vector<TensorSpan> tensor_spans;
+          for (int i = 0; i < batch_size; ++i) {
+            inputs.emplace_back();
+            inputs.back().push_back(
+                MakeFloatTensor({1.f * i, 2.f * i, 3.f * i}));
+          }
+          for (const auto& input : inputs) {
+            tensor_spans.push_back(MakeTensorSpan(input));
+          }
+          MP_ASSIGN_OR_RETURN(auto outputs,
+                              inference_runner->RunBatch(cc, tensor_spans));
+          EXPECT_EQ(outputs.size(), batch_size);
+          for (int i = 0; i < outputs.size(); ++i) {
+            EXPECT_EQ(outputs[i].size(), 1);
+            EXPECT_EQ(outputs[i][0].shape().dims, std::vector<int>({1, 3}));
+            EXPECT_THAT(GetFloatValues(outputs[i][0]),
+                        testing::ElementsAre(1.f * i * i, 4.f * i * i,
+                                             9.f * i * i));
+          }
+        }
+
+        // A single input set runs with the model's original batch size.
+        std::vector<Tensor> input;
+        input.push_back(MakeFloatTensor({1.f, 2.f, 3.f}));
+        MP_ASSIGN_OR_RETURN(auto output_tensors,
+                            inference_runner->Run(cc, MakeTensorSpan(input)));
+        EXPECT_EQ(output_tensors.size(), 1);
+        EXPECT_EQ(output_tensors[0].shape().dims, std::vector<int>({1, 3}));
+        EXPECT_THAT(GetFloatValues(output_tensors[0]),
+                    testing::ElementsAre(1.f, 4.f, 9.f));
+        return absl::OkStatus();
+      }));
+}
+
 }  // namespace
 }  // namespace api2
 }  // namespace mediapipe
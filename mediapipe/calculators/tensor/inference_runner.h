@@ -1,13 +1,16 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 
+#include <utility>
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/inference_io_mapper.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/status_macros.h"
 
 namespace mediapipe {
 
@@ -15,9 +18,29 @@ namespace mediapipe {
 class InferenceRunner {
  public:
   virtual ~InferenceRunner() = default;
+
+  // Runs inference on one set of input tensors. "cc" is used for profiling and
+  // to allocate the output tensors, and may be null when the inference is not
+  // run on behalf of a single calculator.
   virtual absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const TensorSpan& tensor_span) = 0;
 
+  // Runs inference on several independent sets of input tensors, e.g. the
+  // inputs of several timestamps, and returns the output tensors of each set.
+  // Runners that can stack the sets along the batch dimension override this to
+  // invoke the model once. By default, Run() is called for each set.
+  virtual absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(tensor_spans.size());
+    for (const TensorSpan& tensor_span : tensor_spans) {
+      MP_ASSIGN_OR_RETURN(std::vector<Tensor> output_tensors,
+                          Run(cc, tensor_span));
+      outputs.push_back(std::move(output_tensors));
+    }
+    return outputs;
+  }
+
   // Returns the TfLite model's input/output tensor names. This enables tensor
   // name based I/O mapping in the InferenceCalculator base class.
   virtual const InputOutputTensorNames& GetInputOutputTensorNames() const = 0;
@@ -0,0 +1,258 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/shared_inference_service.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/calculators/tensor/inference_io_mapper.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+// The interpreters of one model, and the queue of requests waiting for them.
+class SharedInferenceService::SharedModel {
+ public:
+  SharedModel(std::vector<std::unique_ptr<InferenceRunner>> runners,
+              int max_batch_size)
+      : max_batch_size_(max_batch_size),
+        input_output_tensor_names_(runners[0]->GetInputOutputTensorNames()),
+        runners_(std::move(runners)) {
+    for (const auto& runner : runners_) {
+      idle_runners_.push_back(runner.get());
+    }
+  }
+
+  // Queues one request per input set, and runs queued requests until all of
+  // them are done.
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc, absl::Span<const TensorSpan> tensor_spans) {
+    Submission submission;
+    submission.requests.resize(tensor_spans.size());
+    submission.remaining = tensor_spans.size();
+
+    absl::MutexLock lock(&mutex_);
+    for (int i = 0; i < tensor_spans.size(); ++i) {
+      submission.requests[i].cc = cc;
+      submission.requests[i].tensor_span = &tensor_spans[i];
+      submission.requests[i].submission = &submission;
+      pending_.push_back(&submission.requests[i]);
+    }
+    auto done_or_runnable = [this, &submission]() {
+      mutex_.AssertHeld();
+      return submission.remaining == 0 ||
+             (!pending_.empty() && !idle_runners_.empty());
+    };
+    while (submission.remaining > 0) {
+      mutex_.Await(absl::Condition(&done_or_runnable));
+      if (submission.remaining > 0) RunPendingRequests();
+    }
+
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(tensor_spans.size());
+    for (Request& request : submission.requests) {
+      if (!request.status.ok()) return request.status;
+      outputs.push_back(std::move(request.output_tensors));
+    }
+    return outputs;
+  }
+
+  const InputOutputTensorNames& GetInputOutputTensorNames() const {
+    return input_output_tensor_names_;
+  }
+
+ private:
+  struct Submission;
+
+  struct Request {
+    // The context of the calculator that submitted the request.
+    CalculatorContext* cc = nullptr;
+    const TensorSpan* tensor_span = nullptr;
+    Submission* submission = nullptr;
+    absl::Status status;
+    std::vector<Tensor> output_tensors;
+  };
+
+  // The requests queued by one RunBatch() call.
+  struct Submission {
+    std::vector<Request> requests;
+    int remaining = 0;
+  };
+
+  // Runs up to max_batch_size_ queued requests, from any caller, on one idle
+  // interpreter. The mutex is released while the interpreter runs, so that
+  // other interpreters can run and new requests can be queued meanwhile.
+  //
+  // A batch of requests from a single calculator is run with its context. A
+  // batch mixing calculators is run without a context: its output tensors are
+  // not allocated from any graph's MemoryManager, and its inference time is
+  // not charged to any graph's profiler.
+  void RunPendingRequests() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    InferenceRunner* runner = idle_runners_.back();
+    idle_runners_.pop_back();
+    std::vector<Request*> batch;
+    while (!pending_.empty() && batch.size() < max_batch_size_) {
+      batch.push_back(pending_.front());
+      pending_.pop_front();
+    }
+
+    mutex_.Unlock();
+    CalculatorContext* cc = batch[0]->cc;
+    std::vector<TensorSpan> tensor_spans;
+    tensor_spans.reserve(batch.size());
+    for (const Request* request : batch) {
+      if (request->cc != cc) cc = nullptr;
+      tensor_spans.push_back(*request->tensor_span);
+    }
+    absl::StatusOr<std::vector<std::vector<Tensor>>> outputs =
+        runner->RunBatch(cc, tensor_spans);
+    if (outputs.ok() && outputs->size() != batch.size()) {
+      outputs = absl::InternalError(
+          absl::StrCat("Expected ", batch.size(),
+                       " sets of output tensors, got ", outputs->size()));
+    }
+    mutex_.Lock();
+
+    for (int i = 0; i < batch.size(); ++i) {
+      if (outputs.ok()) {
+        batch[i]->output_tensors = std::move((*outputs)[i]);
+      } else {
+        batch[i]->status = outputs.status();
+      }
+      --batch[i]->submission->remaining;
+    }
+    idle_runners_.push_back(runner);
+  }
+
+  const int max_batch_size_;
+  const InputOutputTensorNames input_output_tensor_names_;
+  const std::vector<std::unique_ptr<InferenceRunner>> runners_;
+
+  absl::Mutex mutex_;
+  std::deque<Request*> pending_ ABSL_GUARDED_BY(mutex_);
+  std::vector<InferenceRunner*> idle_runners_ ABSL_GUARDED_BY(mutex_);
+};
+
+namespace {
+
+// The InferenceRunner handed out to calculators. Keeps its model alive.
+class SharedInferenceRunner : public InferenceRunner {
+ public:
+  explicit SharedInferenceRunner(
+      std::shared_ptr<SharedInferenceService::SharedModel> model)
+      : model_(std::move(model)) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    MP_ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                        model_->RunBatch(cc, {tensor_span}));
+    return std::move(outputs[0]);
+  }
+
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      absl::Span<const TensorSpan> tensor_spans) override {
+    return model_->RunBatch(cc, tensor_spans);
+  }
+
+  const InputOutputTensorNames& GetInputOutputTensorNames() const override {
+    return model_->GetInputOutputTensorNames();
+  }
+
+ private:
+  std::shared_ptr<SharedInferenceService::SharedModel> model_;
+};
+
+}  // namespace
+
+SharedInferenceService::SharedInferenceService(Options options)
+    : options_(std::move(options)) {}
+
+std::shared_ptr<SharedInferenceService::SharedModel>
+SharedInferenceService::GetModel(ModelEntry& entry) {
+  absl::MutexLock lock(&mutex_);
+  return entry.model.lock();
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+SharedInferenceService::GetRunner(const std::string& model_key,
+                                  RunnerFactory create_runner) {
+  RET_CHECK_GE(options_.num_interpreters, 1);
+  RET_CHECK_GE(options_.max_batch_size, 1);
+  std::shared_ptr<ModelEntry> entry;
+  std::shared_ptr<SharedModel> model;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (auto it = models_.begin(); it != models_.end();) {
+      // Entries held by other GetRunner calls may be creating their model.
+      if (it->second.use_count() == 1 && it->second->model.expired()) {
+        models_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    std::shared_ptr<ModelEntry>& model_entry = models_[model_key];
+    if (model_entry == nullptr) {
+      model_entry = std::make_shared<ModelEntry>();
+    }
+    entry = model_entry;
+    model = entry->model.lock();
+  }
+
+  if (model == nullptr) {
+    // Creating the interpreters is slow, so it only blocks the callers that
+    // request the same model, which then share it.
+    absl::MutexLock creation_lock(&entry->creation_mutex);
+    model = GetModel(*entry);
+    if (model == nullptr) {
+      std::vector<std::unique_ptr<InferenceRunner>> runners;
+      for (int i = 0; i < options_.num_interpreters; ++i) {
+        MP_ASSIGN_OR_RETURN(std::unique_ptr<InferenceRunner> runner,
+                            create_runner());
+        RET_CHECK(runner != nullptr);
+        runners.push_back(std::move(runner));
+      }
+      model = std::make_shared<SharedModel>(std::move(runners),
+                                            options_.max_batch_size);
+      absl::MutexLock lock(&mutex_);
+      entry->model = model;
+    }
+  }
+  return std::make_unique<SharedInferenceRunner>(std::move(model));
+}
+
+int SharedInferenceService::NumModels() const {
+  absl::MutexLock lock(&mutex_);
+  return std::count_if(models_.begin(), models_.end(), [](const auto& entry) {
+    return !entry.second->model.expired();
+  });
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,113 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_SERVICE_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_SERVICE_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// Shares model interpreters between all the graphs of a process.
+//
+// Without this service, every InferenceCalculator instance builds its own
+// interpreter, so that N graphs running the same model hold N copies of its
+// tensor arena and invoke it N times per frame. When the same
+// SharedInferenceService object is set on several graphs:
+//
+//   auto service = std::make_shared<SharedInferenceService>();
+//   for (CalculatorGraph& graph : graphs) {
+//     MP_RETURN_IF_ERROR(
+//         graph.SetServiceObject(kSharedInferenceService, service));
+//   }
+//
+// the CPU and XNNPACK InferenceCalculators of these graphs share one pool of
+// interpreters per model. Inference requests that arrive while all of a
+// model's interpreters are busy are queued, and the next free interpreter runs
+// all the queued requests, from any graph, in one batched invocation (see
+// InferenceRunner::RunBatch).
+//
+// A request is executed either by the thread that submitted it or by a thread
+// that submitted another request for the same model; the submitting thread
+// only waits for its own result. Models are released when the last
+// calculator using them is closed.
+//
+// Models with feedback tensors keep state between invocations and are never
+// shared.
+class SharedInferenceService {
+ public:
+  struct Options {
+    // Number of interpreters created for each model. Each interpreter runs
+    // one batch at a time.
+    int num_interpreters = 1;
+    // Maximum number of requests run in one invocation.
+    int max_batch_size = 16;
+  };
+
+  using RunnerFactory =
+      absl::AnyInvocable<absl::StatusOr<std::unique_ptr<InferenceRunner>>()>;
+
+  SharedInferenceService() : SharedInferenceService(Options()) {}
+  explicit SharedInferenceService(Options options);
+  SharedInferenceService(const SharedInferenceService&) = delete;
+  SharedInferenceService& operator=(const SharedInferenceService&) = delete;
+
+  // Returns an InferenceRunner for the model identified by "model_key". The
+  // first call for a key creates the model's interpreters with
+  // "create_runner"; later calls share them as long as a returned runner is
+  // alive. The key must identify everything that affects the interpreters,
+  // e.g. the model, the op resolver and the delegate options.
+  absl::StatusOr<std::unique_ptr<InferenceRunner>> GetRunner(
+      const std::string& model_key, RunnerFactory create_runner);
+
+  // Returns the number of models that currently have interpreters.
+  int NumModels() const;
+
+  class SharedModel;
+
+ private:
+  // The model of one key.
+  struct ModelEntry {
+    // Held while the model is created, so that concurrent requests for the
+    // same key create it once.
+    absl::Mutex creation_mutex;
+    std::weak_ptr<SharedModel> model;  // Guarded by the service's mutex_.
+  };
+
+  // Looks up the model of "entry".
+  std::shared_ptr<SharedModel> GetModel(ModelEntry& entry)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const Options options_;
+  // Never held while a model is created.
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<ModelEntry>> models_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+inline constexpr GraphService<SharedInferenceService> kSharedInferenceService(
+    "SharedInferenceService", GraphServiceBase::kDisallowDefaultInitialization);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_SERVICE_H_
@@ -0,0 +1,299 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/shared_inference_service.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "mediapipe/calculators/tensor/inference_io_mapper.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/profiler/test_context_builder.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using RunnerOr = absl::StatusOr<std::unique_ptr<InferenceRunner>>;
+
+Tensor MakeScalarTensor(float value) {
+  Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape{1});
+  *tensor.GetCpuWriteView().buffer<float>() = value;
+  return tensor;
+}
+
+float GetScalarValue(const Tensor& tensor) {
+  return *tensor.GetCpuReadView().buffer<float>();
+}
+
+// Records the size and the calculator context of each batch it runs, and
+// doubles its input. The first
+// batch optionally blocks until "unblock_first_batch" is notified.
+class FakeRunner : public InferenceRunner {
+ public:
+  explicit FakeRunner(absl::Notification* unblock_first_batch = nullptr)
+      : unblock_first_batch_(unblock_first_batch) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    if (GetScalarValue(tensor_span[0]) < 0) {
+      return absl::InvalidArgumentError("Negative input");
+    }
+    std::vector<Tensor> outputs;
+    outputs.push_back(MakeScalarTensor(2 * GetScalarValue(tensor_span[0])));
+    return outputs;
+  }
+
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      absl::Span<const TensorSpan> tensor_spans) override {
+    {
+      absl::MutexLock lock(&mutex_);
+      batch_sizes_.push_back(tensor_spans.size());
+      batch_contexts_.push_back(cc);
+    }
+    if (unblock_first_batch_ != nullptr) {
+      unblock_first_batch_->WaitForNotification();
+      unblock_first_batch_ = nullptr;
+    }
+    return InferenceRunner::RunBatch(cc, tensor_spans);
+  }
+
+  const InputOutputTensorNames& GetInputOutputTensorNames() const override {
+    return input_output_tensor_names_;
+  }
+
+  std::vector<int> batch_sizes() {
+    absl::MutexLock lock(&mutex_);
+    return batch_sizes_;
+  }
+
+  std::vector<CalculatorContext*> batch_contexts() {
+    absl::MutexLock lock(&mutex_);
+    return batch_contexts_;
+  }
+
+ private:
+  absl::Notification* unblock_first_batch_;
+  InputOutputTensorNames input_output_tensor_names_;
+  absl::Mutex mutex_;
+  std::vector<int> batch_sizes_;
+  std::vector<CalculatorContext*> batch_contexts_;
+};
+
+absl::StatusOr<float> RunScalar(InferenceRunner& runner, float value,
+                                CalculatorContext* cc = nullptr) {
+  std::vector<Tensor> inputs;
+  inputs.push_back(MakeScalarTensor(value));
+  MP_ASSIGN_OR_RETURN(std::vector<Tensor> outputs,
+                      runner.Run(cc, MakeTensorSpan(inputs)));
+  return GetScalarValue(outputs[0]);
+}
+
+TEST(SharedInferenceServiceTest, SharesInterpretersOfSameModel) {
+  SharedInferenceService service;
+  int num_created = 0;
+  auto create_runner = [&num_created]() -> RunnerOr {
+    ++num_created;
+    return std::make_unique<FakeRunner>();
+  };
+
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_a1,
+                          service.GetRunner("a", create_runner));
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_a2,
+                          service.GetRunner("a", create_runner));
+  EXPECT_EQ(num_created, 1);
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_b,
+                          service.GetRunner("b", create_runner));
+  EXPECT_EQ(num_created, 2);
+  EXPECT_EQ(service.NumModels(), 2);
+
+  MP_ASSERT_OK_AND_ASSIGN(float result, RunScalar(*runner_a1, 3.0f));
+  EXPECT_EQ(result, 6.0f);
+  MP_ASSERT_OK_AND_ASSIGN(result, RunScalar(*runner_a2, 4.0f));
+  EXPECT_EQ(result, 8.0f);
+
+  // A model is released with its last runner.
+  runner_a1.reset();
+  EXPECT_EQ(service.NumModels(), 2);
+  runner_a2.reset();
+  EXPECT_EQ(service.NumModels(), 1);
+  MP_ASSERT_OK_AND_ASSIGN(runner_a1, service.GetRunner("a", create_runner));
+  EXPECT_EQ(num_created, 3);
+}
+
+TEST(SharedInferenceServiceTest, CreatesInterpretersPerModel) {
+  SharedInferenceService service({.num_interpreters = 3});
+  int num_created = 0;
+  auto create_runner = [&num_created]() -> RunnerOr {
+    ++num_created;
+    return std::make_unique<FakeRunner>();
+  };
+  MP_ASSERT_OK_AND_ASSIGN(auto runner, service.GetRunner("a", create_runner));
+  EXPECT_EQ(num_created, 3);
+}
+
+TEST(SharedInferenceServiceTest, CreatesModelsConcurrently) {
+  SharedInferenceService service;
+  absl::Notification creating_a;
+  absl::Notification unblock_a;
+  int num_created_a = 0;
+  auto create_runner_a = [&]() -> RunnerOr {
+    ++num_created_a;
+    creating_a.Notify();
+    unblock_a.WaitForNotification();
+    return std::make_unique<FakeRunner>();
+  };
+
+  std::vector<RunnerOr> runners_a(2);
+  std::thread first_a(
+      [&] { runners_a[0] = service.GetRunner("a", create_runner_a); });
+  creating_a.WaitForNotification();
+  std::thread second_a(
+      [&] { runners_a[1] = service.GetRunner("a", create_runner_a); });
+  // Another model can be created while "a" is.
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_b,
+                          service.GetRunner("b", []() -> RunnerOr {
+                            return std::make_unique<FakeRunner>();
+                          }));
+  unblock_a.Notify();
+  first_a.join();
+  second_a.join();
+
+  MP_ASSERT_OK(runners_a[0]);
+  MP_ASSERT_OK(runners_a[1]);
+  EXPECT_EQ(num_created_a, 1);
+  EXPECT_EQ(service.NumModels(), 2);
+}
+
+TEST(SharedInferenceServiceTest, ReturnsRunnerCreationErrors) {
+  SharedInferenceService service;
+  auto create_runner = []() -> RunnerOr {
+    return absl::NotFoundError("No model");
+  };
+  EXPECT_EQ(service.GetRunner("a", create_runner).status().code(),
+            absl::StatusCode::kNotFound);
+  EXPECT_EQ(service.NumModels(), 0);
+}
+
+TEST(SharedInferenceServiceTest, ReturnsInferenceErrorsToTheirCaller) {
+  SharedInferenceService service;
+  MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                          service.GetRunner("a", []() -> RunnerOr {
+                            return std::make_unique<FakeRunner>();
+                          }));
+  EXPECT_EQ(RunScalar(*runner, -1.0f).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  MP_ASSERT_OK_AND_ASSIGN(float result, RunScalar(*runner, 1.0f));
+  EXPECT_EQ(result, 2.0f);
+}
+
+// While the only interpreter is busy, requests from other callers are queued
+// and then run together.
+TEST(SharedInferenceServiceTest, BatchesRequestsQueuedWhileBusy) {
+  constexpr int kNumCallers = 4;
+  SharedInferenceService service({.num_interpreters = 1, .max_batch_size = 8});
+  absl::Notification unblock_first_batch;
+  FakeRunner* fake_runner = nullptr;
+  auto create_runner = [&]() -> RunnerOr {
+    auto runner = std::make_unique<FakeRunner>(&unblock_first_batch);
+    fake_runner = runner.get();
+    return runner;
+  };
+
+  // One runner per caller, like one InferenceCalculator per graph.
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  for (int i = 0; i <= kNumCallers; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto runner,
+                            service.GetRunner("model", create_runner));
+    runners.push_back(std::move(runner));
+  }
+
+  std::vector<absl::StatusOr<float>> results(kNumCallers + 1, 0.0f);
+  std::vector<std::thread> threads;
+  threads.emplace_back([&] { results[0] = RunScalar(*runners[0], 0.0f); });
+  while (fake_runner->batch_sizes().empty()) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  for (int i = 1; i <= kNumCallers; ++i) {
+    threads.emplace_back([&, i] { results[i] = RunScalar(*runners[i], i); });
+  }
+  // Give the other callers time to queue their requests.
+  absl::SleepFor(absl::Milliseconds(100));
+  unblock_first_batch.Notify();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i <= kNumCallers; ++i) {
+    MP_ASSERT_OK(results[i]);
+    EXPECT_EQ(*results[i], 2.0f * i);
+  }
+  EXPECT_THAT(fake_runner->batch_sizes(), ElementsAre(1, kNumCallers));
+}
+
+// Batches are run with the context of their requests' calculator, or without
+// a context when they mix calculators, so that no calculator is charged for
+// the others' requests.
+TEST(SharedInferenceServiceTest, RunsBatchesWithTheContextOfTheirRequests) {
+  SharedInferenceService service({.num_interpreters = 1, .max_batch_size = 8});
+  absl::Notification unblock_first_batch;
+  FakeRunner* fake_runner = nullptr;
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto runner, service.GetRunner("model", [&]() -> RunnerOr {
+        auto runner = std::make_unique<FakeRunner>(&unblock_first_batch);
+        fake_runner = runner.get();
+        return runner;
+      }));
+  TestContextBuilder context_a("a", 0, {}, {});
+  TestContextBuilder context_b("b", 1, {}, {});
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(
+      [&] { MP_EXPECT_OK(RunScalar(*runner, 0.0f, context_a.get())); });
+  while (fake_runner->batch_sizes().empty()) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  threads.emplace_back(
+      [&] { MP_EXPECT_OK(RunScalar(*runner, 1.0f, context_a.get())); });
+  threads.emplace_back(
+      [&] { MP_EXPECT_OK(RunScalar(*runner, 2.0f, context_b.get())); });
+  // Give the other callers time to queue their requests.
+  absl::SleepFor(absl::Milliseconds(100));
+  unblock_first_batch.Notify();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_THAT(fake_runner->batch_sizes(), ElementsAre(1, 2));
+  EXPECT_THAT(fake_runner->batch_contexts(),
+              ElementsAre(context_a.get(), nullptr));
+}
+
+}  // namespace
+}  // namespace mediapipe
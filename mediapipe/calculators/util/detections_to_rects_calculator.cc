@@ -165,6 +165,9 @@ absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
   if (cc->Outputs().HasTag(kNormRectsTag)) {
     cc->Outputs().Tag(kNormRectsTag).Set<std::vector<NormalizedRect>>();
   }
+  cc->SetTimestampOffset(TimestampDiff(0));
+  cc->SetInlineExecution(true);
+  cc->SetFusable(true);
 
   return absl::OkStatus();
 }
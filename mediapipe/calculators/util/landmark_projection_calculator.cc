@@ -133,6 +133,9 @@ class LandmarkProjectionCalculator : public CalculatorBase {
          id != cc->Outputs().EndId(kLandmarksTag); ++id) {
       cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
     }
+    cc->SetTimestampOffset(TimestampDiff(0));
+    cc->SetInlineExecution(true);
+    cc->SetFusable(true);
 
     return absl::OkStatus();
   }
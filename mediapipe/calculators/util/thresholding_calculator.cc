@@ -88,6 +88,9 @@ absl::Status ThresholdingCalculator::GetContract(CalculatorContract* cc) {
         << "Using both the threshold input side packet and input stream is not "
            "supported.";
   }
+  cc->SetTimestampOffset(TimestampDiff(0));
+  cc->SetInlineExecution(true);
+  cc->SetFusable(true);
 
   return absl::OkStatus();
 }
@@ -0,0 +1,154 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the per-frame latency of a video graph with and without inline
+// execution of cheap calculators (CalculatorContract::SetInlineExecution).
+// Frames are sent one at a time, and each is awaited on the output stream
+// before the next one is sent, so that scheduling overhead is not hidden by
+// pipelining.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/absl_log.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+constexpr char kInputStream[] = "input_video";
+constexpr char kOutputStream[] = "output_video";
+
+ABSL_FLAG(std::string, calculator_graph_config_file, "",
+          "Name of file containing text format CalculatorGraphConfig proto.");
+ABSL_FLAG(std::string, input_video_path, "",
+          "Full path of video to load. If not provided, blank frames of "
+          "--width by --height are used.");
+ABSL_FLAG(int, num_frames, 300, "Number of frames sent per run.");
+ABSL_FLAG(int, width, 640, "Width of the blank frames.");
+ABSL_FLAG(int, height, 480, "Height of the blank frames.");
+
+namespace {
+
+// Returns the frames to send, in SRGB format.
+absl::StatusOr<std::vector<std::unique_ptr<mediapipe::ImageFrame>>>
+LoadFrames() {
+  const int num_frames = absl::GetFlag(FLAGS_num_frames);
+  std::vector<std::unique_ptr<mediapipe::ImageFrame>> frames;
+  if (absl::GetFlag(FLAGS_input_video_path).empty()) {
+    for (int i = 0; i < num_frames; ++i) {
+      auto frame = std::make_unique<mediapipe::ImageFrame>(
+          mediapipe::ImageFormat::SRGB, absl::GetFlag(FLAGS_width),
+          absl::GetFlag(FLAGS_height),
+          mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+      frame->SetToZero();
+      frames.push_back(std::move(frame));
+    }
+    return frames;
+  }
+  cv::VideoCapture capture(absl::GetFlag(FLAGS_input_video_path));
+  RET_CHECK(capture.isOpened());
+  cv::Mat camera_frame_raw;
+  while (frames.size() < num_frames && capture.read(camera_frame_raw)) {
+    cv::Mat camera_frame;
+    cv::cvtColor(camera_frame_raw, camera_frame, cv::COLOR_BGR2RGB);
+    auto frame = std::make_unique<mediapipe::ImageFrame>(
+        mediapipe::ImageFormat::SRGB, camera_frame.cols, camera_frame.rows,
+        mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+    camera_frame.copyTo(mediapipe::formats::MatView(frame.get()));
+    frames.push_back(std::move(frame));
+  }
+  RET_CHECK(!frames.empty());
+  return frames;
+}
+
+// Runs the graph over all frames and returns the sorted frame latencies in
+// microseconds.
+absl::StatusOr<std::vector<int64_t>> RunGraph(
+    mediapipe::CalculatorGraphConfig config, bool inline_execution,
+    const std::vector<std::unique_ptr<mediapipe::ImageFrame>>& frames) {
+  config.set_disable_inline_execution(!inline_execution);
+  mediapipe::CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+  MP_ASSIGN_OR_RETURN(mediapipe::OutputStreamPoller poller,
+                      graph.AddOutputStreamPoller(kOutputStream));
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+
+  std::vector<int64_t> latencies;
+  for (int i = 0; i < frames.size(); ++i) {
+    auto frame = std::make_unique<mediapipe::ImageFrame>();
+    frame->CopyFrom(*frames[i],
+                    mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+    const absl::Time start_time = absl::Now();
+    MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+        kInputStream,
+        mediapipe::Adopt(frame.release()).At(mediapipe::Timestamp(i))));
+    mediapipe::Packet packet;
+    RET_CHECK(poller.Next(&packet));
+    latencies.push_back(absl::ToInt64Microseconds(absl::Now() - start_time));
+  }
+  MP_RETURN_IF_ERROR(graph.CloseInputStream(kInputStream));
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+absl::Status RunBenchmark() {
+  std::string calculator_graph_config_contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file),
+      &calculator_graph_config_contents));
+  const auto config =
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+  MP_ASSIGN_OR_RETURN(auto frames, LoadFrames());
+
+  for (const bool inline_execution : {false, true}) {
+    MP_ASSIGN_OR_RETURN(auto latencies,
+                        RunGraph(config, inline_execution, frames));
+    int64_t total = 0;
+    for (const int64_t latency : latencies) total += latency;
+    ABSL_LOG(INFO) << "inline_execution: " << inline_execution
+                   << " frames: " << latencies.size()
+                   << " mean_usec: " << total / latencies.size()
+                   << " p50_usec: " << latencies[latencies.size() / 2]
+                   << " p99_usec: " << latencies[latencies.size() * 99 / 100];
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = RunBenchmark();
+  if (!run_status.ok()) {
+    ABSL_LOG(ERROR) << "Failed to run the benchmark: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
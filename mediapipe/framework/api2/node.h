@@ -17,6 +17,10 @@ namespace api2 {
 
 class NodeIntf {};
 
+// A node may declare
+//   static constexpr int kMaxBatch = 8;
+// to receive up to kMaxBatch input sets in a single Process call. See
+// CalculatorContract::SetMaxBatchSize for details.
 class Node : public CalculatorBase {
  public:
   virtual ~Node();
@@ -35,6 +39,7 @@ class CalculatorBaseFactoryFor<
   absl::Status GetContract(CalculatorContract* cc) final {
     auto status = T::Contract::GetContract(cc);
     if (status.ok()) {
+      SetMaxBatchSize<T>(cc);
       status = UpdateContract<T>(cc);
     }
     return status;
@@ -55,6 +60,13 @@ class CalculatorBaseFactoryFor<
   absl::Status UpdateContract(...) {
     return {};
   }
+
+  template <typename U>
+  auto SetMaxBatchSize(CalculatorContract* cc) -> decltype((void)U::kMaxBatch) {
+    cc->SetMaxBatchSize(U::kMaxBatch);
+  }
+  template <typename U>
+  void SetMaxBatchSize(...) {}
 };
 
 }  // namespace internal
@@ -571,6 +571,192 @@ TEST(NodeTest, ConsumeInputs) {
   MP_EXPECT_OK(graph.WaitUntilDone());
 }
 
+// Doubles its input, receiving up to four input sets per Process call, and
+// reports the size of each batch at its first timestamp.
+struct BatchedDoubler : public Node {
+  static constexpr Input<int> kIn{"IN"};
+  static constexpr Output<int> kOut{"OUT"};
+  static constexpr Output<int>::Optional kBatchSize{"BATCH_SIZE"};
+  static constexpr int kMaxBatch = 4;
+
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut, kBatchSize);
+
+  absl::Status Process(CalculatorContext* cc) override {
+    RET_CHECK_LE(cc->BatchSize(), kMaxBatch);
+    for (int i = 0; i < cc->BatchSize(); ++i) {
+      kOut(cc).Send(*kIn(cc).InBatch(i) * 2, cc->InputTimestampInBatch(i));
+    }
+    kBatchSize(cc).Send(cc->BatchSize());
+    return {};
+  }
+};
+MEDIAPIPE_REGISTER_NODE(BatchedDoubler);
+
+// Like ListIntPackets, for batches of input sets.
+struct BatchedListIntPackets : public Node {
+  static constexpr Input<int> kA{"A"};
+  static constexpr Input<int> kB{"B"};
+  static constexpr Output<std::string> kOut{"STR"};
+  static constexpr int kMaxBatch = 8;
+
+  MEDIAPIPE_NODE_CONTRACT(kA, kB, kOut);
+
+  absl::Status Process(CalculatorContext* cc) override {
+    for (int i = 0; i < cc->BatchSize(); ++i) {
+      std::string result =
+          absl::StrCat(cc->InputTimestampInBatch(i).DebugString(), ":");
+      for (const Packet<int>& packet : {kA(cc).InBatch(i), kB(cc).InBatch(i)}) {
+        if (packet.IsEmpty()) {
+          absl::StrAppend(&result, " empty");
+        } else {
+          absl::StrAppend(&result, " ", *packet);
+        }
+      }
+      kOut(cc).Send(std::move(result), cc->InputTimestampInBatch(i));
+    }
+    return {};
+  }
+};
+MEDIAPIPE_REGISTER_NODE(BatchedListIntPackets);
+
+TEST(NodeTest, GetContractSetsMaxBatchSize) {
+  const CalculatorGraphConfig::Node node_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+        calculator: "BatchedDoubler"
+        input_stream: "IN:in"
+        output_stream: "OUT:out"
+      )pb");
+  mediapipe::CalculatorContract contract;
+  MP_EXPECT_OK(contract.Initialize(node_config));
+  MP_EXPECT_OK(mediapipe::internal::CalculatorBaseFactoryFor<BatchedDoubler>()
+                   .GetContract(&contract));
+  EXPECT_EQ(contract.GetMaxBatchSize(), BatchedDoubler::kMaxBatch);
+
+  mediapipe::CalculatorContract foo_contract;
+  MP_EXPECT_OK(foo_contract.Initialize(node_config));
+  MP_EXPECT_OK(mediapipe::internal::CalculatorBaseFactoryFor<FooImpl>()
+                   .GetContract(&foo_contract));
+  EXPECT_EQ(foo_contract.GetMaxBatchSize(), 1);
+}
+
+TEST(NodeTest, ProcessesBatches) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out"
+        output_stream: "batch_size"
+        executor { type: "ApplicationThreadExecutor" }
+        node {
+          calculator: "BatchedDoubler"
+          input_stream: "IN:in"
+          output_stream: "OUT:out"
+          output_stream: "BATCH_SIZE:batch_size"
+        }
+      )pb");
+  std::vector<mediapipe::Packet> out_packets;
+  std::vector<mediapipe::Packet> batch_size_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  tool::AddVectorSink("batch_size", &config, &batch_size_packets);
+  mediapipe::CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config, {}));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // The application thread executor runs nothing until WaitUntilIdle, so all
+  // the packets are queued when the node first runs.
+  constexpr int kNumPackets = 10;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", mediapipe::MakePacket<int>(i).At(Timestamp(i * 10))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  std::vector<int> expected_values;
+  std::vector<Timestamp> expected_timestamps;
+  for (int i = 0; i < kNumPackets; ++i) {
+    expected_values.push_back(i * 2);
+    expected_timestamps.push_back(Timestamp(i * 10));
+  }
+  EXPECT_EQ(PacketValues<int>(out_packets), expected_values);
+  std::vector<Timestamp> timestamps;
+  for (const auto& packet : out_packets) {
+    timestamps.push_back(packet.Timestamp());
+  }
+  EXPECT_EQ(timestamps, expected_timestamps);
+  EXPECT_THAT(PacketValues<int>(batch_size_packets),
+              testing::ElementsAre(4, 4, 2));
+  ASSERT_EQ(batch_size_packets.size(), 3);
+  EXPECT_EQ(batch_size_packets[1].Timestamp(), Timestamp(40));
+  EXPECT_EQ(batch_size_packets[2].Timestamp(), Timestamp(80));
+
+  // A single packet is processed right away, without waiting for a batch.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", mediapipe::MakePacket<int>(100).At(Timestamp(1000))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_EQ(PacketValues<int>(out_packets).back(), 200);
+  EXPECT_EQ(PacketValues<int>(batch_size_packets).back(), 1);
+
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(NodeTest, BatchesKeepInputSetsAligned) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "a"
+        input_stream: "b"
+        output_stream: "out"
+        executor { type: "ApplicationThreadExecutor" }
+        node {
+          calculator: "BatchedListIntPackets"
+          input_stream: "A:a"
+          input_stream: "B:b"
+          output_stream: "STR:out"
+        }
+      )pb");
+  std::vector<mediapipe::Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  mediapipe::CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config, {}));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 1; i <= 4; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "a", mediapipe::MakePacket<int>(i).At(Timestamp(i))));
+    if (i % 2 == 0) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "b", mediapipe::MakePacket<int>(i * 10).At(Timestamp(i))));
+    }
+  }
+  // Timestamp 5 is not settled until stream "b" moves past it.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "a", mediapipe::MakePacket<int>(5).At(Timestamp(5))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_THAT(PacketValues<std::string>(out_packets),
+              testing::ElementsAre("1: 1 empty", "2: 2 20", "3: 3 empty",
+                                   "4: 4 40"));
+
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(PacketValues<std::string>(out_packets),
+              testing::ElementsAre("1: 1 empty", "2: 2 20", "3: 3 empty",
+                                   "4: 4 40", "5: 5 empty"));
+}
+
+TEST(NodeTest, BatchingCannotRunInParallel) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "BatchedDoubler"
+          input_stream: "IN:in"
+          output_stream: "OUT:out"
+          max_in_flight: 2
+        }
+      )pb");
+  mediapipe::CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config, {});
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), testing::HasSubstr("max_in_flight"));
+}
+
 // Just to test that single-port contracts work.
 struct LogSinkNode : public Node {
   static constexpr Input<int> kIn{"IN"};
@@ -92,8 +92,8 @@ class PacketBase {
   // DEPRECATED
   //
   // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.use_count(), which is deprecated and is not
-  // guaranteed to give exact results.
+  // it relies on the holder's reference count, which is not guaranteed to give
+  // exact results while other threads copy the packet.
   template <typename T>
   ABSL_DEPRECATED(
       "Avoid Consume* functions usage as in most cases it's hard to ensure "
@@ -111,10 +111,10 @@ class PacketBase {
   }
 
  protected:
-  explicit PacketBase(std::shared_ptr<const HolderBase> payload)
+  explicit PacketBase(packet_internal::HolderPtr payload)
       : payload_(std::move(payload)) {}
 
-  std::shared_ptr<const HolderBase> payload_;
+  packet_internal::HolderPtr payload_;
   Timestamp timestamp_;
 
   template <typename T>
@@ -245,7 +245,7 @@ class Packet<internal::Generic> : public PacketBase {
   Packet<internal::Generic> At(Timestamp timestamp) &&;
 
  protected:
-  explicit Packet(std::shared_ptr<const HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : PacketBase(std::move(payload)) {}
 
   friend PacketBase;
@@ -279,8 +279,8 @@ class Packet : public Packet<internal::Generic> {
   // DEPRECATED
   //
   // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.unique(), which is deprecated and is not guaranteed
-  // to give exact results.
+  // it relies on the holder's reference count, which is not guaranteed to give
+  // exact results while other threads copy the packet.
   ABSL_DEPRECATED(
       "Avoid Consume* functions usage as in most cases it's hard to ensure "
       "the proper usage (taken the nature of calculators not knowing where "
@@ -295,7 +295,7 @@ class Packet : public Packet<internal::Generic> {
   }
 
  private:
-  explicit Packet(std::shared_ptr<const HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : Packet<internal::Generic>(std::move(payload)) {}
 
   friend PacketBase;
@@ -425,8 +425,8 @@ class Packet<OneOf<T...>> : public PacketBase {
   // DEPRECATED
   //
   // Note: Consume is included for compatibility with the old Packet; however,
-  // it relies on shared_ptr.unique(), which is deprecated and is not guaranteed
-  // to give exact results.
+  // it relies on the holder's reference count, which is not guaranteed to give
+  // exact results while other threads copy the packet.
   template <class U, class = AllowedType<U>>
   ABSL_DEPRECATED(
       "Avoid Consume* functions usage as in most cases it's hard to ensure "
@@ -459,7 +459,7 @@ class Packet<OneOf<T...>> : public PacketBase {
   }
 
  protected:
-  explicit Packet(std::shared_ptr<const HolderBase> payload)
+  explicit Packet(packet_internal::HolderPtr payload)
       : PacketBase(std::move(payload)) {}
 
   friend PacketBase;
@@ -530,18 +530,25 @@ inline Packet<internal::Generic> Packet<internal::Generic>::At(
 
 template <typename T, typename... Args>
 Packet<T> MakePacket(Args&&... args) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
-      new T(std::forward<Args>(args)...)));
+  if constexpr (std::is_nothrow_move_constructible_v<T>) {
+    return Packet<T>(packet_internal::HolderPtr(
+        new packet_internal::InlineHolder<T>(std::forward<Args>(args)...)));
+  } else {
+    return Packet<T>(packet_internal::HolderPtr(
+        new packet_internal::Holder<T>(new T(std::forward<Args>(args)...))));
+  }
 }
 
 template <typename T>
 Packet<T> PacketAdopting(const T* ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr));
+  return Packet<T>(
+      packet_internal::HolderPtr(new packet_internal::Holder<T>(ptr)));
 }
 
 template <typename T>
 Packet<T> PacketAdopting(std::unique_ptr<T> ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr.release()));
+  return Packet<T>(packet_internal::HolderPtr(
+      new packet_internal::Holder<T>(ptr.release())));
 }
 
 }  // namespace api2
@@ -600,6 +600,14 @@ class InputShardAccess : public Packet<T> {
 
   PacketBase Header() const { return FromOldPacket(stream_->Header()); }
 
+  // Returns the packet of the input set at "index" when the node processes a
+  // batch of input sets (see Node::kMaxBatch). InBatch(0) is the same packet
+  // as this object.
+  Packet<T> InBatch(int index) const {
+    return stream_ ? FromOldPacket(stream_->ValueInBatch(index)).template As<T>()
+                   : Packet<T>();
+  }
+
   // "Consume" requires exclusive ownership of the packet's payload. In the
   // current interim implementation, InputShardAccess creates a new reference to
   // the payload (as a Packet<T> instead of a type-erased Packet), which means
@@ -157,6 +157,20 @@ class CalculatorBase {
   // documentation for the suggested solution.
   virtual absl::Status Close(CalculatorContext* cc) { return absl::OkStatus(); }
 
+  // Is called instead of Close() when a graph run is ended early by
+  // CalculatorGraph::ResetRun().  Subclasses may override this method to
+  // discard any state carried over from earlier packets, so that the same
+  // calculator can continue with the next run without Close() and Open().
+  // Resources acquired in Open(), output side packets, and output stream
+  // headers are kept.  No packets may be output during a call to Reset().
+  //
+  // The default implementation returns absl::UnimplementedError(), in which
+  // case the framework calls Close() and replaces the calculator with a
+  // freshly constructed and opened one for the next run.
+  virtual absl::Status Reset(CalculatorContext* cc) {
+    return absl::UnimplementedError("Reset() is not supported.");
+  }
+
   // Returns a value according to which the framework selects
   // the next source calculator to Process(); smaller value means
   // Process() first. The default implementation returns the smallest
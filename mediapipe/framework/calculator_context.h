@@ -16,7 +16,6 @@
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
 
@@ -24,6 +23,7 @@
 #include "absl/status/status.h"
 #include "mediapipe/framework/calculator_state.h"
 #include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -94,6 +94,18 @@ class CalculatorContext {
                                      : input_timestamps_.front();
   }
 
+  // Returns the number of input sets passed to the current Process call.
+  // This is always 1 unless the calculator contract set a max batch size
+  // (see CalculatorContract::SetMaxBatchSize).
+  int BatchSize() const { return batch_size_; }
+
+  // Returns the input timestamp of the input set at "index" in the current
+  // batch. InputTimestampInBatch(0) is the same as InputTimestamp().
+  Timestamp InputTimestampInBatch(int index) const {
+    ABSL_CHECK_LT(index, batch_size_);
+    return input_timestamps_[index];
+  }
+
   // Returns a reference to the input side packet set.
   const PacketSet& InputSidePackets() const;
   // Returns a reference to the output side packet collection.
@@ -166,16 +178,18 @@ class CalculatorContext {
 
   // Adds a new input timestamp by the friend class CalculatorContextManager.
   void PushInputTimestamp(Timestamp input_timestamp) {
-    input_timestamps_.push(input_timestamp);
+    input_timestamps_.push_back(input_timestamp);
   }
 
   void PopInputTimestamp() {
     ABSL_CHECK(!input_timestamps_.empty());
-    input_timestamps_.pop();
+    input_timestamps_.pop_front();
   }
 
   void SetGraphStatus(const absl::Status& status) { graph_status_ = status; }
 
+  void SetBatchSize(int batch_size) { batch_size_ = batch_size; }
+
   // Interface for the friend class Calculator.
   const InputStreamSet& InputStreams() const;
   const OutputStreamSet& OutputStreams() const;
@@ -193,13 +207,17 @@ class CalculatorContext {
   mutable std::unique_ptr<InputStreamSet> input_streams_;
   mutable std::unique_ptr<OutputStreamSet> output_streams_;
   // The queue of timestamp values to Process() in this calculator context.
-  std::queue<Timestamp> input_timestamps_;
+  RingQueue<Timestamp> input_timestamps_;
+  // The number of input sets passed to the current Process call.
+  int batch_size_ = 1;
 
   // The status of the graph run. Only used when Close() is called.
   absl::Status graph_status_;
 
   // Accesses CalculatorContext for setting input timestamp.
   friend class CalculatorContextManager;
+  // Accesses CalculatorContext for running the calculators of a fused node.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
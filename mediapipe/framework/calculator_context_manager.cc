@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_context_manager.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "absl/log/absl_check.h"
@@ -27,12 +28,13 @@ void CalculatorContextManager::Initialize(
     CalculatorState* calculator_state,
     std::shared_ptr<tool::TagMap> input_tag_map,
     std::shared_ptr<tool::TagMap> output_tag_map,
-    bool calculator_run_in_parallel) {
+    bool calculator_run_in_parallel, int max_in_flight) {
   ABSL_CHECK(calculator_state);
   calculator_state_ = calculator_state;
   input_tag_map_ = std::move(input_tag_map);
   output_tag_map_ = std::move(output_tag_map);
   calculator_run_in_parallel_ = calculator_run_in_parallel;
+  max_in_flight_ = std::max(max_in_flight, 1);
 }
 
 absl::Status CalculatorContextManager::PrepareForRun(
@@ -40,6 +42,12 @@ absl::Status CalculatorContextManager::PrepareForRun(
   setup_shards_callback_ = std::move(setup_shards_callback);
   default_context_ = absl::make_unique<CalculatorContext>(
       calculator_state_, input_tag_map_, output_tag_map_);
+  if (calculator_run_in_parallel_) {
+    absl::MutexLock lock(&contexts_mutex_);
+    all_contexts_.reserve(max_in_flight_);
+    idle_contexts_.reserve(max_in_flight_);
+    active_contexts_.reserve(max_in_flight_);
+  }
   return setup_shards_callback_(default_context_.get());
 }
 
@@ -48,6 +56,7 @@ void CalculatorContextManager::CleanupAfterRun() {
   absl::MutexLock lock(&contexts_mutex_);
   active_contexts_.clear();
   idle_contexts_.clear();
+  all_contexts_.clear();
 }
 
 CalculatorContext* CalculatorContextManager::GetDefaultCalculatorContext()
@@ -61,8 +70,16 @@ CalculatorContext* CalculatorContextManager::GetFrontCalculatorContext(
   ABSL_CHECK(calculator_run_in_parallel_);
   absl::MutexLock lock(&contexts_mutex_);
   ABSL_CHECK(!active_contexts_.empty());
-  *context_input_timestamp = active_contexts_.begin()->first;
-  return active_contexts_.begin()->second.get();
+  *context_input_timestamp = active_contexts_.front().input_timestamp;
+  return active_contexts_.front().context;
+}
+
+CalculatorContext* CalculatorContextManager::CreateCalculatorContext() {
+  auto new_context = absl::make_unique<CalculatorContext>(
+      calculator_state_, input_tag_map_, output_tag_map_);
+  MEDIAPIPE_CHECK_OK(setup_shards_callback_(new_context.get()));
+  all_contexts_.push_back(std::move(new_context));
+  return all_contexts_.back().get();
 }
 
 CalculatorContext* CalculatorContextManager::PrepareCalculatorContext(
@@ -71,23 +88,28 @@ CalculatorContext* CalculatorContextManager::PrepareCalculatorContext(
     return GetDefaultCalculatorContext();
   }
   absl::MutexLock lock(&contexts_mutex_);
-  ABSL_CHECK(!mediapipe::ContainsKey(active_contexts_, input_timestamp))
-      << "Multiple invocations with the same timestamps are not allowed with "
-         "parallel execution, input_timestamp = "
-      << input_timestamp;
-  CalculatorContext* calculator_context = nullptr;
   if (idle_contexts_.empty()) {
-    auto new_context = absl::make_unique<CalculatorContext>(
-        calculator_state_, input_tag_map_, output_tag_map_);
-    MEDIAPIPE_CHECK_OK(setup_shards_callback_(new_context.get()));
-    calculator_context = new_context.get();
-    active_contexts_.emplace(input_timestamp, std::move(new_context));
-  } else {
-    // Retrieves an inactive calculator context from idle_contexts_.
-    calculator_context = idle_contexts_.front().get();
-    active_contexts_.emplace(input_timestamp,
-                             std::move(idle_contexts_.front()));
-    idle_contexts_.pop_front();
+    // The first invocation creates the whole pool. This happens after the
+    // node is opened, so that the input shards pick up the stream headers.
+    const int num_new_contexts = all_contexts_.empty() ? max_in_flight_ : 1;
+    for (int i = 0; i < num_new_contexts; ++i) {
+      idle_contexts_.push_back(CreateCalculatorContext());
+    }
+  }
+  // Retrieves an inactive calculator context from idle_contexts_.
+  CalculatorContext* calculator_context = idle_contexts_.back();
+  idle_contexts_.pop_back();
+  // Input timestamps normally arrive in increasing order, so the new context
+  // goes to the back. Otherwise, it is moved into place.
+  active_contexts_.push_back({input_timestamp, calculator_context});
+  for (size_t i = active_contexts_.size() - 1; i > 0; --i) {
+    ActiveContext& previous = active_contexts_[i - 1];
+    ABSL_CHECK_NE(previous.input_timestamp, input_timestamp)
+        << "Multiple invocations with the same timestamps are not allowed with "
+           "parallel execution, input_timestamp = "
+        << input_timestamp;
+    if (previous.input_timestamp < input_timestamp) break;
+    std::swap(previous, active_contexts_[i]);
   }
   return calculator_context;
 }
@@ -95,9 +117,8 @@ CalculatorContext* CalculatorContextManager::PrepareCalculatorContext(
 void CalculatorContextManager::RecycleCalculatorContext() {
   absl::MutexLock lock(&contexts_mutex_);
   // The first element in active_contexts_ will be recycled.
-  auto iter = active_contexts_.begin();
-  idle_contexts_.push_back(std::move(iter->second));
-  active_contexts_.erase(iter);
+  idle_contexts_.push_back(active_contexts_.front().context);
+  active_contexts_.pop_front();
 }
 
 bool CalculatorContextManager::HasActiveContexts() {
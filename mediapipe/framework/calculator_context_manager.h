@@ -15,16 +15,16 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_MANAGER_H_
 
-#include <deque>
 #include <functional>
-#include <map>
 #include <memory>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/log/absl_check.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_state.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/timestamp.h"
@@ -38,10 +38,13 @@ class CalculatorContextManager {
  public:
   CalculatorContextManager() {}
 
+  // For parallel execution, the first invocation of each run creates
+  // "max_in_flight" calculator contexts, which are reused for all later
+  // invocations.
   void Initialize(CalculatorState* calculator_state,
                   std::shared_ptr<tool::TagMap> input_tag_map,
                   std::shared_ptr<tool::TagMap> output_tag_map,
-                  bool calculator_run_in_parallel);
+                  bool calculator_run_in_parallel, int max_in_flight = 1);
 
   // Sets the callback that can setup the input and output stream shards in a
   // newly constructed calculator context. Then, initializes the default
@@ -69,9 +72,10 @@ class CalculatorContextManager {
       Timestamp* context_input_timestamp) ABSL_LOCKS_EXCLUDED(contexts_mutex_);
 
   // For sequential execution, returns a pointer to the default calculator
-  // context. For parallel execution, creates or reuses a calculator context,
-  // and inserts the calculator context with the given input timestamp into
-  // active_contexts_. Returns a pointer to the prepared calculator context.
+  // context. For parallel execution, reuses an idle calculator context (or
+  // creates one if all are active), and inserts the calculator context with
+  // the given input timestamp into active_contexts_. Returns a pointer to the
+  // prepared calculator context.
   // The ownership of the calculator context object isn't tranferred to the
   // caller.
   CalculatorContext* PrepareCalculatorContext(Timestamp input_timestamp)
@@ -96,6 +100,12 @@ class CalculatorContextManager {
     return calculator_context.HasInputTimestamp();
   }
 
+  // Returns the input timestamp at "index" in the queue of the context.
+  Timestamp ContextInputTimestamp(const CalculatorContext& calculator_context,
+                                  int index) const {
+    return calculator_context.input_timestamps_[index];
+  }
+
   void PushInputTimestampToContext(CalculatorContext* calculator_context,
                                    Timestamp input_timestamp) {
     ABSL_CHECK(calculator_context);
@@ -107,6 +117,12 @@ class CalculatorContextManager {
     calculator_context->PopInputTimestamp();
   }
 
+  void SetBatchSizeInContext(CalculatorContext* calculator_context,
+                             int batch_size) {
+    ABSL_CHECK(calculator_context);
+    calculator_context->SetBatchSize(batch_size);
+  }
+
   void SetGraphStatusInContext(CalculatorContext* calculator_context,
                                const absl::Status& status) {
     ABSL_CHECK(calculator_context);
@@ -114,10 +130,22 @@ class CalculatorContextManager {
   }
 
  private:
+  // A calculator context that is prepared for an input timestamp.
+  struct ActiveContext {
+    Timestamp input_timestamp;
+    CalculatorContext* context = nullptr;
+  };
+
+  // Creates a calculator context with its input and output stream shards set
+  // up, and adds it to all_contexts_.
+  CalculatorContext* CreateCalculatorContext()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(contexts_mutex_);
+
   CalculatorState* calculator_state_;
   std::shared_ptr<tool::TagMap> input_tag_map_;
   std::shared_ptr<tool::TagMap> output_tag_map_;
   bool calculator_run_in_parallel_;
+  int max_in_flight_ = 1;
 
   // The callback to setup the input and output stream shards in a newly
   // constructed calculator context.
@@ -133,11 +161,14 @@ class CalculatorContextManager {
   // The mutex for synchronizing the operations on active_contexts_ and
   // idle_contexts_ during parallel execution.
   absl::Mutex contexts_mutex_;
-  // A map from input timestamps to calculator contexts.
-  std::map<Timestamp, std::unique_ptr<CalculatorContext>> active_contexts_
+  // Owns the calculator contexts used for parallel execution. Each of them is
+  // either in active_contexts_ or in idle_contexts_.
+  std::vector<std::unique_ptr<CalculatorContext>> all_contexts_
       ABSL_GUARDED_BY(contexts_mutex_);
+  // The prepared calculator contexts, sorted by input timestamp.
+  RingQueue<ActiveContext> active_contexts_ ABSL_GUARDED_BY(contexts_mutex_);
   // Idle calculator contexts that are ready for reuse.
-  std::deque<std::unique_ptr<CalculatorContext>> idle_contexts_
+  std::vector<CalculatorContext*> idle_contexts_
       ABSL_GUARDED_BY(contexts_mutex_);
 };
 
@@ -138,6 +138,37 @@ class CalculatorContract {
   void SetTimestampOffset(TimestampDiff offset) { timestamp_offset_ = offset; }
   TimestampDiff GetTimestampOffset() const { return timestamp_offset_; }
 
+  // Allows Process to receive up to max_batch_size input sets in a single
+  // call. Input sets that are ready together are then handed to the
+  // calculator at once, instead of one Process call per input timestamp.
+  // Inside Process, CalculatorContext::BatchSize() gives the number of input
+  // sets, and CalculatorContext::InputTimestampInBatch(i) and
+  // InputStreamShard::ValueInBatch(i) give the timestamp and the packets of
+  // each set. A batch is never held back to wait for more input, so batching
+  // adds no latency. Batching cannot be combined with max_in_flight > 1.
+  void SetMaxBatchSize(int max_batch_size) { max_batch_size_ = max_batch_size; }
+  int GetMaxBatchSize() const { return max_batch_size_; }
+
+  // Declares that Process is cheap, so that the framework may run it right
+  // away on the thread whose outputs made the calculator ready, instead of
+  // adding it to the scheduler queue for another executor task. Suited to
+  // small transforms such as gates and vector splits; calculators that block
+  // or take a noticeable time must not set it. Timestamp semantics are
+  // unchanged. Source calculators are never run inline, and graphs can turn
+  // inline execution off with CalculatorGraphConfig::disable_inline_execution.
+  void SetInlineExecution(bool inline_execution) {
+    inline_execution_ = inline_execution;
+  }
+  bool GetInlineExecution() const { return inline_execution_; }
+
+  // Declares that the calculator outputs packets only from Process, and only
+  // at the input timestamp, so that CalculatorGraphConfig::fuse_calculators
+  // may run it inside a FusedCalculator together with the calculators it
+  // feeds. Only meaningful with SetInlineExecution and a timestamp offset of
+  // 0. FusedCalculator fails the graph if the calculator breaks the promise.
+  void SetFusable(bool fusable) { fusable_ = fusable; }
+  bool GetFusable() const { return fusable_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -210,6 +241,9 @@ class CalculatorContract {
   ServiceReqMap service_requests_;
   bool process_timestamps_ = false;
   TimestampDiff timestamp_offset_ = TimestampDiff::Unset();
+  int max_batch_size_ = 1;
+  bool inline_execution_ = false;
+  bool fusable_ = false;
 
   friend class CalculatorNode;
 };
@@ -37,6 +37,8 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -251,20 +253,30 @@ absl::Status CalculatorGraph::InitializeStreams() {
   return absl::OkStatus();
 }
 
+#if !MEDIAPIPE_DISABLE_GPU
 // Hack for backwards compatibility with ancient GPU calculators. Can it
 // be retired yet?
-static void MaybeFixupLegacyGpuNodeContract(CalculatorNode& node) {
-#if !MEDIAPIPE_DISABLE_GPU
-  if (node.Contract().InputSidePackets().HasTag(kGpuSharedTagName)) {
-    const_cast<CalculatorContract&>(node.Contract()).UseService(kGpuService);
+// Applied by ValidatedGraphConfig while it builds the node contracts.
+static void FixupLegacyGpuNodeContract(CalculatorContract& contract) {
+  if (contract.InputSidePackets().HasTag(kGpuSharedTagName)) {
+    contract.UseService(kGpuService);
   }
-#endif  // !MEDIAPIPE_DISABLE_GPU
 }
 
+static const bool kLegacyGpuNodeContractFixupRegistered = [] {
+  internal::RegisterLegacyContractFixup(&FixupLegacyGpuNodeContract);
+  return true;
+}();
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
 absl::Status CalculatorGraph::InitializeCalculatorNodes() {
   // Check if the user has specified a maximum queue size for an input stream.
   max_queue_size_ = validated_graph_->Config().max_queue_size();
   max_queue_size_ = max_queue_size_ ? max_queue_size_ : 100;
+  max_queue_bytes_ = validated_graph_->Config().max_queue_bytes();
+  target_queue_delay_ = absl::Microseconds(
+      std::max<int64_t>(validated_graph_->Config().target_queue_delay_usec(),
+                        0));
 
   // Use a local variable to avoid needing to lock errors_.
   std::vector<absl::Status> errors;
@@ -281,7 +293,6 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
         validated_graph_.get(), node_ref, input_stream_managers_.get(),
         output_stream_managers_.get(), output_side_packets_.get(),
         &buffer_size_hint, profiler_, service_manager_);
-    MaybeFixupLegacyGpuNodeContract(*nodes_.back());
     if (buffer_size_hint > 0) {
       max_queue_size_ = std::max(max_queue_size_, buffer_size_hint);
     }
@@ -319,7 +330,6 @@ absl::Status CalculatorGraph::InitializePacketGeneratorNodes(
         validated_graph_.get(), node_ref, input_stream_managers_.get(),
         output_stream_managers_.get(), output_side_packets_.get(),
         &buffer_size_hint, profiler_, service_manager_);
-    MaybeFixupLegacyGpuNodeContract(*nodes_.back());
     if (!result.ok()) {
       // Collect as many errors as we can before failing.
       errors.push_back(result);
@@ -437,7 +447,7 @@ absl::Status CalculatorGraph::InitializeDefaultExecutor(
 }
 
 absl::Status CalculatorGraph::Initialize(
-    std::unique_ptr<ValidatedGraphConfig> validated_graph,
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph,
     const std::map<std::string, Packet>& side_packets) {
   RET_CHECK(!initialized_).SetNoLogging()
       << "CalculatorGraph can be initialized only once.";
@@ -445,6 +455,17 @@ absl::Status CalculatorGraph::Initialize(
       << "validated_graph is not initialized.";
   validated_graph_ = std::move(validated_graph);
 
+  scheduler_.SetNumQueueShards(
+      validated_graph_->Config().scheduler_queue_shards());
+  scheduler_.SetOldestTimestampFirst(
+      validated_graph_->Config().scheduling_policy() ==
+      CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST);
+  scheduler_.SetShardByNumaNode(
+      validated_graph_->Config().numa_aware_scheduling());
+  scheduler_.SetInlineExecution(
+      !validated_graph_->Config().disable_inline_execution());
+  timestamp_deadline_ =
+      absl::Microseconds(validated_graph_->Config().timestamp_deadline_usec());
   MP_RETURN_IF_ERROR(InitializeExecutors());
   MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
   MP_RETURN_IF_ERROR(InitializeStreams());
@@ -589,9 +610,58 @@ absl::Status CalculatorGraph::StartRun(
   MP_RETURN_IF_ERROR(PrepareForRun(extra_side_packets, stream_headers));
   MP_RETURN_IF_ERROR(profiler_->Start(executors_[""].get()));
   scheduler_.Start();
+  current_run_extra_side_packets_ = extra_side_packets;
+  current_run_stream_headers_ = stream_headers;
   return absl::OkStatus();
 }
 
+absl::Status CalculatorGraph::ResetRun() {
+  RET_CHECK(!has_sources_).SetNoLogging()
+      << "ResetRun() is not supported on a graph with source nodes: "
+      << ListSourceNodes();
+  MP_RETURN_IF_ERROR(WaitUntilIdle());
+  absl::Status status;
+  for (auto& node : nodes_) {
+    status = node->ResetCalculator();
+    if (!status.ok()) break;
+  }
+  if (status.ok()) {
+    status = scheduler_.EndIdleRun();
+  }
+  if (!status.ok()) {
+    // The run goes on, so the calculators reset so far must be closed with
+    // the others when it ends.
+    for (auto& node : nodes_) {
+      node->CancelReset();
+    }
+    return status;
+  }
+  // The calculators without Reset() are closed as at the end of a run, and
+  // fail the run if Close() fails.
+  for (auto& node : nodes_) {
+    absl::Status close_status = node->CloseUnresetCalculator();
+    if (!close_status.ok()) {
+      RecordError(close_status);
+    }
+  }
+  status = FinishRun();
+  if (status.ok()) {
+    // StartRun() replaces the saved side packets and headers.
+    std::map<std::string, Packet> extra_side_packets =
+        std::move(current_run_extra_side_packets_);
+    std::map<std::string, Packet> stream_headers =
+        std::move(current_run_stream_headers_);
+    status = StartRun(extra_side_packets, stream_headers);
+  }
+  if (!status.ok()) {
+    // No run reuses the reset calculators, so they are closed now.
+    for (auto& node : nodes_) {
+      node->CloseResetCalculator(status);
+    }
+  }
+  return status;
+}
+
 #if !MEDIAPIPE_DISABLE_GPU
 absl::Status CalculatorGraph::SetGpuResources(
     std::shared_ptr<::mediapipe::GpuResources> resources) {
@@ -712,6 +782,14 @@ absl::Status CalculatorGraph::PrepareForRun(
   }
   num_closed_graph_input_streams_ = 0;
 
+  if (timestamp_deadline_ > absl::ZeroDuration()) {
+    RET_CHECK(!graph_output_streams_.empty())
+        << "timestamp_deadline_usec requires an observed graph output stream.";
+    absl::MutexLock lock(&deadline_mutex_);
+    admitted_timestamps_.clear();
+    latest_decided_timestamp_ = Timestamp::Unset();
+  }
+
   std::map<std::string, Packet> additional_side_packets;
 #if !MEDIAPIPE_DISABLE_GPU
   auto legacy_sp = GetLegacyGpuSharedSidePacket(extra_side_packets);
@@ -838,6 +916,8 @@ absl::Status CalculatorGraph::PrepareForRun(
   // streams.
   for (auto& node : nodes_) {
     node->SetMaxInputStreamQueueSize(max_queue_size_);
+    node->SetMaxInputStreamQueueBytes(max_queue_bytes_);
+    node->SetInputStreamTargetQueueDelay(target_queue_delay_);
   }
 
   // Allow graph input streams to override the global max queue size.
@@ -989,6 +1069,10 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
       }
     }
   }
+  if (timestamp_deadline_ > absl::ZeroDuration() &&
+      ShouldDropTimestamp(packet.Timestamp())) {
+    return absl::OkStatus();
+  }
 
   // Adding profiling info for a new packet entering the graph.
   const std::string* stream_id = &(*stream)->GetManager()->Name();
@@ -1020,6 +1104,40 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
   return absl::OkStatus();
 }
 
+bool CalculatorGraph::ShouldDropTimestamp(Timestamp timestamp) {
+  // A timestamp is settled once every graph output stream has moved past it.
+  Timestamp settled = Timestamp::Done();
+  for (auto& graph_output_stream : graph_output_streams_) {
+    settled = std::min(
+        settled, graph_output_stream->input_stream()->MinTimestampOrBound(
+                     /*is_empty=*/nullptr));
+  }
+  absl::MutexLock lock(&deadline_mutex_);
+  while (!admitted_timestamps_.empty() &&
+         admitted_timestamps_.front().first < settled) {
+    admitted_timestamps_.pop_front();
+  }
+  if (timestamp <= latest_decided_timestamp_) {
+    // Another graph input stream has already added or dropped this
+    // timestamp, unless it is settled, in which case the graph input stream
+    // reports the error.
+    return timestamp >= settled &&
+           std::none_of(admitted_timestamps_.begin(),
+                        admitted_timestamps_.end(), [timestamp](auto& item) {
+                          return item.first == timestamp;
+                        });
+  }
+  latest_decided_timestamp_ = timestamp;
+  const absl::Time now = absl::Now();
+  if (!admitted_timestamps_.empty() &&
+      now - admitted_timestamps_.front().second > timestamp_deadline_) {
+    counter_factory_->GetCounter("DroppedTimestamps")->Increment();
+    return true;
+  }
+  admitted_timestamps_.emplace_back(timestamp, now);
+  return false;
+}
+
 absl::Status CalculatorGraph::SetInputStreamMaxQueueSize(
     const std::string& stream_name, int max_queue_size) {
   // graph_input_streams_ has not been filled in yet, so we'll check this when
@@ -1106,7 +1224,7 @@ bool CalculatorGraph::GetCombinedErrors(absl::Status* error_status) {
   return GetCombinedErrors("CalculatorGraph::Run() failed: ", error_status);
 }
 
-bool CalculatorGraph::GetCombinedErrors(const std::string& error_prefix,
+bool CalculatorGraph::GetCombinedErrors(absl::string_view error_prefix,
                                         absl::Status* error_status) {
   absl::MutexLock lock(&error_mutex_);
   if (!errors_.empty()) {
@@ -1246,7 +1364,8 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
 
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
   absl::MutexLock lock(&full_input_streams_mutex_);
-  return max_queue_size_ != -1 && !full_input_streams_[node_id].empty();
+  return (max_queue_size_ != -1 || max_queue_bytes_ > 0) &&
+         !full_input_streams_[node_id].empty();
 }
 
 // Returns true if an input stream serves as a graph-output-stream.
@@ -1293,13 +1412,27 @@ bool CalculatorGraph::UnthrottleSources() {
           "\"report_deadlock\".")));
       continue;
     }
-    int new_size = stream->QueueSize() + 1;
-    stream->SetMaxQueueSize(new_size);
-    ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
-        "Resolved a deadlock by increasing max_queue_size of input stream: \"",
-        stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
-        "\" to ", new_size,
-        ". Consider increasing max_queue_size for better performance.");
+    if (stream->MaxQueueSize() != -1) {
+      int new_size = stream->QueueSize() + 1;
+      stream->SetMaxQueueSize(new_size);
+      ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
+          "Resolved a deadlock by increasing max_queue_size of input stream: "
+          "\"",
+          stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
+          "\" to ", new_size,
+          ". Consider increasing max_queue_size for better performance.");
+    }
+    if (stream->IsFull()) {
+      // The stream is also over its byte budget.
+      const int64_t new_bytes = stream->QueueBytes() + 1;
+      stream->SetMaxQueueBytes(new_bytes);
+      ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
+          "Resolved a deadlock by increasing max_queue_bytes of input stream: "
+          "\"",
+          stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
+          "\" to ", new_bytes,
+          ". Consider increasing max_queue_bytes for better performance.");
+    }
   }
   return !full_streams.empty();
 }
@@ -19,6 +19,7 @@
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_H_
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -34,6 +35,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
@@ -151,6 +153,12 @@ class CalculatorGraph {
       const std::string& graph_type = "",
       const Subgraph::SubgraphOptions* options = nullptr);
 
+  // Initializes the graph from an initialized ValidatedGraphConfig, which
+  // can be shared by several graphs.  See ValidatedGraphConfigCache.
+  absl::Status Initialize(
+      std::shared_ptr<const ValidatedGraphConfig> validated_graph,
+      const std::map<std::string, Packet>& side_packets = {});
+
   // Returns the canonicalized CalculatorGraphConfig for this graph.
   const CalculatorGraphConfig& Config() const {
     return validated_graph_->Config();
@@ -246,6 +254,23 @@ class CalculatorGraph {
   // source nodes.
   absl::Status WaitUntilIdle();
 
+  // Ends the current run and starts a new run with the same side packets and
+  // stream headers, for a graph that can be reused by independent sessions.
+  // Waits until the graph is idle, then calls Calculator::Reset() in place of
+  // Close().  Calculators that support Reset() are kept, so the new run does
+  // not construct or Open() them again; the others are closed and reopened.
+  // Packets and timestamp bounds from the current run are discarded, and the
+  // graph input streams accept any timestamp again.
+  //
+  // Can be called only after StartRun(), and only on a graph without source
+  // nodes.  The application must ensure no other threads are adding packets
+  // to graph input streams while ResetRun() is in progress.  If a calculator
+  // fails to reset, the graph is still running and should be cancelled;
+  // calculators reset before the failure are then closed like the others.
+  // If the run fails to end, for example because Close() fails, or the new
+  // run fails to start, the reset calculators are closed before returning.
+  absl::Status ResetRun();
+
   // Wait until a packet is emitted on one of the observed output streams.
   // Returns immediately if a packet has already been emitted since the last
   // call to this function.
@@ -346,7 +371,7 @@ class CalculatorGraph {
 
   // Combines errors into a status. Returns true if the vector of errors is
   // non-empty.
-  bool GetCombinedErrors(const std::string& error_prefix,
+  bool GetCombinedErrors(absl::string_view error_prefix,
                          absl::Status* error_status);
   // Convenience overload which specifies a default error prefix.
   bool GetCombinedErrors(absl::Status* error_status);
@@ -531,10 +556,6 @@ class CalculatorGraph {
     OutputStreamShard shard_;
   };
 
-  // Initializes the graph from a ValidatedGraphConfig object.
-  absl::Status Initialize(std::unique_ptr<ValidatedGraphConfig> validated_graph,
-                          const std::map<std::string, Packet>& side_packets);
-
   // AddPacketToInputStreamInternal template is called by either
   // AddPacketToInputStream(Packet&& packet) or
   // AddPacketToInputStream(const Packet& packet).
@@ -542,6 +563,12 @@ class CalculatorGraph {
   absl::Status AddPacketToInputStreamInternal(absl::string_view stream_name,
                                               T&& packet);
 
+  // Returns true if a packet added to a graph input stream at timestamp
+  // should be dropped to meet timestamp_deadline_usec.  Drops either all or
+  // none of the packets of each timestamp.
+  bool ShouldDropTimestamp(Timestamp timestamp)
+      ABSL_LOCKS_EXCLUDED(deadline_mutex_);
+
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
   // Does not check that the graph is uninitialized and |name| is not a
@@ -647,7 +674,7 @@ class CalculatorGraph {
   PacketType any_packet_type_;
 
   // The ValidatedGraphConfig object defining this CalculatorGraph.
-  std::unique_ptr<ValidatedGraphConfig> validated_graph_;
+  std::shared_ptr<const ValidatedGraphConfig> validated_graph_;
 
   // The PacketGeneratorGraph to use to generate all the input side packets.
   PacketGeneratorGraph packet_generator_graph_;
@@ -671,9 +698,27 @@ class CalculatorGraph {
   std::vector<std::shared_ptr<internal::GraphOutputStream>>
       graph_output_streams_;
 
+  // The latency budget of each timestamp, or zero if timestamps are never
+  // dropped.  See CalculatorGraphConfig::timestamp_deadline_usec.
+  absl::Duration timestamp_deadline_ = absl::ZeroDuration();
+  absl::Mutex deadline_mutex_;
+  // The unsettled timestamps added to graph input streams, in increasing
+  // order, with the times at which they were first added.
+  std::deque<std::pair<Timestamp, absl::Time>> admitted_timestamps_
+      ABSL_GUARDED_BY(deadline_mutex_);
+  // The latest timestamp admitted or dropped by ShouldDropTimestamp.
+  Timestamp latest_decided_timestamp_ ABSL_GUARDED_BY(deadline_mutex_) =
+      Timestamp::Unset();
+
   // Maximum queue size for an input stream. This is used by the scheduler to
   // restrict memory usage.
   int max_queue_size_ = -1;
+  // Maximum number of bytes queued in an input stream, if positive. See
+  // CalculatorGraphConfig::max_queue_bytes.
+  int64_t max_queue_bytes_ = 0;
+  // Target queueing delay of each input stream, if positive. See
+  // CalculatorGraphConfig::target_queue_delay_usec.
+  absl::Duration target_queue_delay_ = absl::ZeroDuration();
 
   // Mode for adding packets to a graph input stream. Set to block until all
   // affected input streams are not full by default.
@@ -712,6 +757,11 @@ class CalculatorGraph {
   // The processed input side packet map for this run.
   std::map<std::string, Packet> current_run_side_packets_;
 
+  // The side packets and stream headers passed to StartRun(), which are
+  // reused by ResetRun().
+  std::map<std::string, Packet> current_run_extra_side_packets_;
+  std::map<std::string, Packet> current_run_stream_headers_;
+
   // Object to manage graph services.
   std::shared_ptr<GraphServiceManager> service_manager_;
 
@@ -0,0 +1,117 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <utility>
+
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+// static
+absl::StatusOr<std::unique_ptr<CalculatorGraphPool>>
+CalculatorGraphPool::Create(Options options) {
+  RET_CHECK_GE(options.max_idle_graphs, 0);
+  auto validated_graph = std::make_shared<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->Initialize(options.config));
+  const int initial_graphs = options.initial_graphs;
+  std::unique_ptr<CalculatorGraphPool> pool(
+      new CalculatorGraphPool(std::move(options), std::move(validated_graph)));
+  for (int i = 0; i < initial_graphs; ++i) {
+    MP_ASSIGN_OR_RETURN(auto graph, pool->StartGraph());
+    absl::MutexLock lock(&pool->mutex_);
+    pool->idle_graphs_.push_back(std::move(graph));
+  }
+  return pool;
+}
+
+CalculatorGraphPool::CalculatorGraphPool(
+    Options options,
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph)
+    : options_(std::move(options)),
+      validated_graph_(std::move(validated_graph)) {}
+
+CalculatorGraphPool::~CalculatorGraphPool() {
+  std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+  {
+    absl::MutexLock lock(&mutex_);
+    graphs.swap(idle_graphs_);
+  }
+  for (auto& graph : graphs) {
+    ShutDown(std::move(graph)).IgnoreError();
+  }
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraph>>
+CalculatorGraphPool::Acquire() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!idle_graphs_.empty()) {
+      std::unique_ptr<CalculatorGraph> graph = std::move(idle_graphs_.back());
+      idle_graphs_.pop_back();
+      return graph;
+    }
+  }
+  return StartGraph();
+}
+
+absl::Status CalculatorGraphPool::Release(
+    std::unique_ptr<CalculatorGraph> graph) {
+  RET_CHECK(graph);
+  bool pool_full;
+  {
+    absl::MutexLock lock(&mutex_);
+    pool_full =
+        static_cast<int>(idle_graphs_.size()) >= options_.max_idle_graphs;
+  }
+  if (pool_full) {
+    return ShutDown(std::move(graph));
+  }
+  absl::Status status = graph->ResetRun();
+  if (!status.ok()) {
+    ShutDown(std::move(graph)).IgnoreError();
+    return status;
+  }
+  absl::MutexLock lock(&mutex_);
+  idle_graphs_.push_back(std::move(graph));
+  return absl::OkStatus();
+}
+
+int CalculatorGraphPool::idle_graphs() {
+  absl::MutexLock lock(&mutex_);
+  return idle_graphs_.size();
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraph>>
+CalculatorGraphPool::StartGraph() {
+  auto graph = std::make_unique<CalculatorGraph>();
+  MP_RETURN_IF_ERROR(
+      graph->Initialize(validated_graph_, options_.side_packets));
+  if (options_.setup) {
+    MP_RETURN_IF_ERROR(options_.setup(*graph));
+  }
+  MP_RETURN_IF_ERROR(graph->StartRun({}));
+  return graph;
+}
+
+// static
+absl::Status CalculatorGraphPool::ShutDown(
+    std::unique_ptr<CalculatorGraph> graph) {
+  graph->CloseAllInputStreams().IgnoreError();
+  return graph->WaitUntilDone();
+}
+
+}  // namespace mediapipe
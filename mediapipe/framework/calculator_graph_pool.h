@@ -0,0 +1,113 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+// A pool of running CalculatorGraphs for many short sessions of one graph.
+//
+// Starting a session on a new graph requires Initialize() and StartRun(),
+// which construct and open every calculator.  CalculatorGraphPool instead
+// hands out graphs that are already running, and restarts returned graphs
+// with CalculatorGraph::ResetRun(), so that calculators supporting
+// Calculator::Reset() are not closed and reopened between sessions:
+//
+//   MP_ASSIGN_OR_RETURN(auto pool, CalculatorGraphPool::Create(options));
+//   ...
+//   MP_ASSIGN_OR_RETURN(auto graph, pool->Acquire());
+//   MP_RETURN_IF_ERROR(graph->AddPacketToInputStream("in", packet));
+//   ...
+//   MP_RETURN_IF_ERROR(graph->WaitUntilIdle());
+//   MP_RETURN_IF_ERROR(pool->Release(std::move(graph)));
+//
+// Outputs must be observed in Options::setup, which runs once per graph
+// before its first run.  The graph must not have source nodes.
+//
+// CalculatorGraphPool is thread-safe.
+class CalculatorGraphPool {
+ public:
+  struct Options {
+    // The graph config.
+    CalculatorGraphConfig config;
+    // The side packets for every run.
+    std::map<std::string, Packet> side_packets;
+    // Called on each new graph after Initialize() and before StartRun(), for
+    // example to observe output streams or to set graph services.
+    std::function<absl::Status(CalculatorGraph&)> setup;
+    // The number of graphs started by Create().
+    int initial_graphs = 1;
+    // The maximum number of idle graphs kept by Release().
+    int max_idle_graphs = 4;
+  };
+
+  // Creates a pool and starts Options::initial_graphs graphs.
+  static absl::StatusOr<std::unique_ptr<CalculatorGraphPool>> Create(
+      Options options);
+
+  // Shuts down the idle graphs.  Graphs that have been acquired must have
+  // been released or destroyed.
+  ~CalculatorGraphPool();
+
+  // Returns a running graph that is ready for a new session.  Starts a new
+  // graph if no graph is idle.
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> Acquire();
+
+  // Returns a graph obtained from Acquire() to the pool, and restarts it for
+  // the next session with CalculatorGraph::ResetRun().  If the restart fails,
+  // or the pool already holds max_idle_graphs, the graph is shut down and
+  // destroyed instead.  Returns any error in the session.
+  absl::Status Release(std::unique_ptr<CalculatorGraph> graph);
+
+  // Returns the number of idle graphs.
+  int idle_graphs();
+
+ private:
+  CalculatorGraphPool(
+      Options options,
+      std::shared_ptr<const ValidatedGraphConfig> validated_graph);
+
+  // Initializes and starts a new graph.
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> StartGraph();
+
+  // Closes a graph and waits until it is done.
+  static absl::Status ShutDown(std::unique_ptr<CalculatorGraph> graph);
+
+  const Options options_;
+  // Shared by all graphs, so that they are initialized without validation.
+  const std::shared_ptr<const ValidatedGraphConfig> validated_graph_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<CalculatorGraph>> idle_graphs_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
@@ -0,0 +1,339 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Counts the calls to each Calculator method.
+struct CallCounts {
+  int open = 0;
+  int reset = 0;
+  int close = 0;
+};
+
+CallCounts& GetCallCounts() {
+  static CallCounts* counts = new CallCounts();
+  return *counts;
+}
+
+// Outputs the running sum of its inputs, which Reset() clears.
+class ResettableSumCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++GetCallCounts().open;
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    sum_ += *kIn(cc);
+    kOut(cc).Send(sum_);
+    return absl::OkStatus();
+  }
+  absl::Status Reset(CalculatorContext* cc) override {
+    ++GetCallCounts().reset;
+    sum_ = 0;
+    return absl::OkStatus();
+  }
+  absl::Status Close(CalculatorContext* cc) override {
+    ++GetCallCounts().close;
+    return absl::OkStatus();
+  }
+
+ private:
+  int sum_ = 0;
+};
+MEDIAPIPE_REGISTER_NODE(ResettableSumCalculator);
+
+// Outputs the running sum of its inputs, and does not support Reset().
+class SumCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++GetCallCounts().open;
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    sum_ += *kIn(cc);
+    kOut(cc).Send(sum_);
+    return absl::OkStatus();
+  }
+  absl::Status Close(CalculatorContext* cc) override {
+    ++GetCallCounts().close;
+    return absl::OkStatus();
+  }
+
+ private:
+  int sum_ = 0;
+};
+MEDIAPIPE_REGISTER_NODE(SumCalculator);
+
+// Passes its inputs on, and fails to reset.
+class FailingResetCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++GetCallCounts().open;
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(*kIn(cc));
+    return absl::OkStatus();
+  }
+  absl::Status Reset(CalculatorContext* cc) override {
+    return absl::InternalError("reset failed");
+  }
+  absl::Status Close(CalculatorContext* cc) override {
+    ++GetCallCounts().close;
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(FailingResetCalculator);
+
+// Passes its inputs on, does not support Reset(), and fails to close.
+class FailingCloseCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++GetCallCounts().open;
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(*kIn(cc));
+    return absl::OkStatus();
+  }
+  absl::Status Close(CalculatorContext* cc) override {
+    ++GetCallCounts().close;
+    return absl::InternalError("close failed");
+  }
+};
+MEDIAPIPE_REGISTER_NODE(FailingCloseCalculator);
+
+CalculatorGraphConfig SumGraphConfig(const std::string& calculator) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node { input_stream: "IN:in" output_stream: "OUT:out" }
+  )pb");
+  config.mutable_node(0)->set_calculator(calculator);
+  return config;
+}
+
+class CalculatorGraphPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override { GetCallCounts() = CallCounts(); }
+
+  // Sends the values 1, 2, 3 at timestamps 0, 1, 2 and waits for the outputs.
+  void RunSession(CalculatorGraph& graph) {
+    for (int i = 0; i < 3; ++i) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i + 1).At(Timestamp(i))));
+    }
+    MP_EXPECT_OK(graph.WaitUntilIdle());
+  }
+
+  // Returns and clears the output values.
+  std::vector<int> TakeOutputs() {
+    absl::MutexLock lock(&mutex_);
+    std::vector<int> result;
+    result.swap(outputs_);
+    return result;
+  }
+
+  absl::Status ObserveOutput(CalculatorGraph& graph) {
+    return graph.ObserveOutputStream("out", [this](const Packet& packet) {
+      absl::MutexLock lock(&mutex_);
+      outputs_.push_back(packet.Get<int>());
+      return absl::OkStatus();
+    });
+  }
+
+  absl::Mutex mutex_;
+  std::vector<int> outputs_ ABSL_GUARDED_BY(mutex_);
+};
+
+TEST_F(CalculatorGraphPoolTest, ResetRunReusesCalculators) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(SumGraphConfig("ResettableSumCalculator")));
+  MP_ASSERT_OK(ObserveOutput(graph));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  RunSession(graph);
+  MP_ASSERT_OK(graph.ResetRun());
+  // The timestamps and the running sum start over.
+  RunSession(graph);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(TakeOutputs(), ElementsAre(1, 3, 6, 1, 3, 6));
+  EXPECT_EQ(GetCallCounts().open, 1);
+  EXPECT_EQ(GetCallCounts().reset, 1);
+  EXPECT_EQ(GetCallCounts().close, 1);
+}
+
+TEST_F(CalculatorGraphPoolTest, ResetRunReopensCalculatorsWithoutReset) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(SumGraphConfig("SumCalculator")));
+  MP_ASSERT_OK(ObserveOutput(graph));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  RunSession(graph);
+  MP_ASSERT_OK(graph.ResetRun());
+  RunSession(graph);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(TakeOutputs(), ElementsAre(1, 3, 6, 1, 3, 6));
+  EXPECT_EQ(GetCallCounts().open, 2);
+  EXPECT_EQ(GetCallCounts().close, 2);
+}
+
+TEST_F(CalculatorGraphPoolTest, ResetRunFailureClosesResetCalculators) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "ResettableSumCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:sum"
+    }
+    node {
+      calculator: "FailingResetCalculator"
+      input_stream: "IN:sum"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(ObserveOutput(graph));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  RunSession(graph);
+  EXPECT_FALSE(graph.ResetRun().ok());
+  graph.Cancel();
+  EXPECT_FALSE(graph.WaitUntilDone().ok());
+
+  // The sum was reset before the failure, and is closed anyway.
+  EXPECT_EQ(GetCallCounts().open, 2);
+  EXPECT_EQ(GetCallCounts().reset, 1);
+  EXPECT_EQ(GetCallCounts().close, 2);
+
+  // The run also fails to end when a calculator without Reset() fails to
+  // close, after the sum was reset.
+  GetCallCounts() = CallCounts();
+  config.mutable_node(1)->set_calculator("FailingCloseCalculator");
+  CalculatorGraph close_failing_graph;
+  MP_ASSERT_OK(close_failing_graph.Initialize(config));
+  MP_ASSERT_OK(ObserveOutput(close_failing_graph));
+  MP_ASSERT_OK(close_failing_graph.StartRun({}));
+
+  RunSession(close_failing_graph);
+  EXPECT_FALSE(close_failing_graph.ResetRun().ok());
+  EXPECT_EQ(GetCallCounts().open, 2);
+  EXPECT_EQ(GetCallCounts().reset, 1);
+  EXPECT_EQ(GetCallCounts().close, 2);
+}
+
+TEST_F(CalculatorGraphPoolTest, ReusesGraphs) {
+  CalculatorGraphPool::Options options;
+  options.config = SumGraphConfig("ResettableSumCalculator");
+  options.setup = [this](CalculatorGraph& graph) {
+    return ObserveOutput(graph);
+  };
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          CalculatorGraphPool::Create(std::move(options)));
+  EXPECT_EQ(pool->idle_graphs(), 1);
+
+  MP_ASSERT_OK_AND_ASSIGN(auto graph, pool->Acquire());
+  const CalculatorGraph* first_graph = graph.get();
+  EXPECT_EQ(pool->idle_graphs(), 0);
+  RunSession(*graph);
+  MP_ASSERT_OK(pool->Release(std::move(graph)));
+  EXPECT_EQ(pool->idle_graphs(), 1);
+
+  MP_ASSERT_OK_AND_ASSIGN(graph, pool->Acquire());
+  EXPECT_EQ(graph.get(), first_graph);
+  RunSession(*graph);
+  MP_ASSERT_OK(pool->Release(std::move(graph)));
+
+  EXPECT_THAT(TakeOutputs(), ElementsAre(1, 3, 6, 1, 3, 6));
+  EXPECT_EQ(GetCallCounts().open, 1);
+  EXPECT_EQ(GetCallCounts().reset, 2);
+  pool.reset();
+  EXPECT_EQ(GetCallCounts().close, 1);
+}
+
+TEST_F(CalculatorGraphPoolTest, ShutsDownSurplusGraphs) {
+  CalculatorGraphPool::Options options;
+  options.config = SumGraphConfig("ResettableSumCalculator");
+  options.initial_graphs = 0;
+  options.max_idle_graphs = 1;
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          CalculatorGraphPool::Create(std::move(options)));
+
+  MP_ASSERT_OK_AND_ASSIGN(auto graph_1, pool->Acquire());
+  MP_ASSERT_OK_AND_ASSIGN(auto graph_2, pool->Acquire());
+  MP_ASSERT_OK(pool->Release(std::move(graph_1)));
+  MP_ASSERT_OK(pool->Release(std::move(graph_2)));
+  EXPECT_EQ(pool->idle_graphs(), 1);
+  EXPECT_EQ(GetCallCounts().close, 1);
+}
+
+TEST_F(CalculatorGraphPoolTest, ShutsDownFailedGraphs) {
+  CalculatorGraphPool::Options options;
+  options.config = SumGraphConfig("ResettableSumCalculator");
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          CalculatorGraphPool::Create(std::move(options)));
+
+  MP_ASSERT_OK_AND_ASSIGN(auto graph, pool->Acquire());
+  MP_ASSERT_OK(graph->AddPacketToInputStream(
+      "in", MakePacket<int>(1).At(Timestamp(1))));
+  // Timestamps must increase within a session.
+  graph->AddPacketToInputStream("in", MakePacket<int>(1).At(Timestamp(0)))
+      .IgnoreError();
+  EXPECT_FALSE(pool->Release(std::move(graph)).ok());
+  EXPECT_EQ(pool->idle_graphs(), 0);
+}
+
+}  // namespace
+}  // namespace mediapipe
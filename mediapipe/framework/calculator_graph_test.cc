@@ -985,6 +985,44 @@ class PthreadSelfSourceCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(PthreadSelfSourceCalculator);
 
+// Outputs the return value of pthread_self() at the input timestamp.
+class PthreadSelfCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<pthread_t>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).Add(new pthread_t(pthread_self()),
+                               cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(PthreadSelfCalculator);
+
+// Outputs whether it runs on the thread whose pthread id it receives, and
+// declares that it may run inline.
+class SameThreadCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<pthread_t>();
+    cc->Outputs().Index(0).Set<bool>();
+    cc->SetInlineExecution(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const pthread_t producer = cc->Inputs().Index(0).Get<pthread_t>();
+    cc->Outputs().Index(0).Add(
+        new bool(pthread_equal(producer, pthread_self())),
+        cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(SameThreadCalculator);
+
 // A source calculator for testing the Calculator::InputTimestamp() method.
 // It outputs five int packets with timestamps 0, 1, 2, 3, 4.
 class CheckInputTimestampSourceCalculator : public CalculatorBase {
@@ -1517,6 +1555,165 @@ TEST(CalculatorGraph, RunsCorrectlyWithCurrentThreadExecutor) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+TEST(CalculatorGraph, RunsCorrectlyWithShardedQueues) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(4);
+  proto.set_scheduler_queue_shards(4);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithShardedQueuesOnApplicationThread) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(0);
+  proto.set_scheduler_queue_shards(4);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithOldestTimestampFirst) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(4);
+  proto.set_scheduling_policy(CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithNumaAwareScheduling) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(4);
+  proto.set_numa_aware_scheduling(true);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsInlineCalculatorsOnProducerThread) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        num_threads: 4
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'in'
+          output_stream: 'thread'
+        }
+        node {
+          calculator: 'SameThreadCalculator'
+          input_stream: 'thread'
+          output_stream: 'same_thread'
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<bool> same_thread;
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "same_thread", [&same_thread](const Packet& packet) {
+        same_thread.push_back(packet.Get<bool>());
+        return absl::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 20; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(same_thread, testing::SizeIs(20));
+  EXPECT_THAT(same_thread, testing::Each(true));
+}
+
+TEST(CalculatorGraph, RejectsBothCpuIdsAndNumaNode) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_ids: 0
+              numa_node: 0
+            }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+          executor: 'pinned'
+        }
+      )pb");
+  CalculatorGraph graph;
+  absl::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("numa_node"));
+}
+
+TEST(CalculatorGraph, DropsTimestampsPastDeadline) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in_a'
+        input_stream: 'in_b'
+        timestamp_deadline_usec: 10000
+        node {
+          calculator: 'SemaphoreCalculator'
+          input_stream: 'in_a'
+          output_stream: 'out_a'
+          input_side_packet: 'POST_SEM:post_sem'
+          input_side_packet: 'WAIT_SEM:wait_sem'
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in_b'
+          output_stream: 'out_b'
+        }
+      )pb");
+  Semaphore calc_entered_process(0);
+  Semaphore calc_can_exit_process(0);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(
+      config, {{"post_sem", MakePacket<Semaphore*>(&calc_entered_process)},
+               {"wait_sem", MakePacket<Semaphore*>(&calc_can_exit_process)}}));
+  std::vector<Timestamp> out_a, out_b;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out_a", [&](const Packet& packet) {
+    out_a.push_back(packet.Timestamp());
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.ObserveOutputStream("out_b", [&](const Packet& packet) {
+    out_b.push_back(packet.Timestamp());
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  auto add_timestamp = [&graph](int64_t ts) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in_a", MakePacket<int>(0).At(Timestamp(ts))));
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in_b", MakePacket<int>(0).At(Timestamp(ts))));
+  };
+  // Timestamp 0 is held up in "out_a" past the deadline, so timestamp 1 is
+  // dropped from both graph input streams.
+  add_timestamp(0);
+  calc_entered_process.Acquire(1);
+  absl::SleepFor(absl::Milliseconds(20));
+  add_timestamp(1);
+  calc_can_exit_process.Release(1);
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  // Timestamp 0 has settled, so timestamp 2 is admitted.
+  calc_can_exit_process.Release(1);
+  add_timestamp(2);
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_THAT(out_a, ElementsAre(Timestamp(0), Timestamp(2)));
+  EXPECT_THAT(out_b, ElementsAre(Timestamp(0), Timestamp(2)));
+  EXPECT_EQ(
+      graph.GetCounterFactory()->GetCounter("DroppedTimestamps")->Get(), 1);
+}
+
 TEST(CalculatorGraph, RunsCorrectlyWithNonDefaultExecutors) {
   CalculatorGraph graph;
   // Add executors "second" and "third".
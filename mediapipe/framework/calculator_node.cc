@@ -182,7 +182,7 @@ absl::Status CalculatorNode::Initialize(
   calculator_context_manager_.Initialize(
       calculator_state_.get(), node_type_info_->InputStreamTypes().TagMap(),
       node_type_info_->OutputStreamTypes().TagMap(),
-      /*calculator_run_in_parallel=*/max_in_flight_ > 1);
+      /*calculator_run_in_parallel=*/max_in_flight_ > 1, max_in_flight_);
 
   // The graph specified InputStreamHandler takes priority.
   const bool graph_specified =
@@ -213,6 +213,17 @@ absl::Status CalculatorNode::Initialize(
   }
   input_stream_handler_->SetProcessTimestampBounds(
       contract.GetProcessTimestampBounds());
+  max_batch_size_ = contract.GetMaxBatchSize();
+  if (max_batch_size_ > 1) {
+    RET_CHECK_EQ(max_in_flight_, 1)
+        << "Calculator \"" << DebugName()
+        << "\" sets a max batch size and cannot also set max_in_flight.";
+    MP_RETURN_IF_ERROR(input_stream_handler_->SetMaxBatchSize(max_batch_size_))
+        << "for calculator \"" << DebugName() << "\"";
+  }
+  // Parallel invocations each need a calculator context of their own, which
+  // an inline run would have to recycle while it is still being scheduled.
+  inline_execution_ = contract.GetInlineExecution() && max_in_flight_ == 1;
 
   return InitializeInputStreams(input_stream_managers, output_stream_managers);
 }
@@ -377,6 +388,17 @@ void CalculatorNode::SetMaxInputStreamQueueSize(int max_queue_size) {
   input_stream_handler_->SetMaxQueueSize(max_queue_size);
 }
 
+void CalculatorNode::SetMaxInputStreamQueueBytes(int64_t max_queue_bytes) {
+  ABSL_CHECK(input_stream_handler_);
+  input_stream_handler_->SetMaxQueueBytes(max_queue_bytes);
+}
+
+void CalculatorNode::SetInputStreamTargetQueueDelay(
+    absl::Duration target_queue_delay) {
+  ABSL_CHECK(input_stream_handler_);
+  input_stream_handler_->SetTargetQueueDelay(target_queue_delay);
+}
+
 absl::Status CalculatorNode::PrepareForRun(
     const std::map<std::string, Packet>& all_side_packets,
     const std::map<std::string, Packet>& service_packets,
@@ -425,12 +447,14 @@ absl::Status CalculatorNode::PrepareForRun(
   MP_RETURN_IF_ERROR(calculator_context_manager_.PrepareForRun(std::bind(
       &CalculatorNode::ConnectShardsToStreams, this, std::placeholders::_1)));
 
-  MP_ASSIGN_OR_RETURN(
-      auto calculator_factory,
-      CalculatorBaseRegistry::CreateByNameInNamespace(
-          validated_graph_->Package(), calculator_state_->CalculatorType()));
-  calculator_ = calculator_factory->CreateCalculator(
-      calculator_context_manager_.GetDefaultCalculatorContext());
+  if (!reuse_calculator_) {
+    MP_ASSIGN_OR_RETURN(
+        auto calculator_factory,
+        CalculatorBaseRegistry::CreateByNameInNamespace(
+            validated_graph_->Package(), calculator_state_->CalculatorType()));
+    calculator_ = calculator_factory->CreateCalculator(
+        calculator_context_manager_.GetDefaultCalculatorContext());
+  }
 
   needs_to_close_ = false;
 
@@ -499,6 +523,14 @@ absl::Status CalculatorNode::OpenNode() {
   absl::Status result;
   if (OutputsAreConstant(default_context)) {
     result = ResendSidePackets(default_context);
+  } else if (reuse_calculator_) {
+    // The calculator was reset rather than closed, so it keeps the state from
+    // its last Open().  Restore the headers and side packets it output there.
+    for (CollectionItemId id = outputs->BeginId(); id < outputs->EndId();
+         ++id) {
+      outputs->Get(id).SetHeader(reused_output_headers_[id.value()]);
+    }
+    result = ResendSidePackets(default_context);
   } else {
     MEDIAPIPE_PROFILING(OPEN, default_context);
     LegacyCalculatorSupport::Scoped<CalculatorContext> s(default_context);
@@ -517,6 +549,7 @@ absl::Status CalculatorNode::OpenNode() {
       "Open() on node \"$0\" returned tool::StatusStop() which should only be "
       "used to signal that a source node is done producing data.",
       DebugName());
+  reuse_calculator_ = false;
   MP_RETURN_IF_ERROR(result).SetPrepend() << absl::Substitute(
       "Calculator::Open() for node \"$0\" failed: ", DebugName());
   needs_to_close_ = true;
@@ -633,6 +666,81 @@ absl::Status CalculatorNode::CloseNode(const absl::Status& graph_status,
   return absl::OkStatus();
 }
 
+absl::Status CalculatorNode::ResetCalculator() {
+  {
+    absl::MutexLock status_lock(&status_mutex_);
+    if (status_ != kStateOpened && status_ != kStateActive) {
+      // The calculator is closed or was never opened.
+      return absl::OkStatus();
+    }
+  }
+  CalculatorContext* default_context =
+      calculator_context_manager_.GetDefaultCalculatorContext();
+  calculator_context_manager_.PushInputTimestampToContext(
+      default_context, Timestamp::Unstarted());
+  absl::Status result;
+  {
+    LegacyCalculatorSupport::Scoped<CalculatorContext> s(default_context);
+    result = calculator_->Reset(default_context);
+  }
+  calculator_context_manager_.PopInputTimestampFromContext(default_context);
+  if (absl::IsUnimplemented(result)) {
+    // CleanupAfterRun() closes the calculator instead.
+    return absl::OkStatus();
+  }
+  MP_RETURN_IF_ERROR(result).SetPrepend() << absl::Substitute(
+      "Calculator::Reset() for node \"$0\" failed: ", DebugName());
+
+  reused_output_headers_.clear();
+  for (OutputStreamManager* stream : output_stream_handler_->OutputStreams()) {
+    reused_output_headers_.push_back(stream->Header());
+  }
+  reuse_calculator_ = true;
+  needs_to_close_ = false;
+  return absl::OkStatus();
+}
+
+void CalculatorNode::CancelReset() {
+  if (reuse_calculator_) {
+    reuse_calculator_ = false;
+    needs_to_close_ = true;
+  }
+}
+
+absl::Status CalculatorNode::CloseUnresetCalculator() {
+  if (!needs_to_close_) {
+    return absl::OkStatus();
+  }
+  calculator_context_manager_.PushInputTimestampToContext(
+      calculator_context_manager_.GetDefaultCalculatorContext(),
+      Timestamp::Done());
+  return CloseNode(absl::OkStatus(), /*graph_run_ended=*/true);
+}
+
+void CalculatorNode::CloseResetCalculator(const absl::Status& graph_status) {
+  if (!reuse_calculator_) {
+    return;
+  }
+  reuse_calculator_ = false;
+  // The contexts of the run were destroyed, so Close() gets a new one, with
+  // the side packets of that run.
+  if (calculator_context_manager_
+          .PrepareForRun(std::bind(&CalculatorNode::ConnectShardsToStreams,
+                                   this, std::placeholders::_1))
+          .ok()) {
+    calculator_context_manager_.PushInputTimestampToContext(
+        calculator_context_manager_.GetDefaultCalculatorContext(),
+        Timestamp::Done());
+    CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
+  }
+  calculator_ = nullptr;
+  calculator_context_manager_.CleanupAfterRun();
+  {
+    absl::MutexLock lock(&status_mutex_);
+    status_ = kStateUninitialized;
+  }
+}
+
 void CalculatorNode::CleanupAfterRun(const absl::Status& graph_status) {
   if (needs_to_close_) {
     calculator_context_manager_.PushInputTimestampToContext(
@@ -640,7 +748,9 @@ void CalculatorNode::CleanupAfterRun(const absl::Status& graph_status) {
         Timestamp::Done());
     CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
   }
-  calculator_ = nullptr;
+  if (!reuse_calculator_) {
+    calculator_ = nullptr;
+  }
   // All pending output packets are automatically dropped when calculator
   // context manager destroys all calculator context objects.
   calculator_context_manager_.CleanupAfterRun();
@@ -846,14 +956,32 @@ absl::Status CalculatorNode::ProcessNode(
     // This is not a source Calculator.
     InputStreamShardSet* const inputs = &calculator_context->Inputs();
     OutputStreamShardSet* const outputs = &calculator_context->Outputs();
-    absl::Status result =
-        absl::InternalError("Calculator context has no input packets.");
-
     int num_invocations = calculator_context_manager_.NumberOfContextTimestamps(
         *calculator_context);
+    if (num_invocations == 0) {
+      return absl::InternalError("Calculator context has no input packets.");
+    }
     RET_CHECK(num_invocations <= 1 || max_in_flight_ <= 1)
         << "num_invocations:" << num_invocations
         << ", max_in_flight_:" << max_in_flight_;
+    if (max_batch_size_ > 1) {
+      int batch_size = 0;
+      while (batch_size < num_invocations &&
+             calculator_context_manager_
+                 .ContextInputTimestamp(*calculator_context, batch_size)
+                 .IsAllowedInStream()) {
+        ++batch_size;
+      }
+      if (batch_size > 0) {
+        absl::Status result = ProcessBatch(calculator_context, batch_size);
+        if (!result.ok() || batch_size == num_invocations) {
+          return result;
+        }
+        // Only Timestamp::Done() can follow the batch.
+        num_invocations -= batch_size;
+      }
+    }
+    absl::Status result;
     for (int i = 0; i < num_invocations; ++i) {
       const Timestamp input_timestamp = calculator_context->InputTimestamp();
       // The node is ready for Process().
@@ -914,6 +1042,45 @@ absl::Status CalculatorNode::ProcessNode(
   }
 }
 
+absl::Status CalculatorNode::ProcessBatch(CalculatorContext* calculator_context,
+                                          int batch_size) {
+  const Timestamp first_timestamp = calculator_context->InputTimestamp();
+  const Timestamp last_timestamp =
+      calculator_context_manager_.ContextInputTimestamp(*calculator_context,
+                                                        batch_size - 1);
+  output_stream_handler_->PrepareOutputs(first_timestamp,
+                                         &calculator_context->Outputs());
+
+  VLOG(2) << "Calling Calculator::Process() for node: " << DebugName()
+          << " timestamps: " << first_timestamp << " to " << last_timestamp;
+
+  calculator_context_manager_.SetBatchSizeInContext(calculator_context,
+                                                    batch_size);
+  absl::Status result;
+  {
+    MEDIAPIPE_PROFILING(PROCESS, calculator_context);
+    LegacyCalculatorSupport::Scoped<CalculatorContext> s(calculator_context);
+    result = calculator_->Process(calculator_context);
+  }
+  calculator_context_manager_.SetBatchSizeInContext(calculator_context, 1);
+
+  VLOG(2) << "Called Calculator::Process() for node: " << DebugName()
+          << " timestamps: " << first_timestamp << " to " << last_timestamp;
+
+  for (int i = 0; i < batch_size; ++i) {
+    input_stream_handler_->ClearCurrentInputs(calculator_context);
+  }
+
+  if (!result.ok() && result != tool::StatusStop()) {
+    return mediapipe::StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend()
+           << absl::Substitute("Calculator::Process() for node \"$0\" failed: ",
+                               DebugName());
+  }
+  // The output timestamp bounds are computed from the last input set.
+  output_stream_handler_->PostProcess(last_timestamp);
+  return result;
+}
+
 void CalculatorNode::SetQueueSizeCallbacks(
     InputStreamManager::QueueSizeCallback becomes_full_callback,
     InputStreamManager::QueueSizeCallback becomes_not_full_callback) {
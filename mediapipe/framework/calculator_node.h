@@ -20,16 +20,19 @@
 
 #include <stddef.h>
 
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -136,9 +139,23 @@ class CalculatorNode {
   absl::Status OpenNode() ABSL_LOCKS_EXCLUDED(status_mutex_);
   // Called when a source node's layer becomes active.
   void ActivateNode() ABSL_LOCKS_EXCLUDED(status_mutex_);
+  // Calls Calculator::Reset() at the end of a run ended by
+  // CalculatorGraph::ResetRun().  If the calculator supports Reset(), it is
+  // kept for the next run instead of being closed and reopened.
+  absl::Status ResetCalculator() ABSL_LOCKS_EXCLUDED(status_mutex_);
+  // Undoes a successful ResetCalculator() when ResetRun() fails, so that the
+  // calculator is closed at the end of the run instead of being kept.
+  void CancelReset();
+  // Closes the calculator at the end of a run ended by ResetRun(), if it does
+  // not support Reset().  Unlike CleanupAfterRun(), returns the Close() error.
+  absl::Status CloseUnresetCalculator() ABSL_LOCKS_EXCLUDED(status_mutex_);
+  // Closes a calculator kept by ResetCalculator() after its run was cleaned
+  // up, when ResetRun() fails to start the next run that would reuse it.
+  void CloseResetCalculator(const absl::Status& graph_status)
+      ABSL_LOCKS_EXCLUDED(status_mutex_);
   // Cleans up the node after the CalculatorGraph has been run. Deletes
-  // the Calculator managed by this node. graph_status is the status of
-  // the graph run.
+  // the Calculator managed by this node, unless it has been reset. graph_status
+  // is the status of the graph run.
   void CleanupAfterRun(const absl::Status& graph_status)
       ABSL_LOCKS_EXCLUDED(status_mutex_);
 
@@ -163,6 +180,10 @@ class CalculatorNode {
 
   int source_layer() const { return source_layer_; }
 
+  // Returns true if the calculator declared that it may be run inline, see
+  // CalculatorContract::SetInlineExecution, and does not run in parallel.
+  bool InlineExecution() const { return inline_execution_; }
+
   // Checks if the node can be scheduled; if so, increases current_in_flight_
   // and returns true; otherwise, returns false.
   // If true is returned, the scheduler must commit to executing the node, and
@@ -215,6 +236,13 @@ class CalculatorNode {
   // max_queue_size to trigger callbacks.
   void SetMaxInputStreamQueueSize(int max_queue_size);
 
+  // Sets each of this node's input streams to use the specified
+  // max_queue_bytes to trigger callbacks.
+  void SetMaxInputStreamQueueBytes(int64_t max_queue_bytes);
+
+  // Sets the target queueing delay of each of this node's input streams.
+  void SetInputStreamTargetQueueDelay(absl::Duration target_queue_delay);
+
   // Closes the node's calculator and input and output streams.
   // graph_status is the current status of the graph run. graph_run_ended
   // indicates whether the graph run has ended.
@@ -287,6 +315,11 @@ class CalculatorNode {
   // Returns true if all outputs will be identical to the previous graph run.
   bool OutputsAreConstant(CalculatorContext* cc);
 
+  // Calls Calculator::Process() once for the first "batch_size" input sets
+  // of the calculator context, and removes them from the context.
+  absl::Status ProcessBatch(CalculatorContext* calculator_context,
+                            int batch_size);
+
   // The calculator.
   std::unique_ptr<CalculatorBase> calculator_;
   // Keeps data which a Calculator subclass needs access to.
@@ -311,6 +344,10 @@ class CalculatorNode {
 
   // The max number of invocations that can be scheduled in parallel.
   int max_in_flight_ = 1;
+  // The max number of input sets passed to a single Process() call.
+  int max_batch_size_ = 1;
+  // See InlineExecution().
+  bool inline_execution_ = false;
   // The following two variables are used for the concurrency control of node
   // scheduling.
   //
@@ -370,6 +407,12 @@ class CalculatorNode {
   // True if CleanupAfterRun() needs to call CloseNode().
   bool needs_to_close_ = false;
 
+  // True if the calculator has been reset by ResetCalculator(), so that the
+  // next run reuses it without calling Open().
+  bool reuse_calculator_ = false;
+  // The output stream headers set by the reused calculator.
+  std::vector<Packet> reused_output_headers_;
+
   internal::SchedulerQueue* scheduler_queue_ = nullptr;
 
   const ValidatedGraphConfig* validated_graph_ = nullptr;
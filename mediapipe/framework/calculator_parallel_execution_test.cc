@@ -24,7 +24,9 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -34,6 +36,7 @@
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
 
 namespace mediapipe {
 
@@ -76,6 +79,44 @@ class SlowPlusOneCalculator : public CalculatorBase {
 
 REGISTER_CALCULATOR(SlowPlusOneCalculator);
 
+// Passes its input through after a short delay, and records the calculator
+// contexts that Process() is invoked with.
+class ContextRecordingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->InputSidePackets().Index(0).Set<ContextRecordingCalculator*>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    BusySleep(absl::Milliseconds(2));
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    ContextRecordingCalculator* recorder =
+        cc->InputSidePackets().Index(0).Get<ContextRecordingCalculator*>();
+    absl::MutexLock lock(&recorder->mutex_);
+    recorder->contexts_.insert(cc);
+    return absl::OkStatus();
+  }
+
+  absl::flat_hash_set<CalculatorContext*> Contexts() {
+    absl::MutexLock lock(&mutex_);
+    return contexts_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_set<CalculatorContext*> contexts_ ABSL_GUARDED_BY(mutex_);
+};
+
+REGISTER_CALCULATOR(ContextRecordingCalculator);
+
 class ParallelExecutionTest : public testing::Test {
  public:
   void AddThreadSafeVectorSink(const Packet& packet) {
@@ -84,13 +125,17 @@ class ParallelExecutionTest : public testing::Test {
   }
 
  protected:
+  // Runs a graph of two SlowPlusOneCalculators configured by
+  // "executor_config" twice and checks the output packets.
+  void RunSlowPlusOneCalculators(const std::string& executor_config);
+
   std::vector<Packet> output_packets_ ABSL_GUARDED_BY(output_packets_mutex_);
   absl::Mutex output_packets_mutex_;
 };
 
-TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
-  CalculatorGraphConfig graph_config =
-      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+void ParallelExecutionTest::RunSlowPlusOneCalculators(
+    const std::string& executor_config) {
+  const std::string config_text = absl::StrCat(R"pb(
         input_stream: "input"
         node {
           calculator: "SlowPlusOneCalculator"
@@ -109,8 +154,10 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
           input_stream: "output"
           input_side_packet: "CALLBACK:callback"
         }
-        num_threads: 5
-      )pb");
+      )pb",
+                                                   executor_config);
+  CalculatorGraphConfig graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(config_text);
 
   // Starts MediaPipe graph.
   CalculatorGraph graph(graph_config);
@@ -152,5 +199,59 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
   }
 }
 
+TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
+  RunSlowPlusOneCalculators("num_threads: 5");
+}
+
+TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsWorkStealingTest) {
+  RunSlowPlusOneCalculators(R"pb(
+    executor {
+      options {
+        [mediapipe.ThreadPoolExecutorOptions.ext] {
+          num_threads: 5
+          enable_work_stealing: true
+        }
+      }
+    }
+  )pb");
+}
+
+TEST(ParallelExecutionContextTest, ReusesCalculatorContexts) {
+  CalculatorGraphConfig graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        num_threads: 4
+        node {
+          calculator: "ContextRecordingCalculator"
+          input_stream: "input"
+          output_stream: "output"
+          input_side_packet: "recorder"
+          max_in_flight: 3
+        }
+      )pb");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &graph_config, &output_packets);
+  ContextRecordingCalculator recorder;
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun(
+      {{"recorder", MakePacket<ContextRecordingCalculator*>(&recorder)}}));
+  constexpr int kNumPackets = 50;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(output_packets.size(), kNumPackets);
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(output_packets[i].Get<int>(), i);
+  }
+  // Calculator contexts are recycled rather than created per invocation. More
+  // than max_in_flight of them can be needed, because a context is only
+  // recycled once the outputs of all earlier timestamps have been propagated.
+  EXPECT_LT(recorder.Contexts().size(), kNumPackets / 4);
+}
+
 }  // namespace
 }  // namespace mediapipe
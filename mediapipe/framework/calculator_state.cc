@@ -21,6 +21,7 @@
 
 #include "absl/log/absl_check.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/resources.h"
@@ -56,6 +57,8 @@ CalculatorState::~CalculatorState() {}
 void CalculatorState::ResetBetweenRuns() {
   input_side_packets_ = nullptr;
   counter_factory_ = nullptr;
+  absl::MutexLock lock(&counters_mutex_);
+  counters_.clear();
 }
 
 void CalculatorState::SetInputSidePackets(const PacketSet* input_side_packets) {
@@ -71,7 +74,15 @@ void CalculatorState::SetOutputSidePackets(
 
 Counter* CalculatorState::GetCounter(const std::string& name) {
   ABSL_CHECK(counter_factory_);
-  return counter_factory_->GetCounter(absl::StrCat(NodeName(), "-", name));
+  absl::MutexLock lock(&counters_mutex_);
+  auto it = counters_.find(name);
+  if (it == counters_.end()) {
+    it = counters_
+             .emplace(name, counter_factory_->GetCounter(
+                                absl::StrCat(NodeName(), "-", name)))
+             .first;
+  }
+  return it->second;
 }
 
 CounterFactory* CalculatorState::GetCounterFactory() {
@@ -23,7 +23,10 @@
 
 // TODO: Move protos in another CL after the C++ code migration.
 #include "absl/base/macros.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/counter.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -115,6 +118,8 @@ class CalculatorState {
   // Sets the counter factory.
   void SetCounterFactory(CounterFactory* counter_factory) {
     counter_factory_ = counter_factory;
+    absl::MutexLock lock(&counters_mutex_);
+    counters_.clear();
   }
 
   absl::Status SetServicePacket(const GraphServiceBase& service,
@@ -165,6 +170,12 @@ class CalculatorState {
   OutputSidePacketSet* output_side_packets_;
 
   CounterFactory* counter_factory_;
+
+  // The counters returned by GetCounter, by their unprefixed names. Avoids
+  // building the prefixed name for every call.
+  absl::Mutex counters_mutex_;
+  absl::flat_hash_map<std::string, Counter*> counters_
+      ABSL_GUARDED_BY(counters_mutex_);
 };
 
 }  // namespace mediapipe
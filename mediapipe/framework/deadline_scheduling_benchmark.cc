@@ -0,0 +1,148 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the end-to-end latency of a graph fed faster than it can run, for
+// each scheduling policy, with and without a timestamp deadline.
+// $ bazel run -c opt mediapipe/framework:deadline_scheduling_benchmark
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumThreads = 2;
+constexpr int kChainLength = 4;
+constexpr int kNumPackets = 500;
+// Each timestamp costs kChainLength * kProcessTime of work, spread over
+// kNumThreads threads, so the graph keeps up with one timestamp every 200us
+// while timestamps arrive every 100us.
+constexpr absl::Duration kProcessTime = absl::Microseconds(100);
+constexpr absl::Duration kInputInterval = absl::Microseconds(100);
+
+// Passes its input through after spinning for kProcessTime.
+class BusyPassThroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->SetTimestampOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const absl::Time end_time = absl::Now() + kProcessTime;
+    while (absl::Now() < end_time) {
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(BusyPassThroughCalculator);
+
+CalculatorGraphConfig MakeChainConfig(
+    CalculatorGraphConfig::SchedulingPolicy policy, int64_t deadline_usec) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.set_num_threads(kNumThreads);
+  // Let the queues grow rather than blocking the producer.
+  config.set_max_queue_size(-1);
+  config.set_scheduling_policy(policy);
+  config.set_timestamp_deadline_usec(deadline_usec);
+  std::string input = "input";
+  for (int i = 0; i < kChainLength; ++i) {
+    const std::string output = absl::StrCat("hop", i);
+    auto* node = config.add_node();
+    node->set_calculator("BusyPassThroughCalculator");
+    node->add_input_stream(input);
+    node->add_output_stream(output);
+    input = output;
+  }
+  config.add_output_stream(input);
+  return config;
+}
+
+// Returns the given percentile of sorted latencies in microseconds.
+double Percentile(const std::vector<int64_t>& sorted, double percentile) {
+  if (sorted.empty()) return 0;
+  const int index = std::min<int>(sorted.size() - 1,
+                                  static_cast<int>(sorted.size() * percentile));
+  return sorted[index];
+}
+
+// Arguments: scheduling policy, and timestamp deadline in microseconds.
+// Reports the p50 and p99 latency from adding a packet to observing it at the
+// graph output, and the fraction of timestamps dropped.
+void BM_OverloadedChain(benchmark::State& state) {
+  const auto policy =
+      static_cast<CalculatorGraphConfig::SchedulingPolicy>(state.range(0));
+  const int64_t deadline_usec = state.range(1);
+  CalculatorGraph graph;
+  const CalculatorGraphConfig config = MakeChainConfig(policy, deadline_usec);
+  ABSL_CHECK_OK(graph.Initialize(config));
+  std::vector<absl::Time> add_times(kNumPackets);
+  absl::Mutex mutex;
+  std::vector<int64_t> latencies;
+  ABSL_CHECK_OK(graph.ObserveOutputStream(
+      config.output_stream(0), [&](const Packet& packet) {
+        const absl::Time now = absl::Now();
+        absl::MutexLock lock(&mutex);
+        latencies.push_back(absl::ToInt64Microseconds(
+            now - add_times[packet.Timestamp().Value()]));
+        return absl::OkStatus();
+      }));
+  Counter* dropped = graph.GetCounterFactory()->GetCounter("DroppedTimestamps");
+  int64_t total_packets = 0;
+  for (auto _ : state) {
+    ABSL_CHECK_OK(graph.StartRun({}));
+    const absl::Time start_time = absl::Now();
+    for (int i = 0; i < kNumPackets; ++i) {
+      const absl::Time send_time = start_time + i * kInputInterval;
+      while (absl::Now() < send_time) {
+      }
+      add_times[i] = absl::Now();
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+    total_packets += kNumPackets;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["p50_usec"] = Percentile(latencies, 0.5);
+  state.counters["p99_usec"] = Percentile(latencies, 0.99);
+  state.counters["dropped_fraction"] =
+      static_cast<double>(dropped->Get()) / total_packets;
+}
+BENCHMARK(BM_OverloadedChain)
+    ->ArgsProduct({{CalculatorGraphConfig::DEFAULT_SCHEDULING,
+                    CalculatorGraphConfig::OLDEST_TIMESTAMP_FIRST},
+                   {0, 2000}})
+    ->ArgNames({"policy", "deadline_usec"})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
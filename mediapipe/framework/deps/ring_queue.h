@@ -0,0 +1,134 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_RING_QUEUE_H_
+#define MEDIAPIPE_DEPS_RING_QUEUE_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+
+namespace mediapipe {
+
+// A FIFO queue stored in a single contiguous ring buffer.
+//
+// Unlike std::deque, which allocates and frees a block every few elements as
+// the queue slides forward, a RingQueue only allocates when it grows beyond
+// its current capacity. Once it has reached its steady-state size, push_back
+// and pop_front never touch the heap. The capacity is always a power of two
+// and never shrinks, except through shrink_to_fit().
+//
+// Not thread-safe.
+template <typename T>
+class RingQueue {
+ public:
+  RingQueue() = default;
+  RingQueue(const RingQueue&) = delete;
+  RingQueue& operator=(const RingQueue&) = delete;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return slots_.size(); }
+
+  T& front() {
+    ABSL_DCHECK(!empty());
+    return slots_[head_];
+  }
+  const T& front() const {
+    ABSL_DCHECK(!empty());
+    return slots_[head_];
+  }
+  T& back() { return (*this)[size_ - 1]; }
+  const T& back() const { return (*this)[size_ - 1]; }
+
+  // Returns the element at "index" positions from the front.
+  T& operator[](size_t index) {
+    ABSL_DCHECK_LT(index, size_);
+    return slots_[(head_ + index) & (slots_.size() - 1)];
+  }
+  const T& operator[](size_t index) const {
+    ABSL_DCHECK_LT(index, size_);
+    return slots_[(head_ + index) & (slots_.size() - 1)];
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (size_ == slots_.size()) {
+      Grow(size_ + 1);
+    }
+    T& slot = slots_[(head_ + size_) & (slots_.size() - 1)];
+    slot = T(std::forward<Args>(args)...);
+    ++size_;
+    return slot;
+  }
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  // Removes the front element. The vacated slot is reset to T() so that
+  // resources held by the element are released immediately.
+  void pop_front() {
+    ABSL_DCHECK(!empty());
+    slots_[head_] = T();
+    head_ = (head_ + 1) & (slots_.size() - 1);
+    --size_;
+  }
+
+  void clear() {
+    while (!empty()) {
+      pop_front();
+    }
+    head_ = 0;
+  }
+
+  // Makes room for at least "capacity" elements without reallocating.
+  void reserve(size_t capacity) {
+    if (capacity > slots_.size()) {
+      Grow(capacity);
+    }
+  }
+
+  // Releases the storage of an empty queue.
+  void shrink_to_fit() {
+    if (empty()) {
+      std::vector<T>().swap(slots_);
+      head_ = 0;
+    }
+  }
+
+ private:
+  // Reallocates to the smallest power of two that holds "min_capacity"
+  // elements, moving the elements to the start of the new buffer.
+  void Grow(size_t min_capacity) {
+    size_t new_capacity = slots_.empty() ? 8 : slots_.size();
+    while (new_capacity < min_capacity) {
+      new_capacity *= 2;
+    }
+    std::vector<T> new_slots(new_capacity);
+    for (size_t i = 0; i < size_; ++i) {
+      new_slots[i] = std::move((*this)[i]);
+    }
+    slots_.swap(new_slots);
+    head_ = 0;
+  }
+
+  std::vector<T> slots_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_RING_QUEUE_H_
@@ -0,0 +1,85 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/ring_queue.h"
+
+#include <memory>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(RingQueueTest, PushAndPopInFifoOrder) {
+  RingQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 100; ++i) {
+    queue.push_back(i);
+  }
+  EXPECT_EQ(queue.size(), 100);
+  EXPECT_EQ(queue.back(), 99);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(queue.front(), i);
+    queue.pop_front();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(RingQueueTest, WrapsAroundWithoutGrowing) {
+  RingQueue<int> queue;
+  queue.reserve(4);
+  const size_t capacity = queue.capacity();
+  for (int i = 0; i < 1000; ++i) {
+    queue.push_back(i);
+    queue.push_back(i);
+    queue.pop_front();
+    queue.pop_front();
+  }
+  EXPECT_EQ(queue.capacity(), capacity);
+}
+
+TEST(RingQueueTest, GrowKeepsOrderAfterWrapAround) {
+  RingQueue<int> queue;
+  queue.reserve(8);
+  for (int i = 0; i < 6; ++i) queue.push_back(i);
+  for (int i = 0; i < 4; ++i) queue.pop_front();
+  // The queue now wraps around the end of its buffer when it grows.
+  for (int i = 6; i < 40; ++i) queue.push_back(i);
+  ASSERT_EQ(queue.size(), 36);
+  for (int i = 0; i < 36; ++i) {
+    EXPECT_EQ(queue[i], i + 4);
+  }
+}
+
+TEST(RingQueueTest, PopReleasesElement) {
+  RingQueue<std::shared_ptr<int>> queue;
+  auto value = std::make_shared<int>(1);
+  queue.push_back(value);
+  EXPECT_EQ(value.use_count(), 2);
+  queue.pop_front();
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(RingQueueTest, ClearAndShrink) {
+  RingQueue<int> queue;
+  for (int i = 0; i < 10; ++i) queue.push_back(i);
+  queue.clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_GT(queue.capacity(), 0);
+  queue.shrink_to_fit();
+  EXPECT_EQ(queue.capacity(), 0);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,12 +15,12 @@
 #ifndef MEDIAPIPE_DEPS_THREADPOOL_H_
 #define MEDIAPIPE_DEPS_THREADPOOL_H_
 
-#include <deque>
 #include <functional>
 #include <string>
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/deps/thread_options.h"
 
 namespace mediapipe {
@@ -94,7 +94,7 @@ class ThreadPool {
   absl::Mutex mutex_;
   absl::CondVar condition_;
   bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
-  std::deque<std::function<void()>> tasks_ ABSL_GUARDED_BY(mutex_);
+  RingQueue<std::function<void()>> tasks_ ABSL_GUARDED_BY(mutex_);
 
   ThreadOptions thread_options_;
 };
@@ -0,0 +1,141 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <memory>
+#include <utility>
+
+namespace mediapipe {
+
+namespace {
+
+// Identifies the pool and worker index of the current thread, so that
+// Schedule() can push onto the caller's own deque.
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : num_threads_((num_threads == 0) ? 1 : num_threads),
+      thread_pool_(thread_options, name_prefix, num_threads_) {
+  workers_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&sleep_mutex_);
+    stopped_ = true;
+    sleep_condition_.SignalAll();
+  }
+  // thread_pool_ is destroyed next and joins the workers, which exit once
+  // every pending callback has run.
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  thread_pool_.StartWorkers();
+  // Each worker loop occupies one pool thread until shutdown.
+  for (int i = 0; i < num_threads_; ++i) {
+    thread_pool_.Schedule([this, i] { RunWorker(i); });
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  // Count the task before publishing it so that a worker can never take a
+  // task that is not yet accounted for.
+  num_pending_.fetch_add(1, std::memory_order_seq_cst);
+  auto task = std::make_unique<Task>(std::move(callback));
+  if (current_pool == this &&
+      workers_[current_worker]->deque.Push(task.get())) {
+    task.release();
+  } else {
+    Worker& worker = current_pool == this
+                         ? *workers_[current_worker]
+                         : *workers_[next_injection_.fetch_add(
+                                         1, std::memory_order_relaxed) %
+                                     num_threads_];
+    absl::MutexLock lock(&worker.injection_mutex);
+    worker.injection.push_back(task.release());
+  }
+  WakeOne();
+}
+
+void WorkStealingThreadPool::WakeOne() {
+  // Pairs with the seq_cst increment of num_sleeping_ in RunWorker: either we
+  // see the sleeper here, or the sleeper sees the new pending task.
+  if (num_sleeping_.load(std::memory_order_seq_cst) > 0) {
+    absl::MutexLock lock(&sleep_mutex_);
+    sleep_condition_.Signal();
+  }
+}
+
+// static
+WorkStealingThreadPool::Task* WorkStealingThreadPool::PopInjection(
+    Worker& worker) {
+  absl::MutexLock lock(&worker.injection_mutex);
+  if (worker.injection.empty()) {
+    return nullptr;
+  }
+  Task* task = worker.injection.front();
+  worker.injection.pop_front();
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::FindTask(int index) {
+  Worker& self = *workers_[index];
+  if (Task* task = self.deque.Pop()) return task;
+  if (Task* task = PopInjection(self)) return task;
+  for (int i = 1; i < num_threads_; ++i) {
+    Worker& victim = *workers_[(index + i) % num_threads_];
+    if (Task* task = victim.deque.Steal()) return task;
+    if (Task* task = PopInjection(victim)) return task;
+  }
+  return nullptr;
+}
+
+void WorkStealingThreadPool::RunWorker(int index) {
+  current_pool = this;
+  current_worker = index;
+  while (true) {
+    if (Task* task = FindTask(index)) {
+      num_pending_.fetch_sub(1, std::memory_order_relaxed);
+      (*task)();
+      delete task;
+      continue;
+    }
+    if (num_pending_.load(std::memory_order_seq_cst) > 0) {
+      // A task is still being published by Schedule().
+      continue;
+    }
+    absl::MutexLock lock(&sleep_mutex_);
+    num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+    while (num_pending_.load(std::memory_order_seq_cst) == 0 && !stopped_) {
+      sleep_condition_.Wait(&sleep_mutex_);
+    }
+    num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    if (stopped_ && num_pending_.load(std::memory_order_seq_cst) == 0) {
+      break;
+    }
+  }
+  current_pool = nullptr;
+  current_worker = -1;
+}
+
+}  // namespace mediapipe
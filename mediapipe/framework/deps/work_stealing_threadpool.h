@@ -0,0 +1,204 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/threadpool.h"
+
+namespace mediapipe {
+
+namespace internal {
+
+// A bounded Chase-Lev work-stealing deque of pointers.
+//
+// Only the owning worker thread may call Push() and Pop(); any thread may call
+// Steal(). Push() fails when the deque is full, in which case the caller is
+// expected to fall back to a slower overflow queue.
+//
+// See "Correct and Efficient Work-Stealing for Weak Memory Models",
+// Lê et al., PPoPP 2013.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  // "capacity" must be a power of two.
+  explicit WorkStealingDeque(int64_t capacity)
+      : mask_(capacity - 1), buffer_(new std::atomic<T*>[capacity]) {}
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  // Owner only. Returns false if the deque is full.
+  bool Push(T* item) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > mask_) {
+      return false;
+    }
+    buffer_[bottom & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only. Takes the most recently pushed item, or returns nullptr.
+  T* Pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* item = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last item: race against thieves for it.
+      if (!top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread. Takes the least recently pushed item, or returns nullptr if
+  // the deque is empty or the steal lost a race.
+  T* Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    T* item = buffer_[top & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+ private:
+  const int64_t mask_;
+  std::unique_ptr<std::atomic<T*>[]> buffer_;
+  // Keep the indices modified by thieves and by the owner on separate cache
+  // lines.
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+};
+
+}  // namespace internal
+
+// A thread pool in which every worker owns a lock-free deque of callbacks.
+//
+// Callbacks scheduled from one of the pool's own worker threads are pushed
+// onto that worker's deque without taking any lock. Callbacks scheduled from
+// other threads are distributed round-robin over small per-worker injection
+// queues. An idle worker first drains its own deque and injection queue and
+// then steals from the other workers, so a single shared mutex is never on
+// the hot path.
+//
+// Unlike ThreadPool, callbacks are not guaranteed to run in FIFO order, even
+// with a single thread.
+//
+// The pool is shut down when it is destroyed; pending callbacks are run
+// before the destructor returns.
+class WorkStealingThreadPool {
+ public:
+  // Same as the corresponding ThreadPool constructor.
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Waits for closures (if any) to complete. May be called without
+  // having called StartWorkers().
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Add specified callback to the pool. Eventually a worker will run it.
+  void Schedule(std::function<void()> callback);
+
+  // Provided for debugging and testing only.
+  int num_threads() const { return num_threads_; }
+
+  // Standard thread options.  Use this accessor to get them.
+  const ThreadOptions& thread_options() const {
+    return thread_pool_.thread_options();
+  }
+
+ private:
+  using Task = std::function<void()>;
+
+  struct Worker {
+    // Number of slots in each worker's lock-free deque. Callbacks that do not
+    // fit spill into the injection queue.
+    static constexpr int64_t kDequeCapacity = 1024;
+
+    Worker() : deque(kDequeCapacity) {}
+
+    internal::WorkStealingDeque<Task> deque;
+    absl::Mutex injection_mutex;
+    std::deque<Task*> injection ABSL_GUARDED_BY(injection_mutex);
+  };
+
+  // Runs the scheduling loop of worker "index" until the pool is stopped and
+  // no callbacks are left.
+  void RunWorker(int index);
+
+  // Returns a callback for worker "index" or nullptr if none could be found.
+  Task* FindTask(int index);
+  static Task* PopInjection(Worker& worker);
+
+  // Wakes up one sleeping worker, if any.
+  void WakeOne();
+
+  const int num_threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Number of scheduled callbacks that no worker has picked up yet.
+  std::atomic<int64_t> num_pending_{0};
+  // Used to pick an injection queue for callbacks from outside the pool.
+  std::atomic<uint32_t> next_injection_{0};
+
+  absl::Mutex sleep_mutex_;
+  absl::CondVar sleep_condition_;
+  std::atomic<int> num_sleeping_{0};
+  bool stopped_ ABSL_GUARDED_BY(sleep_mutex_) = false;
+
+  // Provides the worker threads, which then run RunWorker() until shutdown.
+  // Declared last so that it joins its threads before the workers go away.
+  ThreadPool thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
@@ -0,0 +1,158 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingDequeTest, PushPopIsLifo) {
+  internal::WorkStealingDeque<int> deque(4);
+  int values[3] = {0, 1, 2};
+  for (int& value : values) {
+    ASSERT_TRUE(deque.Push(&value));
+  }
+  EXPECT_EQ(deque.Pop(), &values[2]);
+  EXPECT_EQ(deque.Pop(), &values[1]);
+  EXPECT_EQ(deque.Pop(), &values[0]);
+  EXPECT_EQ(deque.Pop(), nullptr);
+}
+
+TEST(WorkStealingDequeTest, StealIsFifo) {
+  internal::WorkStealingDeque<int> deque(4);
+  int values[3] = {0, 1, 2};
+  for (int& value : values) {
+    ASSERT_TRUE(deque.Push(&value));
+  }
+  EXPECT_EQ(deque.Steal(), &values[0]);
+  EXPECT_EQ(deque.Steal(), &values[1]);
+  EXPECT_EQ(deque.Pop(), &values[2]);
+  EXPECT_EQ(deque.Steal(), nullptr);
+}
+
+TEST(WorkStealingDequeTest, PushFailsWhenFull) {
+  internal::WorkStealingDeque<int> deque(2);
+  int values[3] = {0, 1, 2};
+  EXPECT_TRUE(deque.Push(&values[0]));
+  EXPECT_TRUE(deque.Push(&values[1]));
+  EXPECT_FALSE(deque.Push(&values[2]));
+  EXPECT_EQ(deque.Steal(), &values[0]);
+  EXPECT_TRUE(deque.Push(&values[2]));
+}
+
+TEST(WorkStealingDequeTest, ConcurrentStealsTakeEachItemOnce) {
+  constexpr int kNumItems = 100000;
+  constexpr int kNumThieves = 4;
+  internal::WorkStealingDeque<int> deque(1024);
+  std::vector<int> items(kNumItems);
+  std::vector<std::atomic<int>> taken(kNumItems);
+  std::atomic<bool> done{false};
+  auto record = [&](int* item) { taken[item - items.data()].fetch_add(1); };
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kNumThieves; ++i) {
+    thieves.emplace_back([&] {
+      while (!done.load()) {
+        if (int* item = deque.Steal()) record(item);
+      }
+      while (int* item = deque.Steal()) record(item);
+    });
+  }
+  for (int i = 0; i < kNumItems; ++i) {
+    while (!deque.Push(&items[i])) {
+      if (int* item = deque.Pop()) record(item);
+    }
+    if (i % 3 == 0) {
+      if (int* item = deque.Pop()) record(item);
+    }
+  }
+  done.store(true);
+  for (auto& thief : thieves) thief.join();
+  while (int* item = deque.Pop()) record(item);
+
+  for (int i = 0; i < kNumItems; ++i) {
+    ASSERT_EQ(taken[i].load(), 1) << "item " << i;
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool(ThreadOptions(), "testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool(ThreadOptions(), "testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool(ThreadOptions(), "testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, TasksScheduledFromWorkers) {
+  // Each task fans out into more tasks, which exercises the per-worker
+  // deques, their overflow into the injection queues, and stealing.
+  std::atomic<int> count{0};
+  constexpr int kDepth = 12;
+  WorkStealingThreadPool* pool = nullptr;
+  std::function<void(int)> spawn = [&](int depth) {
+    count.fetch_add(1);
+    if (depth == 0) return;
+    for (int i = 0; i < 2; ++i) {
+      pool->Schedule([&spawn, depth] { spawn(depth - 1); });
+    }
+  };
+  {
+    WorkStealingThreadPool thread_pool(ThreadOptions(), "testpool", 4);
+    thread_pool.StartWorkers();
+    pool = &thread_pool;
+    thread_pool.Schedule([&spawn] { spawn(kDepth); });
+  }
+
+  EXPECT_EQ((1 << (kDepth + 1)) - 1, count.load());
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_nice_priority_level(-10);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(-10, thread_pool.thread_options().nice_priority_level());
+  thread_pool.StartWorkers();
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,127 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The smallest size class.
+constexpr size_t kMinSizeClass = 64;
+
+// The alignment of pooled buffers if none or a smaller one is requested.
+constexpr int kMinAlignment = alignof(std::max_align_t);
+
+thread_local int64_t thread_hits = 0;
+thread_local int64_t thread_misses = 0;
+
+}  // namespace
+
+CpuBufferPool::CpuBufferPool(const CpuBufferPoolOptions& options)
+    : options_(options) {}
+
+CpuBufferPool::~CpuBufferPool() { Clear(); }
+
+size_t CpuBufferPool::SizeClass(size_t size) {
+  if (size <= kMinSizeClass) {
+    return kMinSizeClass;
+  }
+  // Keeps the top three bits of size - 1, so that each power of two is split
+  // into four classes.
+  const size_t step = size_t{1} << (absl::bit_width(size - 1) - 3);
+  return (size + step - 1) & ~(step - 1);
+}
+
+CpuBufferPool::Key CpuBufferPool::GetKey(size_t size, int alignment) {
+  return {SizeClass(size), std::max(alignment, kMinAlignment)};
+}
+
+void* CpuBufferPool::Acquire(size_t size, int alignment) {
+  const Key key = GetKey(size, alignment);
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = idle_buffers_.find(key);
+    if (it != idle_buffers_.end() && !it->second.empty()) {
+      void* buffer = it->second.back();
+      it->second.pop_back();
+      --pooled_buffers_;
+      pooled_bytes_ -= key.first;
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      ++thread_hits;
+      return buffer;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  ++thread_misses;
+  return aligned_malloc(key.first, key.second);
+}
+
+void CpuBufferPool::Release(void* buffer, size_t size, int alignment) {
+  if (buffer == nullptr) {
+    return;
+  }
+  const Key key = GetKey(size, alignment);
+  {
+    absl::MutexLock lock(&mutex_);
+    if (pooled_bytes_ + static_cast<int64_t>(key.first) <=
+        options_.max_pooled_bytes) {
+      idle_buffers_[key].push_back(buffer);
+      ++pooled_buffers_;
+      pooled_bytes_ += key.first;
+      return;
+    }
+  }
+  aligned_free(buffer);
+}
+
+void CpuBufferPool::Clear() {
+  absl::flat_hash_map<Key, std::vector<void*>> idle_buffers;
+  {
+    absl::MutexLock lock(&mutex_);
+    idle_buffers.swap(idle_buffers_);
+    pooled_buffers_ = 0;
+    pooled_bytes_ = 0;
+  }
+  for (auto& [key, buffers] : idle_buffers) {
+    for (void* buffer : buffers) {
+      aligned_free(buffer);
+    }
+  }
+}
+
+CpuBufferPool::Stats CpuBufferPool::GetStats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  absl::MutexLock lock(&mutex_);
+  stats.pooled_buffers = pooled_buffers_;
+  stats.pooled_bytes = pooled_bytes_;
+  return stats;
+}
+
+int64_t CpuBufferPool::ThreadHits() { return thread_hits; }
+
+int64_t CpuBufferPool::ThreadMisses() { return thread_misses; }
+
+}  // namespace mediapipe
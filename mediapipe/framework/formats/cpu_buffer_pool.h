@@ -0,0 +1,103 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace mediapipe {
+
+struct CpuBufferPoolOptions {
+  // The maximum total size of the idle buffers kept for reuse. Buffers
+  // released while the pool is at this limit are freed.
+  int64_t max_pooled_bytes = 64 << 20;
+};
+
+// Pools CPU memory buffers, such as the CPU storage of Tensors.
+//
+// Requested sizes are rounded up to size classes, four per power of two, so
+// that buffers of similar sizes can be reused while wasting at most a quarter
+// of each buffer. Idle buffers are kept per size class and alignment, up to
+// CpuBufferPoolOptions::max_pooled_bytes in total.
+//
+// The pool is thread-safe. It must outlive the buffers it hands out, which is
+// why Tensor holds a shared_ptr to it, see MemoryManager::GetCpuBufferPool.
+class CpuBufferPool {
+ public:
+  struct Stats {
+    // Number of Acquire calls served from the pool.
+    int64_t hits = 0;
+    // Number of Acquire calls that allocated a new buffer.
+    int64_t misses = 0;
+    // Number and total size of the idle buffers in the pool.
+    int64_t pooled_buffers = 0;
+    int64_t pooled_bytes = 0;
+  };
+
+  explicit CpuBufferPool(const CpuBufferPoolOptions& options = {});
+  ~CpuBufferPool();
+  CpuBufferPool(const CpuBufferPool&) = delete;
+  CpuBufferPool& operator=(const CpuBufferPool&) = delete;
+
+  // Returns a buffer of at least "size" bytes, aligned to "alignment" if
+  // positive, or nullptr if the allocation fails.
+  void* Acquire(size_t size, int alignment = 0) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns a buffer obtained from Acquire with the same size and alignment
+  // to the pool, or frees it if the pool is full.
+  void Release(void* buffer, size_t size, int alignment = 0)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Frees all idle buffers.
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  Stats GetStats() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the size of the buffers allocated for requests of "size" bytes.
+  static size_t SizeClass(size_t size);
+
+  // Returns the number of hits and misses of the Acquire calls made by the
+  // calling thread on any pool. Used by the GraphProfiler to attribute pool
+  // usage to calculators.
+  static int64_t ThreadHits();
+  static int64_t ThreadMisses();
+
+ private:
+  // The size class and alignment of a buffer.
+  using Key = std::pair<size_t, int>;
+
+  static Key GetKey(size_t size, int alignment);
+
+  const CpuBufferPoolOptions options_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<Key, std::vector<void*>> idle_buffers_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t pooled_buffers_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t pooled_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
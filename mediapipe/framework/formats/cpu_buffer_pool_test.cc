@@ -0,0 +1,83 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+
+#include <cstdint>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CpuBufferPoolTest, SizeClass) {
+  EXPECT_EQ(CpuBufferPool::SizeClass(0), 64);
+  EXPECT_EQ(CpuBufferPool::SizeClass(64), 64);
+  EXPECT_EQ(CpuBufferPool::SizeClass(65), 80);
+  EXPECT_EQ(CpuBufferPool::SizeClass(1000), 1024);
+  EXPECT_EQ(CpuBufferPool::SizeClass(1025), 1280);
+  EXPECT_EQ(CpuBufferPool::SizeClass(1 << 20), 1 << 20);
+}
+
+TEST(CpuBufferPoolTest, ReusesBuffersOfSameSizeClass) {
+  CpuBufferPool pool;
+  void* buffer = pool.Acquire(1000, 64);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % 64, 0);
+  pool.Release(buffer, 1000, 64);
+
+  // 1010 bytes fall into the same size class as 1000 bytes.
+  EXPECT_EQ(pool.Acquire(1010, 64), buffer);
+  // Other alignments use other buffers.
+  void* other = pool.Acquire(1000, 128);
+  EXPECT_NE(other, buffer);
+  pool.Release(buffer, 1010, 64);
+  pool.Release(other, 1000, 128);
+
+  const CpuBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.pooled_buffers, 2);
+  EXPECT_EQ(stats.pooled_bytes, 2048);
+}
+
+TEST(CpuBufferPoolTest, FreesBuffersOverBudget) {
+  CpuBufferPoolOptions options;
+  options.max_pooled_bytes = 1024;
+  CpuBufferPool pool(options);
+  void* first = pool.Acquire(1024);
+  void* second = pool.Acquire(1024);
+  pool.Release(first, 1024);
+  pool.Release(second, 1024);
+  EXPECT_EQ(pool.GetStats().pooled_buffers, 1);
+  EXPECT_EQ(pool.GetStats().pooled_bytes, 1024);
+
+  pool.Clear();
+  EXPECT_EQ(pool.GetStats().pooled_buffers, 0);
+  EXPECT_EQ(pool.GetStats().pooled_bytes, 0);
+}
+
+TEST(CpuBufferPoolTest, CountsThreadHitsAndMisses) {
+  CpuBufferPool pool;
+  const int64_t hits = CpuBufferPool::ThreadHits();
+  const int64_t misses = CpuBufferPool::ThreadMisses();
+  pool.Release(pool.Acquire(100), 100);
+  pool.Release(pool.Acquire(100), 100);
+  EXPECT_EQ(CpuBufferPool::ThreadHits() - hits, 1);
+  EXPECT_EQ(CpuBufferPool::ThreadMisses() - misses, 1);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,347 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_frame_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+std::atomic<uint64_t> next_pool_id = 1;
+
+// The bytes cached by threads and the trim generation are packed into one
+// word, so that a thread only counts its buffers while its cache is not
+// trimmed.
+constexpr int kGenerationShift = 40;
+constexpr uint64_t kCachedBytesMask = (uint64_t{1} << kGenerationShift) - 1;
+
+CpuBufferPoolOptions GetSharedPoolOptions(const CpuFramePoolOptions& options,
+                                          int num_nodes) {
+  CpuBufferPoolOptions shared_options;
+  shared_options.max_pooled_bytes = options.max_pooled_bytes / num_nodes;
+  return shared_options;
+}
+
+}  // namespace
+
+struct CpuFramePool::State : std::enable_shared_from_this<State> {
+  State(const CpuFramePoolOptions& options, uint64_t id);
+
+  // Returns the calling thread's free lists for this pool, emptied if Trim
+  // was called since the thread last used them, or nullptr if the thread is
+  // exiting and its free lists have been destroyed.
+  ThreadCache* GetThreadCache();
+
+  // Returns the NUMA node whose shared pool serves the calling thread.
+  int CurrentNode() const;
+
+  uint8_t* Acquire(size_t size, int node);
+  void Release(uint8_t* buffer, size_t size, int node);
+  void Trim();
+
+  // Adds "delta" to the bytes cached by threads, unless the pool was trimmed
+  // since "generation". Returns whether it did.
+  bool AddCachedBytes(uint64_t generation, int64_t delta);
+  uint64_t Generation() const {
+    return cache_state.load(std::memory_order_relaxed) >> kGenerationShift;
+  }
+  int64_t CachedBytes() const {
+    return cache_state.load(std::memory_order_relaxed) & kCachedBytesMask;
+  }
+
+  void UpdateSharedPooledBytes();
+  // Trims the pool if its idle buffers exceed max_idle_bytes.
+  void MaybeTrim();
+
+  const CpuFramePoolOptions options;
+  // Identifies the free lists of this pool in the thread caches; unlike the
+  // address, it is never reused by another pool.
+  const uint64_t id;
+  // The shared pools, by NUMA node.
+  std::vector<std::unique_ptr<CpuBufferPool>> shared_pools;
+  // The trim generation and the bytes cached by threads of this generation.
+  std::atomic<uint64_t> cache_state = 0;
+  // Updated after each use of the shared pools, for the high-water mark.
+  std::atomic<int64_t> shared_pooled_bytes = 0;
+  std::atomic<int64_t> thread_cache_hits = 0;
+  // Set when the pool is destroyed; the frames released afterwards are not
+  // cached by threads anymore.
+  std::atomic<bool> pool_destroyed = false;
+};
+
+// The idle buffers of one pool kept by one thread, by size class.
+struct CpuFramePool::ThreadCache {
+  ~ThreadCache() {
+    if (auto shared_state = state.lock()) {
+      shared_state->AddCachedBytes(generation, -cached_bytes);
+    }
+    FreeBuffers();
+  }
+
+  // Frees the buffers without counting them off the pool, for caches that
+  // were trimmed.
+  void FreeBuffers() {
+    for (auto& [size, buffers] : buffers_by_size) {
+      for (uint8_t* buffer : buffers) {
+        aligned_free(buffer);
+      }
+    }
+    buffers_by_size.clear();
+    cached_bytes = 0;
+  }
+
+  std::weak_ptr<State> state;
+  absl::flat_hash_map<size_t, std::vector<uint8_t*>> buffers_by_size;
+  int64_t cached_bytes = 0;
+  uint64_t generation = 0;
+};
+
+absl::node_hash_map<uint64_t, CpuFramePool::ThreadCache>*
+CpuFramePool::ThreadCaches() {
+  // Frames can still be released by the destructors of other thread_local
+  // objects after the caches are destroyed. The flag has no destructor, so it
+  // remains valid until the thread is gone.
+  thread_local bool destroyed = false;
+  if (destroyed) {
+    return nullptr;
+  }
+  struct Caches {
+    ~Caches() { destroyed = true; }
+    absl::node_hash_map<uint64_t, ThreadCache> by_pool;
+  };
+  thread_local Caches caches;
+  return &caches.by_pool;
+}
+
+CpuFramePool& CpuFramePool::GetDefault() {
+  static NoDestructor<CpuFramePool> pool;
+  return *pool;
+}
+
+CpuFramePool::CpuFramePool(const CpuFramePoolOptions& options)
+    : state_(std::make_shared<State>(
+          options, next_pool_id.fetch_add(1, std::memory_order_relaxed))) {}
+
+CpuFramePool::~CpuFramePool() {
+  state_->pool_destroyed.store(true, std::memory_order_relaxed);
+  if (auto* caches = ThreadCaches()) {
+    caches->erase(state_->id);
+  }
+}
+
+CpuFramePool::State::State(const CpuFramePoolOptions& options, uint64_t id)
+    : options(options), id(id) {
+  const int num_nodes = NumNumaNodes();
+  for (int node = 0; node < num_nodes; ++node) {
+    shared_pools.push_back(std::make_unique<CpuBufferPool>(
+        GetSharedPoolOptions(options, num_nodes)));
+  }
+}
+
+CpuFramePool::ThreadCache* CpuFramePool::State::GetThreadCache() {
+  auto* caches = ThreadCaches();
+  if (caches == nullptr) {
+    return nullptr;
+  }
+  if (caches->size() > 1) {
+    // Free the buffers of the destroyed pools.
+    for (auto it = caches->begin(); it != caches->end();) {
+      if (it->second.state.expired()) {
+        caches->erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  auto [it, inserted] = caches->try_emplace(id);
+  ThreadCache& cache = it->second;
+  const uint64_t generation = Generation();
+  if (inserted) {
+    cache.state = weak_from_this();
+    cache.generation = generation;
+  } else if (cache.generation != generation) {
+    cache.FreeBuffers();
+    cache.generation = generation;
+  }
+  return &cache;
+}
+
+int CpuFramePool::State::CurrentNode() const {
+  return shared_pools.size() > 1 ? CurrentNumaNode() % shared_pools.size()
+                                 : 0;
+}
+
+std::unique_ptr<ImageFrame> CpuFramePool::GetFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32_t alignment_boundary) {
+  if (alignment_boundary > kMaxAlignmentBoundary) {
+    return std::make_unique<ImageFrame>(format, width, height,
+                                        alignment_boundary);
+  }
+  ABSL_CHECK_NE(ImageFormat::UNKNOWN, format);
+  ABSL_CHECK(alignment_boundary > 0 &&
+             (alignment_boundary & (alignment_boundary - 1)) == 0)
+      << "Invalid alignment boundary: " << alignment_boundary;
+  // Rows are padded as in ImageFrame::Reset.
+  int width_step = width * ImageFrame::NumberOfChannelsForFormat(format) *
+                   ImageFrame::ChannelSizeForFormat(format);
+  if (alignment_boundary > 1) {
+    width_step = ((width_step - 1) | (alignment_boundary - 1)) + 1;
+  }
+  const size_t size =
+      CpuBufferPool::SizeClass(static_cast<size_t>(height) * width_step);
+  const int node = state_->CurrentNode();
+  uint8_t* pixel_data = state_->Acquire(size, node);
+  return std::make_unique<ImageFrame>(
+      format, width, height, width_step, pixel_data,
+      [state = state_, size, node](uint8_t* buffer) {
+        state->Release(buffer, size, node);
+      });
+}
+
+uint8_t* CpuFramePool::State::Acquire(size_t size, int node) {
+  ThreadCache* cache = GetThreadCache();
+  if (cache != nullptr) {
+    auto it = cache->buffers_by_size.find(size);
+    if (it != cache->buffers_by_size.end() && !it->second.empty() &&
+        AddCachedBytes(cache->generation, -static_cast<int64_t>(size))) {
+      uint8_t* buffer = it->second.back();
+      it->second.pop_back();
+      cache->cached_bytes -= size;
+      thread_cache_hits.fetch_add(1, std::memory_order_relaxed);
+      return buffer;
+    }
+  }
+  CpuBufferPool& shared_pool = *shared_pools[node];
+  const int64_t misses = CpuBufferPool::ThreadMisses();
+  void* buffer = shared_pool.Acquire(size, kMaxAlignmentBoundary);
+  if (buffer == nullptr) {
+    // Give the memory held by the pool back and try once more.
+    Trim();
+    GetThreadCache();
+    buffer = shared_pool.Acquire(size, kMaxAlignmentBoundary);
+  }
+  ABSL_CHECK(buffer != nullptr) << "Failed to allocate " << size << " bytes";
+  UpdateSharedPooledBytes();
+  if (shared_pools.size() > 1 && CpuBufferPool::ThreadMisses() != misses) {
+    // The pages of a new buffer are placed on the NUMA node of the thread
+    // that first writes them.
+    std::memset(buffer, 0, size);
+  }
+  return static_cast<uint8_t*>(buffer);
+}
+
+void CpuFramePool::State::Release(uint8_t* buffer, size_t size, int node) {
+  if (buffer == nullptr) {
+    return;
+  }
+  // Threads only cache buffers of their own node, so that the buffers of
+  // another node go back where threads of that node can reuse them.
+  ThreadCache* cache = pool_destroyed.load(std::memory_order_relaxed)
+                           ? nullptr
+                           : GetThreadCache();
+  if (cache != nullptr && node == CurrentNode() &&
+      cache->cached_bytes + static_cast<int64_t>(size) <=
+          options.max_thread_cached_bytes) {
+    std::vector<uint8_t*>& buffers = cache->buffers_by_size[size];
+    if (static_cast<int>(buffers.size()) <
+            options.max_thread_cached_buffers_per_size &&
+        AddCachedBytes(cache->generation, size)) {
+      buffers.push_back(buffer);
+      cache->cached_bytes += size;
+      MaybeTrim();
+      return;
+    }
+  }
+  shared_pools[node]->Release(buffer, size, kMaxAlignmentBoundary);
+  UpdateSharedPooledBytes();
+  MaybeTrim();
+}
+
+bool CpuFramePool::State::AddCachedBytes(uint64_t generation, int64_t delta) {
+  uint64_t current = cache_state.load(std::memory_order_relaxed);
+  do {
+    if ((current >> kGenerationShift) != generation) {
+      return false;
+    }
+  } while (!cache_state.compare_exchange_weak(
+      current, current + static_cast<uint64_t>(delta),
+      std::memory_order_relaxed));
+  return true;
+}
+
+void CpuFramePool::State::UpdateSharedPooledBytes() {
+  int64_t pooled_bytes = 0;
+  for (const auto& shared_pool : shared_pools) {
+    pooled_bytes += shared_pool->GetStats().pooled_bytes;
+  }
+  shared_pooled_bytes.store(pooled_bytes, std::memory_order_relaxed);
+}
+
+void CpuFramePool::State::MaybeTrim() {
+  if (options.max_idle_bytes > 0 &&
+      CachedBytes() + shared_pooled_bytes.load(std::memory_order_relaxed) >
+          options.max_idle_bytes) {
+    Trim();
+  }
+}
+
+void CpuFramePool::State::Trim() {
+  // Starting a new generation stops counting the buffers of all thread
+  // caches, which are freed the next time their threads use the pool.
+  uint64_t current = cache_state.load(std::memory_order_relaxed);
+  while (!cache_state.compare_exchange_weak(
+      current, ((current >> kGenerationShift) + 1) << kGenerationShift,
+      std::memory_order_relaxed)) {
+  }
+  for (auto& shared_pool : shared_pools) {
+    shared_pool->Clear();
+  }
+  UpdateSharedPooledBytes();
+}
+
+void CpuFramePool::Trim() { state_->Trim(); }
+
+CpuFramePool::Stats CpuFramePool::GetStats() const {
+  Stats stats;
+  stats.thread_cache_hits =
+      state_->thread_cache_hits.load(std::memory_order_relaxed);
+  stats.thread_cached_bytes = state_->CachedBytes();
+  for (const auto& shared_pool : state_->shared_pools) {
+    const CpuBufferPool::Stats shared_stats = shared_pool->GetStats();
+    stats.shared_hits += shared_stats.hits;
+    stats.misses += shared_stats.misses;
+    stats.shared_pooled_bytes += shared_stats.pooled_bytes;
+  }
+  return stats;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,120 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_CPU_FRAME_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_CPU_FRAME_POOL_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/container/node_hash_map.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+
+namespace mediapipe {
+
+struct CpuFramePoolOptions {
+  // The maximum total size of the idle buffers shared by all threads. On hosts
+  // with several NUMA nodes, each node gets an equal share.
+  int64_t max_pooled_bytes = 64 << 20;
+  // The maximum total size of the idle buffers cached by each thread.
+  int64_t max_thread_cached_bytes = 4 << 20;
+  // The maximum number of idle buffers of one size class cached by each
+  // thread. Further buffers go to the shared pool, where other threads can
+  // reuse them.
+  int max_thread_cached_buffers_per_size = 2;
+  // The pool is trimmed when the total size of its idle buffers, shared and
+  // cached by threads, exceeds this high-water mark. Zero disables it.
+  int64_t max_idle_bytes = 128 << 20;
+};
+
+// Pools the pixel memory of ImageFrames of any dimensions and format.
+//
+// Buffers are bucketed by byte size, using the size classes of CpuBufferPool,
+// so that a frame can reuse the buffer of any frame of a similar size. Each
+// thread keeps a few idle buffers of each size, which serve most requests
+// without locking; the shared CpuBufferPool is only used when the calling
+// thread has no idle buffer of the right size, or when its free lists are
+// full.
+//
+// On hosts with several NUMA nodes, the shared pool is split per node, like
+// the free lists of ImageFramePool. Frames are served from the pool of the
+// calling thread's node, new buffers are zeroed by the calling thread so that
+// their memory is placed on its node, and released buffers go back to the pool
+// of the node they were allocated on.
+//
+// The frames are regular ImageFrames whose deleter returns the pixel data to
+// the pool, so they can be sent in packets like any other frame. Frames can
+// outlive the pool: the buffers they release after it is destroyed are freed
+// when the last one is gone. The buffers of a destroyed pool still cached by
+// other threads are freed when those threads next use any pool, or exit.
+//
+// Thread-safe.
+class CpuFramePool {
+ public:
+  struct Stats {
+    // Number of frames served from the calling thread's free lists.
+    int64_t thread_cache_hits = 0;
+    // Number of frames served from, or allocated by, the shared pool.
+    int64_t shared_hits = 0;
+    int64_t misses = 0;
+    // Total size of the idle buffers in the shared pool. Buffers cached by
+    // threads are not included.
+    int64_t shared_pooled_bytes = 0;
+    // Total size of the idle buffers cached by threads, not counting the
+    // caches that were trimmed but not freed yet.
+    int64_t thread_cached_bytes = 0;
+  };
+
+  // Returns the pool used by the image calculators.
+  static CpuFramePool& GetDefault();
+
+  explicit CpuFramePool(const CpuFramePoolOptions& options = {});
+  ~CpuFramePool();
+  CpuFramePool(const CpuFramePool&) = delete;
+  CpuFramePool& operator=(const CpuFramePool&) = delete;
+
+  // Returns an uninitialized frame, laid out as by the ImageFrame constructor
+  // with the same arguments. Alignments above kMaxAlignmentBoundary are not
+  // pooled.
+  std::unique_ptr<ImageFrame> GetFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32_t alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+  // Frees the idle buffers of the shared pool, and makes every thread free
+  // its cached buffers the next time it uses the pool. The pool trims itself
+  // when its idle buffers exceed max_idle_bytes; applications can also call
+  // this when the system is low on memory.
+  void Trim();
+
+  Stats GetStats() const;
+
+  // The alignment of all pooled buffers.
+  static constexpr uint32_t kMaxAlignmentBoundary = 64;
+
+ private:
+  struct State;
+  struct ThreadCache;
+
+  // The free lists of the calling thread, by pool id, or nullptr once they
+  // have been destroyed at thread exit.
+  static absl::node_hash_map<uint64_t, ThreadCache>* ThreadCaches();
+
+  // Shared with the deleters of the frames, which can outlive the pool.
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_CPU_FRAME_POOL_H_
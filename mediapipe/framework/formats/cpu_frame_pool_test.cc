@@ -0,0 +1,191 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_frame_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CpuFramePoolTest, LaysOutFramesLikeImageFrame) {
+  CpuFramePool pool;
+  std::unique_ptr<ImageFrame> frame = pool.GetFrame(ImageFormat::SRGB, 13, 7);
+  ImageFrame expected(ImageFormat::SRGB, 13, 7);
+  EXPECT_EQ(frame->Format(), ImageFormat::SRGB);
+  EXPECT_EQ(frame->Width(), 13);
+  EXPECT_EQ(frame->Height(), 7);
+  EXPECT_EQ(frame->WidthStep(), expected.WidthStep());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(frame->PixelData()) %
+                ImageFrame::kDefaultAlignmentBoundary,
+            0);
+
+  std::unique_ptr<ImageFrame> contiguous =
+      pool.GetFrame(ImageFormat::GRAY8, 13, 7, /*alignment_boundary=*/1);
+  EXPECT_TRUE(contiguous->IsContiguous());
+}
+
+TEST(CpuFramePoolTest, ReusesBuffersOfFramesOfSimilarSize) {
+  CpuFramePool pool;
+  std::unique_ptr<ImageFrame> frame = pool.GetFrame(ImageFormat::SRGBA, 64, 32);
+  const uint8_t* pixel_data = frame->PixelData();
+  frame.reset();
+
+  // Other dimensions and formats reuse the buffer if their size falls into
+  // the same size class.
+  frame = pool.GetFrame(ImageFormat::GRAY8, 128, 62);
+  EXPECT_EQ(frame->PixelData(), pixel_data);
+
+  const CpuFramePool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.thread_cache_hits, 1);
+  EXPECT_EQ(stats.shared_hits, 0);
+  EXPECT_EQ(stats.misses, 1);
+}
+
+TEST(CpuFramePoolTest, ReusesFramesReleasedOnOtherThreads) {
+  CpuFramePoolOptions options;
+  options.max_thread_cached_bytes = 0;
+  CpuFramePool pool(options);
+  std::unique_ptr<ImageFrame> frame = pool.GetFrame(ImageFormat::SRGB, 32, 32);
+  const uint8_t* pixel_data = frame->PixelData();
+  // The releasing thread cannot cache the buffer, so it goes to the shared
+  // pool.
+  std::thread([&frame] { frame.reset(); }).join();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 32 * 32 * 3);
+
+  frame = pool.GetFrame(ImageFormat::SRGB, 32, 32);
+  EXPECT_EQ(frame->PixelData(), pixel_data);
+  const CpuFramePool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.thread_cache_hits, 0);
+  EXPECT_EQ(stats.shared_hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+}
+
+TEST(CpuFramePoolTest, CachesFewBuffersOfEachSizePerThread) {
+  CpuFramePoolOptions options;
+  options.max_thread_cached_buffers_per_size = 2;
+  CpuFramePool pool(options);
+  std::unique_ptr<ImageFrame> frames[3];
+  for (auto& frame : frames) {
+    frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  }
+  for (auto& frame : frames) {
+    frame.reset();
+  }
+  // The third buffer goes to the shared pool, although the thread could cache
+  // more bytes.
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 1024);
+}
+
+TEST(CpuFramePoolTest, ReleasesFramesAfterThreadCachesAreDestroyed) {
+  CpuFramePool pool;
+  std::thread([&pool] {
+    // Constructed before the thread caches of the pool, so destroyed after
+    // them when the thread exits.
+    thread_local std::unique_ptr<ImageFrame> frame;
+    frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  }).join();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 1024);
+}
+
+TEST(CpuFramePoolTest, TrimFreesIdleBuffers) {
+  CpuFramePoolOptions options;
+  options.max_thread_cached_bytes = 1024;
+  CpuFramePool pool(options);
+  // The first buffer is cached by the thread, the second one by the shared
+  // pool.
+  std::unique_ptr<ImageFrame> first = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  std::unique_ptr<ImageFrame> second =
+      pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  first.reset();
+  second.reset();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 1024);
+
+  pool.Trim();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 0);
+  first = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  const CpuFramePool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.thread_cache_hits, 0);
+  EXPECT_EQ(stats.misses, 3);
+}
+
+TEST(CpuFramePoolTest, TrimsWhenIdleBuffersExceedHighWaterMark) {
+  CpuFramePoolOptions options;
+  options.max_thread_cached_bytes = 0;
+  options.max_idle_bytes = 2048;
+  CpuFramePool pool(options);
+  std::unique_ptr<ImageFrame> frames[3];
+  for (auto& frame : frames) {
+    frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  }
+  frames[0].reset();
+  frames[1].reset();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 2048);
+
+  // The third idle buffer is over the mark.
+  frames[2].reset();
+  EXPECT_EQ(pool.GetStats().shared_pooled_bytes, 0);
+}
+
+TEST(CpuFramePoolTest, CountsBytesCachedByThreadsTowardsHighWaterMark) {
+  CpuFramePoolOptions options;
+  options.max_idle_bytes = 2048;
+  CpuFramePool pool(options);
+  std::unique_ptr<ImageFrame> frames[3];
+  for (auto& frame : frames) {
+    frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  }
+  frames[0].reset();
+  std::thread([&frames] { frames[1].reset(); }).join();
+  // The cache of the exited thread is not counted anymore.
+  EXPECT_EQ(pool.GetStats().thread_cached_bytes, 1024);
+  frames[2].reset();
+  EXPECT_EQ(pool.GetStats().thread_cached_bytes, 2048);
+
+  for (auto& frame : frames) {
+    frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+  }
+  // The thread caches two buffers again, and the third one is over the mark.
+  for (auto& frame : frames) {
+    frame.reset();
+  }
+  const CpuFramePool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.thread_cache_hits, 2);
+  EXPECT_EQ(stats.thread_cached_bytes, 0);
+  EXPECT_EQ(stats.shared_pooled_bytes, 0);
+}
+
+TEST(CpuFramePoolTest, FramesCanOutliveThePool) {
+  std::unique_ptr<ImageFrame> frames[2];
+  {
+    CpuFramePool pool;
+    for (auto& frame : frames) {
+      frame = pool.GetFrame(ImageFormat::GRAY8, 32, 32);
+    }
+  }
+  // The buffers are freed with the last frame, whichever thread releases it.
+  frames[0]->MutablePixelData()[0] = 1;
+  frames[0].reset();
+  std::thread([&frames] { frames[1].reset(); }).join();
+}
+
+}  // namespace
+}  // namespace mediapipe
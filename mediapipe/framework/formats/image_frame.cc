@@ -27,6 +27,7 @@
 #include "absl/log/absl_log.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/packet_byte_size.h"
 #include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/proto_ns.h"
 
@@ -401,4 +402,9 @@ void ImageFrame::CopyToBuffer(float* buffer, int buffer_size) const {
                          reinterpret_cast<char*>(buffer));
   }
 }
+
+MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE(ImageFrame, [](const ImageFrame& frame) {
+  return frame.PixelDataSize();
+});
+
 }  // namespace mediapipe
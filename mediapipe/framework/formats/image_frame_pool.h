@@ -42,6 +42,9 @@ class ImageFramePool : public std::enable_shared_from_this<ImageFramePool> {
   }
 
   // Obtains a buffers. May either be reused or created anew.
+  // On hosts with several NUMA nodes, only buffers allocated on the calling
+  // thread's NUMA node are reused, and new buffers are zeroed by the calling
+  // thread so that their memory is placed on its node.
   ImageFrameSharedPtr GetBuffer();
 
   int width() const { return width_; }
@@ -55,8 +58,8 @@ class ImageFramePool : public std::enable_shared_from_this<ImageFramePool> {
   ImageFramePool(int width, int height, ImageFormat::Format format,
                  int keep_count);
 
-  // Return a buffer to the pool.
-  void Return(ImageFrame* buf);
+  // Return a buffer allocated on NUMA node index "node" to the pool.
+  void Return(ImageFrame* buf, int node);
 
   // If the total number of buffers is greater than keep_count, destroys any
   // surplus buffers that are no longer in use.
@@ -70,7 +73,10 @@ class ImageFramePool : public std::enable_shared_from_this<ImageFramePool> {
 
   absl::Mutex mutex_;
   int in_use_count_ ABSL_GUARDED_BY(mutex_) = 0;
-  std::vector<std::unique_ptr<ImageFrame>> available_ ABSL_GUARDED_BY(mutex_);
+  int available_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The buffers not in use, indexed by the NUMA node they were allocated on.
+  std::vector<std::vector<std::unique_ptr<ImageFrame>>> available_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace mediapipe
@@ -19,6 +19,8 @@
 #include "absl/log/absl_check.h"
 #include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/cpu_frame_pool.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/port/logging.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
@@ -30,14 +32,14 @@
 
 namespace mediapipe {
 
+#if !MEDIAPIPE_DISABLE_GPU
+
 // Keep this many buffers allocated for a given frame size.
 static constexpr int kKeepCount = 2;
 // The maximum size of the ImageMultiPool. When the limit is reached, the
 // oldest IBufferSpec will be dropped.
 static constexpr int kMaxPoolCount = 20;
 
-#if !MEDIAPIPE_DISABLE_GPU
-
 #if MEDIAPIPE_GPU_BUFFER_USE_CV_PIXEL_BUFFER
 
 ImageMultiPool::SimplePoolGpu ImageMultiPool::MakeSimplePoolGpu(
@@ -113,17 +115,6 @@ Image ImageMultiPool::GetBufferFromSimplePool(
 
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
-ImageMultiPool::SimplePoolCpu ImageMultiPool::MakeSimplePoolCpu(
-    IBufferSpec spec) {
-  return ImageFramePool::Create(spec.width, spec.height, spec.format,
-                                kKeepCount);
-}
-
-Image ImageMultiPool::GetBufferFromSimplePool(
-    IBufferSpec spec, const ImageMultiPool::SimplePoolCpu& pool) {
-  return Image(pool->GetBuffer());
-}
-
 Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
                                 ImageFormat::Format format) {
 #if !MEDIAPIPE_DISABLE_GPU
@@ -158,33 +149,11 @@ Image ImageMultiPool::GetBuffer(int width, int height, bool use_gpu,
   } else  // NOLINT(readability/braces)
 #endif    // !MEDIAPIPE_DISABLE_GPU
   {
-    absl::MutexLock lock(&mutex_cpu_);
-    IBufferSpec key(width, height, format);
-    auto pool_it = pools_cpu_.find(key);
-    if (pool_it == pools_cpu_.end()) {
-      // Discard the least recently used pool in LRU cache.
-      if (pools_cpu_.size() >= kMaxPoolCount) {
-        auto old_spec = buffer_specs_cpu_.front();  // Front has LRU.
-        buffer_specs_cpu_.pop_front();
-        pools_cpu_.erase(old_spec);
-      }
-      buffer_specs_cpu_.push_back(key);  // Push new spec to back.
-      std::tie(pool_it, std::ignore) = pools_cpu_.emplace(
-          std::piecewise_construct, std::forward_as_tuple(key),
-          std::forward_as_tuple(MakeSimplePoolCpu(key)));
-    } else {
-      // Find and move current 'key' spec to back, keeping others in same order.
-      auto specs_it = buffer_specs_cpu_.begin();
-      while (specs_it != buffer_specs_cpu_.end()) {
-        if (*specs_it == key) {
-          buffer_specs_cpu_.erase(specs_it);
-          break;
-        }
-        ++specs_it;
-      }
-      buffer_specs_cpu_.push_back(key);
-    }
-    return GetBufferFromSimplePool(pool_it->first, pool_it->second);
+    // CPU buffers come from a pool bucketed by byte size rather than by
+    // dimensions, which serves most requests from per-thread free lists.
+    // Fix alignment at 4 for best compatability with OpenGL.
+    return Image(ImageFrameSharedPtr(CpuFramePool::GetDefault().GetFrame(
+        format, width, height, ImageFrame::kGlDefaultAlignmentBoundary)));
   }
 }
 
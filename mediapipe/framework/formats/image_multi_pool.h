@@ -14,7 +14,8 @@
 
 // This class lets calculators allocate GpuBuffers of various sizes, caching
 // and reusing them as needed. It does so by automatically creating and using
-// platform-specific buffer pools for the requested sizes.
+// platform-specific buffer pools for the requested sizes. CPU buffers come
+// from CpuFramePool::GetDefault, which reuses them across sizes and formats.
 //
 // This class is not meant to be used directly by calculators, but is instead
 // used by GlCalculatorHelper to allocate buffers.
@@ -28,7 +29,7 @@
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/formats/image.h"
-#include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/formats/image_frame.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gpu_buffer.h"
@@ -118,17 +119,6 @@ class ImageMultiPool {
   std::deque<IBufferSpec> buffer_specs_gpu_;
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
-  typedef std::shared_ptr<ImageFramePool> SimplePoolCpu;
-  SimplePoolCpu MakeSimplePoolCpu(IBufferSpec spec);
-  Image GetBufferFromSimplePool(IBufferSpec spec, const SimplePoolCpu& pool);
-
-  absl::Mutex mutex_cpu_;
-  std::unordered_map<IBufferSpec, SimplePoolCpu, IBufferSpecHash> pools_cpu_
-      ABSL_GUARDED_BY(mutex_cpu_);
-  // A queue of IBufferSpecs to keep track of the age of each IBufferSpec added
-  // to the pool.
-  std::deque<IBufferSpec> buffer_specs_cpu_;
-
 #if !MEDIAPIPE_DISABLE_GPU
 #ifdef __APPLE__
   // Texture caches used with this pool.
@@ -26,6 +26,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/packet_byte_size.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/aligned_malloc_and_free.h"  // IWYU pragma: keep
 #include "mediapipe/framework/port/ret_check.h"
@@ -444,6 +445,7 @@ void Tensor::Move(Tensor* src) {
   element_type_ = src->element_type();
   src->element_type_ = ElementType::kNone;  // Mark as invalidated.
   cpu_buffer_ = std::exchange(src->cpu_buffer_, nullptr);
+  cpu_buffer_pool_ = std::move(src->cpu_buffer_pool_);
   ahwb_tracking_key_ = src->ahwb_tracking_key_;
   mtl_resources_ = std::move(src->mtl_resources_);
   MoveAhwbStuff(src);
@@ -474,11 +476,12 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
       shape_(shape),
       memory_alignment_(memory_alignment),
       mtl_resources_(std::make_unique<MtlResources>()) {
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
-  }
 #endif  // MEDIAPIPE_TENSOR_USE_AHWB
+  }
 }
 Tensor::Tensor(ElementType element_type, const Shape& shape,
                const QuantizationParameters& quantization_parameters,
@@ -488,11 +491,12 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
       quantization_parameters_(quantization_parameters),
       memory_alignment_(memory_alignment),
       mtl_resources_(std::make_unique<MtlResources>()) {
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
-  }
 #endif  // MEDIAPIPE_TENSOR_USE_AHWB
+  }
 }
 
 #if MEDIAPIPE_METAL_ENABLED
@@ -754,7 +758,10 @@ absl::Status Tensor::AllocateCpuBuffer() const {
     // memory page which should match common alignment requirements.
     cpu_buffer_ = AllocateVirtualMemory(bytes());
 #else
-    if (memory_alignment_ > 0) {
+    if (cpu_buffer_pool_) {
+      cpu_buffer_ = cpu_buffer_pool_->Acquire(
+          std::max(memory_alignment_, bytes()), memory_alignment_);
+    } else if (memory_alignment_ > 0) {
       // TODO b/339271330 - Investigate how aligned memory performs in
       // MP WebAssembly targets.
       // TfLite custom allocation requires at least memory_alignment_ bytes.
@@ -776,7 +783,10 @@ void Tensor::FreeCpuBuffer() const {
 #if MEDIAPIPE_METAL_ENABLED
   free(cpu_buffer_);
 #else
-  if (memory_alignment_ > 0) {
+  if (cpu_buffer_pool_) {
+    cpu_buffer_pool_->Release(cpu_buffer_, std::max(memory_alignment_, bytes()),
+                              memory_alignment_);
+  } else if (memory_alignment_ > 0) {
     aligned_free(cpu_buffer_);
   } else {
     free(cpu_buffer_);
@@ -785,4 +795,8 @@ void Tensor::FreeCpuBuffer() const {
   cpu_buffer_ = nullptr;
 }
 
+MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE(Tensor, [](const Tensor& tensor) {
+  return tensor.bytes();
+});
+
 }  // namespace mediapipe
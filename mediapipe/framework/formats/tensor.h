@@ -29,6 +29,7 @@
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
 #include "mediapipe/framework/formats/tensor/internal.h"
 #include "mediapipe/framework/memory_manager.h"
 // Exports MEDIAPIPE_TENSOR_USE_AHWB macro.
@@ -452,6 +453,9 @@ class Tensor {
   mutable void* cpu_buffer_ = nullptr;
   absl::Status AllocateCpuBuffer() const;
   void FreeCpuBuffer() const;
+  // Provides cpu_buffer_ if the Tensor was created with a MemoryManager.
+  // Holding the shared_ptr to the pool ensures it outlives cpu_buffer_.
+  std::shared_ptr<CpuBufferPool> cpu_buffer_pool_;
   // Forward declaration of the MtlResources provides compile-time verification
   // of ODR if this header includes any actual code that uses MtlResources.
   mutable std::unique_ptr<MtlResources> mtl_resources_;
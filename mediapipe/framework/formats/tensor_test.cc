@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/framework/port/gmock.h"
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -68,6 +69,25 @@ TEST(Cpu, TestAlignedMemoryAllocation) {
   }
 }
 
+TEST(Cpu, TestPooledMemoryAllocation) {
+  MemoryManager memory_manager;
+  void* p1;
+  {
+    Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{4, 3, 2, 3},
+              &memory_manager, /*memory_alignment=*/64);
+    p1 = t1.GetCpuWriteView().buffer<void>();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p1) % 64, 0);
+  }
+  // The buffer of t1 returned to the pool and is reused for t2.
+  Tensor t2(Tensor::ElementType::kFloat32, Tensor::Shape{4, 3, 2, 3},
+            &memory_manager, /*memory_alignment=*/64);
+  EXPECT_EQ(t2.GetCpuWriteView().buffer<void>(), p1);
+  const CpuBufferPool::Stats stats =
+      memory_manager.GetCpuBufferPool()->GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+}
+
 TEST(Cpu, TestTensorMove) {
   Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{4, 3, 2, 3},
             Tensor::QuantizationParameters(0.5, 127));
@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/input_stream_handler.h"
 
+#include <algorithm>
+
 #include "absl/log/absl_check.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -24,6 +26,49 @@
 namespace mediapipe {
 using SyncSet = InputStreamHandler::SyncSet;
 
+namespace {
+
+// The NotificationBatch collecting notifications on the current thread.
+thread_local InputStreamHandler::NotificationBatch* current_batch = nullptr;
+
+}  // namespace
+
+InputStreamHandler::NotificationBatch::NotificationBatch()
+    : outermost_(current_batch == nullptr) {
+  if (outermost_) {
+    current_batch = this;
+  }
+}
+
+InputStreamHandler::NotificationBatch::~NotificationBatch() {
+  if (!outermost_) {
+    return;
+  }
+  // Notifications may run nodes inline, which start batches of their own.
+  current_batch = nullptr;
+  for (const Entry& entry : entries_) {
+    if (entry.notifications > 0) {
+      entry.handler->notification_();
+    }
+    entry.handler->RecordNotifications(
+        entry.bound_updates, entry.notifications > 0 ? 1 : 0,
+        std::max(entry.notifications - 1, 0));
+  }
+}
+
+void InputStreamHandler::NotificationBatch::Add(InputStreamHandler* handler,
+                                                bool bound_update,
+                                                bool notify) {
+  for (Entry& entry : entries_) {
+    if (entry.handler == handler) {
+      entry.bound_updates += bound_update;
+      entry.notifications += notify;
+      return;
+    }
+  }
+  entries_.push_back({handler, bound_update, notify});
+}
+
 absl::Status InputStreamHandler::InitializeInputStreamManagers(
     InputStreamManager* flat_input_stream_managers) {
   for (CollectionItemId id = input_stream_managers_.BeginId();
@@ -130,6 +175,19 @@ void InputStreamHandler::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+void InputStreamHandler::SetMaxQueueBytes(int64_t max_queue_bytes) {
+  for (auto& stream : input_stream_managers_) {
+    stream->SetMaxQueueBytes(max_queue_bytes);
+  }
+}
+
+void InputStreamHandler::SetTargetQueueDelay(
+    absl::Duration target_queue_delay) {
+  for (auto& stream : input_stream_managers_) {
+    stream->SetTargetQueueDelay(target_queue_delay);
+  }
+}
+
 std::string InputStreamHandler::DebugStreamNames() const {
   std::vector<absl::string_view> stream_names;
   for (const auto& stream : input_stream_managers_) {
@@ -180,6 +238,14 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
       mediapipe::LogEvent(default_context->GetProfilingContext(),
                           TraceEvent(TraceEvent::NOT_READY)
                               .set_node_id(default_context->NodeId()));
+      // No more input sets are ready, so an incomplete batch is scheduled
+      // right away rather than waiting for later inputs.
+      if (schedule_partial_batches_ &&
+          calculator_context_manager_->ContextHasInputTimestamp(
+              *default_context)) {
+        schedule_callback_(default_context);
+        ++invocations_scheduled;
+      }
       break;
     } else if (node_readiness == NodeReadiness::kReadyForProcess) {
       CalculatorContext* calculator_context =
@@ -268,9 +334,7 @@ void InputStreamHandler::AddPackets(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
-  if (notify) {
-    notification_();
-  }
+  NotifyUpdate(/*bound_update=*/false, notify);
 }
 
 void InputStreamHandler::MovePackets(CollectionItemId id,
@@ -283,9 +347,7 @@ void InputStreamHandler::MovePackets(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
-  if (notify) {
-    notification_();
-  }
+  NotifyUpdate(/*bound_update=*/false, notify);
 }
 
 void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
@@ -296,9 +358,34 @@ void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
+  NotifyUpdate(/*bound_update=*/true, notify);
+}
+
+void InputStreamHandler::NotifyUpdate(bool bound_update, bool notify) {
+  if (current_batch != nullptr) {
+    current_batch->Add(this, bound_update, notify);
+    return;
+  }
   if (notify) {
     notification_();
   }
+  RecordNotifications(bound_update, notify, 0);
+}
+
+void InputStreamHandler::RecordNotifications(int bound_updates,
+                                             int notifications,
+                                             int coalesced_notifications) {
+#ifdef MEDIAPIPE_PROFILER_AVAILABLE
+  if (bound_updates == 0 && notifications == 0) {
+    return;
+  }
+  CalculatorContext* context =
+      GetCalculatorContext(calculator_context_manager_);
+  if (context && context->GetProfilingContext()) {
+    context->GetProfilingContext()->AddInputNotifications(
+        *context, bound_updates, notifications, coalesced_notifications);
+  }
+#endif
 }
 
 void InputStreamHandler::ClearCurrentInputs(
@@ -330,6 +417,22 @@ void InputStreamHandler::SetBatchSize(int batch_size) {
   batch_size_ = batch_size;
 }
 
+absl::Status InputStreamHandler::SetMaxBatchSize(int max_batch_size) {
+  RET_CHECK_GE(max_batch_size, 1)
+      << "Max batch size has to be greater than or equal to 1.";
+  RET_CHECK(!calculator_run_in_parallel_ || max_batch_size == 1)
+      << "Batching cannot be combined with parallel execution.";
+  RET_CHECK(!late_preparation_ || max_batch_size == 1)
+      << "Batching cannot be combined with late preparation.";
+  RET_CHECK_EQ(batch_size_, 1)
+      << "Batching is already enabled by the input stream handler.";
+  RET_CHECK_GT(NumInputStreams(), 0)
+      << "Source nodes cannot batch input packets.";
+  batch_size_ = max_batch_size;
+  schedule_partial_batches_ = true;
+  return absl::OkStatus();
+}
+
 void InputStreamHandler::SetLatePreparation(bool late_preparation) {
   ABSL_CHECK(batch_size_ == 1 || !late_preparation_)
       << "Batching cannot be combined with late preparation.";
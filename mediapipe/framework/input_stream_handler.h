@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_HANDLER_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
@@ -23,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
+#include "absl/time/time.h"
 // TODO: Move protos in another CL after the C++ code migration.
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_context_manager.h"
@@ -78,6 +81,40 @@ class InputStreamHandler {
 
   virtual ~InputStreamHandler() = default;
 
+  // While a NotificationBatch is in scope, the notifications of the input
+  // stream handlers updated on the current thread are deferred, and each
+  // handler is notified at most once when the outermost NotificationBatch is
+  // destroyed.  OutputStreamManager and OutputStreamHandler use it while
+  // propagating packets and timestamp bounds, so that a node consuming several
+  // of the updated streams checks its readiness once per propagation rather
+  // than once per stream.
+  class NotificationBatch {
+   public:
+    NotificationBatch();
+    ~NotificationBatch();
+
+    NotificationBatch(const NotificationBatch&) = delete;
+    NotificationBatch& operator=(const NotificationBatch&) = delete;
+
+   private:
+    friend class InputStreamHandler;
+
+    // The updates received by one input stream handler in this batch.
+    struct Entry {
+      InputStreamHandler* handler;
+      int bound_updates;
+      int notifications;
+    };
+
+    // Records an update of "handler", which requests a notification if
+    // "notify" is true.
+    void Add(InputStreamHandler* handler, bool bound_update, bool notify);
+
+    // True if this is the outermost NotificationBatch on its thread.
+    const bool outermost_;
+    absl::InlinedVector<Entry, 8> entries_;
+  };
+
   // Initializes the InputStreamManagerSet object.
   // flat_input_stream_managers is expected to point to a contiguous
   // flat array with InputStreamManagers corresponding to the id's in
@@ -127,6 +164,12 @@ class InputStreamHandler {
   // Sets max queue size of a particular stream.
   void SetMaxQueueSize(CollectionItemId id, int max_queue_size);
 
+  // Sets the maximum number of queued bytes of every stream.
+  void SetMaxQueueBytes(int64_t max_queue_bytes);
+
+  // Sets the target queueing delay of every stream.
+  void SetTargetQueueDelay(absl::Duration target_queue_delay);
+
   void SetQueueSizeCallbacks(
       InputStreamManager::QueueSizeCallback becomes_full_callback,
       InputStreamManager::QueueSizeCallback becomes_not_full_callback);
@@ -184,6 +227,12 @@ class InputStreamHandler {
   // When true, Calculator::Process is called for every input timestamp bound.
   bool ProcessTimestampBounds() { return process_timestamps_; }
 
+  // Collects up to max_batch_size input sets per invocation. Unlike
+  // SetBatchSize(), an incomplete batch is scheduled as soon as the node
+  // becomes not ready, so batching never delays an input set. Used for
+  // calculators that set CalculatorContract::SetMaxBatchSize().
+  absl::Status SetMaxBatchSize(int max_batch_size);
+
   // Returns the number of sync-sets populated by this input stream handler.
   virtual int SyncSetCount() { return 1; }
 
@@ -300,9 +349,22 @@ class InputStreamHandler {
   // CalculatorNode is scheduled.
   int batch_size_ = 1;
 
+  // When true, an incomplete batch is scheduled once no more input sets are
+  // ready, instead of waiting until batch_size_ input sets are collected.
+  bool schedule_partial_batches_ = false;
+
   // When true, any increase in timestamp bound invokes Calculator::Process.
   bool process_timestamps_ = false;
 
+  // Notifies the observer of an update of one of the input streams, or defers
+  // the notification to the current NotificationBatch.
+  void NotifyUpdate(bool bound_update, bool notify);
+
+  // Records the input stream updates and notifications in the profile of the
+  // calculator.
+  void RecordNotifications(int bound_updates, int notifications,
+                           int coalesced_notifications);
+
   // A callback to notify the observer when all the input stream headers
   // (excluding headers of back edges) become available.
   std::function<void()> headers_ready_callback_;
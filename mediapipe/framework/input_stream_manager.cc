@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -25,7 +27,9 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_byte_size.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
@@ -33,6 +37,20 @@
 
 namespace mediapipe {
 
+namespace {
+
+// Upper bound on the number of packet slots SetMaxQueueSize() preallocates.
+constexpr int kMaxReservedQueueSize = 256;
+
+// Weight of the latest sample in the moving average of the drain interval.
+constexpr double kDrainIntervalSmoothing = 0.125;
+
+// Lower bound of the adaptive queue size, which leaves a packet waiting after
+// each pop, so that the drain interval keeps being measured.
+constexpr int kMinAdaptiveQueueSize = 2;
+
+}  // namespace
+
 absl::Status InputStreamManager::Initialize(const std::string& name,
                                             const PacketType* packet_type,
                                             bool back_edge) {
@@ -55,7 +73,12 @@ void InputStreamManager::SetQueueSizeCallbacks(
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
   queue_.clear();
+  UpdateQueueSize();
   last_reported_stream_full_ = false;
+  queue_bytes_ = 0;
+  last_backlogged_pop_time_ = absl::InfinitePast();
+  drain_interval_usec_ = 0;
+  adaptive_queue_size_ = -1;
   num_packets_added_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
   last_select_timestamp_ = Timestamp::Unstarted();
@@ -63,11 +86,6 @@ void InputStreamManager::PrepareForRun() {
   header_ = Packet();
 }
 
-bool InputStreamManager::IsEmpty() const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  return queue_.empty();
-}
-
 Packet InputStreamManager::QueueHead() const {
   absl::MutexLock stream_lock(&stream_mutex_);
   if (queue_.empty()) {
@@ -103,6 +121,22 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
   *notify = false;
   bool queue_became_non_empty = false;
   bool queue_became_full = false;
+  // Packet types don't depend on the stream state, so they are validated
+  // before taking stream_mutex_ to keep the critical section short. The first
+  // mismatch is reported at the same point in the loop below as before.
+  int first_invalid_index = -1;
+  absl::Status invalid_type_status;
+  {
+    int index = 0;
+    for (const auto& packet : container) {
+      invalid_type_status = packet_type_->Validate(packet);
+      if (!invalid_type_status.ok()) {
+        first_invalid_index = index;
+        break;
+      }
+      ++index;
+    }
+  }
   {
     // Scope to prevent locking the stream when notification is called.
     absl::MutexLock stream_lock(&stream_mutex_);
@@ -123,18 +157,17 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
       return absl::OkStatus();
     }
     // Check if the queue was full before packets came in.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullHelper();
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
+    int index = 0;
     for (auto& packet : container) {
-      absl::Status result = packet_type_->Validate(packet);
-      if (!result.ok()) {
+      if (index++ == first_invalid_index) {
         return tool::AddStatusPrefix(
             absl::StrCat(
                 "Packet type mismatch on a calculator receiving from stream \"",
                 name_, "\": "),
-            result);
+            invalid_type_status);
       }
 
       const Timestamp timestamp = packet.Timestamp();
@@ -173,6 +206,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
       // If the caller is MovePackets(), packet's underlying holder should be
       // transferred into queue_. Otherwise, queue_ keeps a copy of the packet.
       ++num_packets_added_;
+      if (max_queue_bytes_ > 0) {
+        queue_bytes_ += byte_sizer_.ByteSize(packet);
+      }
       VLOG(3) << "Input stream:" << name_
               << " has added packet at time: " << packet.Timestamp();
       if (std::is_const<
@@ -181,9 +217,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
       } else {
         queue_.emplace_back(std::move(packet));
       }
+      UpdateQueueSize();
     }
-    queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
-                         queue_.size() >= max_queue_size_);
+    queue_became_full = !was_queue_full && IsFullHelper();
     if (queue_.size() > 1) {
       VLOG(3) << "Queue size greater than 1: stream name: " << name_
               << " queue_size: " << queue_.size();
@@ -267,6 +303,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
   ABSL_CHECK(enable_timestamps_);
   *num_packets_dropped = -1;
   *stream_is_done = false;
+  bool queue_became_full = false;
   bool queue_became_non_full = false;
   Packet packet;
   {
@@ -289,15 +326,19 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
     Timestamp current_timestamp = Timestamp::Unset();
 
     // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullHelper();
 
     while (!queue_.empty() && queue_.front().Timestamp() <= timestamp) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      RemoveQueueBytes(packet);
       current_timestamp = packet.Timestamp();
       ++(*num_packets_dropped);
     }
+    UpdateQueueSize();
+    if (current_timestamp != Timestamp::Unset()) {
+      UpdateDrainInterval();
+    }
     // Clear value_ if it doesn't have exactly the right timestamp.
     if (current_timestamp != timestamp) {
       // The timestamp bound reported when no packet is sent.
@@ -308,10 +349,16 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    // The adaptive queue size may shrink below the remaining packets.
+    const bool is_queue_full = IsFullHelper();
+    queue_became_full = !was_queue_full && is_queue_full;
+    queue_became_non_full = was_queue_full && !is_queue_full;
     *stream_is_done = IsDone();
   }
-  if (queue_became_non_full) {
+  if (queue_became_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  } else if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
     becomes_not_full_callback_(this, &last_reported_stream_full_);
   }
@@ -321,6 +368,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
 Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   ABSL_CHECK(!enable_timestamps_);
   *stream_is_done = false;
+  bool queue_became_full = false;
   bool queue_became_non_full = false;
   Packet packet;
   {
@@ -329,22 +377,29 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     VLOG(3) << "Input stream " << name_ << " selecting at queue head";
 
     // Check if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullHelper();
 
     if (!queue_.empty()) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      RemoveQueueBytes(packet);
+      UpdateQueueSize();
+      UpdateDrainInterval();
     } else {
       packet = Packet();
     }
 
     VLOG(3) << "Input stream removed a packet:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    const bool is_queue_full = IsFullHelper();
+    queue_became_full = !was_queue_full && is_queue_full;
+    queue_became_non_full = was_queue_full && !is_queue_full;
     *stream_is_done = IsDone();
   }
-  if (queue_became_non_full) {
+  if (queue_became_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  } else if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
     becomes_not_full_callback_(this, &last_reported_stream_full_);
   }
@@ -356,11 +411,6 @@ int InputStreamManager::NumPacketsAdded() const {
   return num_packets_added_;
 }
 
-int InputStreamManager::QueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return static_cast<int>(queue_.size());
-}
-
 int InputStreamManager::MaxQueueSize() const {
   absl::MutexLock lock(&stream_mutex_);
   return max_queue_size_;
@@ -371,9 +421,45 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   bool is_full;
   {
     absl::MutexLock lock(&stream_mutex_);
-    was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    was_full = IsFullHelper();
     max_queue_size_ = max_queue_size;
-    is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    // The adaptive limit is measured again against the new maximum.
+    adaptive_queue_size_ = -1;
+    is_full = IsFullHelper();
+    if (max_queue_size_ > 0) {
+      queue_.reserve(std::min(max_queue_size_, kMaxReservedQueueSize));
+    }
+  }
+
+  // QueueSizeCallback is called with no mutexes held.
+  if (!was_full && is_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  } else if (was_full && !is_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+}
+
+int64_t InputStreamManager::QueueBytes() const {
+  absl::MutexLock lock(&stream_mutex_);
+  return queue_bytes_;
+}
+
+void InputStreamManager::SetMaxQueueBytes(int64_t max_queue_bytes) {
+  bool was_full;
+  bool is_full;
+  {
+    absl::MutexLock lock(&stream_mutex_);
+    was_full = IsFullHelper();
+    max_queue_bytes_ = max_queue_bytes;
+    queue_bytes_ = 0;
+    if (max_queue_bytes_ > 0) {
+      for (int i = 0; i < queue_.size(); ++i) {
+        queue_bytes_ += byte_sizer_.ByteSize(queue_[i]);
+      }
+    }
+    is_full = IsFullHelper();
   }
 
   // QueueSizeCallback is called with no mutexes held.
@@ -386,9 +472,70 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+void InputStreamManager::SetTargetQueueDelay(
+    absl::Duration target_queue_delay) {
+  absl::MutexLock lock(&stream_mutex_);
+  target_queue_delay_ = target_queue_delay;
+  adaptive_queue_size_ = -1;
+}
+
+void InputStreamManager::SetClock(Clock* clock) {
+  absl::MutexLock lock(&stream_mutex_);
+  clock_ = clock;
+}
+
 bool InputStreamManager::IsFull() const {
   absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
+  return IsFullHelper();
+}
+
+bool InputStreamManager::IsFullHelper() const {
+  if (max_queue_size_ != -1) {
+    const int limit = adaptive_queue_size_ > 0
+                          ? std::min(max_queue_size_, adaptive_queue_size_)
+                          : max_queue_size_;
+    if (queue_.size() >= limit) {
+      return true;
+    }
+  }
+  return max_queue_bytes_ > 0 && queue_bytes_ >= max_queue_bytes_;
+}
+
+void InputStreamManager::RemoveQueueBytes(const Packet& packet) {
+  if (max_queue_bytes_ > 0) {
+    queue_bytes_ -= byte_sizer_.ByteSize(packet);
+  }
+}
+
+void InputStreamManager::UpdateDrainInterval() {
+  // Without a maximum queue size there is no limit to adapt.
+  if (target_queue_delay_ <= absl::ZeroDuration() || max_queue_size_ == -1) {
+    return;
+  }
+  if (queue_.empty()) {
+    // The consumer caught up, so the time until the next pop depends on the
+    // producer.
+    last_backlogged_pop_time_ = absl::InfinitePast();
+    return;
+  }
+  const absl::Time now = clock_->TimeNow();
+  if (last_backlogged_pop_time_ != absl::InfinitePast()) {
+    const double interval_usec =
+        absl::ToDoubleMicroseconds(now - last_backlogged_pop_time_);
+    drain_interval_usec_ =
+        drain_interval_usec_ == 0
+            ? interval_usec
+            : drain_interval_usec_ +
+                  kDrainIntervalSmoothing *
+                      (interval_usec - drain_interval_usec_);
+    const double target_usec = absl::ToDoubleMicroseconds(target_queue_delay_);
+    const double packets =
+        std::ceil(target_usec / std::max(drain_interval_usec_, 1.0));
+    adaptive_queue_size_ = static_cast<int>(std::clamp(
+        packets, static_cast<double>(kMinAdaptiveQueueSize),
+        static_cast<double>(std::max(max_queue_size_, kMinAdaptiveQueueSize))));
+  }
+  last_backlogged_pop_time_ = now;
 }
 
 Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
@@ -396,7 +543,8 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
   if (queue_.empty()) {
     return Timestamp::Unset();
   }
-  return (queue_.cend() - std::min((size_t)n, queue_.size()))->Timestamp();
+  return queue_[queue_.size() - std::min((size_t)n, queue_.size())]
+      .Timestamp();
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
@@ -404,16 +552,17 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
   {
     absl::MutexLock lock(&stream_mutex_);
     // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullHelper();
 
     while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
+      RemoveQueueBytes(queue_.front());
       queue_.pop_front();
     }
+    UpdateQueueSize();
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    queue_became_non_full = was_queue_full && !IsFullHelper();
   }
   if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
@@ -15,15 +15,19 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
+#include <atomic>
 #include <cstdint>
-#include <deque>
 #include <functional>
 #include <list>
 #include <string>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_byte_size.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/status.h"
@@ -120,8 +124,8 @@ class InputStreamManager {
   // Turns off the use of packet timestamps.
   void DisableTimestamps();
 
-  // Returns true iff the queue is empty.
-  bool IsEmpty() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
+  // Returns true iff the queue is empty. Does not acquire stream_mutex_.
+  bool IsEmpty() const { return QueueSize() == 0; }
 
   // If the queue is not empty, returns the packet at the front of the queue.
   // Otherwise, returns an empty packet.
@@ -148,8 +152,11 @@ class InputStreamManager {
   // Returns the number of packets in the queue.
   int NumPacketsAdded() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
-  // Returns the number of packets in the queue.
-  int QueueSize() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
+  // Returns the number of packets in the queue. Does not acquire
+  // stream_mutex_, so the result may be stale by the time it is used.
+  int QueueSize() const {
+    return queue_size_.load(std::memory_order_relaxed);
+  }
 
   // Returns true iff the queue is full.
   bool IsFull() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
@@ -159,9 +166,35 @@ class InputStreamManager {
 
   // Sets the maximum queue size for the stream. Used to determine when the
   // callbacks for becomes_full and becomes_not_full should be invoked. A value
-  // of -1 means that there is no maximum queue size.
+  // of -1 means that there is no maximum queue size. Storage for up to
+  // max_queue_size packets is reserved up front, so that a queue that stays
+  // within its limit does not allocate while packets flow.
   void SetMaxQueueSize(int max_queue_size) ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns the number of bytes held by the packets in the queue, as estimated
+  // by PacketByteSize(). Only tracked while a maximum is set with
+  // SetMaxQueueBytes(), and 0 otherwise.
+  int64_t QueueBytes() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
+  // Sets the maximum number of bytes held by the packets in the queue. The
+  // queue also counts as full while it holds at least this many bytes. A
+  // value of 0 or less means that there is no maximum.
+  void SetMaxQueueBytes(int64_t max_queue_bytes)
+      ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
+  // If positive, the queue size is further limited to the number of packets
+  // the consumer is expected to pop within target_queue_delay, based on the
+  // measured time between pops while packets are waiting in the queue. The
+  // limit is at least 2 packets, so that the time between pops can still be
+  // measured, and has no effect if there is no maximum queue size.
+  void SetTargetQueueDelay(absl::Duration target_queue_delay)
+      ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
+  // Sets the clock used to measure the time between pops for
+  // SetTargetQueueDelay. The caller keeps ownership of "clock", which
+  // defaults to Clock::RealClock(). Meant for testing.
+  void SetClock(Clock* clock) ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
   // If there are equal to or more than n packets in the queue, this function
   // returns the min timestamp of among the latest n packets of the queue.  If
   // there are fewer than n packets in the queue, this function returns
@@ -198,8 +231,27 @@ class InputStreamManager {
   // Returns the smallest timestamp at which this stream might see an input.
   Timestamp MinTimestampOrBoundHelper() const;
 
+  // Returns true iff the queue is full.
+  bool IsFullHelper() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+
+  // Removes the bytes of a packet leaving the queue from queue_bytes_.
+  void RemoveQueueBytes(const Packet& packet)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+
+  // Updates the measured time between pops after packets are popped, and the
+  // queue size limit derived from it.
+  void UpdateDrainInterval() ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+
+  // Publishes queue_.size() for the lock-free QueueSize() and IsEmpty().
+  void UpdateQueueSize() ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_) {
+    queue_size_.store(static_cast<int>(queue_.size()),
+                      std::memory_order_relaxed);
+  }
+
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
+  RingQueue<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
+  // Mirrors queue_.size(), so that it can be read without stream_mutex_.
+  std::atomic<int> queue_size_{0};
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
   int64_t num_packets_added_ ABSL_GUARDED_BY(stream_mutex_);
@@ -219,6 +271,25 @@ class InputStreamManager {
   // The maximum queue size for this stream if set.
   int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
 
+  // The maximum number of bytes held by the queued packets, if positive.
+  int64_t max_queue_bytes_ ABSL_GUARDED_BY(stream_mutex_) = 0;
+  // The bytes held by the queued packets, while max_queue_bytes_ is positive.
+  int64_t queue_bytes_ ABSL_GUARDED_BY(stream_mutex_) = 0;
+  PacketByteSizer byte_sizer_ ABSL_GUARDED_BY(stream_mutex_);
+
+  // The queueing delay targeted by adaptive_queue_size_, if positive.
+  absl::Duration target_queue_delay_ ABSL_GUARDED_BY(stream_mutex_);
+  Clock* clock_ ABSL_GUARDED_BY(stream_mutex_) = Clock::RealClock();
+  // The time of the last pop that left packets in the queue, or
+  // absl::InfinitePast() if the queue has been emptied since.
+  absl::Time last_backlogged_pop_time_ ABSL_GUARDED_BY(stream_mutex_) =
+      absl::InfinitePast();
+  // Moving average of the time between pops while packets are waiting, in
+  // microseconds. 0 until measured.
+  double drain_interval_usec_ ABSL_GUARDED_BY(stream_mutex_) = 0;
+  // The queue size limit derived from target_queue_delay_, or -1.
+  int adaptive_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
+
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
 
@@ -0,0 +1,83 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures InputStreamManager throughput in packets per second for a single
+// stream written by several producer threads and drained by one consumer.
+// $ bazel run -c opt mediapipe/framework:input_stream_manager_benchmark
+
+#include <list>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_type.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kPacketsPerProducer = 100000;
+
+// Argument: number of producer threads.
+void BM_InputStreamManagerAddAndPop(benchmark::State& state) {
+  const int num_producers = state.range(0);
+  PacketType packet_type;
+  packet_type.Set<int>();
+  InputStreamManager stream;
+  ABSL_CHECK_OK(stream.Initialize("input", &packet_type, /*back_edge=*/false));
+  // Packets from several producers have no common timestamp order.
+  stream.DisableTimestamps();
+  stream.SetQueueSizeCallbacks([](InputStreamManager*, bool*) {},
+                               [](InputStreamManager*, bool*) {});
+  const Packet packet = MakePacket<int>(0);
+
+  for (auto _ : state) {
+    stream.PrepareForRun();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&stream, &packet] {
+        std::list<Packet> packets = {packet};
+        bool notify;
+        for (int i = 0; i < kPacketsPerProducer; ++i) {
+          ABSL_CHECK_OK(stream.AddPackets(packets, &notify));
+        }
+      });
+    }
+    int num_popped = 0;
+    bool stream_is_done;
+    while (num_popped < num_producers * kPacketsPerProducer) {
+      if (!stream.PopQueueHead(&stream_is_done).IsEmpty()) {
+        ++num_popped;
+      }
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_producers *
+                          kPacketsPerProducer);
+}
+BENCHMARK(BM_InputStreamManagerAddAndPop)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(8)
+    ->ArgName("producers")
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -14,18 +14,41 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
 #include <memory>
+#include <string>
 
 #include "absl/memory/memory.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/lifetime_tracker.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_byte_size.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
 
 namespace mediapipe {
 namespace {
+
+MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE(std::string, [](const std::string& s) {
+  return s.size();
+});
+
+// A clock that only advances when slept on.
+class ManualClock : public Clock {
+ public:
+  absl::Time TimeNow() override { return now_; }
+  void Sleep(absl::Duration d) override { now_ += d; }
+  void SleepUntil(absl::Time wakeup_time) override {
+    now_ = std::max(now_, wakeup_time);
+  }
+
+ private:
+  absl::Time now_ = absl::UnixEpoch();
+};
+
 class InputStreamManagerTest : public ::testing::Test {
  protected:
   InputStreamManagerTest() {}
@@ -783,6 +806,93 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
+TEST_F(InputStreamManagerTest, QueueBytesTest) {
+  input_stream_manager_->SetMaxQueueBytes(10);
+  std::list<Packet> packets;
+  packets.push_back(MakePacket<std::string>("12345").At(Timestamp(10)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_EQ(5, input_stream_manager_->QueueBytes());
+  EXPECT_FALSE(input_stream_manager_->IsFull());
+
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("123456").At(Timestamp(20)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_EQ(11, input_stream_manager_->QueueBytes());
+  EXPECT_TRUE(input_stream_manager_->IsFull());
+
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(10), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_EQ("12345", popped_packet_.Get<std::string>());
+  EXPECT_EQ(6, input_stream_manager_->QueueBytes());
+  EXPECT_FALSE(input_stream_manager_->IsFull());
+
+  // Lowering the budget below the queued bytes makes the queue full.
+  input_stream_manager_->SetMaxQueueBytes(6);
+  EXPECT_TRUE(input_stream_manager_->IsFull());
+
+  expected_queue_becomes_full_count_ = 2;
+  expected_queue_becomes_not_full_count_ = 1;
+}
+
+TEST_F(InputStreamManagerTest, AdaptiveQueueSizeTest) {
+  ManualClock clock;
+  input_stream_manager_->SetClock(&clock);
+  input_stream_manager_->SetMaxQueueSize(10);
+  input_stream_manager_->SetTargetQueueDelay(absl::Milliseconds(30));
+  std::list<Packet> packets;
+  for (int i = 1; i <= 10; ++i) {
+    packets.push_back(MakePacket<std::string>("packet").At(Timestamp(i * 10)));
+  }
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(input_stream_manager_->IsFull());
+
+  // The first pop only starts measuring the drain interval.
+  clock.Sleep(absl::Milliseconds(10));
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(10), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_FALSE(input_stream_manager_->IsFull());
+
+  // The consumer takes a packet every 10 ms, so 3 packets cover the target
+  // delay, and the queue is full until fewer than 3 are left.
+  for (int i = 2; i <= 7; ++i) {
+    clock.Sleep(absl::Milliseconds(10));
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        Timestamp(i * 10), &num_packets_dropped_, &stream_is_done_);
+    EXPECT_TRUE(input_stream_manager_->IsFull()) << "after pop " << i;
+  }
+  clock.Sleep(absl::Milliseconds(10));
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(80), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_EQ(2, input_stream_manager_->QueueSize());
+  EXPECT_FALSE(input_stream_manager_->IsFull());
+
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet").At(Timestamp(110)));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(input_stream_manager_->IsFull());
+
+  expected_queue_becomes_full_count_ = 3;
+  expected_queue_becomes_not_full_count_ = 2;
+}
+
+TEST_F(InputStreamManagerTest, AdaptiveQueueSizeNeedsMaxQueueSize) {
+  ManualClock clock;
+  input_stream_manager_->SetClock(&clock);
+  input_stream_manager_->SetMaxQueueSize(-1);
+  input_stream_manager_->SetTargetQueueDelay(absl::Milliseconds(30));
+  std::list<Packet> packets;
+  for (int i = 1; i <= 10; ++i) {
+    packets.push_back(MakePacket<std::string>("packet").At(Timestamp(i * 10)));
+  }
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  for (int i = 1; i <= 5; ++i) {
+    clock.Sleep(absl::Milliseconds(10));
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        Timestamp(i * 10), &num_packets_dropped_, &stream_is_done_);
+  }
+  EXPECT_FALSE(input_stream_manager_->IsFull());
+}
+
 TEST_F(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
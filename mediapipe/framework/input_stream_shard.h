@@ -15,9 +15,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 
-#include <queue>
 #include <string>
 
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/input_stream.h"
 #include "mediapipe/framework/packet.h"
 
@@ -50,6 +50,13 @@ class InputStreamShard : public InputStream {
     return !packet_queue_.empty() ? packet_queue_.front() : empty_packet_;
   }
 
+  // Returns the packet of the input set at "index" in the current batch, or
+  // an empty packet if there is none. ValueInBatch(0) is the same as Value().
+  // See CalculatorContext::BatchSize().
+  const Packet& ValueInBatch(int index) const {
+    return index < NumberOfPackets() ? packet_queue_[index] : empty_packet_;
+  }
+
   // Returns a reference to the name string of the InputStreamManager.
   const std::string& Name() const { return *name_; }
 
@@ -62,7 +69,7 @@ class InputStreamShard : public InputStream {
 
   void ClearCurrentPacket() {
     if (!packet_queue_.empty()) {
-      packet_queue_.pop();
+      packet_queue_.pop_front();
     }
   }
 
@@ -70,8 +77,9 @@ class InputStreamShard : public InputStream {
 
   void AddPacket(Packet&& value, bool is_done);
 
-  // Packet storage for batch processing.
-  std::queue<Packet> packet_queue_;
+  // Packet storage for batch processing. Reused across invocations, so it
+  // stops allocating once it has grown to the largest batch.
+  RingQueue<Packet> packet_queue_;
   Packet empty_packet_;
 
   // Pointer to the name string of the InputStreamManager.
@@ -80,6 +88,8 @@ class InputStreamShard : public InputStream {
 
   // Accesses InputStreamShard for setting data.
   friend class InputStreamHandler;
+  // Accesses InputStreamShard for setting data of fused calculators.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
@@ -14,9 +14,13 @@
 
 #include "mediapipe/framework/output_stream_handler.h"
 
+#include <cstddef>
+#include <utility>
+
 #include "absl/log/absl_check.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/collection_item_id.h"
+#include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/output_stream_shard.h"
 
 namespace mediapipe {
@@ -102,7 +106,7 @@ void OutputStreamHandler::PostProcess(Timestamp input_timestamp) {
   }
   {
     absl::MutexLock lock(&timestamp_mutex_);
-    completed_input_timestamps_.insert(input_timestamp);
+    AddCompletedInputTimestamp(input_timestamp);
     if (propagation_state_ == kPropagatingBound) {
       propagation_state_ = kPropagationPending;
       return;
@@ -114,6 +118,20 @@ void OutputStreamHandler::PostProcess(Timestamp input_timestamp) {
   }
 }
 
+void OutputStreamHandler::AddCompletedInputTimestamp(
+    Timestamp input_timestamp) {
+  for (size_t i = 0; i < completed_input_timestamps_.size(); ++i) {
+    if (completed_input_timestamps_[i] == input_timestamp) return;
+  }
+  completed_input_timestamps_.push_back(input_timestamp);
+  for (size_t i = completed_input_timestamps_.size() - 1; i > 0; --i) {
+    Timestamp& previous = completed_input_timestamps_[i - 1];
+    Timestamp& current = completed_input_timestamps_[i];
+    if (previous < current) break;
+    std::swap(previous, current);
+  }
+}
+
 std::string OutputStreamHandler::FirstStreamName() const {
   if (output_stream_managers_.NumEntries() == 0) {
     return std::string();
@@ -128,6 +146,7 @@ void OutputStreamHandler::TryPropagateTimestampBound(Timestamp input_bound) {
     return;
   }
   OutputStreamShard empty_output;
+  InputStreamHandler::NotificationBatch notification_batch;
   for (OutputStreamManager* manager : output_stream_managers_) {
     if (manager->OffsetEnabled() && !manager->IsClosed() &&
         input_bound + manager->Offset() > manager->NextTimestampBound()) {
@@ -138,6 +157,7 @@ void OutputStreamHandler::TryPropagateTimestampBound(Timestamp input_bound) {
 }
 
 void OutputStreamHandler::Close(OutputStreamShardSet* output_shards) {
+  InputStreamHandler::NotificationBatch notification_batch;
   for (CollectionItemId id = output_stream_managers_.BeginId();
        id < output_stream_managers_.EndId(); ++id) {
     if (output_shards) {
@@ -151,6 +171,9 @@ void OutputStreamHandler::Close(OutputStreamShardSet* output_shards) {
 void OutputStreamHandler::PropagateOutputPackets(
     Timestamp input_timestamp, OutputStreamShardSet* output_shards) {
   ABSL_CHECK(output_shards);
+  // Consumers of several of these streams are notified once, after all of the
+  // streams are updated.
+  InputStreamHandler::NotificationBatch notification_batch;
   for (CollectionItemId id = output_stream_managers_.BeginId();
        id < output_stream_managers_.EndId(); ++id) {
     OutputStreamManager* manager = output_stream_managers_.Get(id);
@@ -17,7 +17,6 @@
 
 #include <functional>
 #include <memory>
-#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,6 +29,7 @@
 #include "mediapipe/framework/calculator_context_manager.h"
 #include "mediapipe/framework/collection.h"
 #include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/mediapipe_options.pb.h"
 #include "mediapipe/framework/output_stream_manager.h"
 #include "mediapipe/framework/packet_set.h"
@@ -148,8 +148,14 @@ class OutputStreamHandler {
   const bool calculator_run_in_parallel_;
 
   absl::Mutex timestamp_mutex_;
-  // A set of the completed input timestamps in ascending order.
-  std::set<Timestamp> completed_input_timestamps_
+  // Adds "input_timestamp" to completed_input_timestamps_, keeping it sorted.
+  void AddCompletedInputTimestamp(Timestamp input_timestamp)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(timestamp_mutex_);
+
+  // The completed input timestamps in ascending order. Timestamps complete
+  // mostly in order, so a sorted ring buffer avoids allocating a set node
+  // per invocation.
+  RingQueue<Timestamp> completed_input_timestamps_
       ABSL_GUARDED_BY(timestamp_mutex_);
   // The current minimum timestamp for which a new packet could possibly arrive.
   // TODO: Rename the variable to be more descriptive.
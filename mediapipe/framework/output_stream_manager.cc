@@ -53,6 +53,7 @@ void OutputStreamManager::Close() {
     next_timestamp_bound_ = Timestamp::Done();
   }
 
+  InputStreamHandler::NotificationBatch notification_batch;
   for (const auto& mirror : mirrors_) {
     mirror.input_stream_handler->SetNextTimestampBound(mirror.id,
                                                        Timestamp::Done());
@@ -185,6 +186,8 @@ void OutputStreamManager::PropagateUpdatesToMirrors(
        packets_to_propagate->back().Timestamp().NextAllowedInStream() !=
            next_timestamp_bound);
   int mirror_count = mirrors_.size();
+  // A mirror receiving both packets and a bound notifies its node once.
+  InputStreamHandler::NotificationBatch notification_batch;
   for (int idx = 0; idx < mirror_count; ++idx) {
     const Mirror& mirror = mirrors_[idx];
     if (add_packets) {
@@ -204,7 +207,7 @@ void OutputStreamManager::PropagateUpdatesToMirrors(
     }
   }
   // Clear out the packets.
-  packets_to_propagate->clear();
+  output_stream_shard->ClearOutputQueue();
 }
 
 void OutputStreamManager::ResetShard(OutputStreamShard* output_stream_shard) {
@@ -123,7 +123,13 @@ absl::Status OutputStreamShard::AddPacketInternal(T&& packet) {
 
   // Adds the packet to output_queue_ if it's a const lvalue reference.
   // Otherwise, moves the packet into output_queue_.
-  output_queue_.push_back(std::forward<T>(packet));
+  if (spare_nodes_.empty()) {
+    output_queue_.push_back(std::forward<T>(packet));
+  } else {
+    output_queue_.splice(output_queue_.end(), spare_nodes_,
+                         spare_nodes_.begin());
+    output_queue_.back() = std::forward<T>(packet);
+  }
   next_timestamp_bound_ = timestamp.NextAllowedInStream();
   updated_next_timestamp_bound_ = next_timestamp_bound_;
 
@@ -153,8 +159,15 @@ Timestamp OutputStreamShard::LastAddedPacketTimestamp() const {
   return output_queue_.back().Timestamp();
 }
 
+void OutputStreamShard::ClearOutputQueue() {
+  for (Packet& packet : output_queue_) {
+    packet = Packet();
+  }
+  spare_nodes_.splice(spare_nodes_.end(), output_queue_);
+}
+
 void OutputStreamShard::Reset(Timestamp next_timestamp_bound, bool close) {
-  output_queue_.clear();
+  ClearOutputQueue();
   next_timestamp_bound_ = next_timestamp_bound;
   updated_next_timestamp_bound_ = Timestamp::Unset();
   closed_ = close;
@@ -109,6 +109,9 @@ class OutputStreamShard : public OutputStream {
   std::list<Packet>* OutputQueue() { return &output_queue_; }
   const std::list<Packet>* OutputQueue() const { return &output_queue_; }
 
+  // Empties the output queue, keeping its list nodes for later packets.
+  void ClearOutputQueue();
+
   // Resets data members.
   void Reset(Timestamp next_timestamp_bound, bool close);
 
@@ -116,6 +119,9 @@ class OutputStreamShard : public OutputStream {
   // stream manager.
   OutputStreamSpec* output_stream_spec_;
   std::list<Packet> output_queue_;
+  // Emptied list nodes of output_queue_, which AddPacket reuses instead of
+  // allocating new ones.
+  std::list<Packet> spare_nodes_;
   bool closed_;
   Timestamp next_timestamp_bound_;
   // Equal to next_timestamp_bound_ only if the bound has been explicitly set
@@ -132,6 +138,8 @@ class OutputStreamShard : public OutputStream {
   friend class PerfettoTraceScope;
   // Accesses OutputStreamShard for post processing.
   friend class OutputStreamManager;
+  // Accesses OutputStreamShard for post processing of fused calculators.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
@@ -40,18 +40,18 @@ HolderBase::~HolderBase() {}
 
 Packet Create(HolderBase* holder) {
   Packet result;
-  result.holder_.reset(holder);
+  result.holder_ = HolderPtr(holder);
   return result;
 }
 
 Packet Create(HolderBase* holder, Timestamp timestamp) {
   Packet result;
-  result.holder_.reset(holder);
+  result.holder_ = HolderPtr(holder);
   result.timestamp_ = timestamp;
   return result;
 }
 
-Packet Create(std::shared_ptr<const HolderBase> holder, Timestamp timestamp) {
+Packet Create(HolderPtr holder, Timestamp timestamp) {
   Packet result;
   result.holder_ = std::move(holder);
   result.timestamp_ = timestamp;
@@ -17,6 +17,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PACKET_H_
 #define MEDIAPIPE_FRAMEWORK_PACKET_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -60,13 +61,58 @@ class Packet;
 
 namespace packet_internal {
 class HolderBase;
+template <typename T>
+class InlineHolder;
+
+// A reference-counted pointer to a HolderBase, used by Packet in place of
+// std::shared_ptr. The reference count lives in the HolderBase itself, so a
+// holder needs no separate control block, and dropping the last reference to
+// a holder that was never shared does not need an atomic read-modify-write.
+class HolderPtr {
+ public:
+  HolderPtr() = default;
+  HolderPtr(std::nullptr_t) {}  // NOLINT(google-explicit-constructor)
+  // Takes over the reference that a newly created holder starts with.
+  explicit HolderPtr(const HolderBase* holder) : holder_(holder) {}
+
+  HolderPtr(const HolderPtr& other);
+  HolderPtr& operator=(const HolderPtr& other);
+  HolderPtr(HolderPtr&& other) noexcept
+      : holder_(std::exchange(other.holder_, nullptr)) {}
+  HolderPtr& operator=(HolderPtr&& other) noexcept;
+  ~HolderPtr();
+
+  const HolderBase* get() const { return holder_; }
+  const HolderBase* operator->() const { return holder_; }
+  const HolderBase& operator*() const { return *holder_; }
+  explicit operator bool() const { return holder_ != nullptr; }
+
+  void reset();
+
+  // Returns the number of HolderPtrs that refer to the holder, or 0 if this
+  // is null.
+  int use_count() const;
+
+  friend bool operator==(const HolderPtr& p, std::nullptr_t) {
+    return p.holder_ == nullptr;
+  }
+  friend bool operator!=(const HolderPtr& p, std::nullptr_t) {
+    return p.holder_ != nullptr;
+  }
+
+ private:
+  static void Ref(const HolderBase* holder);
+  static void Unref(const HolderBase* holder);
+
+  const HolderBase* holder_ = nullptr;
+};
 
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
-Packet Create(std::shared_ptr<const HolderBase> holder, Timestamp timestamp);
+Packet Create(HolderPtr holder, Timestamp timestamp);
 const HolderBase* GetHolder(const Packet& packet);
-const std::shared_ptr<const HolderBase>& GetHolderShared(const Packet& packet);
-std::shared_ptr<const HolderBase> GetHolderShared(Packet&& packet);
+const HolderPtr& GetHolderShared(const Packet& packet);
+HolderPtr GetHolderShared(Packet&& packet);
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized);
 }  // namespace packet_internal
@@ -74,8 +120,8 @@ absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
 // A generic container class which can hold data of any type.  The type of
 // the data is specified when accessing the data (using Packet::Get<T>()).
 //
-// The Packet is implemented as a reference-counted pointer.  This means
-// that copying Packets creates a fast, shallow copy.  Packets are
+// The Packet is implemented as an intrusively reference-counted pointer.
+// This means that copying Packets creates a fast, shallow copy.  Packets are
 // copyable, movable, and assignable.  Packets can be stored in STL
 // containers.  A Packet may optionally contain a timestamp.
 //
@@ -131,6 +177,7 @@ class Packet {
   // Transfers the ownership of holder's data to a unique pointer
   // of the object if the packet is the sole owner of a non-foreign
   // holder. Otherwise, returns error when the packet can't be consumed.
+  // The data of a packet created by MakePacket is moved to a new object.
   //
   // --- WARNING ---
   // Packet is thread-compatible and this member function is non-const. Hence,
@@ -275,20 +322,19 @@ class Packet {
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder);
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder,
                                         class Timestamp timestamp);
-  friend Packet packet_internal::Create(
-      std::shared_ptr<const packet_internal::HolderBase> holder,
-      class Timestamp timestamp);
+  friend Packet packet_internal::Create(packet_internal::HolderPtr holder,
+                                        class Timestamp timestamp);
   friend const packet_internal::HolderBase* packet_internal::GetHolder(
       const Packet& packet);
-  friend const std::shared_ptr<const packet_internal::HolderBase>&
-  packet_internal::GetHolderShared(const Packet& packet);
-  friend std::shared_ptr<const packet_internal::HolderBase>
-  packet_internal::GetHolderShared(Packet&& packet);
+  friend const packet_internal::HolderPtr& packet_internal::GetHolderShared(
+      const Packet& packet);
+  friend packet_internal::HolderPtr packet_internal::GetHolderShared(
+      Packet&& packet);
 
   friend class PacketType;
   absl::Status ValidateAsType(TypeId type_id) const;
 
-  std::shared_ptr<const packet_internal::HolderBase> holder_;
+  packet_internal::HolderPtr holder_;
   class Timestamp timestamp_;
 };
 
@@ -375,12 +421,18 @@ Packet AdoptAsSyncedPacket(const T* ptr) {
 // provided arguments. Similar to MakeUnique. Especially convenient for arrays,
 // since it ensures the packet gets the right type (see below).
 //
-// Version for scalars.
+// Version for scalars. The object is allocated together with the Packet's
+// holder, unless it cannot be moved out again by Packet::Consume().
 template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  if constexpr (std::is_nothrow_move_constructible_v<T>) {
+    return packet_internal::Create(
+        new packet_internal::InlineHolder<T>(std::forward<Args>(args)...));
+  } else {
+    return Adopt(new T(std::forward<Args>(args)...));
+  }
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -467,8 +519,62 @@ class HolderBase {
   GetVectorOfProtoMessageLite() const = 0;
 
   virtual bool HasForeignOwner() const { return false; }
+
+ private:
+  friend class HolderPtr;
+
+  // Number of HolderPtrs that refer to this holder. A new holder starts with
+  // the reference that the first HolderPtr takes over.
+  mutable std::atomic<int> ref_count_{1};
 };
 
+inline HolderPtr::HolderPtr(const HolderPtr& other) : holder_(other.holder_) {
+  if (holder_) Ref(holder_);
+}
+
+inline HolderPtr& HolderPtr::operator=(const HolderPtr& other) {
+  if (other.holder_) Ref(other.holder_);
+  if (holder_) Unref(holder_);
+  holder_ = other.holder_;
+  return *this;
+}
+
+inline HolderPtr& HolderPtr::operator=(HolderPtr&& other) noexcept {
+  if (this != &other) {
+    if (holder_) Unref(holder_);
+    holder_ = std::exchange(other.holder_, nullptr);
+  }
+  return *this;
+}
+
+inline HolderPtr::~HolderPtr() {
+  if (holder_) Unref(holder_);
+}
+
+inline void HolderPtr::reset() {
+  if (holder_) Unref(std::exchange(holder_, nullptr));
+}
+
+inline int HolderPtr::use_count() const {
+  return holder_ ? holder_->ref_count_.load(std::memory_order_acquire) : 0;
+}
+
+// static
+inline void HolderPtr::Ref(const HolderBase* holder) {
+  holder->ref_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// static
+inline void HolderPtr::Unref(const HolderBase* holder) {
+  // If ours is the only reference, no other thread can be copying it, so the
+  // holder can be deleted without decrementing. This keeps packets that are
+  // never shared free of atomic read-modify-writes.
+  if (holder->ref_count_.load(std::memory_order_acquire) == 1 ||
+      holder->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete holder;
+  }
+}
+
 // Two helper functions to get the proto base pointers.
 template <typename T>
 const proto_ns::MessageLite* ConvertToProtoMessageLite(const T* data,
@@ -570,8 +676,7 @@ class Holder : public HolderBase, private HolderPayloadRegistrator<T> {
           "Foreign holder can't release data ptr without ownership.");
     }
     // Casts away constness to make the data mutable after the release.
-    std::unique_ptr<T> data_ptr(const_cast<T*>(ptr_));
-    ptr_ = nullptr;
+    std::unique_ptr<T> data_ptr(const_cast<T*>(ReleaseData()));
     return std::move(data_ptr);
   }
   // TODO: support unbounded array after fixing the bug in holder's
@@ -595,6 +700,10 @@ class Holder : public HolderBase, private HolderPayloadRegistrator<T> {
   }
 
  protected:
+  // Gives up ownership of the data and returns a pointer to it that the
+  // caller must delete.
+  virtual const T* ReleaseData() { return std::exchange(ptr_, nullptr); }
+
   // The pointer that uniquely owns the data. However, the ownership of the
   // Holder itself may be shared by several Packets.
   const T* ptr_;
@@ -655,6 +764,30 @@ class ForeignHolder : public Holder<T> {
   absl::AnyInvocable<void()> cleanup_;
 };
 
+// Like Holder, but stores the data in the same allocation as the holder.
+// Releasing the data moves it to a new heap object.
+template <typename T>
+class InlineHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit InlineHolder(Args&&... args)
+      : Holder<T>(nullptr), data_(std::forward<Args>(args)...) {
+    this->ptr_ = &data_;
+  }
+
+  ~InlineHolder() override {
+    // Null out ptr_ so it doesn't get deleted by ~Holder; data_ is destroyed
+    // as a member.
+    this->ptr_ = nullptr;
+  }
+
+ protected:
+  const T* ReleaseData() override { return new T(std::move(data_)); }
+
+ private:
+  T data_;
+};
+
 template <typename T>
 Holder<T>* HolderBase::AsMutable() const {
   if (PayloadIsOfType<T>()) {
@@ -856,12 +989,11 @@ inline bool operator!=(const Packet& p1, const Packet& p2) {
 
 namespace packet_internal {
 
-inline const std::shared_ptr<const HolderBase>& GetHolderShared(
-    const Packet& packet) {
+inline const HolderPtr& GetHolderShared(const Packet& packet) {
   return packet.holder_;
 }
 
-inline std::shared_ptr<const HolderBase> GetHolderShared(Packet&& packet) {
+inline HolderPtr GetHolderShared(Packet&& packet) {
   return std::move(packet.holder_);
 }
 
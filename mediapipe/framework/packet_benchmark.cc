@@ -0,0 +1,113 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the cost of creating, copying and destroying packets.
+// $ bazel run -c opt mediapipe/framework:packet_benchmark
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace {
+
+void BM_MakePacketAndDestroy(benchmark::State& state) {
+  for (auto _ : state) {
+    Packet packet = MakePacket<int>(42);
+    benchmark::DoNotOptimize(packet);
+  }
+}
+BENCHMARK(BM_MakePacketAndDestroy);
+
+void BM_AdoptAndDestroy(benchmark::State& state) {
+  for (auto _ : state) {
+    Packet packet = Adopt(new int(42));
+    benchmark::DoNotOptimize(packet);
+  }
+}
+BENCHMARK(BM_AdoptAndDestroy);
+
+void BM_Api2MakePacketAndDestroy(benchmark::State& state) {
+  for (auto _ : state) {
+    api2::Packet<int> packet = api2::MakePacket<int>(42);
+    benchmark::DoNotOptimize(packet);
+  }
+}
+BENCHMARK(BM_Api2MakePacketAndDestroy);
+
+void BM_CopyAndDestroy(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(42);
+  for (auto _ : state) {
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_CopyAndDestroy);
+
+void BM_At(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(42);
+  int64_t t = 0;
+  for (auto _ : state) {
+    Packet copy = packet.At(Timestamp(++t));
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_At);
+
+// Creates one packet and copies it to "fan_out" consumers, like a node whose
+// output stream feeds several calculators.
+void BM_FanOut(benchmark::State& state) {
+  const int fan_out = state.range(0);
+  std::vector<Packet> consumers(fan_out);
+  int64_t t = 0;
+  for (auto _ : state) {
+    Packet packet = MakePacket<std::string>("frame").At(Timestamp(++t));
+    for (Packet& consumer : consumers) {
+      consumer = packet;
+    }
+    for (Packet& consumer : consumers) {
+      consumer = Packet();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * fan_out);
+}
+BENCHMARK(BM_FanOut)->Arg(1)->Arg(6)->Arg(10);
+
+// Copies one packet from several threads at once, which contends on its
+// reference count.
+void BM_CopyAndDestroyContended(benchmark::State& state) {
+  static Packet* packet = nullptr;
+  if (state.thread_index() == 0) {
+    packet = new Packet(MakePacket<int>(42));
+  }
+  for (auto _ : state) {
+    Packet copy = *packet;
+    benchmark::DoNotOptimize(copy);
+  }
+  if (state.thread_index() == 0) {
+    delete packet;
+    packet = nullptr;
+  }
+}
+BENCHMARK(BM_CopyAndDestroyContended)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,87 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_byte_size.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The byte size functions, keyed by payload type.
+class ByteSizeRegistry {
+ public:
+  void Register(TypeId type_id, packet_byte_size_internal::ByteSizeFn fn) {
+    absl::WriterMutexLock lock(&mutex_);
+    const bool inserted = byte_size_fns_.emplace(type_id, fn).second;
+    ABSL_CHECK(inserted) << "A packet byte size function is already "
+                            "registered for type "
+                         << type_id.name();
+  }
+
+  packet_byte_size_internal::ByteSizeFn Find(TypeId type_id) const {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = byte_size_fns_.find(type_id);
+    return it == byte_size_fns_.end() ? nullptr : it->second;
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<TypeId, packet_byte_size_internal::ByteSizeFn>
+      byte_size_fns_ ABSL_GUARDED_BY(mutex_);
+};
+
+ByteSizeRegistry& GetByteSizeRegistry() {
+  static NoDestructor<ByteSizeRegistry> registry;
+  return *registry;
+}
+
+}  // namespace
+
+int64_t PacketByteSize(const Packet& packet) {
+  if (packet.IsEmpty()) {
+    return 0;
+  }
+  packet_byte_size_internal::ByteSizeFn fn =
+      GetByteSizeRegistry().Find(packet.GetTypeId());
+  return fn ? fn(packet) : 0;
+}
+
+int64_t PacketByteSizer::ByteSize(const Packet& packet) {
+  if (packet.IsEmpty()) {
+    return 0;
+  }
+  const TypeId type_id = packet.GetTypeId();
+  if (!type_id_.has_value() || !(*type_id_ == type_id)) {
+    type_id_ = type_id;
+    byte_size_fn_ = GetByteSizeRegistry().Find(type_id);
+  }
+  return byte_size_fn_ ? byte_size_fn_(packet) : 0;
+}
+
+namespace packet_byte_size_internal {
+
+bool RegisterByteSizeFn(TypeId type_id, ByteSizeFn byte_size_fn) {
+  GetByteSizeRegistry().Register(type_id, byte_size_fn);
+  return true;
+}
+
+}  // namespace packet_byte_size_internal
+
+}  // namespace mediapipe
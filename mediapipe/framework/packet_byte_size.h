@@ -0,0 +1,77 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_BYTE_SIZE_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_BYTE_SIZE_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/tool/type_util.h"
+
+namespace mediapipe {
+
+// Returns the approximate number of bytes held by the payload of "packet", as
+// reported by the function registered for its type with
+// MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE. Returns 0 for empty packets and for
+// payload types without a registered function.
+//
+// Used by CalculatorGraphConfig::max_queue_bytes to bound the memory held by
+// the packets queued in input streams.
+int64_t PacketByteSize(const Packet& packet);
+
+namespace packet_byte_size_internal {
+
+using ByteSizeFn = int64_t (*)(const Packet& packet);
+
+// Registers the byte size function for payloads of the given type. Returns
+// true, so that it can initialize a static variable.
+bool RegisterByteSizeFn(TypeId type_id, ByteSizeFn byte_size_fn);
+
+}  // namespace packet_byte_size_internal
+
+// Computes PacketByteSize for the packets of one stream. The function
+// registered for the payload type is looked up when the type changes rather
+// than for every packet, which keeps the registry lock off the packet path.
+// Not thread-safe.
+class PacketByteSizer {
+ public:
+  int64_t ByteSize(const Packet& packet);
+
+ private:
+  std::optional<TypeId> type_id_;
+  packet_byte_size_internal::ByteSizeFn byte_size_fn_ = nullptr;
+};
+
+}  // namespace mediapipe
+
+// Registers "byte_size_fn", a function taking a const reference to "type" and
+// returning the number of bytes it holds, for use by PacketByteSize. Must be
+// used at namespace scope, once per type. Example:
+//
+//   MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE(
+//       ImageFrame, [](const ImageFrame& frame) -> int64_t {
+//         return frame.PixelDataSize();
+//       });
+#define MEDIAPIPE_REGISTER_PACKET_BYTE_SIZE(type, byte_size_fn)               \
+  static const bool REGISTRY_STATIC_VAR(packet_byte_size_registration,       \
+                                        __LINE__) =                          \
+      ::mediapipe::packet_byte_size_internal::RegisterByteSizeFn(            \
+          ::mediapipe::kTypeId<type>, [](const ::mediapipe::Packet& packet) { \
+            return static_cast<int64_t>((byte_size_fn)(packet.Get<type>()));  \
+          })
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_BYTE_SIZE_H_
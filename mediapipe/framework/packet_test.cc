@@ -18,6 +18,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -559,5 +560,52 @@ TEST(PacketTest, SharedPtrWithPacketOwnership) {
   EXPECT_EQ(exist, false);
 }
 
+TEST(PacketTest, MakePacketWithNonMovableType) {
+  struct NonMovable {
+    explicit NonMovable(int value) : value(value) {}
+    NonMovable(const NonMovable&) = delete;
+    NonMovable& operator=(const NonMovable&) = delete;
+    int value;
+  };
+  Packet packet = MakePacket<NonMovable>(7);
+  EXPECT_EQ(packet.Get<NonMovable>().value, 7);
+  absl::StatusOr<std::unique_ptr<NonMovable>> result =
+      packet.Consume<NonMovable>();
+  MP_ASSERT_OK(result);
+  EXPECT_EQ((*result)->value, 7);
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketTest, ConsumeMovesDataOutOfMadePacket) {
+  Packet packet = MakePacket<std::vector<int>>(3, 5);
+  const int* data = packet.Get<std::vector<int>>().data();
+  absl::StatusOr<std::unique_ptr<std::vector<int>>> result =
+      packet.Consume<std::vector<int>>();
+  MP_ASSERT_OK(result);
+  EXPECT_THAT(**result, testing::ElementsAre(5, 5, 5));
+  // The vector's buffer is moved along, not copied.
+  EXPECT_EQ((*result)->data(), data);
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketTest, CopiesOnManyThreadsReleaseDataOnce) {
+  int num_cleanup = 0;
+  const int data = 0;
+  Packet packet = PointToForeign(&data, [&num_cleanup]() { ++num_cleanup; });
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([copy = packet]() {
+      for (int j = 0; j < 10000; ++j) {
+        Packet packet_copy = copy;
+        Packet moved = std::move(packet_copy).At(Timestamp(j));
+      }
+    });
+  }
+  packet = Packet();
+  for (auto& thread : threads) thread.join();
+  threads.clear();
+  EXPECT_EQ(num_cleanup, 1);
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -0,0 +1,43 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/allocation_counter.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace mediapipe {
+namespace {
+
+// Constant-initialized, so that it can be used from operator new before any
+// dynamic initialization has run.
+thread_local int64_t thread_allocations = 0;
+
+std::atomic<bool> hooks_available{false};
+
+}  // namespace
+
+bool AllocationCounter::IsAvailable() {
+  return hooks_available.load(std::memory_order_relaxed);
+}
+
+int64_t AllocationCounter::ThreadAllocations() { return thread_allocations; }
+
+void AllocationCounter::RecordAllocation() { ++thread_allocations; }
+
+void AllocationCounter::SetAvailable() {
+  hooks_available.store(true, std::memory_order_relaxed);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,47 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_ALLOCATION_COUNTER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace mediapipe {
+
+// Counts the heap allocations made by each thread.
+//
+// The counts are only maintained if the binary links
+// "//mediapipe/framework/profiler:allocation_counter_hooks", which replaces
+// the global operator new. Otherwise IsAvailable() returns false and the
+// counts stay at zero.
+//
+// Used by the GraphProfiler to report the allocations made by each
+// Calculator::Process() call, see ProfilerConfig.enable_allocation_counting.
+class AllocationCounter {
+ public:
+  // Returns true if the allocation hooks are linked into this binary.
+  static bool IsAvailable();
+
+  // Returns the number of heap allocations made by the calling thread since
+  // it started.
+  static int64_t ThreadAllocations();
+
+  // Called by the allocation hooks.
+  static void RecordAllocation();
+  static void SetAvailable();
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_ALLOCATION_COUNTER_H_
@@ -0,0 +1,72 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Replaces the global operator new and operator delete in order to count heap
+// allocations per thread, see AllocationCounter. The array and nothrow forms
+// of operator new forward to the replaced operator new. Over-aligned
+// allocations are not counted.
+//
+// Only link this into test and benchmark binaries.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "mediapipe/framework/profiler/allocation_counter.h"
+
+namespace {
+
+const bool kHooksRegistered = [] {
+  mediapipe::AllocationCounter::SetAvailable();
+  return true;
+}();
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  mediapipe::AllocationCounter::RecordAllocation();
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    // Exceptions may be disabled, so fail like a failed allocation would.
+    std::abort();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  mediapipe::AllocationCounter::RecordAllocation();
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
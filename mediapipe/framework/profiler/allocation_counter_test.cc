@@ -0,0 +1,219 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/allocation_counter.h"
+
+#include <cstdint>
+#include <new>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kAllocationsPerProcess = 3;
+
+// Makes kAllocationsPerProcess heap allocations in each Process() call.
+class AllocatingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    for (int i = 0; i < kAllocationsPerProcess; ++i) {
+      ::operator delete(::operator new(16));
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(AllocatingCalculator);
+
+const CalculatorProfile* FindProfile(
+    const std::vector<CalculatorProfile>& profiles, const std::string& name) {
+  for (const CalculatorProfile& profile : profiles) {
+    if (profile.name() == name) return &profile;
+  }
+  return nullptr;
+}
+
+TEST(AllocationCounterTest, CountsAllocationsOfCurrentThread) {
+  ASSERT_TRUE(AllocationCounter::IsAvailable());
+  const int64_t start = AllocationCounter::ThreadAllocations();
+  ::operator delete(::operator new(16));
+  ::operator delete[](::operator new[](16));
+  EXPECT_EQ(AllocationCounter::ThreadAllocations() - start, 2);
+
+  // Allocations are counted separately for each thread.
+  constexpr int kNumThreadAllocations = 1000;
+  const int64_t before_thread = AllocationCounter::ThreadAllocations();
+  int64_t thread_allocations = 0;
+  std::thread thread([&thread_allocations] {
+    const int64_t thread_start = AllocationCounter::ThreadAllocations();
+    for (int i = 0; i < kNumThreadAllocations; ++i) {
+      ::operator delete(::operator new(16));
+    }
+    thread_allocations =
+        AllocationCounter::ThreadAllocations() - thread_start;
+  });
+  thread.join();
+  EXPECT_EQ(thread_allocations, kNumThreadAllocations);
+  // Starting the thread may allocate on this thread, but not that much.
+  EXPECT_LT(AllocationCounter::ThreadAllocations() - before_thread,
+            kNumThreadAllocations);
+}
+
+TEST(AllocationCounterTest, ReportsProcessAllocationsInProfile) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "AllocatingCalculator"
+      input_stream: "input"
+      output_stream: "allocated"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "allocated"
+      output_stream: "output"
+    }
+    profiler_config { enable_profiler: true enable_allocation_counting: true }
+  )pb");
+  constexpr int kNumWarmupPackets = 10;
+  constexpr int kNumPackets = 100;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumWarmupPackets + kNumPackets; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < kNumWarmupPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream("input", packets[i]));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  graph.profiler()->Reset();
+  for (int i = kNumWarmupPackets; i < packets.size(); ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream("input", packets[i]));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  std::vector<CalculatorProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  const CalculatorProfile* allocating =
+      FindProfile(profiles, "AllocatingCalculator");
+  ASSERT_NE(allocating, nullptr);
+  EXPECT_EQ(allocating->process_allocations(),
+            kNumPackets * kAllocationsPerProcess);
+  EXPECT_EQ(allocating->max_process_allocations(), kAllocationsPerProcess);
+  // Once warmed up, forwarding a packet does not allocate.
+  const CalculatorProfile* pass_through =
+      FindProfile(profiles, "PassThroughCalculator");
+  ASSERT_NE(pass_through, nullptr);
+  EXPECT_EQ(pass_through->process_allocations(), 0);
+  EXPECT_EQ(pass_through->max_process_allocations(), 0);
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(AllocationCounterTest, ProfileHasNoCountsUnlessEnabled) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "AllocatingCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+    profiler_config { enable_profiler: true }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(
+      graph.AddPacketToInputStream("input", MakePacket<int>(0).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<CalculatorProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  ASSERT_EQ(profiles.size(), 1);
+  EXPECT_FALSE(profiles[0].has_process_allocations());
+}
+
+// Runs a chain of PassThroughCalculators on the application thread, so that
+// all the framework work of a graph iteration is counted on this thread.
+TEST(AllocationCounterTest, SteadyStateGraphDoesNotAllocate) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    executor { type: "ApplicationThreadExecutor" }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "hop0"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "hop0"
+      output_stream: "hop1"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "hop1"
+      output_stream: "hop2"
+    }
+  )pb");
+  constexpr int kNumWarmupPackets = 10;
+  constexpr int kNumPackets = 100;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumWarmupPackets + kNumPackets; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < kNumWarmupPackets; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream("input", packets[i]));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  // The test assertions themselves allocate, so check the status afterwards.
+  absl::Status status;
+  const int64_t start = AllocationCounter::ThreadAllocations();
+  for (int i = kNumWarmupPackets; i < packets.size(); ++i) {
+    status.Update(graph.AddPacketToInputStream("input", packets[i]));
+    status.Update(graph.WaitUntilIdle());
+  }
+  const int64_t num_allocations =
+      AllocationCounter::ThreadAllocations() - start;
+  MP_ASSERT_OK(status);
+  EXPECT_EQ(num_allocations, 0);
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+}  // namespace
+}  // namespace mediapipe
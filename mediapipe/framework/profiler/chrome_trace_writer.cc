@@ -0,0 +1,361 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace mediapipe {
+namespace {
+
+// The number of recent packet outputs remembered for flow arrows.
+constexpr int kMaxPacketOutputs = 10000;
+
+// Returns a quoted JSON string.
+std::string JsonString(absl::string_view s) {
+  std::string result = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", static_cast<int>(c));
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+// Returns true for event types that mark a point in time rather than
+// the start or finish of an interval.
+bool IsInstantEventType(GraphTrace::EventType event_type) {
+  switch (event_type) {
+    case GraphTrace::UNKNOWN:
+    case GraphTrace::NOT_READY:
+    case GraphTrace::READY_FOR_PROCESS:
+    case GraphTrace::READY_FOR_CLOSE:
+    case GraphTrace::THROTTLED:
+    case GraphTrace::UNTHROTTLED:
+    case GraphTrace::PACKET_QUEUED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the JSON "args" describing the packet of a TraceEvent.
+std::string EventArgs(const TraceEvent& event) {
+  std::vector<std::string> args;
+  if (event.input_ts != Timestamp::Unset()) {
+    args.push_back(absl::StrCat("\"input_ts\":", event.input_ts.Value()));
+  }
+  if (event.stream_id != nullptr) {
+    args.push_back(absl::StrCat("\"stream\":", JsonString(*event.stream_id)));
+  }
+  if (event.packet_ts != Timestamp::Unset()) {
+    args.push_back(absl::StrCat("\"packet_ts\":", event.packet_ts.Value()));
+  }
+  return absl::StrCat("{", absl::StrJoin(args, ","), "}");
+}
+
+}  // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(Options options)
+    : options_(std::move(options)) {
+  thread_ = std::thread([this] { Run(); });
+}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+  }
+  thread_.join();
+  if (file_.is_open()) {
+    file_ << "\n]\n";
+    file_.close();
+  }
+}
+
+void ChromeTraceWriter::Write(std::vector<TraceEvent> events) {
+  if (events.empty()) {
+    return;
+  }
+  int64_t num_bytes = events.size() * sizeof(TraceEvent);
+  absl::MutexLock lock(&mutex_);
+  if (queued_bytes_ + num_bytes > options_.max_buffered_bytes) {
+    dropped_events_ += events.size();
+    return;
+  }
+  for (TraceEvent& event : events) {
+    if (event.stream_id != nullptr) {
+      event.stream_id = InternStreamName(event.stream_id);
+    }
+  }
+  queued_bytes_ += num_bytes;
+  queue_.push_back(std::move(events));
+}
+
+absl::Status ChromeTraceWriter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &ChromeTraceWriter::IsIdle));
+  return status_;
+}
+
+int64_t ChromeTraceWriter::dropped_events() {
+  absl::MutexLock lock(&mutex_);
+  return dropped_events_;
+}
+
+const std::string* ChromeTraceWriter::InternStreamName(
+    const std::string* stream_name) {
+  auto iter = interned_stream_names_.find(stream_name);
+  if (iter == interned_stream_names_.end()) {
+    const std::string* interned = &*stream_names_.insert(*stream_name).first;
+    iter = interned_stream_names_.insert({stream_name, interned}).first;
+  }
+  return iter->second;
+}
+
+bool ChromeTraceWriter::HasWork() const { return !queue_.empty() || stopped_; }
+
+bool ChromeTraceWriter::IsIdle() const { return queue_.empty() && !writing_; }
+
+void ChromeTraceWriter::Run() {
+  while (true) {
+    std::vector<TraceEvent> events;
+    int64_t dropped_events;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &ChromeTraceWriter::HasWork));
+      if (queue_.empty()) {
+        return;
+      }
+      events = std::move(queue_.front());
+      queue_.pop_front();
+      queued_bytes_ -= events.size() * sizeof(TraceEvent);
+      dropped_events = dropped_events_;
+      writing_ = true;
+    }
+    absl::Status status = WriteBatch(events, dropped_events);
+    absl::MutexLock lock(&mutex_);
+    writing_ = false;
+    status_.Update(status);
+  }
+}
+
+absl::Status ChromeTraceWriter::WriteBatch(
+    const std::vector<TraceEvent>& events, int64_t dropped_events) {
+  output_.clear();
+  if (write_count_ % std::max(options_.writes_per_file, 1) == 0) {
+    absl::Status status = OpenNextFile();
+    if (!status.ok()) {
+      ++write_count_;
+      return status;
+    }
+  }
+  ++write_count_;
+  if (dropped_events != written_dropped_events_) {
+    AppendJson(absl::StrFormat(
+        R"({"name":"dropped_trace_events","ph":"C","ts":%d,"pid":%d,)"
+        R"("args":{"events":%d}})",
+        absl::ToUnixMicros(events.front().event_time), options_.process_id,
+        dropped_events));
+    written_dropped_events_ = dropped_events;
+  }
+  for (const TraceEvent& event : events) {
+    AppendEvent(event);
+  }
+  file_ << output_;
+  file_.flush();
+  if (!file_.good()) {
+    return absl::UnavailableError(
+        absl::StrCat("Could not write trace events to: ", options_.path_prefix,
+                     "*.json"));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ChromeTraceWriter::OpenNextFile() {
+  if (file_.is_open()) {
+    file_ << "\n]\n";
+    file_.close();
+  }
+  int index = write_count_ / std::max(options_.writes_per_file, 1) %
+              std::max(options_.file_count, 1);
+  std::string path = absl::StrCat(options_.path_prefix, index, ".json");
+  file_.open(path, std::ofstream::out | std::ofstream::trunc);
+  if (!file_.is_open()) {
+    return absl::UnavailableError(
+        absl::StrCat("Could not open trace file: ", path));
+  }
+  // The closing bracket is optional in the trace-event format, so events
+  // can be appended until the file is rotated.
+  file_ << "[";
+  file_is_empty_ = true;
+  named_threads_.clear();
+  AppendJson(absl::StrFormat(
+      R"({"name":"process_name","ph":"M","pid":%d,"args":{"name":%s}})",
+      options_.process_id, JsonString(options_.process_name)));
+  return absl::OkStatus();
+}
+
+void ChromeTraceWriter::AppendEvent(const TraceEvent& event) {
+  if (event.node_id >= 0) {
+    AppendThreadName(event.thread_id, event.node_id);
+  }
+  if (event.node_id < 0 || IsInstantEventType(event.event_type)) {
+    AppendInstant(event);
+    return;
+  }
+
+  // Each invocation logs one start event per input packet and one finish
+  // event per output packet, all with the same event_time.
+  Slice& slice = slices_[{event.thread_id, event.node_id, event.event_type}];
+  if (!event.is_finish) {
+    if (!slice.open || slice.begin_time != event.event_time) {
+      if (slice.open) {
+        AppendInstant(TraceEvent(event.event_type)
+                          .set_event_time(slice.begin_time)
+                          .set_node_id(event.node_id)
+                          .set_thread_id(event.thread_id)
+                          .set_input_ts(slice.input_ts));
+      }
+      slice.open = true;
+      slice.input_ts = event.input_ts;
+      slice.begin_time = event.event_time;
+    }
+    if (event.stream_id != nullptr) {
+      AppendFlow(event);
+    }
+    return;
+  }
+
+  absl::Time output_time = event.event_time;
+  if (slice.open) {
+    AppendJson(absl::StrFormat(
+        R"({"name":%s,"cat":"%s","ph":"X","ts":%d,"dur":%d,"pid":%d,)"
+        R"("tid":%d,"args":{"input_ts":%d}})",
+        JsonString(NodeName(event.node_id)),
+        GraphTrace::EventType_Name(event.event_type),
+        absl::ToUnixMicros(slice.begin_time),
+        absl::ToInt64Microseconds(event.event_time - slice.begin_time),
+        options_.process_id, event.thread_id, slice.input_ts.Value()));
+    slice.open = false;
+    slice.end_time = event.event_time;
+  } else if (slice.end_time != event.event_time) {
+    AppendInstant(event);
+  }
+  if (slice.end_time == event.event_time) {
+    // Flow arrows start within the slice that output the packet.
+    output_time = slice.begin_time;
+  }
+  if (event.stream_id != nullptr) {
+    PacketKey key = {event.stream_id, event.packet_ts.Value()};
+    packet_outputs_[key] = {event.thread_id, output_time};
+    packet_output_order_.push_back(key);
+    if (packet_output_order_.size() > kMaxPacketOutputs) {
+      packet_outputs_.erase(packet_output_order_.front());
+      packet_output_order_.pop_front();
+    }
+  }
+}
+
+void ChromeTraceWriter::AppendFlow(const TraceEvent& event) {
+  auto iter =
+      packet_outputs_.find(PacketKey{event.stream_id, event.packet_ts.Value()});
+  if (iter == packet_outputs_.end()) {
+    return;
+  }
+  int64_t flow_id = next_flow_id_++;
+  const PacketOutput& output = iter->second;
+  std::string name = JsonString(*event.stream_id);
+  AppendJson(absl::StrFormat(
+      R"({"name":%s,"cat":"packet","ph":"s","id":%d,"ts":%d,"pid":%d,)"
+      R"("tid":%d})",
+      name, flow_id, absl::ToUnixMicros(output.event_time),
+      options_.process_id, output.thread_id));
+  AppendJson(absl::StrFormat(
+      R"({"name":%s,"cat":"packet","ph":"f","bp":"e","id":%d,"ts":%d,)"
+      R"("pid":%d,"tid":%d})",
+      name, flow_id, absl::ToUnixMicros(event.event_time), options_.process_id,
+      event.thread_id));
+}
+
+void ChromeTraceWriter::AppendInstant(const TraceEvent& event) {
+  std::string name;
+  if (event.node_id >= 0) {
+    name = NodeName(event.node_id);
+  } else if (event.stream_id != nullptr) {
+    name = *event.stream_id;
+  }
+  AppendJson(absl::StrFormat(
+      R"({"name":%s,"cat":"%s","ph":"i","s":"t","ts":%d,"pid":%d,"tid":%d,)"
+      R"("args":%s})",
+      JsonString(name), GraphTrace::EventType_Name(event.event_type),
+      absl::ToUnixMicros(event.event_time), options_.process_id,
+      event.thread_id, EventArgs(event)));
+}
+
+void ChromeTraceWriter::AppendThreadName(int thread_id, int node_id) {
+  if (!named_threads_.insert(thread_id).second) {
+    return;
+  }
+  std::string executor;
+  if (node_id >= 0 &&
+      static_cast<size_t>(node_id) < options_.node_executors.size()) {
+    executor = options_.node_executors[node_id];
+  }
+  if (executor.empty()) {
+    executor = "default";
+  }
+  AppendJson(absl::StrFormat(
+      R"({"name":"thread_name","ph":"M","pid":%d,"tid":%d,)"
+      R"("args":{"name":%s}})",
+      options_.process_id, thread_id,
+      JsonString(absl::StrCat(executor, " thread ", thread_id))));
+}
+
+void ChromeTraceWriter::AppendJson(const std::string& json) {
+  output_ += file_is_empty_ ? "\n" : ",\n";
+  output_ += json;
+  file_is_empty_ = false;
+}
+
+const std::string& ChromeTraceWriter::NodeName(int node_id) const {
+  static const std::string* kUnknownNode = new std::string("");
+  return (node_id >= 0 &&
+          static_cast<size_t>(node_id) < options_.node_names.size())
+             ? options_.node_names[node_id]
+             : *kUnknownNode;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,178 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+
+namespace mediapipe {
+
+// Writes TraceEvents to rolling files in the Chrome trace-event JSON format,
+// which can be opened in ui.perfetto.dev or chrome://tracing.
+//
+// Write only queues the events, and a background thread formats and writes
+// them, so that trace output does not stall the graph.  The queued events are
+// limited to a fixed number of bytes.  Events that do not fit are dropped,
+// and the count of dropped events is written as a counter track.
+//
+// Each calculator invocation is written as a slice on the track of the thread
+// that ran it, and each thread track is named after the executor of the first
+// node it runs.  A flow arrow links each packet from the invocation that
+// output it to each invocation that received it.
+class ChromeTraceWriter {
+ public:
+  struct Options {
+    // Trace files are written to StrCat(path_prefix, index, ".json").
+    std::string path_prefix;
+    // The number of trace files retained.
+    int file_count = 2;
+    // The number of calls to Write that go into each trace file.
+    int writes_per_file = 10;
+    // The maximum number of bytes of queued TraceEvents.
+    int64_t max_buffered_bytes = 4 << 20;
+    // The process id and name for the trace.
+    int process_id = 0;
+    std::string process_name;
+    // The name and the executor of each calculator node, by node id.
+    std::vector<std::string> node_names;
+    std::vector<std::string> node_executors;
+  };
+
+  explicit ChromeTraceWriter(Options options);
+
+  // Writes all queued events and stops the background thread.
+  ~ChromeTraceWriter();
+
+  ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+  ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+  // Queues TraceEvents to be written, ordered by event_time.
+  // Does not wait for file output.  If the events do not fit within
+  // max_buffered_bytes, they are dropped.
+  void Write(std::vector<TraceEvent> events);
+
+  // Waits until all queued events are written, and returns the first error
+  // encountered while writing, if any.
+  absl::Status Flush();
+
+  // Returns the number of events dropped so far.
+  int64_t dropped_events();
+
+ private:
+  // A calculator invocation waiting for its finish event, or recently
+  // finished.
+  struct Slice {
+    Timestamp input_ts;
+    absl::Time begin_time;
+    absl::Time end_time = absl::InfinitePast();
+    bool open = false;
+  };
+
+  // Where and when a packet was output, identified by stream and timestamp.
+  struct PacketOutput {
+    int thread_id;
+    absl::Time event_time;
+  };
+  using PacketKey = std::pair<const std::string*, int64_t>;
+
+  // Returns a copy of a stream name, owned by this writer.
+  const std::string* InternStreamName(const std::string* stream_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns true if a batch is queued or the writer is stopped.
+  bool HasWork() const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Returns true if no batch is queued or being written.
+  bool IsIdle() const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Writes queued events until the writer is stopped.
+  void Run();
+
+  // Writes one batch of events to the current trace file.
+  absl::Status WriteBatch(const std::vector<TraceEvent>& events,
+                          int64_t dropped_events);
+
+  // Starts the next trace file in the rotation.
+  absl::Status OpenNextFile();
+
+  // Appends the JSON for one TraceEvent to output_.
+  void AppendEvent(const TraceEvent& event);
+
+  // Appends a flow arrow from a packet output to the current event.
+  void AppendFlow(const TraceEvent& event);
+
+  // Appends the thread_name metadata for a thread, once per file.
+  void AppendThreadName(int thread_id, int node_id);
+
+  // Appends an instant event for an event without a matching slice.
+  void AppendInstant(const TraceEvent& event);
+
+  // Appends one JSON object to output_.
+  void AppendJson(const std::string& json);
+
+  // Returns the name of a node, or "" for an unknown node.
+  const std::string& NodeName(int node_id) const;
+
+  const Options options_;
+
+  // Guards the queue shared with the background thread.
+  absl::Mutex mutex_;
+  std::deque<std::vector<TraceEvent>> queue_ ABSL_GUARDED_BY(mutex_);
+  int64_t queued_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t dropped_events_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool writing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+
+  // Stream names, which outlive the graph's own stream names.
+  absl::node_hash_set<std::string> stream_names_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<const std::string*, const std::string*>
+      interned_stream_names_ ABSL_GUARDED_BY(mutex_);
+
+  // The state below is accessed only by the background thread.
+  std::ofstream file_;
+  std::string output_;
+  int write_count_ = 0;
+  bool file_is_empty_ = true;
+  absl::flat_hash_set<int> named_threads_;
+  std::map<std::tuple<int, int, int>, Slice> slices_;
+  absl::flat_hash_map<PacketKey, PacketOutput> packet_outputs_;
+  std::deque<PacketKey> packet_output_order_;
+  int64_t next_flow_id_ = 1;
+  int64_t written_dropped_events_ = 0;
+
+  std::thread thread_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
@@ -0,0 +1,156 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+class ChromeTraceWriterTest : public ::testing::Test {
+ protected:
+  ChromeTraceWriterTest() {
+    options_.process_id = 7;
+    options_.process_name = "test_graph";
+    options_.node_names = {"source", "sink"};
+    options_.node_executors = {"", "gpu_executor"};
+  }
+
+  // Returns a start or finish event for a PROCESS call at time_usec.
+  TraceEvent ProcessEvent(int node_id, int thread_id, int64_t time_usec,
+                          bool is_finish) {
+    return TraceEvent(GraphTrace::PROCESS)
+        .set_event_time(absl::FromUnixMicros(time_usec))
+        .set_node_id(node_id)
+        .set_thread_id(thread_id)
+        .set_input_ts(Timestamp(100))
+        .set_is_finish(is_finish);
+  }
+
+  std::string ReadFile(const std::string& path) {
+    std::string contents;
+    MP_EXPECT_OK(file::GetContents(path, &contents));
+    return contents;
+  }
+
+  std::string log_path_ = absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_");
+  ChromeTraceWriter::Options options_;
+  // A stream name shared by the producer and the consumer.
+  std::string stream_name_ = "video";
+};
+
+TEST_F(ChromeTraceWriterTest, WritesSlicesAndFlows) {
+  options_.path_prefix = absl::StrCat(log_path_, "slices_");
+  auto writer = std::make_unique<ChromeTraceWriter>(options_);
+
+  // The source outputs a packet on thread 1, which the sink receives on
+  // thread 2.  The events arrive in two separate batches.
+  writer->Write({ProcessEvent(0, 1, 1000, false),
+                 ProcessEvent(0, 1, 1010, true)
+                     .set_stream_id(&stream_name_)
+                     .set_packet_ts(Timestamp(100))});
+  writer->Write({ProcessEvent(1, 2, 1012, false)
+                     .set_stream_id(&stream_name_)
+                     .set_packet_ts(Timestamp(100)),
+                 ProcessEvent(1, 2, 1020, true)});
+  MP_EXPECT_OK(writer->Flush());
+  writer.reset();
+
+  std::string trace = ReadFile(absl::StrCat(options_.path_prefix, 0, ".json"));
+  EXPECT_THAT(trace, HasSubstr(R"({"name":"process_name","ph":"M","pid":7,)"
+                               R"("args":{"name":"test_graph"}})"));
+  EXPECT_THAT(trace,
+              HasSubstr(R"({"name":"thread_name","ph":"M","pid":7,"tid":1,)"
+                        R"("args":{"name":"default thread 1"}})"));
+  EXPECT_THAT(trace,
+              HasSubstr(R"({"name":"thread_name","ph":"M","pid":7,"tid":2,)"
+                        R"("args":{"name":"gpu_executor thread 2"}})"));
+  EXPECT_THAT(trace, HasSubstr(R"({"name":"source","cat":"PROCESS","ph":"X",)"
+                               R"("ts":1000,"dur":10,"pid":7,"tid":1,)"
+                               R"("args":{"input_ts":100}})"));
+  EXPECT_THAT(trace, HasSubstr(R"({"name":"sink","cat":"PROCESS","ph":"X",)"
+                               R"("ts":1012,"dur":8,"pid":7,"tid":2,)"
+                               R"("args":{"input_ts":100}})"));
+  EXPECT_THAT(trace, HasSubstr(R"({"name":"video","cat":"packet","ph":"s",)"
+                               R"("id":1,"ts":1000,"pid":7,"tid":1})"));
+  EXPECT_THAT(trace,
+              HasSubstr(R"({"name":"video","cat":"packet","ph":"f","bp":"e",)"
+                        R"("id":1,"ts":1012,"pid":7,"tid":2})"));
+  EXPECT_EQ(trace.front(), '[');
+  EXPECT_THAT(trace, HasSubstr("}\n]\n"));
+}
+
+TEST_F(ChromeTraceWriterTest, DropsEventsBeyondBudget) {
+  options_.path_prefix = absl::StrCat(log_path_, "budget_");
+  options_.max_buffered_bytes = sizeof(TraceEvent);
+  ChromeTraceWriter writer(options_);
+
+  writer.Write(
+      {ProcessEvent(0, 1, 1000, false), ProcessEvent(0, 1, 1010, true)});
+  EXPECT_EQ(writer.dropped_events(), 2);
+  writer.Write({ProcessEvent(1, 1, 1020, false)});
+  MP_EXPECT_OK(writer.Flush());
+  EXPECT_EQ(writer.dropped_events(), 2);
+
+  std::string trace = ReadFile(absl::StrCat(options_.path_prefix, 0, ".json"));
+  EXPECT_THAT(trace,
+              HasSubstr(R"({"name":"dropped_trace_events","ph":"C","ts":1020,)"
+                        R"("pid":7,"args":{"events":2}})"));
+  EXPECT_THAT(trace, Not(HasSubstr(R"("ts":1000)")));
+}
+
+TEST_F(ChromeTraceWriterTest, RotatesFiles) {
+  options_.path_prefix = absl::StrCat(log_path_, "rotate_");
+  options_.file_count = 2;
+  options_.writes_per_file = 1;
+  {
+    ChromeTraceWriter writer(options_);
+    for (int i = 0; i < 3; ++i) {
+      writer.Write({ProcessEvent(0, 1, 1000 * (i + 1), false),
+                    ProcessEvent(0, 1, 1000 * (i + 1) + 10, true)});
+      MP_EXPECT_OK(writer.Flush());
+    }
+  }
+
+  // The third write replaces the first file.
+  std::string trace_0 =
+      ReadFile(absl::StrCat(options_.path_prefix, 0, ".json"));
+  std::string trace_1 =
+      ReadFile(absl::StrCat(options_.path_prefix, 1, ".json"));
+  EXPECT_THAT(trace_0, Not(HasSubstr(R"("ts":1000,)")));
+  EXPECT_THAT(trace_0, HasSubstr(R"("ts":3000,"dur":10,)"));
+  EXPECT_THAT(trace_1, HasSubstr(R"("ts":2000,"dur":10,)"));
+  EXPECT_THAT(trace_0, HasSubstr("thread_name"));
+  EXPECT_THAT(trace_1, HasSubstr("thread_name"));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 #include <vector>
 
 namespace mediapipe {
@@ -28,6 +29,8 @@ namespace mediapipe {
 // Multiple writers and readers are supported.  All writes and reads
 // will succeed as long as the buffer does not grow by more than
 // "buffer_margin_" during a read.
+// The buffer memory is allocated in chunks as the buffer fills, so that a
+// buffer with a large capacity holding few events remains small.
 template <typename T>
 class CircularBuffer {
  public:
@@ -36,6 +39,9 @@ class CircularBuffer {
   // Create a circular buffer to hold up to |capacity| events.
   // Buffer writers are separated from readers by |buffer_margin|.
   CircularBuffer(size_t capacity, double buffer_margin = 0.25);
+  ~CircularBuffer();
+  CircularBuffer(const CircularBuffer&) = delete;
+  CircularBuffer& operator=(const CircularBuffer&) = delete;
 
   // Appends one event to the buffer.
   // Returns true if the buffer is free and writing succeeds.
@@ -59,6 +65,26 @@ class CircularBuffer {
   inline iterator end() const { return iterator(this, current_); }
 
  private:
+  // The number of consecutive buffer slots allocated together.
+  static constexpr size_t kChunkSize = 256;
+
+  // The events and the laps of kChunkSize consecutive buffer slots.
+  struct Chunk {
+    Chunk() {
+      for (std::atomic_char& lap : laps) {
+        lap.store(0, std::memory_order_relaxed);
+      }
+    }
+    T events[kChunkSize];
+    mutable std::atomic_char laps[kChunkSize];
+  };
+
+  // Returns the chunk holding a buffer index, allocating it if needed.
+  inline Chunk* GetChunkForWrite(size_t index);
+
+  // Returns the chunk holding a buffer index, once a writer allocated it.
+  inline const Chunk* GetChunkForRead(size_t index) const;
+
   // Marks an atom busy and returns its previous value.
   static inline char AcquireForWrite(std::atomic_char& atom);
 
@@ -78,8 +104,7 @@ class CircularBuffer {
   double buffer_margin_;
   size_t capacity_;
   size_t buffer_size_;
-  std::vector<T> buffer_;
-  mutable std::vector<std::atomic_char> lap_;
+  std::vector<std::atomic<Chunk*>> chunks_;
   std::atomic<size_t> current_;
   static constexpr char kBusy = 0xFF;
   static constexpr char kMask = 0x7F;
@@ -89,18 +114,26 @@ template <typename T>
 CircularBuffer<T>::CircularBuffer(size_t capacity, double buffer_margin)
     : capacity_(capacity),
       buffer_size_((size_t)capacity * (1 + buffer_margin)),
-      buffer_(buffer_size_),
-      lap_(buffer_size_),
+      chunks_((buffer_size_ + kChunkSize - 1) / kChunkSize),
       current_(0) {}
 
+template <typename T>
+CircularBuffer<T>::~CircularBuffer() {
+  for (std::atomic<Chunk*>& chunk : chunks_) {
+    delete chunk.load(std::memory_order_relaxed);
+  }
+}
+
 template <typename T>
 bool CircularBuffer<T>::push_back(const T& event) {
   size_t i = current_++;
   char lap = GetLap(i, buffer_size_);
   size_t index = i % buffer_size_;
-  char prev = AcquireForWrite(lap_[index]);
-  buffer_[index] = event;
-  Release(lap_[index], MaxLap(prev, lap));
+  Chunk* chunk = GetChunkForWrite(index);
+  std::atomic_char& atom = chunk->laps[index % kChunkSize];
+  char prev = AcquireForWrite(atom);
+  chunk->events[index % kChunkSize] = event;
+  Release(atom, MaxLap(prev, lap));
   return true;
 }
 
@@ -108,12 +141,42 @@ template <typename T>
 T CircularBuffer<T>::GetAbsolute(size_t i) const {
   char lap = GetLap(i, buffer_size_);
   size_t index = i % buffer_size_;
-  char prev = AcquireForRead(lap_[index], lap);
-  T result = buffer_[index];
-  Release(lap_[index], prev);
+  const Chunk* chunk = GetChunkForRead(index);
+  std::atomic_char& atom = chunk->laps[index % kChunkSize];
+  char prev = AcquireForRead(atom, lap);
+  T result = chunk->events[index % kChunkSize];
+  Release(atom, prev);
   return result;
 }
 
+template <typename T>
+typename CircularBuffer<T>::Chunk* CircularBuffer<T>::GetChunkForWrite(
+    size_t index) {
+  std::atomic<Chunk*>& slot = chunks_[index / kChunkSize];
+  Chunk* chunk = slot.load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    // Concurrent writers may both allocate the chunk, and only one is kept.
+    auto new_chunk = std::make_unique<Chunk>();
+    if (slot.compare_exchange_strong(chunk, new_chunk.get(),
+                                     std::memory_order_acq_rel)) {
+      chunk = new_chunk.release();
+    }
+  }
+  return chunk;
+}
+
+template <typename T>
+const typename CircularBuffer<T>::Chunk* CircularBuffer<T>::GetChunkForRead(
+    size_t index) const {
+  // Only written indices are read, so the chunk is allocated by a writer that
+  // may not have stored it yet.
+  const std::atomic<Chunk*>& slot = chunks_[index / kChunkSize];
+  const Chunk* chunk;
+  while ((chunk = slot.load(std::memory_order_acquire)) == nullptr) {
+  }
+  return chunk;
+}
+
 template <typename T>
 T CircularBuffer<T>::Get(size_t i) const {
   if (current_ > capacity_) {
@@ -82,6 +82,13 @@ bool IsTraceLogEnabled(const ProfilerConfig& profiler_config) {
          !profiler_config.trace_log_disabled();
 }
 
+// Returns true if trace events are written in the Chrome trace-event format.
+bool IsChromeTraceLogEnabled(const ProfilerConfig& profiler_config) {
+  return IsTraceLogEnabled(profiler_config) &&
+         profiler_config.trace_log_format() ==
+             ProfilerConfig::CHROME_TRACE_EVENT;
+}
+
 // Returns true if trace events are written periodically.
 bool IsTraceIntervalEnabled(const ProfilerConfig& profiler_config,
                             GraphTracer* tracer) {
@@ -170,6 +177,13 @@ void GraphProfiler::Initialize(
   if (IsTracerEnabled(profiler_config_)) {
     packet_tracer_ = absl::make_unique<GraphTracer>(profiler_config_);
   }
+  count_allocations_ = IsProfilerEnabled(profiler_config_) &&
+                       profiler_config_.enable_allocation_counting();
+  if (count_allocations_ && !AllocationCounter::IsAvailable()) {
+    ABSL_LOG(WARNING) << "enable_allocation_counting is set, but the binary "
+                         "does not link the allocation counter hooks. "
+                         "Allocation counts will be zero.";
+  }
   for (int node_id = 0;
        node_id < validated_graph_config.CalculatorInfos().size(); ++node_id) {
     std::string node_name =
@@ -194,6 +208,8 @@ void GraphProfiler::Initialize(
     auto iter = calculator_profiles_.insert({node_name, profile});
     ABSL_CHECK(iter.second) << absl::Substitute(
         "Calculator \"$0\" has already been added.", node_name);
+    input_notification_counters_[node_name] =
+        std::make_unique<InputNotificationCounters>();
   }
   profile_builder_ = std::make_unique<GraphProfileBuilder>(this);
   graph_id_ = ++next_instance_id_;
@@ -227,12 +243,21 @@ void GraphProfiler::Resume() {
 
 void GraphProfiler::Reset() {
   absl::WriterMutexLock lock(&profiler_mutex_);
+  for (auto& [name, counters] : input_notification_counters_) {
+    counters->timestamp_bound_updates = 0;
+    counters->input_notifications = 0;
+    counters->coalesced_notifications = 0;
+  }
   for (auto iter = calculator_profiles_.begin();
        iter != calculator_profiles_.end(); ++iter) {
     CalculatorProfile* calculator_profile = &iter->second;
     ResetTimeHistogram(calculator_profile->mutable_process_runtime());
     ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
     ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
+    calculator_profile->clear_process_allocations();
+    calculator_profile->clear_max_process_allocations();
+    calculator_profile->clear_cpu_buffer_pool_hits();
+    calculator_profile->clear_cpu_buffer_pool_misses();
     for (auto& input_stream_profile :
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
@@ -244,6 +269,9 @@ void GraphProfiler::Reset() {
 absl::Status GraphProfiler::Start(mediapipe::Executor* executor) {
   // If specified, start periodic profile output while the graph runs.
   Resume();
+  if (IsChromeTraceLogEnabled(profiler_config_) && !chrome_trace_writer_) {
+    MP_RETURN_IF_ERROR(CreateChromeTraceWriter());
+  }
   if (is_tracing_ && IsTraceIntervalEnabled(profiler_config_, tracer()) &&
       executor != nullptr) {
     // Inform the user via logging the path to the trace logs.
@@ -290,6 +318,9 @@ absl::Status GraphProfiler::Stop() {
   if (IsTraceLogEnabled(profiler_config_)) {
     MP_RETURN_IF_ERROR(WriteProfile());
   }
+  if (chrome_trace_writer_) {
+    MP_RETURN_IF_ERROR(chrome_trace_writer_->Flush());
+  }
   return absl::OkStatus();
 }
 
@@ -347,6 +378,14 @@ absl::Status GraphProfiler::GetCalculatorProfiles(
       << "GetCalculatorProfiles can only be called after Initialize()";
   for (auto& entry : calculator_profiles_) {
     profiles->push_back(entry.second);
+    auto counters_iter = input_notification_counters_.find(entry.first);
+    if (counters_iter != input_notification_counters_.end()) {
+      const InputNotificationCounters& counters = *counters_iter->second;
+      CalculatorProfile& profile = profiles->back();
+      profile.set_timestamp_bound_updates(counters.timestamp_bound_updates);
+      profile.set_input_notifications(counters.input_notifications);
+      profile.set_coalesced_notifications(counters.coalesced_notifications);
+    }
   }
   return absl::OkStatus();
 }
@@ -549,7 +588,7 @@ int64_t GraphProfiler::AddInputStreamTimeSamples(
 
 void GraphProfiler::AddProcessSample(
     const CalculatorContext& calculator_context, int64_t start_time_usec,
-    int64_t end_time_usec) {
+    int64_t end_time_usec, int64_t num_allocations) {
   absl::ReaderMutexLock lock(&profiler_mutex_);
   if (!is_profiling_) {
     return;
@@ -566,6 +605,14 @@ void GraphProfiler::AddProcessSample(
   AddTimeSample(start_time_usec, end_time_usec,
                 calculator_profile->mutable_process_runtime());
 
+  if (count_allocations_) {
+    calculator_profile->set_process_allocations(
+        calculator_profile->process_allocations() + num_allocations);
+    if (num_allocations > calculator_profile->max_process_allocations()) {
+      calculator_profile->set_max_process_allocations(num_allocations);
+    }
+  }
+
   if (profiler_config_.enable_stream_latency()) {
     int64_t min_source_process_start_usec = AddStreamLatencies(
         calculator_context, start_time_usec, end_time_usec, calculator_profile);
@@ -577,6 +624,45 @@ void GraphProfiler::AddProcessSample(
   }
 }
 
+void GraphProfiler::AddInputNotifications(
+    const CalculatorContext& calculator_context, int64_t bound_updates,
+    int64_t notifications, int64_t coalesced_notifications) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto counters_iter =
+      input_notification_counters_.find(calculator_context.NodeName());
+  if (counters_iter == input_notification_counters_.end()) {
+    return;
+  }
+  InputNotificationCounters& counters = *counters_iter->second;
+  counters.timestamp_bound_updates.fetch_add(bound_updates,
+                                             std::memory_order_relaxed);
+  counters.input_notifications.fetch_add(notifications,
+                                         std::memory_order_relaxed);
+  counters.coalesced_notifications.fetch_add(coalesced_notifications,
+                                             std::memory_order_relaxed);
+}
+
+void GraphProfiler::AddCpuBufferPoolUsage(
+    const CalculatorContext& calculator_context, int64_t hits,
+    int64_t misses) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  if (profile_iter == calculator_profiles_.end()) {
+    return;
+  }
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  calculator_profile->set_cpu_buffer_pool_hits(
+      calculator_profile->cpu_buffer_pool_hits() + hits);
+  calculator_profile->set_cpu_buffer_pool_misses(
+      calculator_profile->cpu_buffer_pool_misses() + misses);
+}
+
 std::unique_ptr<GlProfilingHelper> GraphProfiler::CreateGlProfilingHelper() {
   if (!IsTracerEnabled(profiler_config_)) {
     return nullptr;
@@ -676,6 +762,43 @@ absl::StatusOr<std::string> GraphProfiler::GetTraceLogPath() {
   }
 }
 
+absl::Status GraphProfiler::CreateChromeTraceWriter() {
+  MP_ASSIGN_OR_RETURN(std::string trace_log_path, GetTraceLogPath());
+  const CalculatorGraphConfig& config = validated_graph_->Config();
+  ChromeTraceWriter::Options options;
+  options.path_prefix = trace_log_path;
+  options.file_count = GetLogFileCount(profiler_config_);
+  options.writes_per_file = GetLogIntervalCount(profiler_config_);
+  if (profiler_config_.trace_log_buffer_bytes() > 0) {
+    options.max_buffered_bytes = profiler_config_.trace_log_buffer_bytes();
+  }
+  options.process_id = graph_id_;
+  options.process_name = config.type().empty()
+                             ? absl::StrCat("CalculatorGraph ", graph_id_)
+                             : config.type();
+  for (int node_id = 0; node_id < validated_graph_->CalculatorInfos().size();
+       ++node_id) {
+    options.node_names.push_back(tool::CanonicalNodeName(config, node_id));
+    options.node_executors.push_back(config.node(node_id).executor());
+  }
+  chrome_trace_writer_ =
+      std::make_unique<ChromeTraceWriter>(std::move(options));
+  return absl::OkStatus();
+}
+
+absl::Status GraphProfiler::WriteChromeTrace() {
+  // As in CaptureProfile, the end_time is trace_log_margin_usec in the past.
+  absl::Time end_time =
+      clock_->TimeNow() -
+      absl::Microseconds(profiler_config_.trace_log_margin_usec());
+  if (tracer()) {
+    chrome_trace_writer_->Write(
+        tracer()->GetTraceEvents(previous_log_end_time_, end_time));
+  }
+  previous_log_end_time_ = end_time;
+  return absl::OkStatus();
+}
+
 absl::Status GraphProfiler::CaptureProfile(
     GraphProfile* result, PopulateGraphConfig populate_config) {
   // Record the GraphTrace events since the previous WriteProfile.
@@ -717,6 +840,9 @@ absl::Status GraphProfiler::WriteProfile() {
     // Logging is disabled, so we can exit writing without error.
     return absl::OkStatus();
   }
+  if (chrome_trace_writer_) {
+    return WriteChromeTrace();
+  }
   MP_ASSIGN_OR_RETURN(std::string trace_log_path, GetTraceLogPath());
   int log_interval_count = GetLogIntervalCount(profiler_config_);
   int log_file_count = GetLogFileCount(profiler_config_);
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -30,6 +31,9 @@
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+#include "mediapipe/framework/profiler/allocation_counter.h"
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
 #include "mediapipe/framework/validated_graph_config.h"
@@ -146,6 +150,20 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   absl::Status GetCalculatorProfiles(std::vector<CalculatorProfile>*) const
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Adds the timestamp bound updates and the readiness notifications received
+  // by the input streams of a calculator to its CalculatorProfile. Called by
+  // the threads producing the inputs, possibly concurrently.
+  void AddInputNotifications(const CalculatorContext& calculator_context,
+                             int64_t bound_updates, int64_t notifications,
+                             int64_t coalesced_notifications)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
+  // Adds the CpuBufferPool hits and misses of a Process() call to the
+  // CalculatorProfile of its calculator.
+  void AddCpuBufferPoolUsage(const CalculatorContext& calculator_context,
+                             int64_t hits, int64_t misses)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Records recent profiling and tracing data.  Includes events since the
   // previous call to CaptureProfile.
   //
@@ -169,7 +187,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
 
   // Convenience temporary object to record scoped entry and exit.
   // Gets start_time_usec_ on construction and records process runtime on
-  // destruction. The |calculator_context| and |profiler| must not be null.
+  // destruction. If allocation counting is enabled, also records the heap
+  // allocations made by Process() on the current thread.
+  // The |calculator_context| and |profiler| must not be null.
   class Scope {
    public:
     // Constructs a scope.
@@ -188,9 +208,22 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
         profiler_->packet_tracer_->LogInputEvents(
             calculator_method_, &calculator_context_, time_now);
       }
+      if (profiler_->count_allocations_) {
+        start_allocations_ = AllocationCounter::ThreadAllocations();
+      }
+      count_pool_usage_ = profiler_->is_profiling_ &&
+                          calculator_method_ == GraphTrace::PROCESS;
+      if (count_pool_usage_) {
+        start_pool_hits_ = CpuBufferPool::ThreadHits();
+        start_pool_misses_ = CpuBufferPool::ThreadMisses();
+      }
     }
 
     inline ~Scope() {
+      const int64_t num_allocations =
+          profiler_->count_allocations_
+              ? AllocationCounter::ThreadAllocations() - start_allocations_
+              : 0;
       int64_t end_time_usec;
       if (profiler_->is_profiling_ || profiler_->is_tracing_) {
         end_time_usec = profiler_->TimeNowUsec();
@@ -205,7 +238,17 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
 
           case GraphTrace::PROCESS:
             profiler_->AddProcessSample(calculator_context_, start_time_usec_,
-                                        end_time_usec);
+                                        end_time_usec, num_allocations);
+            if (count_pool_usage_) {
+              const int64_t pool_hits =
+                  CpuBufferPool::ThreadHits() - start_pool_hits_;
+              const int64_t pool_misses =
+                  CpuBufferPool::ThreadMisses() - start_pool_misses_;
+              if (pool_hits > 0 || pool_misses > 0) {
+                profiler_->AddCpuBufferPoolUsage(calculator_context_,
+                                                 pool_hits, pool_misses);
+              }
+            }
             break;
 
           case GraphTrace::CLOSE:
@@ -228,6 +271,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
     const CalculatorContext& calculator_context_;
     GraphProfiler* profiler_;
     int64_t start_time_usec_;
+    int64_t start_allocations_ = 0;
+    bool count_pool_usage_ = false;
+    int64_t start_pool_hits_ = 0;
+    int64_t start_pool_misses_ = 0;
   };
 
   const ProfilerConfig& profiler_config() { return profiler_config_; }
@@ -302,7 +349,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Updates the Process() data for calculator.
   // Requires ReaderLock for is_profiling_.
   void AddProcessSample(const CalculatorContext& calculator_context,
-                        int64_t start_time_usec, int64_t end_time_usec)
+                        int64_t start_time_usec, int64_t end_time_usec,
+                        int64_t num_allocations)
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
   // Helper method to get trace_log_path.  If the trace_log_path is empty and
@@ -310,6 +358,13 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // trace_log_path.
   absl::StatusOr<std::string> GetTraceLogPath();
 
+  // Creates the background writer for CHROME_TRACE_EVENT trace logs.
+  absl::Status CreateChromeTraceWriter();
+
+  // Queues the trace events since the previous WriteProfile for the
+  // CHROME_TRACE_EVENT trace log.
+  absl::Status WriteChromeTrace();
+
   // Helper method to get the clock time in microsecond.
   int64_t TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
 
@@ -327,9 +382,26 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // If true, the tracer records timing events.
   std::atomic_bool is_tracing_;
 
+  // If true, the profiler counts the heap allocations made by Process().
+  // Set once during Initialize.
+  bool count_allocations_ = false;
+
   // Stores all the calculator profiles with the calculator name as the key.
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
+
+  // The input notification counts of one calculator. They are updated by the
+  // threads producing its inputs, concurrently with each other and with the
+  // calculator's own Process() samples, so they are kept outside of its
+  // CalculatorProfile and copied into it by GetCalculatorProfiles.
+  struct InputNotificationCounters {
+    std::atomic<int64_t> timestamp_bound_updates = 0;
+    std::atomic<int64_t> input_notifications = 0;
+    std::atomic<int64_t> coalesced_notifications = 0;
+  };
+  // Keyed by calculator name. Filled by Initialize and not modified after.
+  absl::flat_hash_map<std::string, std::unique_ptr<InputNotificationCounters>>
+      input_notification_counters_;
   // Stores the production time of a packet, based on profiler's clock.
   using PacketInfoMap =
       ShardedMap<std::string, std::list<std::pair<int64_t, PacketInfo>>>;
@@ -356,6 +428,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // The configuration for the graph being profiled.
   const ValidatedGraphConfig* validated_graph_;
 
+  // Writes trace events in the CHROME_TRACE_EVENT format, if enabled.
+  std::unique_ptr<ChromeTraceWriter> chrome_trace_writer_;
+
   // A private resource for creating GraphProfiles.
   class GraphProfileBuilder;
   std::unique_ptr<GraphProfileBuilder> profile_builder_;
@@ -31,6 +31,7 @@ using mediapipe::CalculatorProfile;
 using mediapipe::GraphProfile;
 using mediapipe::GraphTrace;
 
+class CalculatorContext;
 class ValidatedGraphConfig;
 class Executor;
 class Packet;
@@ -95,6 +96,12 @@ class GraphProfilerStub {
       PopulateGraphConfig populate_config = PopulateGraphConfig::kNo) {
     return absl::OkStatus();
   }
+  inline void AddInputNotifications(const CalculatorContext& calculator_context,
+                                    int64_t bound_updates,
+                                    int64_t notifications,
+                                    int64_t coalesced_notifications) {}
+  inline void AddCpuBufferPoolUsage(const CalculatorContext& calculator_context,
+                                    int64_t hits, int64_t misses) {}
   inline absl::Status WriteProfile() { return absl::OkStatus(); }
   inline void Pause() {}
   inline void Resume() {}
@@ -14,8 +14,13 @@
 
 #include "mediapipe/framework/profiler/graph_tracer.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -39,6 +44,119 @@ inline int GetCurrentThreadId() {
   return thread_id;
 }
 
+// Returns a unique identifier for a new GraphTracer.
+int64_t NewTracerId() {
+  static std::atomic<int64_t> next_tracer_id = 1;
+  return next_tracer_id++;
+}
+
+// Merges the TraceEvents of several threads in order of event_time.
+// The order of the events within each thread is preserved.  A TraceBuffer can
+// hold the events of several threads, logged one thread after another, so
+// the events are sorted rather than merged buffer by buffer.
+std::vector<TraceEvent> MergeTraceEvents(
+    std::vector<std::vector<TraceEvent>> thread_events) {
+  if (thread_events.size() == 1) {
+    return std::move(thread_events[0]);
+  }
+  size_t num_events = 0;
+  for (const auto& events : thread_events) {
+    num_events += events.size();
+  }
+  std::vector<TraceEvent> result;
+  result.reserve(num_events);
+  for (const auto& events : thread_events) {
+    result.insert(result.end(), events.begin(), events.end());
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     return a.event_time < b.event_time;
+                   });
+  return result;
+}
+
+}  // namespace
+
+namespace internal {
+
+// The TraceBuffers of a GraphTracer.  A TraceBuffer is held by one thread at
+// a time, and is reused once that thread exits, so the number of TraceBuffers
+// is bounded by the number of threads logging concurrently.
+class TraceBufferPool {
+ public:
+  explicit TraceBufferPool(int64_t capacity) : capacity_(capacity) {}
+
+  // Returns a TraceBuffer that no other thread holds.
+  TraceBuffer* Acquire() {
+    absl::MutexLock lock(&mutex_);
+    if (!free_buffers_.empty()) {
+      TraceBuffer* result = free_buffers_.back();
+      free_buffers_.pop_back();
+      return result;
+    }
+    buffers_.push_back(std::make_unique<TraceBuffer>(capacity_));
+    return buffers_.back().get();
+  }
+
+  // Makes a TraceBuffer available to other threads.  The events it holds are
+  // kept until they are overwritten.
+  void Release(TraceBuffer* trace_buffer) {
+    absl::MutexLock lock(&mutex_);
+    free_buffers_.push_back(trace_buffer);
+  }
+
+  // Returns all TraceBuffers, including the ones no thread holds.
+  std::vector<const TraceBuffer*> GetBuffers() {
+    absl::MutexLock lock(&mutex_);
+    std::vector<const TraceBuffer*> result;
+    result.reserve(buffers_.size());
+    for (const auto& trace_buffer : buffers_) {
+      result.push_back(trace_buffer.get());
+    }
+    return result;
+  }
+
+ private:
+  const int64_t capacity_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers_ ABSL_GUARDED_BY(mutex_);
+  std::vector<TraceBuffer*> free_buffers_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace internal
+
+namespace {
+
+// The TraceBuffers held by the current thread, one per GraphTracer, which are
+// returned to their GraphTracers when the thread exits.  A GraphTracer is
+// identified by id rather than by address, because a new GraphTracer can be
+// allocated at the address of a deleted one.
+struct ThreadTraceBuffers {
+  struct Entry {
+    int64_t tracer_id;
+    std::weak_ptr<internal::TraceBufferPool> pool;
+    TraceBuffer* trace_buffer;
+  };
+
+  ~ThreadTraceBuffers() {
+    for (const Entry& entry : entries) {
+      if (auto pool = entry.pool.lock()) {
+        pool->Release(entry.trace_buffer);
+      }
+    }
+  }
+
+  // The TraceBuffer used last by the thread, and its GraphTracer.
+  int64_t last_tracer_id = 0;
+  TraceBuffer* last_trace_buffer = nullptr;
+  std::vector<Entry> entries;
+};
+
+ThreadTraceBuffers& CurrentThreadTraceBuffers() {
+  static thread_local ThreadTraceBuffers thread_buffers;
+  return thread_buffers;
+}
+
 }  // namespace
 
 absl::Duration GraphTracer::GetTraceLogInterval() {
@@ -53,30 +171,90 @@ int64_t GraphTracer::GetTraceLogCapacity() {
              : 20000;
 }
 
+int GraphTracer::GetTraceSampleInterval() {
+  return std::max(profiler_config_.trace_sample_interval(), 1);
+}
+
 GraphTracer::GraphTracer(const ProfilerConfig& profiler_config)
-    : profiler_config_(profiler_config), trace_buffer_(GetTraceLogCapacity()) {
+    : profiler_config_(profiler_config),
+      tracer_id_(NewTracerId()),
+      sample_interval_(GetTraceSampleInterval()),
+      trace_buffers_(std::make_shared<internal::TraceBufferPool>(
+          GetTraceLogCapacity())) {
   for (int disabled : profiler_config_.trace_event_types_disabled()) {
     EventType event_type = static_cast<EventType>(disabled);
     (*trace_event_registry())[event_type].set_enabled(false);
   }
 }
 
+GraphTracer::~GraphTracer() = default;
+
 TraceEventRegistry* GraphTracer::trace_event_registry() {
   return trace_builder_.trace_event_registry();
 }
 
 void GraphTracer::LogEvent(TraceEvent event) {
-  if (!(*trace_event_registry())[event.event_type].enabled()) {
+  if (!(*trace_event_registry())[event.event_type].enabled() ||
+      !IsSampled(event.input_ts)) {
     return;
   }
   event.set_thread_id(GetCurrentThreadId());
-  trace_buffer_.push_back(event);
+  GetThreadTraceBuffer()->push_back(event);
+}
+
+bool GraphTracer::IsSampled(Timestamp input_ts) const {
+  if (sample_interval_ == 1 || !input_ts.IsRangeValue()) {
+    return true;
+  }
+  // Timestamps are often multiples of a frame period, so they are hashed
+  // before sampling to spread the sampled timestamps evenly.
+  uint64_t hash = static_cast<uint64_t>(input_ts.Value()) * 0x9E3779B97F4A7C15;
+  return (hash >> 32) % sample_interval_ == 0;
+}
+
+TraceBuffer* GraphTracer::GetThreadTraceBuffer() {
+  ThreadTraceBuffers& thread_buffers = CurrentThreadTraceBuffers();
+  if (thread_buffers.last_tracer_id == tracer_id_) {
+    return thread_buffers.last_trace_buffer;
+  }
+  TraceBuffer* trace_buffer = nullptr;
+  for (const ThreadTraceBuffers::Entry& entry : thread_buffers.entries) {
+    if (entry.tracer_id == tracer_id_) {
+      trace_buffer = entry.trace_buffer;
+      break;
+    }
+  }
+  if (trace_buffer == nullptr) {
+    // Forget the TraceBuffers of deleted GraphTracers.
+    std::vector<ThreadTraceBuffers::Entry>& entries = thread_buffers.entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const ThreadTraceBuffers::Entry& entry) {
+                                   return entry.pool.expired();
+                                 }),
+                  entries.end());
+    trace_buffer = trace_buffers_->Acquire();
+    entries.push_back({tracer_id_, trace_buffers_, trace_buffer});
+  }
+  thread_buffers.last_tracer_id = tracer_id_;
+  thread_buffers.last_trace_buffer = trace_buffer;
+  return trace_buffer;
+}
+
+std::vector<const TraceBuffer*> GraphTracer::GetThreadTraceBuffers() {
+  return trace_buffers_->GetBuffers();
+}
+
+int GraphTracer::GetNumTraceBuffers() {
+  return trace_buffers_->GetBuffers().size();
 }
 
 void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
                                  const CalculatorContext* context,
                                  absl::Time event_time) {
   Timestamp input_ts = context->InputTimestamp();
+  if (!IsSampled(input_ts)) {
+    return;
+  }
   for (const InputStreamShard& in_stream : context->Inputs()) {
     const Packet& packet = in_stream.Value();
     if (!packet.IsEmpty()) {
@@ -100,6 +278,9 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
   Timestamp input_ts = (context->Inputs().NumEntries() > 0)
                            ? context->InputTimestamp()
                            : GetOutputTimestamp(context);
+  if (!IsSampled(input_ts)) {
+    return;
+  }
   for (const OutputStreamShard& out_stream : context->Outputs()) {
     const std::string* stream_id = &out_stream.Name();
     for (const Packet& packet : *out_stream.OutputQueue()) {
@@ -116,7 +297,12 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
 }
 
 Timestamp GraphTracer::TimestampAfter(absl::Time begin_time) {
-  return TraceBuilder::TimestampAfter(trace_buffer_, begin_time);
+  Timestamp result = Timestamp::Min() + 1;
+  for (const TraceBuffer* trace_buffer : GetThreadTraceBuffers()) {
+    result =
+        std::max(result, TraceBuilder::TimestampAfter(*trace_buffer, begin_time));
+  }
+  return result;
 }
 
 // The mutex to guard GraphTracer::trace_builder_.
@@ -127,19 +313,35 @@ absl::Mutex* trace_builder_mutex() {
 
 void GraphTracer::GetTrace(absl::Time begin_time, absl::Time end_time,
                            GraphTrace* result) {
+  std::vector<TraceEvent> snapshot = GetTraceEvents(begin_time, end_time);
   absl::MutexLock lock(trace_builder_mutex());
-  trace_builder_.CreateTrace(trace_buffer_, begin_time, end_time, result);
+  trace_builder_.CreateTrace(snapshot, result);
   trace_builder_.Clear();
 }
 
 void GraphTracer::GetLog(absl::Time begin_time, absl::Time end_time,
                          GraphTrace* result) {
+  std::vector<TraceEvent> snapshot = GetTraceEvents(begin_time, end_time);
   absl::MutexLock lock(trace_builder_mutex());
-  trace_builder_.CreateLog(trace_buffer_, begin_time, end_time, result);
+  trace_builder_.CreateLog(snapshot, result);
   trace_builder_.Clear();
 }
 
-const TraceBuffer& GraphTracer::GetTraceBuffer() { return trace_buffer_; }
+std::vector<TraceEvent> GraphTracer::GetTraceEvents(absl::Time begin_time,
+                                                    absl::Time end_time) {
+  std::vector<std::vector<TraceEvent>> thread_events;
+  for (const TraceBuffer* trace_buffer : GetThreadTraceBuffers()) {
+    std::vector<TraceEvent>& events = thread_events.emplace_back();
+    TraceBuffer::iterator buffer_end = trace_buffer->end();
+    for (auto iter = trace_buffer->begin(); iter < buffer_end; ++iter) {
+      TraceEvent event = *iter;
+      if (event.event_time >= begin_time && event.event_time < end_time) {
+        events.push_back(event);
+      }
+    }
+  }
+  return MergeTraceEvents(std::move(thread_events));
+}
 
 Timestamp GraphTracer::GetOutputTimestamp(const CalculatorContext* context) {
   for (const OutputStreamShard& out_stream : context->Outputs()) {
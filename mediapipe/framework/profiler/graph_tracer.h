@@ -15,8 +15,12 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
@@ -25,11 +29,19 @@
 
 namespace mediapipe {
 
+namespace internal {
+class TraceBufferPool;
+}  // namespace internal
+
 // GraphTracer records events when packets enter and exit the nodes of
 // a calculator graph.
 //
 // GraphTracer is thread-safe, and the Log* methods are also non-blocking
 // so they can be called during graph execution with mimimal overhead.
+// Each thread appends events to its own TraceBuffer, so that threads do not
+// contend for the same buffer.  The events of all threads are merged only
+// when a trace or a log is requested.  A thread returns its TraceBuffer when
+// it exits, so that the TraceBuffer is reused by threads started later.
 //
 // The method GetTrace returns the events for a range of recent Timestamps.
 // The begin_ts should be the first timestamp completely enclosed in the
@@ -49,16 +61,20 @@ class GraphTracer {
   // Returns the interval between trace log output.
   absl::Duration GetTraceLogInterval();
 
-  // Returns the maximum number of trace events buffered in memory.
+  // Returns the maximum number of trace events buffered in memory per thread.
   int64_t GetTraceLogCapacity();
 
-  // Create a tracer to record up to |capacity| recent events.
+  // Returns the interval between traced input timestamps.
+  int GetTraceSampleInterval();
+
+  // Create a tracer to record up to |capacity| recent events per thread.
   GraphTracer(const ProfilerConfig& profiler_config);
+  ~GraphTracer();
 
   // Returns the registry of trace event types.
   TraceEventRegistry* trace_event_registry();
 
-  // Append a TraceEvent to the TraceBuffer.
+  // Append a TraceEvent to the TraceBuffer of the current thread.
   void LogEvent(TraceEvent event);
 
   // Append TraceEvents to the TraceBuffer for task input.
@@ -78,18 +94,39 @@ class GraphTracer {
   // Returns trace events between begin_time and end_time exclusive.
   void GetLog(absl::Time begin_time, absl::Time end_time, GraphTrace* result);
 
-  // Returns the logged TraceEvents.
-  const TraceBuffer& GetTraceBuffer();
+  // Returns the logged TraceEvents between begin_time and end_time exclusive.
+  // The events of each thread are merged in order of event_time.
+  std::vector<TraceEvent> GetTraceEvents(absl::Time begin_time,
+                                         absl::Time end_time);
+
+  // Returns the number of TraceBuffers allocated for logging threads.
+  int GetNumTraceBuffers();
 
  private:
   // Returns the timestamp of the first output packet.
   Timestamp GetOutputTimestamp(const CalculatorContext* context);
 
+  // Returns true if the events for an input timestamp are logged.
+  bool IsSampled(Timestamp input_ts) const;
+
+  // Returns the TraceBuffer of the current thread.
+  TraceBuffer* GetThreadTraceBuffer();
+
+  // Returns the TraceBuffers of all threads that have logged events.
+  std::vector<const TraceBuffer*> GetThreadTraceBuffers();
+
   // The settings for this tracer.
   ProfilerConfig profiler_config_;
 
-  // The circular buffer of TraceEvents.
-  TraceBuffer trace_buffer_;
+  // Identifies this tracer in the per-thread TraceBuffer cache.
+  const int64_t tracer_id_;
+
+  // The interval between traced input timestamps.
+  const int sample_interval_;
+
+  // The circular buffers of TraceEvents, shared with the logging threads so
+  // that they can return their buffers when they exit.
+  std::shared_ptr<internal::TraceBufferPool> trace_buffers_;
 
   // The builder for the GraphTrace protobuf.
   TraceBuilder trace_builder_;
@@ -19,6 +19,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -58,6 +59,7 @@ class GraphProfilerTestPeer {
 namespace {
 
 using testing::ElementsAre;
+using testing::HasSubstr;
 
 class GraphTracerTest : public ::testing::Test {
  protected:
@@ -329,6 +331,111 @@ TEST_F(GraphTracerTest, GraphTrace) {
   EXPECT_EQ(4, trace.calculator_trace().size());
 }
 
+TEST_F(GraphTracerTest, MergesEventsOfThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 100;
+  SetUpGraphTracer();
+
+  // Each thread logs the events of one node, interleaved in time with the
+  // events of the other threads.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([this, i] {
+      for (int j = 0; j < kNumEvents; ++j) {
+        tracer_->LogEvent(
+            TraceEvent(GraphTrace::PROCESS)
+                .set_event_time(start_time_ +
+                                absl::Microseconds(j * kNumThreads + i))
+                .set_node_id(i)
+                .set_input_ts(start_timestamp_ + j));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<TraceEvent> events =
+      tracer_->GetTraceEvents(absl::InfinitePast(), absl::InfiniteFuture());
+  ASSERT_EQ(events.size(), kNumThreads * kNumEvents);
+  std::map<int, int> node_thread_ids;
+  for (int k = 0; k < events.size(); ++k) {
+    EXPECT_EQ(events[k].event_time, start_time_ + absl::Microseconds(k));
+    EXPECT_EQ(events[k].node_id, k % kNumThreads);
+    EXPECT_EQ(events[k].input_ts, start_timestamp_ + k / kNumThreads);
+    auto [it, inserted] =
+        node_thread_ids.insert({events[k].node_id, events[k].thread_id});
+    EXPECT_EQ(it->second, events[k].thread_id);
+  }
+  EXPECT_EQ(node_thread_ids.size(), kNumThreads);
+
+  // Only the events in the requested time range are returned.
+  events = tracer_->GetTraceEvents(start_time_ + absl::Microseconds(10),
+                                   start_time_ + absl::Microseconds(20));
+  EXPECT_EQ(events.size(), 10);
+  EXPECT_EQ(tracer_->TimestampAfter(start_time_ + absl::Microseconds(10)),
+            start_timestamp_ + 3);
+}
+
+TEST_F(GraphTracerTest, ReusesTraceBuffersOfExitedThreads) {
+  constexpr int kNumThreads = 50;
+  SetUpGraphTracer();
+
+  // Short-lived threads, such as application threads adding packets, log
+  // events one after another.
+  for (int i = 0; i < kNumThreads; ++i) {
+    std::thread([this, i] {
+      tracer_->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                            .set_event_time(start_time_ + absl::Microseconds(i))
+                            .set_node_id(i)
+                            .set_input_ts(start_timestamp_ + i));
+    }).join();
+  }
+  EXPECT_EQ(tracer_->GetNumTraceBuffers(), 1);
+
+  // The events of all threads are kept.
+  std::vector<TraceEvent> events =
+      tracer_->GetTraceEvents(absl::InfinitePast(), absl::InfiniteFuture());
+  ASSERT_EQ(events.size(), kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(events[i].node_id, i);
+  }
+}
+
+TEST_F(GraphTracerTest, SamplesInputTimestamps) {
+  constexpr int kNumTimestamps = 1000;
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  profiler_config.set_trace_sample_interval(4);
+  tracer_ = absl::make_unique<GraphTracer>(profiler_config);
+
+  tracer_->LogEvent(
+      TraceEvent(GraphTrace::OPEN).set_event_time(start_time_).set_node_id(0));
+  for (int i = 0; i < kNumTimestamps; ++i) {
+    // Timestamps of a 30 fps video stream.
+    Timestamp input_ts = start_timestamp_ + i * 33333;
+    for (int node_id = 0; node_id < 2; ++node_id) {
+      tracer_->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                            .set_event_time(start_time_ + absl::Seconds(1))
+                            .set_node_id(node_id)
+                            .set_input_ts(input_ts));
+    }
+  }
+
+  std::vector<TraceEvent> events =
+      tracer_->GetTraceEvents(absl::InfinitePast(), absl::InfiniteFuture());
+  ASSERT_FALSE(events.empty());
+  EXPECT_EQ(events[0].event_type, GraphTrace::OPEN);
+  std::map<int, std::vector<Timestamp>> node_timestamps;
+  for (int k = 1; k < events.size(); ++k) {
+    node_timestamps[events[k].node_id].push_back(events[k].input_ts);
+  }
+  // The same timestamps are sampled in every node.
+  EXPECT_EQ(node_timestamps[0], node_timestamps[1]);
+  EXPECT_GT(node_timestamps[0].size(), kNumTimestamps / 4 * 0.8);
+  EXPECT_LT(node_timestamps[0].size(), kNumTimestamps / 4 * 1.2);
+}
+
 // Tests showing GraphTracer logging packet latencies.
 class GraphTracerE2ETest : public ::testing::Test {
  protected:
@@ -1011,6 +1118,24 @@ TEST_F(GraphTracerE2ETest, DemuxGraphLogFile) {
   EXPECT_EQ(113, profile.graph_trace(0).calculator_trace().size());
 }
 
+TEST_F(GraphTracerE2ETest, DemuxGraphChromeTraceLogFile) {
+  std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_file_");
+  SetUpDemuxInFlightGraph();
+  graph_config_.mutable_profiler_config()->set_trace_log_path(log_path);
+  graph_config_.mutable_profiler_config()->set_trace_log_interval_usec(-1);
+  graph_config_.mutable_profiler_config()->set_trace_log_format(
+      ProfilerConfig::CHROME_TRACE_EVENT);
+  RunDemuxInFlightGraph();
+  std::string trace;
+  MP_EXPECT_OK(file::GetContents(absl::StrCat(log_path, 0, ".json"), &trace));
+  EXPECT_THAT(trace, HasSubstr(R"("name":"FlowLimiterCalculator")"));
+  EXPECT_THAT(trace, HasSubstr(R"("cat":"PROCESS","ph":"X")"));
+  EXPECT_THAT(trace, HasSubstr(R"("name":"input_packets_0","cat":"packet")"));
+  EXPECT_THAT(trace, HasSubstr(R"("ph":"f","bp":"e")"));
+  EXPECT_FALSE(mediapipe::file::Exists(absl::StrCat(log_path, 0, ".binarypb"))
+                   .ok());
+}
+
 TEST_F(GraphTracerE2ETest, DemuxGraphLogFiles) {
   std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/log_files_");
   SetUpDemuxInFlightGraph();
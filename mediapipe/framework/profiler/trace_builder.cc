@@ -189,9 +189,10 @@ class TraceBuilder::Impl {
     return max_ts + 1;
   }
 
-  void CreateTrace(const TraceBuffer& buffer, absl::Time begin_time,
-                   absl::Time end_time, GraphTrace* result) {
-    // Snapshot recent TraceEvents
+  // Returns the TraceEvents between begin_time and end_time exclusive.
+  static std::vector<TraceEvent> Snapshot(const TraceBuffer& buffer,
+                                          absl::Time begin_time,
+                                          absl::Time end_time) {
     std::vector<TraceEvent> snapshot;
     snapshot.reserve(10000);
     TraceBuffer::iterator buffer_end = buffer.end();
@@ -201,6 +202,11 @@ class TraceBuilder::Impl {
         snapshot.push_back(event);
       }
     }
+    return snapshot;
+  }
+
+  void CreateTrace(const std::vector<TraceEvent>& snapshot,
+                   GraphTrace* result) {
     SetBaseTime(snapshot);
 
     // Index TraceEvents by task-id and stream-hop-id.
@@ -240,18 +246,7 @@ class TraceBuilder::Impl {
     }
   }
 
-  void CreateLog(const TraceBuffer& buffer, absl::Time begin_time,
-                 absl::Time end_time, GraphTrace* result) {
-    // Snapshot recent TraceEvents
-    std::vector<TraceEvent> snapshot;
-    snapshot.reserve(10000);
-    TraceBuffer::iterator buffer_end = buffer.end();
-    for (auto iter = buffer.begin(); iter < buffer_end; ++iter) {
-      TraceEvent event = *iter;
-      if (event.event_time >= begin_time && event.event_time < end_time) {
-        snapshot.push_back(event);
-      }
-    }
+  void CreateLog(const std::vector<TraceEvent>& snapshot, GraphTrace* result) {
     SetBaseTime(snapshot);
 
     // Log each TraceEvent.
@@ -414,11 +409,19 @@ Timestamp TraceBuilder::TimestampAfter(const TraceBuffer& buffer,
 }
 void TraceBuilder::CreateTrace(const TraceBuffer& buffer, absl::Time begin_time,
                                absl::Time end_time, GraphTrace* result) {
-  impl_->CreateTrace(buffer, begin_time, end_time, result);
+  impl_->CreateTrace(Impl::Snapshot(buffer, begin_time, end_time), result);
 }
 void TraceBuilder::CreateLog(const TraceBuffer& buffer, absl::Time begin_time,
                              absl::Time end_time, GraphTrace* result) {
-  impl_->CreateLog(buffer, begin_time, end_time, result);
+  impl_->CreateLog(Impl::Snapshot(buffer, begin_time, end_time), result);
+}
+void TraceBuilder::CreateTrace(const std::vector<TraceEvent>& snapshot,
+                               GraphTrace* result) {
+  impl_->CreateTrace(snapshot, result);
+}
+void TraceBuilder::CreateLog(const std::vector<TraceEvent>& snapshot,
+                             GraphTrace* result) {
+  impl_->CreateLog(snapshot, result);
 }
 void TraceBuilder::Clear() { impl_->Clear(); }
 
@@ -15,7 +15,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_BUILDER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_TRACE_BUILDER_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/profiler/trace_buffer.h"
@@ -43,6 +45,13 @@ class TraceBuilder {
   void CreateLog(const TraceBuffer& buffer, absl::Time begin_time,
                  absl::Time end_time, GraphTrace* result);
 
+  // Returns the graph of traces for a snapshot of TraceEvents.
+  void CreateTrace(const std::vector<TraceEvent>& snapshot,
+                   GraphTrace* result);
+
+  // Returns the trace events for a snapshot of TraceEvents.
+  void CreateLog(const std::vector<TraceEvent>& snapshot, GraphTrace* result);
+
   // Resets the TraceBuilder to begin building a new trace.
   void Clear();
 
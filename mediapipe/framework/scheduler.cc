@@ -83,6 +83,45 @@ void Scheduler::SetExecutor(Executor* executor) {
   default_queue_.SetExecutor(executor);
 }
 
+void Scheduler::SetNumQueueShards(int num_shards) {
+  ABSL_CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetNumQueueShards must not be called after the scheduler has started";
+  num_queue_shards_ = num_shards;
+  for (auto queue : scheduler_queues_) {
+    queue->SetNumShards(num_shards);
+  }
+}
+
+void Scheduler::SetOldestTimestampFirst(bool oldest_timestamp_first) {
+  ABSL_CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetOldestTimestampFirst must not be called after the scheduler has "
+         "started";
+  oldest_timestamp_first_ = oldest_timestamp_first;
+  for (auto queue : scheduler_queues_) {
+    queue->SetOldestTimestampFirst(oldest_timestamp_first);
+  }
+}
+
+void Scheduler::SetShardByNumaNode(bool shard_by_numa_node) {
+  ABSL_CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetShardByNumaNode must not be called after the scheduler has "
+         "started";
+  shard_by_numa_node_ = shard_by_numa_node;
+  for (auto queue : scheduler_queues_) {
+    queue->SetShardByNumaNode(shard_by_numa_node);
+  }
+}
+
+void Scheduler::SetInlineExecution(bool inline_execution) {
+  ABSL_CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetInlineExecution must not be called after the scheduler has "
+         "started";
+  inline_execution_ = inline_execution;
+  for (auto queue : scheduler_queues_) {
+    queue->SetInlineExecution(inline_execution);
+  }
+}
+
 // TODO: Consider renaming this method CreateNonDefaultQueue.
 absl::Status Scheduler::SetNonDefaultExecutor(const std::string& name,
                                               Executor* executor) {
@@ -99,6 +138,10 @@ absl::Status Scheduler::SetNonDefaultExecutor(const std::string& name,
   queue->SetIdleCallback(std::bind(&Scheduler::QueueIdleStateChanged, this,
                                    std::placeholders::_1));
   queue->SetExecutor(executor);
+  queue->SetNumShards(num_queue_shards_);
+  queue->SetOldestTimestampFirst(oldest_timestamp_first_);
+  queue->SetShardByNumaNode(shard_by_numa_node_);
+  queue->SetInlineExecution(inline_execution_);
   scheduler_queues_.push_back(queue);
   return absl::OkStatus();
 }
@@ -273,7 +316,11 @@ absl::Status Scheduler::WaitForObservedOutput() {
 
 absl::Status Scheduler::WaitUntilIdle() {
   RET_CHECK_NE(state_, STATE_NOT_STARTED);
-  ApplicationThreadAwait(std::bind(&Scheduler::IsIdle, this));
+  // A lambda capturing only "this" is stored inline by std::function, unlike
+  // the equivalent std::bind expression.
+  ApplicationThreadAwait([this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state_mutex_) {
+    return IsIdle();
+  });
   return absl::OkStatus();
 }
 
@@ -507,6 +554,15 @@ void Scheduler::Cancel() {
   SubmitWaitingTasksOnQueues();
 }
 
+absl::Status Scheduler::EndIdleRun() {
+  absl::MutexLock lock(&state_mutex_);
+  RET_CHECK_EQ(state_, STATE_RUNNING);
+  RET_CHECK(IsIdle() && handling_idle_ == 0 && app_thread_tasks_.empty())
+      << "The graph must be idle.";
+  Quit();
+  return absl::OkStatus();
+}
+
 bool Scheduler::IsPaused() {
   absl::MutexLock lock(&state_mutex_);
   return state_ == STATE_PAUSED;
@@ -27,6 +27,7 @@
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
+#include "mediapipe/framework/deps/ring_queue.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/scheduler_queue.h"
 #include "mediapipe/framework/scheduler_shared.h"
@@ -58,6 +59,26 @@ class Scheduler {
   absl::Status SetNonDefaultExecutor(const std::string& name,
                                      Executor* executor);
 
+  // Sets the number of shards of every scheduler queue, including queues
+  // created later by SetNonDefaultExecutor. Must be called before the
+  // scheduler is started. See SchedulerQueue::SetNumShards.
+  void SetNumQueueShards(int num_shards);
+
+  // Sets the ordering of ready nodes in every scheduler queue, including
+  // queues created later by SetNonDefaultExecutor. Must be called before the
+  // scheduler is started. See SchedulerQueue::SetOldestTimestampFirst.
+  void SetOldestTimestampFirst(bool oldest_timestamp_first);
+
+  // Sets the sharding of every scheduler queue by NUMA node, including queues
+  // created later by SetNonDefaultExecutor. Must be called before the
+  // scheduler is started. See SchedulerQueue::SetShardByNumaNode.
+  void SetShardByNumaNode(bool shard_by_numa_node);
+
+  // Enables or disables inline execution in every scheduler queue, including
+  // queues created later by SetNonDefaultExecutor. Must be called before the
+  // scheduler is started. See SchedulerQueue::SetInlineExecution.
+  void SetInlineExecution(bool inline_execution);
+
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
@@ -145,6 +166,10 @@ class Scheduler {
   // must also return true.
   void Cancel() ABSL_LOCKS_EXCLUDED(state_mutex_);
 
+  // Terminates a running scheduler that is idle, without waiting for the
+  // graph input streams to close.  Used by CalculatorGraph::ResetRun().
+  absl::Status EndIdleRun() ABSL_LOCKS_EXCLUDED(state_mutex_);
+
   // Returns true if scheduler is paused.
   bool IsPaused() ABSL_LOCKS_EXCLUDED(state_mutex_);
 
@@ -244,7 +269,8 @@ class Scheduler {
   // TODO: analyze call sites, split it up further.
   void HandleIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state_mutex_);
 
-  // Terminates the scheduler. Should only be called by HandleIdle.
+  // Terminates the scheduler. Should only be called by HandleIdle and
+  // EndIdleRun.
   void Quit() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state_mutex_);
 
   // Helper for the various Wait methods. Waits for the given condition,
@@ -266,6 +292,18 @@ class Scheduler {
   // Holds pointers to all queues used by the scheduler, for convenience.
   std::vector<SchedulerQueue*> scheduler_queues_;
 
+  // Number of shards of each scheduler queue. See SetNumQueueShards.
+  int num_queue_shards_ = 1;
+
+  // See SetOldestTimestampFirst.
+  bool oldest_timestamp_first_ = false;
+
+  // See SetShardByNumaNode.
+  bool shard_by_numa_node_ = false;
+
+  // See SetInlineExecution.
+  bool inline_execution_ = true;
+
   // Priority queue of source nodes ordered by layer and then source process
   // order. This stores the set of sources that are yet to be run.
   std::priority_queue<SchedulerQueue::Item> sources_queue_
@@ -303,7 +341,7 @@ class Scheduler {
   int non_idle_queue_count_ ABSL_GUARDED_BY(state_mutex_) = 0;
 
   // Tasks to be executed on the application thread.
-  std::deque<std::function<void()>> app_thread_tasks_
+  RingQueue<std::function<void()>> app_thread_tasks_
       ABSL_GUARDED_BY(state_mutex_);
 
   // Used by HandleIdle to avoid multiple concurrent executions.
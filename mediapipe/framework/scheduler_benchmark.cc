@@ -0,0 +1,82 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the scheduling cost of a packet hop between two calculators, for
+// different numbers of executor threads and scheduler queue shards.
+// $ bazel run -c opt mediapipe/framework:scheduler_benchmark
+
+#include <cstdint>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kChainLength = 1000;
+constexpr int kNumPackets = 100;
+
+// Builds a chain of kChainLength PassThroughCalculators reading from the graph
+// input stream "input".
+CalculatorGraphConfig MakeChainConfig(int num_threads, int num_shards) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.set_num_threads(num_threads);
+  config.set_scheduler_queue_shards(num_shards);
+  std::string input = "input";
+  for (int i = 0; i < kChainLength; ++i) {
+    const std::string output = absl::StrCat("hop", i);
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(input);
+    node->add_output_stream(output);
+    input = output;
+  }
+  return config;
+}
+
+// Arguments: number of executor threads, and number of scheduler queue shards.
+// Reports the mean time per hop, i.e. per packet per calculator.
+void BM_PassThroughChain(benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const int num_shards = state.range(1);
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(MakeChainConfig(num_threads, num_shards)));
+  for (auto _ : state) {
+    ABSL_CHECK_OK(graph.StartRun({}));
+    for (int i = 0; i < kNumPackets; ++i) {
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+  const int64_t num_hops = state.iterations() * kNumPackets * kChainLength;
+  state.SetItemsProcessed(num_hops);
+  state.counters["ns_per_hop"] = benchmark::Counter(
+      num_hops * 1e-9,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_PassThroughChain)
+    ->ArgsProduct({{1, 4, 16}, {1, 4, 16}})
+    ->ArgNames({"threads", "shards"})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -14,7 +14,10 @@
 
 #include "mediapipe/framework/scheduler_queue.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
 
@@ -25,6 +28,7 @@
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/cpu_util.h"
 
 #ifdef __APPLE__
 #define AUTORELEASEPOOL @autoreleasepool
@@ -35,7 +39,29 @@
 namespace mediapipe {
 namespace internal {
 
-SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
+namespace {
+
+// Returns a small number that is fixed for the calling thread. Threads use it
+// to pick the shard they add non-source nodes to and take nodes from first,
+// so that a node readied by a worker thread tends to run on the same thread.
+int ThreadIndex() {
+  static std::atomic<int> next_thread_index{0};
+  thread_local const int thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed) & 0xffff;
+  return thread_index;
+}
+
+// The queue whose task the calling thread is running, if any.
+thread_local const SchedulerQueue* current_queue = nullptr;
+// The number of nested inline node runs on the calling thread.
+thread_local int inline_depth = 0;
+// Bounds the stack depth used by chains of inline calculators.
+constexpr int kMaxInlineDepth = 8;
+
+}  // namespace
+
+SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc,
+                           bool oldest_timestamp_first)
     : node_(node), cc_(cc) {
   ABSL_CHECK(node);
   ABSL_CHECK(cc);
@@ -44,6 +70,8 @@ SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = node->SourceProcessOrder(cc).Value();
+  } else if (oldest_timestamp_first) {
+    input_timestamp_ = cc->InputTimestamp().Value();
   }
 }
 
@@ -82,30 +110,77 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   } else {
     // Non-sources run before sources.
     if (that.is_source_) return false;
+    // Newer timestamps run after older timestamps.
+    if (input_timestamp_ != that.input_timestamp_) {
+      return input_timestamp_ > that.input_timestamp_;
+    }
     // For non-sources, higher ids run before lower ids.
     return id_ < that.id_;
   }
 }
 
+SchedulerQueue::SchedulerQueue(SchedulerShared* shared) : shared_(shared) {
+  SetNumShards(1);
+}
+
 void SchedulerQueue::Reset() {
-  absl::MutexLock lock(&mutex_);
-  num_pending_tasks_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
 
-bool SchedulerQueue::IsIdle() {
-  VLOG(3) << "Scheduler queue empty: " << queue_.empty()
-          << ", # of pending tasks: " << num_pending_tasks_;
-  return queue_.empty() && num_pending_tasks_ == 0;
+void SchedulerQueue::SetNumShards(int num_shards) {
+  num_shards = std::max(num_shards, 1);
+  shards_.clear();
+  shards_.reserve(num_shards);
+  for (int i = 0; i < num_shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+void SchedulerQueue::SetShardByNumaNode(bool shard_by_numa_node) {
+  shard_by_numa_node_ = shard_by_numa_node && NumNumaNodes() > 1;
+  if (shard_by_numa_node_) {
+    SetNumShards(1 + NumNumaNodes());
+  }
+}
+
+int SchedulerQueue::PreferredShard() const {
+  return shard_by_numa_node_ ? CurrentNumaNode() : ThreadIndex();
+}
+
+SchedulerQueue::Shard& SchedulerQueue::ShardForItem(const Item& item) {
+  if (shards_.size() == 1 || item.IsSource()) {
+    return *shards_[0];
+  }
+  return *shards_[1 + PreferredShard() % (shards_.size() - 1)];
+}
+
+std::optional<SchedulerQueue::Item> SchedulerQueue::PopItem() {
+  const int num_shards = shards_.size();
+  const int first = num_shards == 1 ? 0 : PreferredShard() % (num_shards - 1);
+  for (int i = 0; i < num_shards; ++i) {
+    // Visit the non-source shards starting from the preferred one, and the
+    // source shard last.
+    Shard& shard =
+        i == num_shards - 1 ? *shards_[0]
+                            : *shards_[1 + (first + i) % (num_shards - 1)];
+    if (shard.size.load(std::memory_order_relaxed) == 0) continue;
+    absl::MutexLock lock(&shard.mutex);
+    if (shard.queue.empty()) continue;
+    Item item = shard.queue.top();
+    shard.queue.pop();
+    shard.size.fetch_sub(1, std::memory_order_relaxed);
+    return item;
+  }
+  return std::nullopt;
 }
 
 void SchedulerQueue::SetRunning(bool running) {
-  absl::MutexLock lock(&mutex_);
-  running_count_ += running ? 1 : -1;
-  ABSL_DCHECK_LE(running_count_, 1);
+  const int running_count = running_count_.fetch_add(running ? 1 : -1) +
+                            (running ? 1 : -1);
+  ABSL_DCHECK_LE(running_count, 1);
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -121,7 +196,19 @@ void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
     ABSL_CHECK(node->IsSource()) << node->DebugName();
     return;
   }
-  AddItemToQueue(Item(node, cc));
+  if (inline_execution_ && node->InlineExecution() && !node->IsSource() &&
+      current_queue == this && inline_depth < kMaxInlineDepth &&
+      running_count_.load() > 0) {
+    // The same check as for the queued nodes in RunNextTask().
+    ABSL_CHECK(!node->Closed())
+        << "Scheduled a node that was closed. This should not happen.";
+    VLOG(4) << "Running " << node->DebugName() << " inline.";
+    ++inline_depth;
+    RunCalculatorNode(node, cc);
+    --inline_depth;
+    return;
+  }
+  AddItemToQueue(Item(node, cc, oldest_timestamp_first_));
 }
 
 void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
@@ -133,53 +220,49 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
   const CalculatorNode* node = item.Node();
-  bool was_idle;
-  int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    queue_.push(item);
-    ++num_tasks_to_add_;
-    VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
-
-    // Now grab the tasks to execute while still holding the lock. This will
-    // gather any waiting tasks, in addition to the one we just added.
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
-  }
+  // Count the item before it becomes visible, so that it cannot be run and
+  // uncounted before it is counted.
+  const bool was_idle = num_active_items_.fetch_add(1) == 0;
   if (was_idle && idle_callback_) {
     // Became not idle.
     idle_callback_(false);
   }
+  {
+    Shard& shard = ShardForItem(item);
+    absl::MutexLock lock(&shard.mutex);
+    shard.queue.push(std::move(item));
+    shard.size.fetch_add(1, std::memory_order_relaxed);
+  }
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
+  num_tasks_to_add_.fetch_add(1);
+
+  // Grab the tasks to execute. This will gather any waiting tasks, in
+  // addition to the one we just added.
   // Note: this should be done after calling idle_callback_(false) above.
   // This ensures that we never get an idle_callback_(true) that is not
   // preceded by the corresponding idle_callback_(false). See the comments on
   // SetIdleCallback for details.
-  while (tasks_to_add > 0) {
-    executor_->AddTask(this);
-    --tasks_to_add;
+  if (running_count_.load() > 0) {
+    int tasks_to_add = GetTasksToSubmitToExecutor();
+    while (tasks_to_add > 0) {
+      executor_->AddTask(this);
+      --tasks_to_add;
+    }
   }
 }
 
 int SchedulerQueue::GetTasksToSubmitToExecutor() {
-  int tasks_to_add = num_tasks_to_add_;
-  num_tasks_to_add_ = 0;
-  num_pending_tasks_ += tasks_to_add;
-  return tasks_to_add;
+  return num_tasks_to_add_.exchange(0);
 }
 
 void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   // If a node is added to the scheduler queue while the queue is not running,
   // we do not immediately submit tasks to the executor. Here we check for any
   // such waiting tasks, and submit them.
-  int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
+  if (running_count_.load() <= 0) {
+    return;
   }
+  int tasks_to_add = GetTasksToSubmitToExecutor();
   while (tasks_to_add > 0) {
     executor_->AddTask(this);
     --tasks_to_add;
@@ -187,47 +270,42 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
 }
 
 void SchedulerQueue::RunNextTask() {
-  CalculatorNode* node;
-  CalculatorContext* calculator_context;
-  bool is_open_node;
-  {
-    absl::MutexLock lock(&mutex_);
-
-    ABSL_CHECK(!queue_.empty())
+  // Every task is submitted after its item was queued, so there is always an
+  // item for this task. With several shards, another task may take the item
+  // from the shard we are about to visit, but then the item belonging to that
+  // task is still queued somewhere, so we keep looking.
+  std::optional<Item> item = PopItem();
+  while (!item.has_value()) {
+    ABSL_CHECK_GT(shards_.size(), 1)
         << "Called RunNextTask when the queue is empty. "
            "This should not happen.";
-
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
-
-    ABSL_CHECK(!node->Closed())
-        << "Scheduled a node that was closed. This should not happen.";
+    item = PopItem();
   }
+  CalculatorNode* node = item->Node();
+  ABSL_CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
 
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
   // want to rely on executors setting up an autorelease pool for us (e.g.
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
+  const SchedulerQueue* const previous_queue = current_queue;
+  current_queue = this;
   AUTORELEASEPOOL {
-    if (is_open_node) {
-      ABSL_DCHECK(!calculator_context);
+    if (item->IsOpenNode()) {
+      ABSL_DCHECK(!item->Context());
       OpenCalculatorNode(node);
     } else {
-      RunCalculatorNode(node, calculator_context);
+      RunCalculatorNode(node, item->Context());
     }
   }
+  current_queue = previous_queue;
 
-  bool is_idle;
-  {
-    absl::MutexLock lock(&mutex_);
-    ABSL_DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
-  }
-  if (is_idle && idle_callback_) {
+  const int num_active_items = num_active_items_.fetch_sub(1) - 1;
+  ABSL_DCHECK_GE(num_active_items, 0);
+  VLOG(3) << "Scheduler queue active items: " << num_active_items;
+  if (num_active_items == 0 && idle_callback_) {
     // Became idle.
     idle_callback_(true);
   }
@@ -258,9 +336,11 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
   } else {
     // Note that we don't need a lock because only one thread can execute this
     // due to the lock on running_nodes.
-    int64_t start_time = shared_->timer.StartNode();
+    // An inline run is timed as part of the run of the node that readied it.
+    const bool timed = inline_depth == 0;
+    int64_t start_time = timed ? shared_->timer.StartNode() : 0;
     const absl::Status result = node->ProcessNode(cc);
-    shared_->timer.EndNode(start_time);
+    if (timed) shared_->timer.EndNode(start_time);
 
     if (!result.ok()) {
       if (result == tool::StatusStop()) {
@@ -297,18 +377,21 @@ void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
 }
 
 void SchedulerQueue::CleanupAfterRun() {
-  bool was_idle;
-  {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    ABSL_CHECK_EQ(num_pending_tasks_, 0);
-    ABSL_CHECK_EQ(num_tasks_to_add_, queue_.size());
-    num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
+  int num_queued_items = 0;
+  for (auto& shard : shards_) {
+    absl::MutexLock lock(&shard->mutex);
+    num_queued_items += shard->queue.size();
+    while (!shard->queue.empty()) {
+      shard->queue.pop();
     }
+    shard->size = 0;
   }
-  if (!was_idle && idle_callback_) {
+  // No task may be in flight at this point, so every active item is queued.
+  ABSL_CHECK_EQ(num_active_items_.load(), num_queued_items);
+  ABSL_CHECK_EQ(num_tasks_to_add_.load(), num_queued_items);
+  num_tasks_to_add_ = 0;
+  num_active_items_ = 0;
+  if (num_queued_items > 0 && idle_callback_) {
     // Became idle.
     idle_callback_(true);
   }
@@ -19,8 +19,10 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
@@ -35,6 +37,15 @@ class CalculatorNode;
 namespace internal {
 
 // Manages a priority queue of nodes to be run on the associated executor.
+//
+// By default all ready nodes are kept in a single priority queue, so nodes run
+// in strict priority order. SetNumShards() splits the ready queue into several
+// independently locked priority queues, so that many threads can add and take
+// ready nodes at the same time. Source nodes then get a shard of their own,
+// which is only consulted after the non-source shards; non-source nodes are
+// added to a shard chosen by the calling thread, and priority order is only
+// maintained within each shard. SetShardByNumaNode() instead gives every NUMA
+// node a shard of its own.
 class SchedulerQueue : public TaskQueue {
  public:
   // Callback to be invoked when the queue's idle state changes.
@@ -45,7 +56,10 @@ class SchedulerQueue : public TaskQueue {
   // Item in the queue. Wraps a node pointer and helps with priority sorting.
   class Item {
    public:
-    Item(CalculatorNode* node, CalculatorContext* cc);
+    // If oldest_timestamp_first is true, a non-source item is ordered by the
+    // input timestamp of cc before the node id.
+    Item(CalculatorNode* node, CalculatorContext* cc,
+         bool oldest_timestamp_first = false);
     // A null CalculatorContext indicates the task should run OpenNode().
     Item(CalculatorNode* node);
 
@@ -55,6 +69,8 @@ class SchedulerQueue : public TaskQueue {
 
     bool IsOpenNode() const { return is_open_node_; }
 
+    bool IsSource() const { return is_source_; }
+
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
@@ -63,11 +79,14 @@ class SchedulerQueue : public TaskQueue {
     //   Calculator::SourceProcessOrder (smaller values run first), then by
     //   node id: smaller ids run first, since they come earlier in the config.
     // - Non-sources are sorted by node id: larger ids run first, because they
-    //   are closer to the leaves.
+    //   are closer to the leaves.  With oldest_timestamp_first, non-sources
+    //   are first sorted by input timestamp: older timestamps run first.
     bool operator<(const Item& that) const;
 
    private:
     int64_t source_process_order_ = 0;
+    // The input timestamp with oldest_timestamp_first, and otherwise 0.
+    int64_t input_timestamp_ = 0;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
@@ -76,12 +95,41 @@ class SchedulerQueue : public TaskQueue {
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
-  explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
+  explicit SchedulerQueue(SchedulerShared* shared);
 
   // Sets the executor that will run the nodes. Must be called before the
   // scheduler is started.
   void SetExecutor(Executor* executor);
 
+  // Sets the number of shards of the ready queue. Values less than 2 keep a
+  // single queue. Must be called before the scheduler is started.
+  void SetNumShards(int num_shards);
+
+  // If true, ready non-source nodes processing older input timestamps run
+  // before those processing newer ones, so that the timestamps already in
+  // flight finish first.  Must be called before the scheduler is started.
+  void SetOldestTimestampFirst(bool oldest_timestamp_first) {
+    oldest_timestamp_first_ = oldest_timestamp_first;
+  }
+
+  // If true and the host has several NUMA nodes, the ready queue gets one
+  // non-source shard per NUMA node in place of the shards set by
+  // SetNumShards(). A non-source node readied by a thread is then added to the
+  // shard of the thread's NUMA node, and threads take nodes from the shard of
+  // their own NUMA node first, so that the calculators processing a timestamp
+  // tend to run on the NUMA node where its packets were produced. Must be
+  // called before the scheduler is started.
+  void SetShardByNumaNode(bool shard_by_numa_node);
+
+  // If true, AddNode() runs a non-source node that declared
+  // CalculatorContract::SetInlineExecution right away when it is called by a
+  // thread that is running a task of this queue, instead of queueing it. The
+  // inline run is nested in the run of the node that readied it, up to a
+  // small depth. Must be called before the scheduler is started.
+  void SetInlineExecution(bool inline_execution) {
+    inline_execution_ = inline_execution;
+  }
+
   // Sets the idle callback. It is called exactly once whenever the queue goes
   // from idle to active, or vice versa.
   // Note: if the queue is accessed by multiple threads, it is possible for
@@ -105,69 +153,93 @@ class SchedulerQueue : public TaskQueue {
   // NOTE: After calling SetRunning(true), the caller must call
   // SubmitWaitingTasksToExecutor since tasks may have been added while the
   // queue was not running.
-  void SetRunning(bool running) ABSL_LOCKS_EXCLUDED(mutex_);
-
-  // Gets the number of tasks that need to be submitted to the executor, and
-  // updates num_pending_tasks_. If this method is called and returns a
-  // non-zero value, the executor's AddTask method *must* be called for each
-  // task returned, but it can be called without holding the lock.
-  int GetTasksToSubmitToExecutor() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void SetRunning(bool running);
 
   // Submits tasks that are waiting (e.g. that were added while the queue was
   // not running) if the queue is running. The caller must not hold any mutex.
-  void SubmitWaitingTasksToExecutor() ABSL_LOCKS_EXCLUDED(mutex_);
+  void SubmitWaitingTasksToExecutor();
 
   // Adds a node and a calculator context to the scheduler queue if the node is
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
-  // not lost.
-  void AddNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  // not lost. May instead run the node inline, see SetInlineExecution.
+  void AddNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Adds a node to the scheduler queue for an OpenNode() call.
-  void AddNodeForOpen(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void AddNodeForOpen(CalculatorNode* node);
 
-  // Adds an Item to queue_.
+  // Adds an Item to one of the shards.
   void AddItemToQueue(Item&& item);
 
-  void CleanupAfterRun() ABSL_LOCKS_EXCLUDED(mutex_);
+  void CleanupAfterRun();
 
  private:
+  // One independently locked priority queue of ready nodes.
+  struct Shard {
+    absl::Mutex mutex;
+    std::priority_queue<Item> queue ABSL_GUARDED_BY(mutex);
+    // Mirrors queue.size(), so that empty shards can be skipped without
+    // taking their lock.
+    std::atomic<int> size{0};
+  };
+
+  // Gets the number of tasks that need to be submitted to the executor. If
+  // this method returns a non-zero value, the executor's AddTask method *must*
+  // be called for each task returned.
+  int GetTasksToSubmitToExecutor();
+
+  // Returns the shard that should hold "item".
+  Shard& ShardForItem(const Item& item);
+
+  // Returns a small number identifying the calling thread's preferred
+  // non-source shard, before reducing it modulo the number of such shards.
+  int PreferredShard() const;
+
+  // Removes and returns the highest priority item of the first non-empty
+  // shard, starting with the calling thread's preferred shard. Returns
+  // std::nullopt if all shards were empty.
+  std::optional<Item> PopItem();
+
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
   // by EndScheduling.
-  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
-  void OpenCalculatorNode(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
-
-  // Checks whether the queue has no queued nodes or pending tasks.
-  bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void OpenCalculatorNode(CalculatorNode* node);
 
   Executor* executor_ = nullptr;
 
   IdleCallback idle_callback_;
 
+  // See SetOldestTimestampFirst.
+  bool oldest_timestamp_first_ = false;
+
+  // See SetShardByNumaNode.
+  bool shard_by_numa_node_ = false;
+
+  // See SetInlineExecution.
+  bool inline_execution_ = true;
+
   // The net number of times SetRunning(true) has been called.
   // SetRunning(true) increments running_count_ and SetRunning(false)
   // decrements it. The queue is running if running_count_ > 0. A running
   // queue will submit tasks to the executor.
   // Invariant: running_count_ <= 1.
-  int running_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::atomic<int> running_count_{0};
 
-  // Number of tasks added to the Executor and not yet complete.
-  int num_pending_tasks_ ABSL_GUARDED_BY(mutex_);
+  // Number of items that are queued or whose task has not completed yet. The
+  // queue is idle when this is zero.
+  std::atomic<int> num_active_items_{0};
 
   // Number of tasks that need to be added to the Executor.
-  int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<int> num_tasks_to_add_{0};
 
-  // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
+  // Shards of the queue of nodes that need to be run. With more than one
+  // shard, shards_[0] holds the source nodes.
+  std::vector<std::unique_ptr<Shard>> shards_;
 
   SchedulerShared* const shared_;
-
-  absl::Mutex mutex_;
 };
 
 }  // namespace internal
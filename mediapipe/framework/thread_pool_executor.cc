@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <set>
 #include <utility>
 
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -59,6 +60,11 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
   if (options.has_thread_name_prefix()) {
     thread_options.set_name_prefix(options.thread_name_prefix());
   }
+  if (options.cpu_ids_size() > 0 && options.numa_node() >= 0) {
+    return absl::InvalidArgumentError(
+        "cpu_ids and numa_node in ThreadPoolExecutorOptions must not both be "
+        "specified.");
+  }
 #if defined(__linux__)
   switch (options.require_processor_performance()) {
     case ThreadPoolExecutorOptions::LOW:
@@ -70,7 +76,23 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
     default:
       break;
   }
+  if (options.cpu_ids_size() > 0) {
+    thread_options.set_cpu_set(
+        std::set<int>(options.cpu_ids().begin(), options.cpu_ids().end()));
+  }
+  if (options.numa_node() >= 0) {
+    std::set<int> cpu_set = NumaNodeCoreIds(options.numa_node());
+    if (cpu_set.empty()) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Could not find the processors of NUMA node "
+             << options.numa_node();
+    }
+    thread_options.set_cpu_set(cpu_set);
+  }
 #endif
+  if (options.enable_work_stealing()) {
+    return new WorkStealingExecutor(thread_options, options.num_threads());
+  }
   return new ThreadPoolExecutor(thread_options, options.num_threads());
 }
 
@@ -104,6 +126,26 @@ void ThreadPoolExecutor::Start() {
           << " threads.";
 }
 
+WorkStealingExecutor::WorkStealingExecutor(const ThreadOptions& thread_options,
+                                           int num_threads)
+    : thread_pool_(thread_options,
+                   thread_options.name_prefix().empty()
+                       ? "mediapipe"
+                       : thread_options.name_prefix(),
+                   num_threads) {
+  thread_pool_.StartWorkers();
+  VLOG(2) << "Started work-stealing thread pool with "
+          << thread_pool_.num_threads() << " threads.";
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  VLOG(2) << "Terminating work-stealing thread pool.";
+}
+
+void WorkStealingExecutor::Schedule(std::function<void()> task) {
+  thread_pool_.Schedule(std::move(task));
+}
+
 REGISTER_EXECUTOR(ThreadPoolExecutor);
 
 }  // namespace mediapipe
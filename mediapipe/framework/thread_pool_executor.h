@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
 
 #include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/port/threadpool.h"
@@ -58,6 +59,26 @@ class ThreadPoolExecutor : public Executor {
   size_t stack_size_ = 0;
 };
 
+// A multithreaded executor based on a work-stealing thread pool. Created by
+// ThreadPoolExecutor::Create() when ThreadPoolExecutorOptions has
+// enable_work_stealing set.
+class WorkStealingExecutor : public Executor {
+ public:
+  WorkStealingExecutor(const ThreadOptions& thread_options, int num_threads);
+  ~WorkStealingExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // For testing.
+  int num_threads() const { return thread_pool_.num_threads(); }
+  // Returns the thread stack size (in bytes).
+  size_t stack_size() const {
+    return thread_pool_.thread_options().stack_size();
+  }
+
+ private:
+  mediapipe::WorkStealingThreadPool thread_pool_;
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
@@ -0,0 +1,114 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures how graph throughput scales with the number of executor threads,
+// with and without work stealing.
+// $ bazel run -c opt mediapipe/framework:thread_pool_executor_benchmark
+
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumChains = 32;
+constexpr int kChainLength = 8;
+constexpr int kNumPackets = 200;
+
+// Adds one to its input after spinning for a short time, like the
+// SlowPlusOneCalculator in calculator_parallel_execution_test, but with a
+// much smaller cost so that scheduling overhead dominates.
+class BusyPlusOneCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const absl::Time end_time = absl::Now() + absl::Microseconds(5);
+    while (absl::Now() < end_time) {
+    }
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(BusyPlusOneCalculator);
+
+// Builds kNumChains independent chains of kChainLength calculators that all
+// read from the graph input stream "input".
+CalculatorGraphConfig MakeGraphConfig(int num_threads, bool work_stealing) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  ThreadPoolExecutorOptions* options =
+      config.add_executor()->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  options->set_num_threads(num_threads);
+  options->set_enable_work_stealing(work_stealing);
+  for (int chain = 0; chain < kNumChains; ++chain) {
+    std::string input = "input";
+    for (int i = 0; i < kChainLength; ++i) {
+      const std::string output = absl::StrCat("chain", chain, "_", i);
+      auto* node = config.add_node();
+      node->set_calculator("BusyPlusOneCalculator");
+      node->add_input_stream(input);
+      node->add_output_stream(output);
+      input = output;
+    }
+  }
+  return config;
+}
+
+// Arguments: number of executor threads, and whether work stealing is on.
+void BM_ParallelChains(benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const bool work_stealing = state.range(1) != 0;
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(MakeGraphConfig(num_threads, work_stealing)));
+  for (auto _ : state) {
+    ABSL_CHECK_OK(graph.StartRun({}));
+    for (int i = 0; i < kNumPackets; ++i) {
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * kNumChains *
+                          kChainLength);
+}
+BENCHMARK(BM_ParallelChains)
+    ->ArgsProduct({{1, 2, 4, 8, 16, 32}, {0, 1}})
+    ->ArgNames({"threads", "work_stealing"})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,284 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/calculator_fusion.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/legacy_calculator_support.h"
+#include "mediapipe/framework/port/proto_ns.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/name_util.h"
+#include "mediapipe/framework/tool/validate_name.h"
+
+namespace mediapipe {
+namespace tool {
+
+namespace {
+
+constexpr char kFusedCalculator[] = "FusedCalculator";
+constexpr char kDefaultInputStreamHandler[] = "DefaultInputStreamHandler";
+
+bool IsDefaultInputStreamHandler(const std::string& input_stream_handler) {
+  return input_stream_handler.empty() ||
+         input_stream_handler == kDefaultInputStreamHandler;
+}
+
+// Returns true if all stream and side packet names in "config" parse.
+bool HasValidNames(const CalculatorGraphConfig& config) {
+  std::string tag, name;
+  int index;
+  auto valid = [&](const proto_ns::RepeatedPtrField<ProtoString>& names) {
+    for (const auto& tag_index_name : names) {
+      if (!ParseTagIndexName(tag_index_name, &tag, &index, &name).ok()) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (const auto& node : config.node()) {
+    if (!valid(node.input_stream()) || !valid(node.output_stream()) ||
+        !valid(node.input_side_packet())) {
+      return false;
+    }
+  }
+  return valid(config.output_stream());
+}
+
+// Returns true if the calculator in "node" can run inside a FusedCalculator.
+// Nodes with errors are left alone, so that graph validation reports them.
+bool IsFusable(const CalculatorGraphConfig& config,
+               const CalculatorGraphConfig::Node& node) {
+  if (node.calculator() == kFusedCalculator || node.input_stream_size() == 0 ||
+      node.output_stream_size() == 0 || node.output_side_packet_size() > 0 ||
+      !node.executor().empty() || node.input_stream_info_size() > 0 ||
+      node.max_in_flight() > 1 || node.has_output_stream_handler()) {
+    return false;
+  }
+  const auto& input_stream_handler = node.has_input_stream_handler()
+                                         ? node.input_stream_handler()
+                                         : config.input_stream_handler();
+  if (!IsDefaultInputStreamHandler(
+          input_stream_handler.input_stream_handler())) {
+    return false;
+  }
+  auto contract = GetCalculatorContract(node, config.package());
+  if (!contract.ok()) {
+    return false;
+  }
+  const CalculatorContract& cc = **contract;
+  return cc.GetFusable() && cc.GetInlineExecution() &&
+         cc.GetTimestampOffset() == TimestampDiff(0) &&
+         !cc.GetProcessTimestampBounds() && cc.GetMaxBatchSize() <= 1 &&
+         cc.ServiceRequests().empty() &&
+         IsDefaultInputStreamHandler(cc.GetInputStreamHandler());
+}
+
+// Returns the nodes of a fused group, so that each node follows the nodes
+// producing its input streams.
+std::vector<int> SortGroup(const CalculatorGraphConfig& config,
+                           const std::vector<int>& group,
+                           const std::map<std::string, int>& producers) {
+  const std::set<int> members(group.begin(), group.end());
+  std::set<int> sorted_members;
+  std::vector<int> sorted;
+  while (sorted.size() < group.size()) {
+    for (int node_id : group) {
+      if (sorted_members.count(node_id)) continue;
+      bool ready = true;
+      for (const auto& stream : config.node(node_id).input_stream()) {
+        auto it = producers.find(ParseNameFromStream(stream));
+        if (it != producers.end() && members.count(it->second) &&
+            !sorted_members.count(it->second)) {
+          ready = false;
+          break;
+        }
+      }
+      if (ready) {
+        sorted_members.insert(node_id);
+        sorted.push_back(node_id);
+      }
+    }
+  }
+  return sorted;
+}
+
+// Returns the FusedCalculator node for the given sorted group.  Its input
+// streams and side packets are those of the members that are not produced
+// within the group, and its output streams are those of the last member.
+CalculatorGraphConfig::Node MakeFusedNode(const CalculatorGraphConfig& config,
+                                          const std::vector<int>& group) {
+  CalculatorGraphConfig::Node fused_node;
+  fused_node.set_calculator(kFusedCalculator);
+  auto* options = fused_node.mutable_options()->MutableExtension(
+      FusedCalculatorOptions::ext);
+  options->set_package(config.package());
+
+  std::set<std::string> internal_streams;
+  std::set<std::string> fused_inputs;
+  std::set<std::string> fused_side_packets;
+  std::vector<std::string> names;
+  for (int node_id : group) {
+    const CalculatorGraphConfig::Node& node = config.node(node_id);
+    for (const auto& stream : node.input_stream()) {
+      const std::string name = ParseNameFromStream(stream);
+      if (!internal_streams.count(name) && fused_inputs.insert(name).second) {
+        const int index = fused_inputs.size() - 1;
+        fused_node.add_input_stream(CatStream({"IN", index}, name));
+      }
+    }
+    for (const auto& side_packet : node.input_side_packet()) {
+      const std::string name = ParseNameFromStream(side_packet);
+      if (fused_side_packets.insert(name).second) {
+        const int index = fused_side_packets.size() - 1;
+        fused_node.add_input_side_packet(CatStream({"SIDE", index}, name));
+      }
+    }
+    for (const auto& stream : node.output_stream()) {
+      internal_streams.insert(ParseNameFromStream(stream));
+    }
+    CalculatorGraphConfig::Node* member = options->add_node();
+    *member = node;
+    member->set_name(CanonicalNodeName(config, node_id));
+    names.push_back(member->name());
+  }
+  const CalculatorGraphConfig::Node& last = config.node(group.back());
+  for (int i = 0; i < last.output_stream_size(); ++i) {
+    fused_node.add_output_stream(
+        CatStream({"OUT", i}, ParseNameFromStream(last.output_stream(i))));
+  }
+  fused_node.set_name(absl::StrJoin(names, "+"));
+  return fused_node;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<CalculatorContract>> GetCalculatorContract(
+    const CalculatorGraphConfig::Node& node, const std::string& package) {
+  auto contract = std::make_unique<CalculatorContract>();
+  MP_RETURN_IF_ERROR(contract->Initialize(node));
+  LegacyCalculatorSupport::Scoped<CalculatorContract> s(contract.get());
+  MP_ASSIGN_OR_RETURN(
+      auto calculator_factory,
+      CalculatorBaseRegistry::CreateByNameInNamespace(package,
+                                                      node.calculator()),
+      _ << "Unable to find Calculator \"" << node.calculator() << "\"");
+  MP_RETURN_IF_ERROR(calculator_factory->GetContract(contract.get()))
+          .SetPrepend()
+      << node.calculator() << ": ";
+  return contract;
+}
+
+absl::Status FuseCalculators(CalculatorGraphConfig* config) {
+  // Invalid graphs are left unchanged, for graph validation to report.
+  if (!HasValidNames(*config)) {
+    return absl::OkStatus();
+  }
+  const int num_nodes = config->node_size();
+  std::map<std::string, int> producers;
+  std::map<std::string, std::set<int>> consumers;
+  for (int i = 0; i < num_nodes; ++i) {
+    for (const auto& stream : config->node(i).output_stream()) {
+      producers[ParseNameFromStream(stream)] = i;
+    }
+    for (const auto& stream : config->node(i).input_stream()) {
+      consumers[ParseNameFromStream(stream)].insert(i);
+    }
+  }
+  std::set<std::string> graph_outputs;
+  for (const auto& stream : config->output_stream()) {
+    graph_outputs.insert(ParseNameFromStream(stream));
+  }
+  std::vector<bool> fusable(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    fusable[i] = IsFusable(*config, config->node(i));
+  }
+
+  // A fusable node is merged into its successor: the fusable node consuming
+  // all of its consumed output streams.  Since each node has at most one
+  // successor, the groups are trees leading to the node whose outputs leave
+  // the group.
+  std::vector<int> successor(num_nodes, -1);
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!fusable[i]) continue;
+    int next = -1;
+    bool single_consumer = true;
+    for (const auto& stream : config->node(i).output_stream()) {
+      const std::string name = ParseNameFromStream(stream);
+      if (graph_outputs.count(name)) {
+        single_consumer = false;
+        break;
+      }
+      for (int consumer : consumers[name]) {
+        if (next != -1 && consumer != next) single_consumer = false;
+        next = consumer;
+      }
+    }
+    if (single_consumer && next != -1 && next != i && fusable[next]) {
+      successor[i] = next;
+    }
+  }
+  std::map<int, std::vector<int>> groups;
+  for (int i = 0; i < num_nodes; ++i) {
+    int root = i;
+    int steps = 0;
+    while (successor[root] != -1 && steps <= num_nodes) {
+      root = successor[root];
+      ++steps;
+    }
+    // A cycle of successors needs back edges, which are never fused.
+    RET_CHECK_LE(steps, num_nodes);
+    groups[root].push_back(i);
+  }
+
+  std::vector<CalculatorGraphConfig::Node> fused_nodes(num_nodes);
+  std::vector<bool> removed(num_nodes);
+  bool changed = false;
+  for (const auto& [root, group] : groups) {
+    if (group.size() < 2) continue;
+    fused_nodes[root] =
+        MakeFusedNode(*config, SortGroup(*config, group, producers));
+    for (int node_id : group) {
+      removed[node_id] = node_id != root;
+    }
+    changed = true;
+  }
+  if (!changed) {
+    return absl::OkStatus();
+  }
+  proto_ns::RepeatedPtrField<CalculatorGraphConfig::Node> nodes;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (removed[i]) continue;
+    if (fused_nodes[i].calculator().empty()) {
+      *nodes.Add() = std::move(*config->mutable_node(i));
+    } else {
+      *nodes.Add() = std::move(fused_nodes[i]);
+    }
+  }
+  config->mutable_node()->Swap(&nodes);
+  return absl::OkStatus();
+}
+
+}  // namespace tool
+}  // namespace mediapipe
@@ -0,0 +1,67 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_contract.h"
+
+namespace mediapipe {
+namespace tool {
+
+// Replaces groups of small calculator nodes with single FusedCalculator nodes.
+//
+// Graphs built from stream utilities, such as those in
+// mediapipe/framework/api2/stream, contain chains of nodes that each do very
+// little work per timestamp.  Every intermediate stream of such a chain costs
+// a packet queue, a scheduling round trip, and timestamp bound propagation.
+// A FusedCalculator runs the calculators of a chain one after another within
+// a single Process() call, and passes packets between them directly.
+//
+// A node can be fused if its calculator declares
+// CalculatorContract::SetFusable, SetInlineExecution and SetTimestampOffset(0),
+// does not set ProcessTimestampBounds, a max batch size, graph services, or a
+// custom input stream handler, and the node has no output side packets,
+// executor, output stream handler, back edges or max_in_flight.  Inline
+// execution alone is not enough, since a fused calculator cannot output
+// packets from Open() or at other timestamps than its input.  A fusable node is
+// merged with the fusable node consuming its output streams, provided that
+// node is the only consumer and none of the streams is a graph output
+// stream.  The resulting FusedCalculator is named after the original nodes,
+// joined with "+", and each original calculator keeps its own node name for
+// counters and error messages.
+//
+// Streams internal to a fused group disappear from the graph, so they can no
+// longer be observed with CalculatorGraph::ObserveOutputStream.  Listing a
+// stream in CalculatorGraphConfig::output_stream keeps it.
+//
+// Enabled by CalculatorGraphConfig::fuse_calculators, which makes
+// ValidatedGraphConfig run this pass after subgraph expansion.
+absl::Status FuseCalculators(CalculatorGraphConfig* config);
+
+// Returns the contract of the calculator in "node", which must outlive the
+// returned contract.
+absl::StatusOr<std::unique_ptr<CalculatorContract>> GetCalculatorContract(
+    const CalculatorGraphConfig::Node& node, const std::string& package);
+
+}  // namespace tool
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_CALCULATOR_FUSION_H_
@@ -0,0 +1,357 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/calculator_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+// Adds one to its input.
+class InlineAddOneCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetInlineExecution(true);
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(*kIn(cc) + 1);
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InlineAddOneCalculator);
+
+// Passes on its input if it is even.
+class InlineEvenFilterCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetInlineExecution(true);
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (*kIn(cc) % 2 == 0) {
+      kOut(cc).Send(*kIn(cc));
+    }
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InlineEvenFilterCalculator);
+
+// Outputs the sum of its present inputs.
+class InlineSumCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kA{"A"};
+  static constexpr api2::Input<int> kB{"B"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kA, kB, kOut);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetInlineExecution(true);
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    int sum = 0;
+    if (!kA(cc).IsEmpty()) sum += *kA(cc);
+    if (!kB(cc).IsEmpty()) sum += *kB(cc);
+    kOut(cc).Send(sum);
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InlineSumCalculator);
+
+// Adds one to its input, without declaring inline execution.
+class AddOneCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(*kIn(cc) + 1);
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(AddOneCalculator);
+
+// Outputs its first input in Open() and then passes on its inputs. Runs
+// inline, but cannot be fused.
+class InlineOpenOutputCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetInlineExecution(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    kOut(cc).Send(0, Timestamp::PreStream());
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(*kIn(cc));
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InlineOpenOutputCalculator);
+
+// Fails on every input.
+class InlineFailingCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    cc->SetInlineExecution(true);
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    return absl::InternalError("expected failure");
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InlineFailingCalculator);
+
+// Sends the values at timestamps 0, 1, 2, ... and returns the outputs.
+absl::StatusOr<std::vector<int>> RunGraph(CalculatorGraphConfig config,
+                                          const std::vector<int>& values) {
+  std::vector<int> outputs;
+  CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream("out", [&](const Packet& p) {
+    outputs.push_back(p.Get<int>());
+    return absl::OkStatus();
+  }));
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+  for (int i = 0; i < values.size(); ++i) {
+    MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(values[i]).At(Timestamp(i))));
+  }
+  MP_RETURN_IF_ERROR(graph.CloseAllInputStreams());
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+  return outputs;
+}
+
+TEST(CalculatorFusionTest, FusesChain) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      name: "first"
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:a"
+    }
+    node {
+      name: "second"
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:b"
+    }
+    node {
+      name: "third"
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:b"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+
+  ASSERT_EQ(config.node_size(), 1);
+  const CalculatorGraphConfig::Node& node = config.node(0);
+  EXPECT_EQ(node.name(), "first+second+third");
+  EXPECT_EQ(node.calculator(), "FusedCalculator");
+  EXPECT_THAT(node.input_stream(), ElementsAre("IN:0:in"));
+  EXPECT_THAT(node.output_stream(), ElementsAre("OUT:0:out"));
+  const auto& options =
+      node.options().GetExtension(FusedCalculatorOptions::ext);
+  ASSERT_EQ(options.node_size(), 3);
+  EXPECT_EQ(options.node(0).name(), "first");
+  EXPECT_EQ(options.node(2).name(), "third");
+
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs, RunGraph(config, {1, 2, 3}));
+  EXPECT_THAT(outputs, ElementsAre(4, 5, 6));
+}
+
+TEST(CalculatorFusionTest, KeepsSharedAndObservedStreams) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    output_stream: "b"
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:a"
+    }
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:b"
+    }
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:c"
+    }
+    node {
+      calculator: "InlineSumCalculator"
+      input_stream: "A:b"
+      input_stream: "B:c"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  const CalculatorGraphConfig original = config;
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+
+  // "a" has two consumers and "b" is a graph output, so only the node
+  // producing "c" is fused with the sum.
+  ASSERT_EQ(config.node_size(), 3);
+  EXPECT_EQ(config.node(2).calculator(), "FusedCalculator");
+  EXPECT_EQ(config.node(2).name(),
+            "InlineAddOneCalculator_3+InlineSumCalculator");
+  EXPECT_THAT(config.node(2).input_stream(), ElementsAre("IN:0:a", "IN:1:b"));
+
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs, RunGraph(config, {1, 2}));
+  MP_ASSERT_OK_AND_ASSIGN(auto expected, RunGraph(original, {1, 2}));
+  EXPECT_THAT(outputs, ElementsAre(6, 8));
+  EXPECT_EQ(outputs, expected);
+}
+
+TEST(CalculatorFusionTest, SkipsCalculatorsWithoutInlineExecution) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:a"
+    }
+    node {
+      calculator: "AddOneCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  const CalculatorGraphConfig original = config;
+  MP_ASSERT_OK(tool::FuseCalculators(&config));
+  EXPECT_THAT(config, EqualsProto(original));
+}
+
+TEST(CalculatorFusionTest, SkipsCalculatorsNotDeclaredFusable) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    fuse_calculators: true
+    node {
+      calculator: "InlineOpenOutputCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:a"
+    }
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  CalculatorGraphConfig fused = config;
+  MP_ASSERT_OK(tool::FuseCalculators(&fused));
+  EXPECT_THAT(fused, EqualsProto(config));
+
+  // The packet output in Open() reaches the next node.
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs, RunGraph(config, {1, 2}));
+  EXPECT_THAT(outputs, ElementsAre(1, 2, 3));
+}
+
+TEST(CalculatorFusionTest, RunsNodesWithAnyInput) {
+  // The sum runs when the filter drops its input, since "in" is present.
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    fuse_calculators: true
+    node {
+      calculator: "InlineEvenFilterCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:even"
+    }
+    node {
+      calculator: "InlineSumCalculator"
+      input_stream: "A:even"
+      input_stream: "B:in"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs, RunGraph(config, {1, 2, 3, 4}));
+  EXPECT_THAT(outputs, ElementsAre(1, 4, 3, 8));
+}
+
+TEST(CalculatorFusionTest, ReportsErrorsWithOriginalNodeName) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    fuse_calculators: true
+    node {
+      calculator: "InlineAddOneCalculator"
+      input_stream: "IN:in"
+      output_stream: "OUT:a"
+    }
+    node {
+      name: "failing"
+      calculator: "InlineFailingCalculator"
+      input_stream: "IN:a"
+      output_stream: "OUT:out"
+    }
+  )pb");
+  auto outputs = RunGraph(config, {1});
+  ASSERT_FALSE(outputs.ok());
+  EXPECT_THAT(outputs.status().message(), HasSubstr("node \"failing\""));
+  EXPECT_THAT(outputs.status().message(), HasSubstr("expected failure"));
+}
+
+}  // namespace
+}  // namespace mediapipe
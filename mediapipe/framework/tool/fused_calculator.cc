@@ -0,0 +1,425 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/fused_calculator.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/calculator_registry.h"
+#include "mediapipe/framework/calculator_state.h"
+#include "mediapipe/framework/collection_item_id.h"
+#include "mediapipe/framework/input_stream_shard.h"
+#include "mediapipe/framework/legacy_calculator_support.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet_set.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/source_location.h"
+#include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/calculator_fusion.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/tag_map.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The stream ports of the member calculators, used to express the stream
+// types of the FusedCalculator in terms of its own ports.
+struct MemberPorts {
+  // The stream read by each member input port.
+  absl::flat_hash_map<const PacketType*, std::string> input_streams;
+  // The member output port producing each stream.
+  std::map<std::string, const PacketType*> producers;
+  // The FusedCalculator input port of each stream from outside.
+  std::map<std::string, PacketType*> fused_inputs;
+};
+
+// Sets "type" to the type of the member port "port".  "Same as" references to
+// member input ports become references to the FusedCalculator input port, or
+// to the type of the member output port, feeding them.
+void ResolveType(const MemberPorts& ports, const PacketType& port,
+                 PacketType* type) {
+  const PacketType* root = port.GetSameAs();
+  auto stream = ports.input_streams.find(root);
+  if (stream != ports.input_streams.end()) {
+    auto fused_input = ports.fused_inputs.find(stream->second);
+    if (fused_input != ports.fused_inputs.end()) {
+      type->SetSameAs(fused_input->second);
+      return;
+    }
+    auto producer = ports.producers.find(stream->second);
+    if (producer != ports.producers.end()) {
+      ResolveType(ports, *producer->second, type);
+      return;
+    }
+  }
+  *type = *root;
+}
+
+// Returns the id of each stream or side packet name in "tag_map".
+std::map<std::string, CollectionItemId> IdsByName(
+    const tool::TagMap& tag_map) {
+  std::map<std::string, CollectionItemId> ids;
+  for (CollectionItemId id = tag_map.BeginId(); id < tag_map.EndId(); ++id) {
+    ids.emplace(tag_map.Names()[id.value()], id);
+  }
+  return ids;
+}
+
+}  // namespace
+
+struct FusedCalculator::Member {
+  std::unique_ptr<CalculatorContract> contract;
+  std::unique_ptr<CalculatorState> state;
+  std::unique_ptr<PacketSet> input_side_packets;
+  // Referenced by the output stream shards of context.
+  std::vector<OutputStreamSpec> output_specs;
+  std::unique_ptr<CalculatorContext> context;
+  std::unique_ptr<CalculatorBase> calculator;
+  // The index in packets_ of each input and output stream.
+  std::vector<int> input_slots;
+  std::vector<int> output_slots;
+  // The FusedCalculator output of each output stream, or an invalid id.
+  std::vector<CollectionItemId> fused_outputs;
+  // The first error reported by the output stream shards.
+  absl::Status output_status;
+};
+
+FusedCalculator::FusedCalculator() = default;
+
+FusedCalculator::~FusedCalculator() = default;
+
+absl::Status FusedCalculator::GetContract(CalculatorContract* cc) {
+  const auto& options = cc->Options<FusedCalculatorOptions>();
+  RET_CHECK_GT(options.node_size(), 0);
+  const auto input_ids = IdsByName(*cc->Inputs().TagMap());
+  const auto side_packet_ids =
+      IdsByName(*cc->InputSidePackets().TagMap());
+  std::vector<std::unique_ptr<CalculatorContract>> contracts;
+  MemberPorts ports;
+  // The member input ports reading each input of the FusedCalculator.
+  std::map<std::string, std::vector<const PacketType*>> consumers;
+  for (const auto& node : options.node()) {
+    MP_ASSIGN_OR_RETURN(auto contract,
+                        tool::GetCalculatorContract(node, options.package()));
+    const auto& inputs = contract->Inputs();
+    for (CollectionItemId id = inputs.BeginId(); id < inputs.EndId(); ++id) {
+      const std::string& name = inputs.TagMap()->Names()[id.value()];
+      ports.input_streams[&inputs.Get(id)] = name;
+      auto producer = ports.producers.find(name);
+      if (producer != ports.producers.end()) {
+        RET_CHECK(inputs.Get(id).IsConsistentWith(*producer->second))
+            << "Input stream \"" << name << "\" of node \"" << node.name()
+            << "\" expects " << inputs.Get(id).DebugTypeName() << " but gets "
+            << producer->second->DebugTypeName();
+      } else {
+        RET_CHECK(input_ids.count(name))
+            << "Missing input stream \"" << name << "\" for node \""
+            << node.name() << "\"";
+        consumers[name].push_back(&inputs.Get(id));
+      }
+    }
+    const auto& outputs = contract->Outputs();
+    for (CollectionItemId id = outputs.BeginId(); id < outputs.EndId(); ++id) {
+      ports.producers[outputs.TagMap()->Names()[id.value()]] = &outputs.Get(id);
+    }
+    const auto& side_packets = contract->InputSidePackets();
+    for (CollectionItemId id = side_packets.BeginId();
+         id < side_packets.EndId(); ++id) {
+      const std::string& name = side_packets.TagMap()->Names()[id.value()];
+      auto fused_id = side_packet_ids.find(name);
+      RET_CHECK(fused_id != side_packet_ids.end())
+          << "Missing input side packet \"" << name << "\" for node \""
+          << node.name() << "\"";
+      PacketType& type = cc->InputSidePackets().Get(fused_id->second);
+      if (!type.IsInitialized() || type.IsAny()) {
+        type = *side_packets.Get(id).GetSameAs();
+      }
+    }
+    contracts.push_back(std::move(contract));
+  }
+
+  // Each input takes the type expected by its first member port with a type
+  // of its own, and the other member ports must accept that type.
+  for (const auto& [name, id] : input_ids) {
+    PacketType& type = cc->Inputs().Get(id);
+    type.SetAny();
+    for (const PacketType* port : consumers[name]) {
+      const PacketType* root = port->GetSameAs();
+      auto stream = ports.input_streams.find(root);
+      if (!root->IsAny() && (stream == ports.input_streams.end() ||
+                             stream->second == name)) {
+        type = *root;
+        break;
+      }
+    }
+    for (const PacketType* port : consumers[name]) {
+      RET_CHECK(port->IsConsistentWith(type))
+          << "Input stream \"" << name << "\" has inconsistent types "
+          << port->DebugTypeName() << " and " << type.DebugTypeName();
+    }
+    ports.fused_inputs[name] = &type;
+  }
+  const auto output_ids = IdsByName(*cc->Outputs().TagMap());
+  for (const auto& [name, id] : output_ids) {
+    auto producer = ports.producers.find(name);
+    RET_CHECK(producer != ports.producers.end())
+        << "Output stream \"" << name << "\" is not produced by any node.";
+    ResolveType(ports, *producer->second, &cc->Outputs().Get(id));
+  }
+  cc->SetTimestampOffset(0);
+  cc->SetInlineExecution(true);
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Open(CalculatorContext* cc) {
+  const auto& options = cc->Options<FusedCalculatorOptions>();
+  // The index in packets_ and the header of each stream.
+  std::map<std::string, int> slots;
+  std::vector<Packet> headers;
+  const auto& input_names = cc->Inputs().TagMap()->Names();
+  for (CollectionItemId id = cc->Inputs().BeginId(); id < cc->Inputs().EndId();
+       ++id) {
+    slots[input_names[id.value()]] = headers.size();
+    input_slots_.push_back(headers.size());
+    headers.push_back(cc->Inputs().Get(id).Header());
+  }
+  const auto side_packet_ids =
+      IdsByName(*cc->InputSidePackets().TagMap());
+  const auto output_ids = IdsByName(*cc->Outputs().TagMap());
+
+  for (const auto& node : options.node()) {
+    auto member = std::make_unique<Member>();
+    MP_ASSIGN_OR_RETURN(member->contract,
+                        tool::GetCalculatorContract(node, options.package()));
+    const CalculatorContract& contract = *member->contract;
+    member->state = std::make_unique<CalculatorState>(
+        node.name(), cc->NodeId(), node.calculator(), node,
+        cc->calculator_state_->GetSharedProfilingContext(),
+        cc->GetSharedGraphServiceManager());
+    member->state->SetCounterFactory(cc->GetCounterFactory());
+    member->input_side_packets =
+        std::make_unique<PacketSet>(contract.InputSidePackets().TagMap());
+    for (CollectionItemId id = member->input_side_packets->BeginId();
+         id < member->input_side_packets->EndId(); ++id) {
+      const std::string& name =
+          contract.InputSidePackets().TagMap()->Names()[id.value()];
+      member->input_side_packets->Get(id) =
+          cc->InputSidePackets().Get(side_packet_ids.at(name));
+    }
+    member->state->SetInputSidePackets(member->input_side_packets.get());
+    member->context = std::make_unique<CalculatorContext>(
+        member->state.get(), contract.Inputs().TagMap(),
+        contract.Outputs().TagMap());
+    CalculatorContext* context = member->context.get();
+
+    const auto& member_input_names = contract.Inputs().TagMap()->Names();
+    for (CollectionItemId id = context->Inputs().BeginId();
+         id < context->Inputs().EndId(); ++id) {
+      const std::string& name = member_input_names[id.value()];
+      auto slot = slots.find(name);
+      RET_CHECK(slot != slots.end());
+      member->input_slots.push_back(slot->second);
+      context->Inputs().Get(id).SetName(&name);
+      context->Inputs().Get(id).SetHeader(headers[slot->second]);
+    }
+    const auto& member_output_names = contract.Outputs().TagMap()->Names();
+    member->output_specs.resize(context->Outputs().NumEntries());
+    for (CollectionItemId id = context->Outputs().BeginId();
+         id < context->Outputs().EndId(); ++id) {
+      const std::string& name = member_output_names[id.value()];
+      OutputStreamSpec& spec = member->output_specs[id.value()];
+      spec.name = name;
+      spec.packet_type = &contract.Outputs().Get(id);
+      spec.error_callback = [member = member.get()](absl::Status status) {
+        member->output_status.Update(status);
+      };
+      spec.locked_intro_data = false;
+      spec.offset_enabled = false;
+      context->Outputs().Get(id).SetSpec(&spec);
+      slots[name] = headers.size();
+      member->output_slots.push_back(headers.size());
+      headers.emplace_back();
+      auto output_id = output_ids.find(name);
+      member->fused_outputs.push_back(output_id != output_ids.end()
+                                          ? output_id->second
+                                          : CollectionItemId::GetInvalid());
+    }
+
+    MP_ASSIGN_OR_RETURN(auto factory,
+                        CalculatorBaseRegistry::CreateByNameInNamespace(
+                            options.package(), node.calculator()));
+    member->calculator = factory->CreateCalculator(context);
+    context->PushInputTimestamp(Timestamp::Unstarted());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = member->calculator->Open(context);
+    }
+    context->PopInputTimestamp();
+    status.Update(member->output_status);
+    MP_RETURN_IF_ERROR(status).SetPrepend() << absl::Substitute(
+        "Calculator::Open() for node \"$0\" failed: ", node.name());
+
+    for (CollectionItemId id = context->Outputs().BeginId();
+         id < context->Outputs().EndId(); ++id) {
+      RET_CHECK(context->Outputs().Get(id).IsEmpty())
+          << "Node \"" << node.name()
+          << "\" cannot output packets in Open() when fused.";
+      OutputStreamSpec& spec = member->output_specs[id.value()];
+      spec.locked_intro_data = true;
+      headers[member->output_slots[id.value()]] = spec.header;
+      const CollectionItemId output_id = member->fused_outputs[id.value()];
+      if (output_id.IsValid() && !spec.header.IsEmpty()) {
+        cc->Outputs().Get(output_id).SetHeader(spec.header);
+      }
+    }
+    members_.push_back(std::move(member));
+  }
+  packets_.resize(headers.size());
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Process(CalculatorContext* cc) {
+  for (CollectionItemId id = cc->Inputs().BeginId(); id < cc->Inputs().EndId();
+       ++id) {
+    packets_[input_slots_[id.value()]] = cc->Inputs().Get(id).Value();
+  }
+  absl::Status status;
+  for (auto& member : members_) {
+    status = ProcessMember(*member, cc->InputTimestamp(), cc);
+    if (!status.ok()) break;
+  }
+  for (Packet& packet : packets_) {
+    packet = Packet();
+  }
+  return status;
+}
+
+absl::Status FusedCalculator::ProcessMember(Member& member,
+                                            Timestamp input_timestamp,
+                                            CalculatorContext* cc) {
+  bool has_input = false;
+  for (int slot : member.input_slots) {
+    has_input = has_input || !packets_[slot].IsEmpty();
+  }
+  if (!has_input) {
+    return absl::OkStatus();
+  }
+  CalculatorContext* context = member.context.get();
+  InputStreamShardSet& inputs = context->Inputs();
+  for (CollectionItemId id = inputs.BeginId(); id < inputs.EndId(); ++id) {
+    Packet packet = packets_[member.input_slots[id.value()]];
+    inputs.Get(id).AddPacket(std::move(packet), /*is_done=*/false);
+  }
+  context->PushInputTimestamp(input_timestamp);
+  absl::Status status;
+  {
+    LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+    status = member.calculator->Process(context);
+  }
+  context->PopInputTimestamp();
+  for (CollectionItemId id = inputs.BeginId(); id < inputs.EndId(); ++id) {
+    inputs.Get(id).ClearCurrentPacket();
+  }
+  status.Update(member.output_status);
+  MP_RETURN_IF_ERROR(status).SetPrepend() << absl::Substitute(
+      "Calculator::Process() for node \"$0\" failed: ",
+      member.state->NodeName());
+
+  OutputStreamShardSet& outputs = context->Outputs();
+  for (CollectionItemId id = outputs.BeginId(); id < outputs.EndId(); ++id) {
+    OutputStreamShard& output = outputs.Get(id);
+    const CollectionItemId output_id = member.fused_outputs[id.value()];
+    for (Packet& packet : *output.OutputQueue()) {
+      RET_CHECK_EQ(packet.Timestamp(), input_timestamp)
+          << "Node \"" << member.state->NodeName()
+          << "\" must output packets at the input timestamp when fused.";
+      if (output_id.IsValid()) {
+        cc->Outputs().Get(output_id).AddPacket(std::move(packet));
+      } else {
+        packets_[member.output_slots[id.value()]] = std::move(packet);
+      }
+    }
+    output.ClearOutputQueue();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Reset(CalculatorContext* cc) {
+  for (auto& member : members_) {
+    CalculatorContext* context = member->context.get();
+    context->PushInputTimestamp(Timestamp::Unstarted());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = member->calculator->Reset(context);
+    }
+    context->PopInputTimestamp();
+    // Unimplemented makes the framework close and reopen this calculator.
+    MP_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Close(CalculatorContext* cc) {
+  absl::Status result;
+  for (auto& member : members_) {
+    CalculatorContext* context = member->context.get();
+    context->PushInputTimestamp(Timestamp::Done());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = member->calculator->Close(context);
+    }
+    context->PopInputTimestamp();
+    status.Update(member->output_status);
+    OutputStreamShardSet& outputs = context->Outputs();
+    for (CollectionItemId id = outputs.BeginId(); id < outputs.EndId(); ++id) {
+      OutputStreamShard& output = outputs.Get(id);
+      const CollectionItemId output_id = member->fused_outputs[id.value()];
+      if (output_id.IsValid()) {
+        for (Packet& packet : *output.OutputQueue()) {
+          cc->Outputs().Get(output_id).AddPacket(std::move(packet));
+        }
+      } else if (!output.IsEmpty()) {
+        status.Update(absl::FailedPreconditionError(
+            "Packets output in Close() cannot reach the next fused node."));
+      }
+      output.ClearOutputQueue();
+    }
+    if (!status.ok()) {
+      result.Update(StatusBuilder(std::move(status), MEDIAPIPE_LOC).SetPrepend()
+                    << absl::Substitute(
+                           "Calculator::Close() for node \"$0\" failed: ",
+                           member->state->NodeName()));
+    }
+  }
+  return result;
+}
+
+REGISTER_CALCULATOR(FusedCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,68 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_FUSED_CALCULATOR_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_FUSED_CALCULATOR_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// Runs the calculator nodes listed in FusedCalculatorOptions within a single
+// node.  For each input timestamp, the nodes are run in order, each with the
+// packets output at that timestamp by the nodes before it, and the packets
+// output by the last node are sent to the output streams.  As with the
+// default input stream handler, a node is only run if at least one of its
+// input streams has a packet.  The nodes must output packets at the input
+// timestamp only.
+//
+// FusedCalculator nodes are created by tool::FuseCalculators(), see
+// mediapipe/framework/tool/calculator_fusion.h.
+class FusedCalculator : public CalculatorBase {
+ public:
+  FusedCalculator();
+  ~FusedCalculator() override;
+
+  static absl::Status GetContract(CalculatorContract* cc);
+  absl::Status Open(CalculatorContext* cc) override;
+  absl::Status Process(CalculatorContext* cc) override;
+  absl::Status Reset(CalculatorContext* cc) override;
+  absl::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // A calculator run by this FusedCalculator, with its own CalculatorContext.
+  struct Member;
+
+  // Runs Process() on a member for the given input timestamp, if any of its
+  // input streams has a packet.
+  absl::Status ProcessMember(Member& member, Timestamp input_timestamp,
+                             CalculatorContext* cc);
+
+  std::vector<std::unique_ptr<Member>> members_;
+  // The packets at the current input timestamp, for the input streams
+  // followed by the output streams of each member.
+  std::vector<Packet> packets_;
+  // The index in packets_ of each input stream of this calculator.
+  std::vector<int> input_slots_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_FUSED_CALCULATOR_H_
@@ -33,8 +33,11 @@ absl::Status StatusFail(absl::string_view message) {
 }
 
 absl::Status StatusStop() {
-  return absl::Status(absl::StatusCode::kOutOfRange,
-                      "mediapipe::tool::StatusStop()");
+  // Copies of a status share its payload, so returning copies of one instance
+  // avoids allocating a new payload on every call.
+  static const absl::Status* const kStatusStop = new absl::Status(
+      absl::StatusCode::kOutOfRange, "mediapipe::tool::StatusStop()");
+  return *kStatusStop;
 }
 
 absl::Status AddStatusPrefix(absl::string_view prefix,
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/validated_graph_config.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -44,6 +45,7 @@
 #include "mediapipe/framework/status_handler.h"
 #include "mediapipe/framework/stream_handler.pb.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/tool/calculator_fusion.h"
 #include "mediapipe/framework/tool/name_util.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/tool/subgraph_expansion.h"
@@ -52,6 +54,29 @@
 
 namespace mediapipe {
 
+namespace internal {
+namespace {
+
+std::atomic<LegacyContractFixup> legacy_contract_fixup{nullptr};
+
+}  // namespace
+
+void RegisterLegacyContractFixup(LegacyContractFixup fixup) {
+  legacy_contract_fixup.store(fixup);
+}
+
+}  // namespace internal
+
+namespace {
+
+void ApplyLegacyContractFixup(CalculatorContract& contract) {
+  if (auto fixup = internal::legacy_contract_fixup.load()) {
+    fixup(contract);
+  }
+}
+
+}  // namespace
+
 // Create a debug string name for a set of edge.  An edge can be either
 // a stream or a side packet.
 std::string DebugEdgeNames(
@@ -222,6 +247,7 @@ absl::Status NodeTypeInfo::Initialize(
       _ << "Unable to find Calculator \"" << node_class << "\"");
   MP_RETURN_IF_ERROR(calculator_factory->GetContract(&contract_)).SetPrepend()
       << node_class << ": ";
+  ApplyLegacyContractFixup(contract_);
 
   // Validate result of FillExpectations or GetContract.
   std::vector<absl::Status> statuses;
@@ -274,6 +300,7 @@ absl::Status NodeTypeInfo::Initialize(
             .SetPrepend()
         << node_class << ": ";
   }
+  ApplyLegacyContractFixup(contract_);
 
   // Validate result of FillExpectations.
   std::vector<absl::Status> statuses;
@@ -337,6 +364,18 @@ absl::Status ValidatedGraphConfig::Initialize(
   config_ = std::move(input_config);
   MP_RETURN_IF_ERROR(
       PerformBasicTransforms(graph_registry, graph_options, service_manager));
+  return InitializeFromConfig();
+}
+
+absl::Status ValidatedGraphConfig::InitializeCompiled(
+    CalculatorGraphConfig compiled_config) {
+  RET_CHECK(!initialized_)
+      << "ValidatedGraphConfig can be initialized only once.";
+  config_ = std::move(compiled_config);
+  return InitializeFromConfig();
+}
+
+absl::Status ValidatedGraphConfig::InitializeFromConfig() {
   // Initialize the basic node information.
   MP_RETURN_IF_ERROR(InitializeGeneratorInfo());
   MP_RETURN_IF_ERROR(InitializeCalculatorInfo());
@@ -455,6 +494,10 @@ absl::Status ValidatedGraphConfig::PerformBasicTransforms(
   MP_RETURN_IF_ERROR(tool::ExpandSubgraphs(&config_, graph_registry,
                                            graph_options, service_manager));
 
+  if (config_.fuse_calculators()) {
+    MP_RETURN_IF_ERROR(tool::FuseCalculators(&config_));
+  }
+
   MP_RETURN_IF_ERROR(AddPredefinedExecutorConfigs(&config_));
 
   // Populate each node with the graph level input stream handler if a
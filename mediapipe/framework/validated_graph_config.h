@@ -38,6 +38,17 @@ namespace mediapipe {
 
 class ValidatedGraphConfig;
 
+namespace internal {
+
+// Adds to a node contract the requirements implied by legacy calculators.
+// CalculatorGraph registers it, since it knows the GPU service, which
+// ValidatedGraphConfig cannot depend on.  It is applied while the contracts
+// are built, because a ValidatedGraphConfig can then be shared by graphs.
+using LegacyContractFixup = void (*)(CalculatorContract& contract);
+void RegisterLegacyContractFixup(LegacyContractFixup fixup);
+
+}  // namespace internal
+
 std::string DebugEdgeNames(
     const std::string& edge_type,
     const proto_ns::RepeatedPtrField<ProtoString>& edges);
@@ -233,6 +244,13 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options = nullptr,
       std::shared_ptr<GraphServiceManager> service_manager = nullptr);
 
+  // Initializes the ValidatedGraphConfig from a compiled config, which is the
+  // Config() of another initialized ValidatedGraphConfig.  In a compiled
+  // config, subgraphs and templates are already expanded and options are
+  // already applied, so these transforms are skipped.  Calculator contracts
+  // and packet types are still created and validated.
+  absl::Status InitializeCompiled(CalculatorGraphConfig compiled_config);
+
   // Returns true if the ValidatedGraphConfig has been initialized.
   bool Initialized() const { return initialized_; }
 
@@ -327,6 +345,10 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options,
       std::shared_ptr<GraphServiceManager> service_manager);
 
+  // Initializes the node and edge information from config_, after the basic
+  // transforms have been applied.
+  absl::Status InitializeFromConfig();
+
   // Initialize the PacketGenerator information.
   absl::Status InitializeGeneratorInfo();
   // Initialize the Calculator information.
@@ -0,0 +1,120 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/validated_graph_config_cache.h"
+
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+std::string SerializeCompiledGraph(
+    const ValidatedGraphConfig& validated_graph) {
+  return validated_graph.Config().SerializeAsString();
+}
+
+absl::StatusOr<std::unique_ptr<ValidatedGraphConfig>> ParseCompiledGraph(
+    absl::string_view compiled_graph) {
+  CalculatorGraphConfig config;
+  RET_CHECK(config.ParseFromString(std::string(compiled_graph)))
+      << "Could not parse the compiled graph.";
+  auto validated_graph = std::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->InitializeCompiled(std::move(config)));
+  return validated_graph;
+}
+
+ValidatedGraphConfigCache::ValidatedGraphConfigCache(int capacity)
+    : capacity_(capacity) {}
+
+ValidatedGraphConfigCache& ValidatedGraphConfigCache::GetGlobal() {
+  static ValidatedGraphConfigCache* cache = new ValidatedGraphConfigCache();
+  return *cache;
+}
+
+absl::StatusOr<std::shared_ptr<const ValidatedGraphConfig>>
+ValidatedGraphConfigCache::GetOrCreate(
+    const CalculatorGraphConfig& config,
+    const std::map<std::string, Packet>& side_packets) {
+  std::string key = absl::StrCat("config:", config.SerializeAsString());
+  for (const auto& [name, packet] : side_packets) {
+    absl::StrAppend(&key, "\n", name, ":", packet.RegisteredTypeName());
+  }
+  if (auto validated_graph = Find(key)) {
+    return validated_graph;
+  }
+  auto validated_graph = std::make_shared<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->Initialize(config));
+  return Insert(key, std::move(validated_graph));
+}
+
+absl::StatusOr<std::shared_ptr<const ValidatedGraphConfig>>
+ValidatedGraphConfigCache::GetOrCreateCompiled(
+    absl::string_view compiled_graph) {
+  std::string key = absl::StrCat("compiled:", compiled_graph);
+  if (auto validated_graph = Find(key)) {
+    return validated_graph;
+  }
+  MP_ASSIGN_OR_RETURN(std::shared_ptr<ValidatedGraphConfig> validated_graph,
+                      ParseCompiledGraph(compiled_graph));
+  return Insert(key, std::move(validated_graph));
+}
+
+void ValidatedGraphConfigCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  entries_.clear();
+}
+
+int ValidatedGraphConfigCache::size() {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+std::shared_ptr<const ValidatedGraphConfig> ValidatedGraphConfigCache::Find(
+    const std::string& key) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = entries_.find(key);
+  if (iter == entries_.end()) {
+    return nullptr;
+  }
+  iter->second.last_use = ++use_count_;
+  return iter->second.validated_graph;
+}
+
+std::shared_ptr<const ValidatedGraphConfig> ValidatedGraphConfigCache::Insert(
+    const std::string& key,
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph) {
+  absl::MutexLock lock(&mutex_);
+  Entry& entry = entries_[key];
+  if (entry.validated_graph == nullptr) {
+    entry.validated_graph = std::move(validated_graph);
+  }
+  entry.last_use = ++use_count_;
+  std::shared_ptr<const ValidatedGraphConfig> result = entry.validated_graph;
+  // Evict the least recently used entry.
+  if (entries_.size() > capacity_) {
+    auto oldest = entries_.begin();
+    for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+      if (iter->second.last_use < oldest->second.last_use) {
+        oldest = iter;
+      }
+    }
+    entries_.erase(oldest);
+  }
+  return result;
+}
+
+}  // namespace mediapipe
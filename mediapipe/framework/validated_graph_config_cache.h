@@ -0,0 +1,107 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
+#define MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+// Returns a "compiled graph": the serialized canonical config of an
+// initialized ValidatedGraphConfig, with subgraphs and templates expanded
+// and options applied.
+std::string SerializeCompiledGraph(const ValidatedGraphConfig& validated_graph);
+
+// Returns a ValidatedGraphConfig restored from a compiled graph, without
+// expanding subgraphs or templates again.
+absl::StatusOr<std::unique_ptr<ValidatedGraphConfig>> ParseCompiledGraph(
+    absl::string_view compiled_graph);
+
+// Caches initialized ValidatedGraphConfigs, so that graphs created
+// repeatedly from one config share a single ValidatedGraphConfig.  After the
+// first graph, CalculatorGraph::Initialize skips subgraph expansion, contract
+// creation, and type validation entirely:
+//
+//   MP_ASSIGN_OR_RETURN(auto validated_graph,
+//                       ValidatedGraphConfigCache::GetGlobal().GetOrCreate(
+//                           config, side_packets));
+//   MP_RETURN_IF_ERROR(graph.Initialize(validated_graph, side_packets));
+//
+// Entries are keyed by the serialized config and the types of the side
+// packets.  Configs whose subgraph expansion depends on anything else, such
+// as graph services, must not be cached.
+//
+// ValidatedGraphConfigCache is thread-safe.
+class ValidatedGraphConfigCache {
+ public:
+  // Creates a cache retaining up to |capacity| recently used entries.
+  explicit ValidatedGraphConfigCache(int capacity = 64);
+
+  // Returns the process-wide cache.
+  static ValidatedGraphConfigCache& GetGlobal();
+
+  // Returns the ValidatedGraphConfig for a config, creating it on first use.
+  // Failed initializations are not cached.
+  absl::StatusOr<std::shared_ptr<const ValidatedGraphConfig>> GetOrCreate(
+      const CalculatorGraphConfig& config,
+      const std::map<std::string, Packet>& side_packets = {});
+
+  // Returns the ValidatedGraphConfig for a compiled graph, creating it on
+  // first use.
+  absl::StatusOr<std::shared_ptr<const ValidatedGraphConfig>>
+  GetOrCreateCompiled(absl::string_view compiled_graph);
+
+  // Removes all entries.
+  void Clear();
+
+  // Returns the number of entries.
+  int size();
+
+ private:
+  struct Entry {
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph;
+    int64_t last_use = 0;
+  };
+
+  // Returns the cached entry for a key, or nullptr.
+  std::shared_ptr<const ValidatedGraphConfig> Find(const std::string& key);
+
+  // Caches an entry, unless another thread cached one first, and returns the
+  // cached entry.
+  std::shared_ptr<const ValidatedGraphConfig> Insert(
+      const std::string& key,
+      std::shared_ptr<const ValidatedGraphConfig> validated_graph);
+
+  const int capacity_;
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  int64_t use_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
@@ -0,0 +1,182 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/validated_graph_config_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+class CachedPassThrough : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{"IN"};
+  static constexpr api2::Output<int> kOut{"OUT"};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut);
+  absl::Status Process(CalculatorContext* cc) override {
+    kOut(cc).Send(kIn(cc).packet());
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(CachedPassThrough);
+
+class CachedPassThroughSubgraph : public Subgraph {
+  absl::StatusOr<CalculatorGraphConfig> GetConfig(
+      SubgraphContext* sc) override {
+    return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+      input_stream: "IN:in"
+      output_stream: "OUT:out"
+      node {
+        calculator: "CachedPassThrough"
+        input_stream: "IN:in"
+        output_stream: "OUT:mid"
+      }
+      node {
+        calculator: "CachedPassThrough"
+        input_stream: "IN:mid"
+        output_stream: "OUT:out"
+      }
+    )pb");
+  }
+};
+REGISTER_MEDIAPIPE_GRAPH(CachedPassThroughSubgraph);
+
+CalculatorGraphConfig SubgraphConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "CachedPassThroughSubgraph"
+      input_stream: "IN:in"
+      output_stream: "OUT:out"
+    }
+  )pb");
+}
+
+// Runs a graph and returns the output packet values.
+std::vector<int> RunGraph(CalculatorGraph& graph) {
+  std::vector<int> result;
+  MP_EXPECT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    result.push_back(packet.Get<int>());
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  return result;
+}
+
+TEST(ValidatedGraphConfigCacheTest, SharesValidatedGraphConfig) {
+  ValidatedGraphConfigCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(auto validated_graph_1,
+                          cache.GetOrCreate(SubgraphConfig()));
+  MP_ASSERT_OK_AND_ASSIGN(auto validated_graph_2,
+                          cache.GetOrCreate(SubgraphConfig()));
+  EXPECT_EQ(validated_graph_1, validated_graph_2);
+  EXPECT_EQ(cache.size(), 1);
+
+  // Graphs initialized from the shared ValidatedGraphConfig run normally.
+  for (int i = 0; i < 2; ++i) {
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(validated_graph_1));
+    EXPECT_EQ(graph.Config().node_size(), 2);
+    EXPECT_THAT(RunGraph(graph), testing::ElementsAre(0, 1, 2));
+  }
+}
+
+TEST(ValidatedGraphConfigCacheTest, KeysBySidePacketTypes) {
+  ValidatedGraphConfigCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto validated_graph_1,
+      cache.GetOrCreate(SubgraphConfig(), {{"side", MakePacket<int>(1)}}));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto validated_graph_2,
+      cache.GetOrCreate(SubgraphConfig(), {{"side", MakePacket<int>(2)}}));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto validated_graph_3,
+      cache.GetOrCreate(SubgraphConfig(),
+                        {{"side", MakePacket<std::string>("text")}}));
+  EXPECT_EQ(validated_graph_1, validated_graph_2);
+  EXPECT_NE(validated_graph_1, validated_graph_3);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(ValidatedGraphConfigCacheTest, DoesNotCacheErrors) {
+  ValidatedGraphConfigCache cache;
+  CalculatorGraphConfig config;
+  config.add_node()->set_calculator("UnregisteredCalculator");
+  EXPECT_FALSE(cache.GetOrCreate(config).ok());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(ValidatedGraphConfigCacheTest, EvictsLeastRecentlyUsed) {
+  ValidatedGraphConfigCache cache(/*capacity=*/2);
+  CalculatorGraphConfig config_1 = SubgraphConfig();
+  CalculatorGraphConfig config_2 = SubgraphConfig();
+  config_2.set_max_queue_size(2);
+  CalculatorGraphConfig config_3 = SubgraphConfig();
+  config_3.set_max_queue_size(3);
+  MP_ASSERT_OK_AND_ASSIGN(auto validated_graph_1, cache.GetOrCreate(config_1));
+  MP_ASSERT_OK(cache.GetOrCreate(config_2).status());
+  MP_ASSERT_OK(cache.GetOrCreate(config_1).status());
+  MP_ASSERT_OK(cache.GetOrCreate(config_3).status());
+  EXPECT_EQ(cache.size(), 2);
+
+  // config_2 was evicted, while config_1 remains cached.
+  MP_ASSERT_OK_AND_ASSIGN(auto validated_graph_4, cache.GetOrCreate(config_1));
+  EXPECT_EQ(validated_graph_1, validated_graph_4);
+}
+
+TEST(ValidatedGraphConfigCacheTest, CompiledGraphSkipsExpansion) {
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(SubgraphConfig()));
+  std::string compiled_graph = SerializeCompiledGraph(validated_graph);
+
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ValidatedGraphConfig> restored,
+                          ParseCompiledGraph(compiled_graph));
+  EXPECT_THAT(restored->Config(), EqualsProto(validated_graph.Config()));
+  for (const auto& node : restored->Config().node()) {
+    EXPECT_EQ(node.calculator(), "CachedPassThrough");
+  }
+
+  ValidatedGraphConfigCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(auto cached_graph,
+                          cache.GetOrCreateCompiled(compiled_graph));
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(cached_graph));
+  EXPECT_THAT(RunGraph(graph), testing::ElementsAre(0, 1, 2));
+}
+
+TEST(ValidatedGraphConfigCacheTest, RejectsInvalidCompiledGraph) {
+  EXPECT_FALSE(ParseCompiledGraph("not a graph config").ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -19,10 +19,6 @@ limitations under the License.
 #include <fcntl.h>
 #include <stddef.h>
 
-#ifdef ABSL_HAVE_MMAP
-#include <sys/mman.h>
-#endif
-
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
@@ -33,16 +29,19 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/tasks/cc/common.h"
 #include "mediapipe/tasks/cc/core/proto/external_file.pb.h"
+#include "mediapipe/util/mapped_file.h"
 #include "mediapipe/util/resource_util.h"
 
 namespace mediapipe {
@@ -60,23 +59,6 @@ using ::absl::StatusCode;
 #endif              // _O_BINARY
 #endif              // O_BINARY
 
-// Gets the offset aligned to page size for mapping given files into memory by
-// file descriptor correctly, as according to mmap(2), the offset used in mmap
-// must be a multiple of sysconf(_SC_PAGE_SIZE).
-int64_t GetPageSizeAlignedOffset(int64_t offset) {
-#ifdef _WIN32
-  // mmap is not used on Windows
-  return 0;
-#else
-  int64_t aligned_offset = offset;
-  int64_t page_size = sysconf(_SC_PAGE_SIZE);
-  if (offset % page_size != 0) {
-    aligned_offset = offset / page_size * page_size;
-  }
-  return aligned_offset;
-#endif  // _WIN32
-}
-
 }  // namespace
 
 /* static */
@@ -203,12 +185,6 @@ absl::Status ExternalFileHandler::MapExternalFile() {
         MediaPipeTasksStatus::kInvalidArgumentError);
   }
 
-  // If buffer_offset_ is not multiple of sysconf(_SC_PAGE_SIZE), align with
-  // extra leading bytes and adjust buffer_size_ to account for the extra
-  // leading bytes.
-  buffer_aligned_offset_ = GetPageSizeAlignedOffset(buffer_offset_);
-  buffer_aligned_size_ = buffer_size_ + buffer_offset_ - buffer_aligned_offset_;
-
 #ifdef _WIN32
   buffer_ = malloc(file_size);
   // Return the file pointer back to the beginning of the file
@@ -218,20 +194,32 @@ absl::Status ExternalFileHandler::MapExternalFile() {
     free(buffer_);
     buffer_ = nullptr;
   }
-#else
-  // Map into memory.
-  buffer_ = mmap(/*addr=*/nullptr, buffer_aligned_size_, PROT_READ, MAP_SHARED,
-                 fd, buffer_aligned_offset_);
-  if (buffer_ == MAP_FAILED) {
-    buffer_ = nullptr;
-  }
-#endif  // _WIN32
   if (!buffer_) {
     return CreateStatusWithPayload(
         StatusCode::kUnknown,
         absl::StrFormat("Unable to map file to memory buffer, errno=%d", errno),
         MediaPipeTasksStatus::kFileMmapError);
   }
+#else
+  // Map into memory. The mapping is shared with the other handlers of the same
+  // file region, e.g. the model resources of several graphs loading the same
+  // model, and outlives the file descriptor.
+  absl::StatusOr<std::shared_ptr<const MappedFile>> mapped_file =
+      MappedFile::Map(fd, buffer_offset_, buffer_size_,
+                      MappedFile::AccessHint::kWillNeed);
+  if (!mapped_file.ok()) {
+    return CreateStatusWithPayload(
+        StatusCode::kUnknown,
+        absl::StrCat("Unable to map file to memory buffer: ",
+                     mapped_file.status().message()),
+        MediaPipeTasksStatus::kFileMmapError);
+  }
+  mapped_file_ = *std::move(mapped_file);
+  if (owned_fd_ >= 0) {
+    close(owned_fd_);
+    owned_fd_ = -1;
+  }
+#endif  // _WIN32
   return absl::OkStatus();
 }
 
@@ -243,20 +231,17 @@ absl::string_view ExternalFileHandler::GetFileContent() {
         reinterpret_cast<void*>(external_file_.file_pointer_meta().pointer());
     return absl::string_view(static_cast<const char*>(ptr),
                              external_file_.file_pointer_meta().length());
+  } else if (mapped_file_ != nullptr) {
+    return mapped_file_->data();
   } else {
-    return absl::string_view(static_cast<const char*>(buffer_) +
-                                 buffer_offset_ - buffer_aligned_offset_,
+    return absl::string_view(static_cast<const char*>(buffer_) + buffer_offset_,
                              buffer_size_);
   }
 }
 
 ExternalFileHandler::~ExternalFileHandler() {
   if (buffer_) {
-#ifdef _WIN32
     free(buffer_);
-#else
-    munmap(buffer_, buffer_aligned_size_);
-#endif  // _WIN32
   }
   if (owned_fd_ >= 0) {
     close(owned_fd_);
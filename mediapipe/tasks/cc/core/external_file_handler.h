@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/tasks/cc/core/proto/external_file.pb.h"
+#include "mediapipe/util/mapped_file.h"
 
 namespace mediapipe {
 namespace tasks {
@@ -69,22 +70,18 @@ class ExternalFileHandler {
   // opened and owned by this class. Set to -1 otherwise.
   int owned_fd_{-1};
 
-  // Points to the memory buffer mapped from the file descriptor of the
-  // ExternalFile, if provided by path or file descriptor.
+  // The memory mapping of the file descriptor of the ExternalFile, if provided
+  // by path or file descriptor. Shared with the other handlers mapping the
+  // same region of the same file.
+  std::shared_ptr<const MappedFile> mapped_file_;
+
+  // On Windows, where files are not mapped, the buffer the file is read into.
   void* buffer_{};
 
-  // The mapped memory buffer offset, if any.
+  // The offset of the file contents within the file, if any.
   int64_t buffer_offset_{};
-  // The size in bytes of the mapped memory buffer, if any.
+  // The size in bytes of the file contents, if any.
   int64_t buffer_size_{};
-
-  // As mmap(2) requires the offset to be a multiple of sysconf(_SC_PAGE_SIZE):
-
-  // The aligned mapped memory buffer offset, if any.
-  int64_t buffer_aligned_offset_{};
-  // The aligned mapped memory buffer size in bytes taking into account the
-  // offset shift introduced by buffer_aligned_memory_offset_, if any.
-  int64_t buffer_aligned_size_{};
 };
 
 }  // namespace core
@@ -137,6 +137,22 @@ TEST_F(ModelResourcesTest, CreateFromFile) {
 }
 
 #ifndef _WIN32
+TEST_F(ModelResourcesTest, CreateFromSameFileSharesMapping) {
+  auto model_file = std::make_unique<proto::ExternalFile>();
+  model_file->set_file_name(kTestModelPath);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto model_resources,
+      ModelResources::Create(kTestModelResourcesTag, std::move(model_file)));
+  auto other_model_file = std::make_unique<proto::ExternalFile>();
+  other_model_file->set_file_name(kTestModelPath);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto other_model_resources,
+      ModelResources::Create("other_tag", std::move(other_model_file)));
+  // Both models are built from the same memory mapped bytes.
+  EXPECT_EQ(model_resources->GetTfLiteModel(),
+            other_model_resources->GetTfLiteModel());
+}
+
 TEST_F(ModelResourcesTest, CreateFromFileDescriptor) {
   const int model_file_descriptor = open(kTestModelPath, O_RDONLY);
   auto model_file = std::make_unique<proto::ExternalFile>();
@@ -14,8 +14,12 @@
 
 #include "mediapipe/util/cpu_util.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
 
 #ifdef __ANDROID__
 #include "ndk/sources/android/cpufeatures/cpu-features.h"
@@ -24,12 +28,18 @@
 #else
 #include <unistd.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
 #include <fstream>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/statusor.h"
@@ -104,6 +114,66 @@ std::set<int> InferLowerOrHigherCoreIds(bool lower) {
     return inferred_cores;
   }
 }
+
+// Reads the first line of a sysfs file.
+absl::StatusOr<std::string> ReadFirstLine(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  if (!file.is_open() || !std::getline(file, line)) {
+    return absl::NotFoundError(absl::StrCat("Couldn't read ", path));
+  }
+  return line;
+}
+
+// Parses a sysfs list of ids such as "0-3,8-11". Returns an empty set if the
+// list is malformed.
+std::set<int> ParseIdList(absl::string_view list) {
+  std::set<int> ids;
+  for (absl::string_view range : absl::StrSplit(list, ',')) {
+    range = absl::StripAsciiWhitespace(range);
+    if (range.empty()) continue;
+    std::pair<absl::string_view, absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first;
+    int last;
+    if (!absl::SimpleAtoi(bounds.first, &first)) return {};
+    if (bounds.second.empty()) {
+      last = first;
+    } else if (!absl::SimpleAtoi(bounds.second, &last)) {
+      return {};
+    }
+    for (int id = first; id <= last; ++id) {
+      ids.insert(id);
+    }
+  }
+  return ids;
+}
+
+std::set<int> OnlineNumaNodes() {
+  auto line_or_status = ReadFirstLine("/sys/devices/system/node/online");
+  if (!line_or_status.ok()) {
+    return {};
+  }
+  return ParseIdList(line_or_status.value());
+}
+
+// Maps each CPU id to its NUMA node. Read once, since CurrentNumaNode() is
+// called on hot paths.
+const std::vector<int>& CpuToNumaNode() {
+  static const std::vector<int>* cpu_to_node = [] {
+    auto* cpu_to_node = new std::vector<int>();
+    for (const int node : OnlineNumaNodes()) {
+      for (const int cpu : NumaNodeCoreIds(node)) {
+        if (cpu >= cpu_to_node->size()) {
+          cpu_to_node->resize(cpu + 1, 0);
+        }
+        (*cpu_to_node)[cpu] = node;
+      }
+    }
+    return cpu_to_node;
+  }();
+  return *cpu_to_node;
+}
 }  // namespace
 
 int NumCPUCores() {
@@ -126,4 +196,33 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+int NumNumaNodes() {
+  static const int num_nodes =
+      std::max<int>(OnlineNumaNodes().size(), /*minimum=*/1);
+  return num_nodes;
+}
+
+std::set<int> NumaNodeCoreIds(int node) {
+  if (node < 0) {
+    return {};
+  }
+  auto line_or_status = ReadFirstLine(
+      absl::Substitute("/sys/devices/system/node/node$0/cpulist", node));
+  if (!line_or_status.ok()) {
+    return {};
+  }
+  return ParseIdList(line_or_status.value());
+}
+
+int CurrentNumaNode() {
+#if defined(__linux__)
+  const std::vector<int>& cpu_to_node = CpuToNumaNode();
+  const int cpu = sched_getcpu();
+  if (cpu >= 0 && cpu < cpu_to_node.size()) {
+    return cpu_to_node[cpu];
+  }
+#endif
+  return 0;
+}
+
 }  // namespace mediapipe.
@@ -24,6 +24,15 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the number of NUMA nodes, or 1 if it cannot be determined.
+int NumNumaNodes();
+// Returns the set of CPU ids of NUMA node "node", or an empty set if it cannot
+// be determined.
+std::set<int> NumaNodeCoreIds(int node);
+// Returns the NUMA node of the CPU that the calling thread is running on, or 0
+// if it cannot be determined. Unless the thread is pinned to the CPUs of one
+// node, the result may be stale by the time it is used.
+int CurrentNumaNode();
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
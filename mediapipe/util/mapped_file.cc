@@ -0,0 +1,204 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/mapped_file.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "absl/base/config.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+
+#ifdef ABSL_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // ABSL_HAVE_MMAP
+
+namespace mediapipe {
+
+// Identifies a region of a file, independently of the path or file
+// descriptor used to open it. The size and modification time of the file are
+// included so that a file replaced in place is mapped again.
+struct MappedFile::RegionKey {
+  uint64_t device;
+  uint64_t inode;
+  int64_t file_size;
+  int64_t modification_time;
+  int64_t offset;
+  int64_t length;
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RegionKey& key) {
+    return H::combine(std::move(h), key.device, key.inode, key.file_size,
+                      key.modification_time, key.offset, key.length);
+  }
+  friend bool operator==(const RegionKey& a, const RegionKey& b) {
+    return std::tie(a.device, a.inode, a.file_size, a.modification_time,
+                    a.offset, a.length) ==
+           std::tie(b.device, b.inode, b.file_size, b.modification_time,
+                    b.offset, b.length);
+  }
+};
+
+// The mappings that are alive in the process.
+struct MappedFile::Registry {
+  absl::Mutex mutex;
+  absl::flat_hash_map<RegionKey, std::weak_ptr<const MappedFile>> regions
+      ABSL_GUARDED_BY(mutex);
+
+  // Forgets the regions whose mapping has been released.
+  void RemoveExpired() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    for (auto it = regions.begin(); it != regions.end();) {
+      if (it->second.expired()) {
+        regions.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+};
+
+MappedFile::Registry& MappedFile::GetRegistry() {
+  static NoDestructor<Registry> registry;
+  return *registry;
+}
+
+bool MappedFile::IsSupported() {
+#ifdef ABSL_HAVE_MMAP
+  return true;
+#else
+  return false;
+#endif  // ABSL_HAVE_MMAP
+}
+
+absl::StatusOr<std::shared_ptr<const MappedFile>> MappedFile::Open(
+    const std::string& path, AccessHint hint) {
+#ifdef ABSL_HAVE_MMAP
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(
+        errno, absl::StrFormat("Unable to open file at %s", path));
+  }
+  absl::StatusOr<std::shared_ptr<const MappedFile>> mapped_file =
+      Map(fd, /*offset=*/0, /*length=*/0, hint);
+  close(fd);
+  return mapped_file;
+#else
+  return absl::UnimplementedError(
+      "Memory mapped files are not supported on this platform.");
+#endif  // ABSL_HAVE_MMAP
+}
+
+absl::StatusOr<std::shared_ptr<const MappedFile>> MappedFile::Map(
+    int fd, int64_t offset, int64_t length, AccessHint hint) {
+#ifdef ABSL_HAVE_MMAP
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    return absl::ErrnoToStatus(
+        errno, absl::StrFormat("Unable to stat file descriptor %d", fd));
+  }
+  const int64_t file_size = file_stat.st_size;
+  if (offset < 0 || offset >= file_size) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Offset %d is out of range for a file of %d bytes", offset, file_size));
+  }
+  if (length <= 0) length = file_size - offset;
+  if (offset + length > file_size) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Region of %d bytes at offset %d exceeds the file "
+                        "length (%d)",
+                        length, offset, file_size));
+  }
+
+  const RegionKey key{static_cast<uint64_t>(file_stat.st_dev),
+                      static_cast<uint64_t>(file_stat.st_ino),
+                      file_size,
+                      static_cast<int64_t>(file_stat.st_mtime),
+                      offset,
+                      length};
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  if (std::shared_ptr<const MappedFile> mapped_file =
+          registry.regions[key].lock()) {
+    return mapped_file;
+  }
+  registry.RemoveExpired();
+
+  // mmap requires the offset to be a multiple of the page size.
+  const int64_t page_size = sysconf(_SC_PAGE_SIZE);
+  const int64_t aligned_offset = offset / page_size * page_size;
+  const size_t mapping_size = length + (offset - aligned_offset);
+  void* mapping = mmap(/*addr=*/nullptr, mapping_size, PROT_READ, MAP_SHARED,
+                       fd, aligned_offset);
+  if (mapping == MAP_FAILED) {
+    return absl::ErrnoToStatus(
+        errno, absl::StrFormat("Unable to map file descriptor %d", fd));
+  }
+
+  int advice = MADV_NORMAL;
+  switch (hint) {
+    case AccessHint::kNormal:
+      break;
+    case AccessHint::kWillNeed:
+      advice = MADV_WILLNEED;
+      break;
+    case AccessHint::kSequential:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case AccessHint::kRandom:
+      advice = MADV_RANDOM;
+      break;
+  }
+  if (advice != MADV_NORMAL && madvise(mapping, mapping_size, advice) != 0) {
+    // Hints only affect performance.
+    ABSL_LOG(WARNING) << "madvise failed, errno=" << errno;
+  }
+
+  std::shared_ptr<const MappedFile> mapped_file(new MappedFile(
+      mapping, mapping_size, offset - aligned_offset, length));
+  registry.regions[key] = mapped_file;
+  return mapped_file;
+#else
+  return absl::UnimplementedError(
+      "Memory mapped files are not supported on this platform.");
+#endif  // ABSL_HAVE_MMAP
+}
+
+MappedFile::~MappedFile() {
+#ifdef ABSL_HAVE_MMAP
+  munmap(mapping_, mapping_size_);
+#endif  // ABSL_HAVE_MMAP
+}
+
+int MappedFile::NumMappedRegions() {
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  registry.RemoveExpired();
+  return registry.regions.size();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,104 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_MAPPED_FILE_H_
+#define MEDIAPIPE_UTIL_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace mediapipe {
+
+// A read-only memory mapping of a region of a file, e.g. a model.
+//
+// Mappings are shared: mapping a region of a file that is already mapped in
+// the process, e.g. the same model loaded by several graphs, returns the
+// existing mapping instead of creating a new one. The pages of the mapping
+// belong to the page cache, so they are also shared with every other process
+// that maps the same file, and are never copied to the heap.
+//
+// Mappings are only available where mmap is (see MappedFile::IsSupported());
+// callers are expected to fall back to reading the file otherwise.
+class MappedFile {
+ public:
+  // How the mapped pages are expected to be accessed, passed to madvise.
+  enum class AccessHint {
+    // No hint.
+    kNormal,
+    // The whole region will be read soon, e.g. a model whose weights are read
+    // when building an interpreter. Starts reading the file ahead
+    // asynchronously, which shortens cold starts.
+    kWillNeed,
+    // The region will be read once from start to end.
+    kSequential,
+    // The region will be read in random order; disables read-ahead.
+    kRandom,
+  };
+
+  // Returns whether files can be memory mapped on this platform.
+  static bool IsSupported();
+
+  // Maps the whole file at "path".
+  static absl::StatusOr<std::shared_ptr<const MappedFile>> Open(
+      const std::string& path, AccessHint hint = AccessHint::kWillNeed);
+
+  // Maps "length" bytes starting at "offset" of the open file "fd". The
+  // mapping stays valid after "fd" is closed. "offset" does not need to be
+  // page aligned. If "length" is 0, maps the rest of the file.
+  static absl::StatusOr<std::shared_ptr<const MappedFile>> Map(
+      int fd, int64_t offset, int64_t length,
+      AccessHint hint = AccessHint::kWillNeed);
+
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // The mapped bytes, valid as long as this object is alive.
+  absl::string_view data() const {
+    return absl::string_view(static_cast<const char*>(mapping_) + data_offset_,
+                             data_size_);
+  }
+
+  // Returns the number of distinct regions currently mapped in the process.
+  static int NumMappedRegions();
+
+ private:
+  struct RegionKey;
+  struct Registry;
+
+  MappedFile(void* mapping, size_t mapping_size, size_t data_offset,
+             size_t data_size)
+      : mapping_(mapping),
+        mapping_size_(mapping_size),
+        data_offset_(data_offset),
+        data_size_(data_size) {}
+
+  static Registry& GetRegistry();
+
+  // The page aligned mapping.
+  void* const mapping_;
+  const size_t mapping_size_;
+  // The requested region within the mapping.
+  const size_t data_offset_;
+  const size_t data_size_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_MAPPED_FILE_H_
@@ -0,0 +1,121 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/mapped_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/deps/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Writes a file that spans several pages, and returns its path.
+std::string WriteTestFile(const std::string& name, std::string* contents) {
+  contents->clear();
+  for (int i = 0; i < 10000; ++i) {
+    absl::StrAppend(contents, i, ",");
+  }
+  const std::string path = absl::StrCat(getenv("TEST_TMPDIR"), "/", name);
+  ABSL_CHECK_OK(file::SetContents(path, *contents));
+  return path;
+}
+
+TEST(MappedFileTest, MapsWholeFile) {
+  if (!MappedFile::IsSupported()) GTEST_SKIP();
+  std::string contents;
+  const std::string path = WriteTestFile("whole_file", &contents);
+
+  MP_ASSERT_OK_AND_ASSIGN(auto mapped_file, MappedFile::Open(path));
+  EXPECT_EQ(mapped_file->data(), contents);
+}
+
+TEST(MappedFileTest, SharesMappingsOfSameRegion) {
+  if (!MappedFile::IsSupported()) GTEST_SKIP();
+  std::string contents;
+  const std::string path = WriteTestFile("shared_file", &contents);
+  const int num_regions = MappedFile::NumMappedRegions();
+
+  MP_ASSERT_OK_AND_ASSIGN(auto first, MappedFile::Open(path));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto second, MappedFile::Open(path, MappedFile::AccessHint::kRandom));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first->data().data(), second->data().data());
+  EXPECT_EQ(MappedFile::NumMappedRegions(), num_regions + 1);
+
+  // A different region of the same file has its own mapping.
+  const int fd = open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  MP_ASSERT_OK_AND_ASSIGN(auto region, MappedFile::Map(fd, 1, 10));
+  close(fd);
+  EXPECT_NE(region, first);
+  EXPECT_EQ(MappedFile::NumMappedRegions(), num_regions + 2);
+
+  // Mappings are released with their last reference.
+  first.reset();
+  region.reset();
+  EXPECT_EQ(MappedFile::NumMappedRegions(), num_regions + 1);
+  second.reset();
+  EXPECT_EQ(MappedFile::NumMappedRegions(), num_regions);
+}
+
+TEST(MappedFileTest, MapsUnalignedRegion) {
+  if (!MappedFile::IsSupported()) GTEST_SKIP();
+  std::string contents;
+  const std::string path = WriteTestFile("unaligned_region", &contents);
+  const int fd = open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  MP_ASSERT_OK_AND_ASSIGN(auto region, MappedFile::Map(fd, 5001, 123));
+  MP_ASSERT_OK_AND_ASSIGN(auto rest, MappedFile::Map(fd, 5001, 0));
+  close(fd);
+  // The mappings stay valid after the file is closed.
+  EXPECT_EQ(region->data(), contents.substr(5001, 123));
+  EXPECT_EQ(rest->data(), contents.substr(5001));
+}
+
+TEST(MappedFileTest, RejectsRegionsOutsideFile) {
+  if (!MappedFile::IsSupported()) GTEST_SKIP();
+  std::string contents;
+  const std::string path = WriteTestFile("out_of_range", &contents);
+  const int fd = open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  EXPECT_EQ(MappedFile::Map(fd, contents.size(), 0).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(MappedFile::Map(fd, 10, contents.size()).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  close(fd);
+}
+
+TEST(MappedFileTest, ReturnsNotFoundForMissingFile) {
+  if (!MappedFile::IsSupported()) GTEST_SKIP();
+  EXPECT_EQ(MappedFile::Open(absl::StrCat(getenv("TEST_TMPDIR"), "/missing"))
+                .status()
+                .code(),
+            absl::StatusCode::kNotFound);
+}
+
+}  // namespace
+}  // namespace mediapipe
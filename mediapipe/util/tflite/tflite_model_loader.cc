@@ -21,21 +21,18 @@
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/api2/packet.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/mapped_file.h"
 #include "mediapipe/util/resource_util.h"
-#include "mediapipe/util/tflite/error_reporter.h"
-#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/model_builder.h"
 
 namespace mediapipe {
 
-using ::mediapipe::util::tflite::ErrorReporter;
-using ::tflite::Allocation;
 using ::tflite::FlatBufferModel;
-using ::tflite::MMAPAllocation;
 
 absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
     const std::string& path, bool try_mmap) {
@@ -50,23 +47,28 @@ absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
   }
 
   // Try to memory map file if available. Falls back to loading from buffer on
-  // error.
-  if (try_mmap && MMAPAllocation::IsSupported()) {
-    ErrorReporter error_reporter;
-    std::unique_ptr<Allocation> allocation =
-        std::make_unique<MMAPAllocation>(model_path.c_str(), &error_reporter);
-
-    if (!error_reporter.HasError()) {
-      auto model = FlatBufferModel::BuildFromAllocation(std::move(allocation));
+  // error. The mapping is shared by all the models loaded from the same file.
+  if (try_mmap && MappedFile::IsSupported()) {
+    absl::StatusOr<std::shared_ptr<const MappedFile>> mapped_file =
+        MappedFile::Open(model_path, MappedFile::AccessHint::kWillNeed);
+    if (mapped_file.ok()) {
+      const absl::string_view model_data = (*mapped_file)->data();
+      auto model =
+          FlatBufferModel::BuildFromBuffer(model_data.data(), model_data.size());
       if (model) {
         return api2::MakePacket<TfLiteModelPtr>(
-            model.release(), [](FlatBufferModel* model) { delete model; });
+            model.release(),
+            [mapped_file = *std::move(mapped_file)](FlatBufferModel* model) {
+              // The mapping must outlive the model.
+              delete model;
+            });
       }
+      mapped_file = absl::InvalidArgumentError("Not a valid model.");
     }
 
     ABSL_LOG(WARNING) << "Failed to memory map model from path '" << model_path
                       << "'; falling back to loading from buffer. Error: "
-                      << error_reporter.message();
+                      << mapped_file.status().message();
   }
 
   // Load into a buffer.
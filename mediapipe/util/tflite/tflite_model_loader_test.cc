@@ -78,5 +78,22 @@ TEST_F(TfLiteModelLoaderTest, LoadFromPathWithMmap) {
   model.Get()->error_reporter()->Report("Test%i", 1);
 }
 
+TEST_F(TfLiteModelLoaderTest, LoadFromPathWithMmapSharesMapping) {
+  // TODO: remove LegacyCalculatorSupport usage.
+  LegacyCalculatorSupport::Scoped<CalculatorContext> scope(
+      calculator_context_.get());
+  MP_ASSERT_OK_AND_ASSIGN(
+      api2::Packet<TfLiteModelPtr> model,
+      TfLiteModelLoader::LoadFromPath(model_path_, /* try_mmap=*/true));
+  MP_ASSERT_OK_AND_ASSIGN(
+      api2::Packet<TfLiteModelPtr> other_model,
+      TfLiteModelLoader::LoadFromPath(model_path_, /* try_mmap=*/true));
+  ASSERT_NE(model.Get(), nullptr);
+  ASSERT_NE(other_model.Get(), nullptr);
+  EXPECT_NE(model.Get().get(), other_model.Get().get());
+  // Both models read the same mapped bytes.
+  EXPECT_EQ(model.Get()->GetModel(), other_model.Get()->GetModel());
+}
+
 }  // namespace
 }  // namespace mediapipe